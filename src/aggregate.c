@@ -0,0 +1,211 @@
+/*****************************************************************************/
+/* */
+/* aggregate.c */
+/* Purpose: This file contains the functions that compute the count, sum, minimum, maximum, mean and histogram of a numeric column of the pokemon table for every group of rows, on the server, so a client never has to download the rows to get their statistics. Every group is a selection bitmap and its statistics come from one pass of the vector kernels of column_scan.c. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Parse a request with aggregate_parse and compute its result with aggregate_run. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "aggregate.h"
+
+/* Name of every grouping inside a request, indexed with AggregateGroupingType */
+static const char *grouping_names[NUMBER_OF_GROUPINGS] = {"all", "type", "generation", "legendary"};
+
+/* This function returns the next word of a request, skipping the blanks between words */
+/* Parameters: **position - input/output (the rest of the request, moved past the word) */
+/* Return values: char pointer to the null-terminated word, NULL if the request has no more words */
+/* Side effects: writes null characters over the blanks of the request */
+static char *next_word(char **position) {
+  char *word;
+  do {
+    word = strsep(position, QUERY_BLANKS);
+  } while(word != NULL && *word == '\0');
+  return word;
+}
+
+/* This function parses the text of an aggregation request, for example "attack by type where generation<=3" */
+/* Parameters: *table - input (the table the request runs over), *text - input (the text of the request, not null-terminated), length - input (the amount of characters inside text), *aggregate - output (the parsed request), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if the request was parsed and C_NOK (-1) if it is invalid */
+/* Side effects: allocates and frees a null-terminated copy of the text */
+int aggregate_parse(const PokemonTableType *table, const char *text, int length, AggregateType *aggregate, char *error) {
+  char *copy = (char *)malloc(length + 1);  //null-terminated copy of the text split into words
+  char *position = copy;
+  int result = C_OK;
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(copy == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+
+  aggregate->grouping = GROUP_NONE;
+  aggregate->has_filter = C_NOK;
+
+  /* The request starts with the stat the statistics are computed over */
+  char *word = next_word(&position);
+  int column = (word == NULL) ? C_NOK : query_find_column(word);
+  if(column == C_NOK) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "An aggregation must start with a stat, like 'attack by type'");
+    free(copy);
+    return C_NOK;
+  }
+  aggregate->column = column;
+  word = next_word(&position);
+
+  /* Then how the rows are grouped, every row is inside one group if it is not given */
+  if(word != NULL && strcasecmp(word, "by") == 0) {
+    word = next_word(&position);
+    aggregate->grouping = NUMBER_OF_GROUPINGS;
+    for(int i = GROUP_TYPE; i < NUMBER_OF_GROUPINGS && word != NULL; i++) {
+      if(strcasecmp(word, grouping_names[i]) == 0) {
+        aggregate->grouping = i;
+      }
+    }
+    if(aggregate->grouping == NUMBER_OF_GROUPINGS) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Can only group by type, generation or legendary");
+      free(copy);
+      return C_NOK;
+    }
+    word = next_word(&position);
+  }
+
+  /* Then the filter query choosing the rows, which can't be sorted or limited since every matching row is counted */
+  if(word != NULL && strcasecmp(word, "where") == 0) {
+    const char *filter = (position == NULL) ? "" : position;
+    result = query_parse(table, filter, strlen(filter), &aggregate->filter, error);
+    if(result == C_OK && (aggregate->filter.sort_column != QUERY_NO_SORT || aggregate->filter.limit != QUERY_NO_LIMIT)) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "An aggregation can't be sorted or limited");
+      result = C_NOK;
+    }
+    aggregate->has_filter = C_OK;
+  }
+  else if(word != NULL) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Expected 'by' or 'where' instead of '%.100s'", word);
+    result = C_NOK;
+  }
+
+  free(copy);
+  return result;
+}
+
+/* This function writes the line of one group of an aggregation result */
+/* Parameters: *values - input (the column the statistics are computed over), number_of_rows - input (the amount of rows of the table), *bitmap - input (the rows of the group), *label - input (the name of the group), lowest - input (the value the first histogram bucket starts at), bucket_width - input (the amount of values inside every bucket), keep_empty - input (C_OK if the line is written even if the group has no row), *line - output (the line, at least AGGREGATE_LINE_SIZE characters) */
+/* Return values: int containing the amount of characters written, 0 for an empty group that isn't kept */
+/* Side effects: none */
+static int aggregate_group_line(const short *values, int number_of_rows, const uint64_t *bitmap, const char *label, int lowest, int bucket_width, char keep_empty, char *line) {
+  ColumnStatsType stats;
+  int histogram[AGGREGATE_HISTOGRAM_BUCKETS] = {0};
+
+  /* The count, sum, minimum and maximum come from one vectorized pass over the column */
+  column_scan_stats(values, number_of_rows, bitmap, &stats);
+  if(stats.count == 0 && keep_empty == C_NOK) {
+    return 0;
+  }
+
+  /* The histogram only visits the rows of the group */
+  for(int word = 0; word < bitmap_words(number_of_rows); word++) {
+    for(uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+      histogram[(values[word * BITMAP_WORD_BITS + __builtin_ctzll(bits)] - lowest) / bucket_width]++;
+    }
+  }
+
+  int length = snprintf(line, AGGREGATE_LINE_SIZE, "%.100s,%d,%ld,%d,%d,%.2f,", label, stats.count, stats.sum, stats.minimum, stats.maximum, (stats.count > 0) ? (double)stats.sum / stats.count : 0.0);
+  for(int i = 0; i < AGGREGATE_HISTOGRAM_BUCKETS; i++) {
+    length += snprintf(line + length, AGGREGATE_LINE_SIZE - length, (i == 0) ? "%d" : " %d", histogram[i]);
+  }
+  length += snprintf(line + length, AGGREGATE_LINE_SIZE - length, "\n");
+  return length;
+}
+
+/* This function computes the statistics of an aggregation request for every group of rows */
+/* Parameters: *table - input (the table the request runs over), *aggregate - input (the parsed request), *size - output (the amount of bytes inside the result) */
+/* Return values: char pointer to the text of the result (not null-terminated), which must be freed by the caller */
+/* Side effects: allocates memory for the result and frees the bitmaps it uses, exits the program if memory can't be allocated */
+char *aggregate_run(const PokemonTableType *table, const AggregateType *aggregate, int *size) {
+  int number_of_rows = table->number_of_rows;
+  int words = bitmap_words(number_of_rows);
+  const short *values = table->columns[aggregate->column];
+  uint64_t *filter = (uint64_t *)malloc(sizeof(uint64_t) * (words + 1));  //rows matching the filter query
+  uint64_t *group = (uint64_t *)malloc(sizeof(uint64_t) * (words + 1));   //rows matching the filter query inside the current group
+  ColumnStatsType overall;
+  ColumnStatsType generations;
+  int number_of_groups = 1;
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(filter == NULL || group == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  if(aggregate->has_filter == C_OK) {
+    query_execute(table, &aggregate->filter, filter);
+  }
+  else {
+    bitmap_fill(filter, number_of_rows);
+  }
+
+  /* Every group uses the same histogram buckets, spread over every value of the rows matching the filter */
+  column_scan_stats(values, number_of_rows, filter, &overall);
+  int bucket_width = (overall.maximum - overall.minimum) / AGGREGATE_HISTOGRAM_BUCKETS + 1;
+
+  if(aggregate->grouping == GROUP_TYPE) {
+    number_of_groups = table->number_of_types;
+  }
+  else if(aggregate->grouping == GROUP_GENERATION) {
+    column_scan_stats(table->columns[COLUMN_GENERATION], number_of_rows, filter, &generations);
+    number_of_groups = (generations.count > 0) ? generations.maximum - generations.minimum + 1 : 0;
+  }
+  else if(aggregate->grouping == GROUP_LEGENDARY) {
+    number_of_groups = 2;
+  }
+
+  char *result = (char *)malloc((size_t)(number_of_groups + 2) * AGGREGATE_LINE_SIZE);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(result == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  int length = snprintf(result, 2 * AGGREGATE_LINE_SIZE, "histogram of %d buckets of width %d starting at %d\ngroup,count,sum,min,max,mean,histogram\n", AGGREGATE_HISTOGRAM_BUCKETS, bucket_width, overall.minimum);
+
+  /* Narrow the rows matching the filter down to every group, groups without any row are left out */
+  for(int i = 0; i < number_of_groups; i++) {
+    char label[AGGREGATE_LINE_SIZE];
+
+    memcpy(group, filter, sizeof(uint64_t) * words);
+    switch(aggregate->grouping) {
+      case GROUP_TYPE:
+        scan_either_type(table, table->types[i].type, group);
+        snprintf(label, sizeof(label), "%s", table_string(table, table->types[i].type));
+        break;
+      case GROUP_GENERATION:
+        column_scan_range(table->columns[COLUMN_GENERATION], number_of_rows, generations.minimum + i, generations.minimum + i, group);
+        snprintf(label, sizeof(label), "%d", generations.minimum + i);
+        break;
+      case GROUP_LEGENDARY:
+        scan_legendary(table, (i == 0) ? 'n' : 'y', group);
+        snprintf(label, sizeof(label), "%s", (i == 0) ? "false" : "true");
+        break;
+      default:
+        snprintf(label, sizeof(label), "%s", grouping_names[GROUP_NONE]);
+        break;
+    }
+    length += aggregate_group_line(values, number_of_rows, group, label, overall.minimum, bucket_width, (aggregate->grouping == GROUP_NONE) ? C_OK : C_NOK, result + length);
+  }
+
+  free(filter);
+  free(group);
+  *size = length;
+  return result;
+}
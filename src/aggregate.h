@@ -0,0 +1,48 @@
+/*****************************************************************************/
+/* */
+/* aggregate.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the aggregate.c file */
+/* How to use: use #include "aggregate.h" at the top of any .c files that need to compute statistics of the pokemon table on the server */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef AGGREGATE_H_
+#define AGGREGATE_H_
+
+//importing the header files of the table the statistics are computed over and of the queries choosing the rows
+#include "pokemon_table.h"
+#include "query.h"
+
+//Variety of constants defined
+#define AGGREGATE_HISTOGRAM_BUCKETS 10  //Constant to represent the amount of buckets of equal width inside every histogram
+#define AGGREGATE_LINE_SIZE 512         //Constant to represent the longest line of an aggregation result
+
+/* This enum names every way the rows of an aggregation can be grouped */
+typedef enum AggregateGrouping {
+  GROUP_NONE,             //Every row is inside a single group named "all"
+  GROUP_TYPE,             //One group per type, a pokemon with two types is inside both groups
+  GROUP_GENERATION,       //One group per generation
+  GROUP_LEGENDARY,        //One group for the pokemon that are not legendary and one for the legendary ones
+  NUMBER_OF_GROUPINGS     //Amount of groupings, must stay last
+} AggregateGroupingType;
+
+/* This structure contains an aggregation request, the statistics of one numeric column computed for every group of rows matching an optional filter query.
+   The text of the request is "<stat> [by type|generation|legendary] [where <filter query>]", for example "attack by type where generation<=3".
+   The result is text, a line describing the histograms, a line naming every field, then one line per group:
+     group,count,sum,min,max,mean,histogram   the histogram is the amount of rows inside every bucket, separated by spaces */
+typedef struct Aggregate {
+  PokemonColumnType column;           //Numeric column the statistics are computed over
+  AggregateGroupingType grouping;     //How the rows are grouped
+  char has_filter;                    //C_OK if only the rows matching filter are used, C_NOK if every row is used
+  QueryType filter;                   //Query choosing the rows, only used if has_filter is C_OK
+} AggregateType;
+
+/* all function prototypes for functions in aggregate.c */
+int aggregate_parse(const PokemonTableType *table, const char *text, int length, AggregateType *aggregate, char *error);
+char *aggregate_run(const PokemonTableType *table, const AggregateType *aggregate, int *size);
+
+#endif //end of header file
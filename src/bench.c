@@ -0,0 +1,470 @@
+/*****************************************************************************/
+/* */
+/* bench.c */
+/* Purpose: This file generates load against a running server to measure how many requests it answers per second and how long they take, so every version can be compared before it is rolled out. */
+/* How to use: Make sure to compile the file and then link it with protocol.c, this is already done for you in the MakeFile with make bench. Start the server, then run ./bench, by default 4 connections each keep one request running (closed loop) for 10 seconds after 1 second of warmup. -c sets the amount of connections, -p the amount of requests each keeps running, at most the MAX_PENDING_REQUESTS_PER_CONNECTION the server runs at once, -d and -w the seconds measured and of warmup, -r sends that many requests per second on schedule instead (open loop), -f the percentage of filter queries and every -q gives a filter query to send instead of the default ones. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//needed for ppoll
+#define _GNU_SOURCE
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+//importing the header file included with the program to get access to its functions, constants and structs
+#include "bench.h"
+
+/* Every type a type query is sent for, the same types check_valid_pokemon_type accepts in the client */
+static const char *pokemon_types[BENCH_NUMBER_OF_TYPES] = {
+  "Normal", "Fire", "Water", "Grass", "Electric", "Ice", "Fighting", "Poison", "Ground",
+  "Flying", "Psychic", "Bug", "Rock", "Ghost", "Dragon", "Dark", "Steel", "Fairy"
+};
+
+/* Filter queries sent when the user does not give any, from a few matching pokemon to a large share of the table */
+static const char *default_filters[] = {
+  "speed>=100",
+  "type=Water generation<=3",
+  "legendary=true",
+  "sort=-total limit=20",
+  "type=Fire or type=Dragon",
+  "attack>=50 defense>=50 sort=-speed"
+};
+
+/* This function returns the time of a monotonic clock, used for every time of the run */
+/* Parameters: None */
+/* Return values: int64_t containing the time in nanoseconds */
+/* Side effects: none */
+int64_t bench_now(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+/* This function finds the bucket of a histogram a value is counted in, values below HISTOGRAM_SUB_BUCKETS have their own bucket and every larger power of two is split into HISTOGRAM_HALF_SUB_BUCKETS buckets */
+/* Parameters: value - input (the value being counted) */
+/* Return values: int containing the index of the bucket */
+/* Side effects: none */
+static int histogram_index(int64_t value) {
+  if(value < HISTOGRAM_SUB_BUCKETS) {
+    return (value < 0) ? 0 : (int)value;
+  }
+
+  /* Keep the HISTOGRAM_SUB_BUCKET_BITS highest bits of the value, shift is how many lower bits are dropped */
+  int shift = 63 - __builtin_clzll((unsigned long long)value) - (HISTOGRAM_SUB_BUCKET_BITS - 1);
+  return HISTOGRAM_SUB_BUCKETS + (shift - 1) * HISTOGRAM_HALF_SUB_BUCKETS + (int)(value >> shift) - HISTOGRAM_HALF_SUB_BUCKETS;
+}
+
+/* This function finds the largest value counted in a bucket of a histogram */
+/* Parameters: index - input (the index of the bucket) */
+/* Return values: int64_t containing the largest value of the bucket */
+/* Side effects: none */
+static int64_t histogram_highest_value(int index) {
+  if(index < HISTOGRAM_SUB_BUCKETS) {
+    return index;
+  }
+  int shift = (index - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_HALF_SUB_BUCKETS + 1;
+  int64_t kept_bits = (index - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_HALF_SUB_BUCKETS + HISTOGRAM_HALF_SUB_BUCKETS;
+  return ((kept_bits + 1) << shift) - 1;
+}
+
+/* This function counts one latency inside a histogram */
+/* Parameters: *histogram - input/output (the histogram), value - input (the latency in nanoseconds) */
+/* Return values: nothing since it's a void function */
+/* Side effects: changes the counts of the histogram */
+void histogram_record(LatencyHistogramType *histogram, int64_t value) {
+  if(histogram->total_count == 0 || value < histogram->min) {
+    histogram->min = value;
+  }
+  if(value > histogram->max) {
+    histogram->max = value;
+  }
+  histogram->counts[histogram_index(value)]++;
+  histogram->total_count++;
+  histogram->sum += value;
+}
+
+/* This function adds every latency counted in a histogram to another one */
+/* Parameters: *destination - input/output (the histogram the latencies are added to), *source - input (the histogram the latencies are taken from) */
+/* Return values: nothing since it's a void function */
+/* Side effects: changes the counts of destination */
+void histogram_merge(LatencyHistogramType *destination, const LatencyHistogramType *source) {
+  if(source->total_count == 0) {
+    return;
+  }
+  if(destination->total_count == 0 || source->min < destination->min) {
+    destination->min = source->min;
+  }
+  if(source->max > destination->max) {
+    destination->max = source->max;
+  }
+  for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    destination->counts[i] += source->counts[i];
+  }
+  destination->total_count += source->total_count;
+  destination->sum += source->sum;
+}
+
+/* This function finds the latency that a percentage of the latencies counted in a histogram are lower than or equal to */
+/* Parameters: *histogram - input (the histogram), percentile - input (the percentage, like 99.9) */
+/* Return values: int64_t containing the largest value of the bucket holding that latency, never above the largest latency counted, or 0 if nothing was counted */
+/* Side effects: none */
+int64_t histogram_percentile(const LatencyHistogramType *histogram, double percentile) {
+  if(histogram->total_count == 0) {
+    return 0;
+  }
+
+  /* The latency looked for is the target-th smallest one */
+  double exact_target = percentile / 100.0 * histogram->total_count;
+  int64_t target = (int64_t)exact_target;
+  if(target < exact_target) {
+    target++;
+  }
+  if(target < 1) {
+    target = 1;
+  }
+
+  int64_t counted = 0;
+  for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    counted += histogram->counts[i];
+    if(counted >= target) {
+      int64_t value = histogram_highest_value(i);
+      return (value > histogram->max) ? histogram->max : value;
+    }
+  }
+  return histogram->max;
+}
+
+/* This function returns the next random number of a connection, every connection has its own state so no thread waits on another */
+/* Parameters: *connection - input/output (the connection containing random_state) */
+/* Return values: unsigned int containing the random number */
+/* Side effects: changes random_state */
+static unsigned int bench_random(BenchConnectionType *connection) {
+  unsigned int state = connection->random_state;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  connection->random_state = state;
+  return state;
+}
+
+/* This function sends one request picked at random, a filter query for filter_percent of them and a type query for the rest */
+/* Parameters: *connection - input/output (the connection sending the request), send_time - input (the time the latency of the request is measured from, the time it was meant to be sent at in open loop so waiting to send it is counted) */
+/* Return values: int, C_OK (0) if the request was sent and C_NOK (-1) if the socket failed */
+/* Side effects: takes a free id of the connection, writes to the socket and sets status when it fails */
+int bench_send_request(BenchConnectionType *connection, int64_t send_time) {
+  const BenchOptionsType *options = connection->options;
+  int id = connection->free_slots[--connection->number_of_free_slots];
+  int type = MESSAGE_QUERY;
+  const char *payload;
+
+  if((int)(bench_random(connection) % 100) < options->filter_percent) {
+    type = MESSAGE_FILTER;
+    payload = options->filters[bench_random(connection) % options->number_of_filters];
+  }
+  else {
+    payload = pokemon_types[bench_random(connection) % BENCH_NUMBER_OF_TYPES];
+  }
+
+  connection->send_times[id] = send_time;
+  if(send_message(connection->socket, type, id, payload, strlen(payload)) == C_NOK) {
+    connection->status = C_NOK;
+    return C_NOK;
+  }
+  return C_OK;
+}
+
+/* This function receives one response and measures the request it finishes, a result split into batches finishes with its last batch */
+/* Parameters: *connection - input/output (the connection receiving the response) */
+/* Return values: int, C_OK (0) if a response was received and C_NOK (-1) if the socket failed or the response answers no running request */
+/* Side effects: reads from the socket, gives the id of a finished request back, records its latency when it was sent during the measurement and sets status when the socket fails */
+int bench_receive_response(BenchConnectionType *connection) {
+  MessageHeaderType header;
+  char *payload = NULL;
+
+  if(receive_message(connection->socket, &header, &payload) == C_NOK || header.request_id >= BENCH_MAX_OUTSTANDING || connection->send_times[header.request_id] < 0) {
+    free(payload);
+    connection->status = C_NOK;
+    return C_NOK;
+  }
+
+  int64_t now = bench_now();
+  int is_measured = (now >= connection->start && now < connection->end);
+  int is_last = (header.type != MESSAGE_RESULT || (header.flags & RESULT_FLAG_MORE) == 0);
+
+  if(is_measured) {
+    connection->bytes += PROTOCOL_HEADER_SIZE + header.payload_length;
+    if(header.type == MESSAGE_RESULT && header.payload_length >= RESULT_COUNT_SIZE) {
+      connection->rows += protocol_read_count((const unsigned char *)payload);
+    }
+  }
+  if(is_last) {
+    int64_t send_time = connection->send_times[header.request_id];
+
+    /* The latency belongs to the measurement the request was sent in, the slowest requests are the ones still running when it ends and leaving them out would hide the tail */
+    if(send_time >= connection->start && send_time < connection->end) {
+      histogram_record(&connection->histogram, now - send_time);
+    }
+    if(is_measured) {
+      connection->requests++;
+      connection->errors += (header.type == MESSAGE_ERROR);
+    }
+    connection->send_times[header.request_id] = -1;
+    connection->free_slots[connection->number_of_free_slots++] = header.request_id;
+  }
+  free(payload);
+  return C_OK;
+}
+
+/* This function waits until a response can be read from the connection or a time is reached */
+/* Parameters: *connection - input (the connection containing the socket), until - input (the time to stop waiting at) */
+/* Return values: int, C_OK (0) if a response can be read, or the socket failed so reading it reports the failure, and C_NOK (-1) if the time was reached first */
+/* Side effects: blocks the calling thread */
+int bench_wait(BenchConnectionType *connection, int64_t until) {
+  struct pollfd socket_poll;
+  struct timespec timeout;
+  int64_t remaining = until - bench_now();
+
+  if(remaining < 0) {
+    remaining = 0;
+  }
+  timeout.tv_sec = remaining / NANOSECONDS_PER_SECOND;
+  timeout.tv_nsec = remaining % NANOSECONDS_PER_SECOND;
+  socket_poll.fd = connection->socket;
+  socket_poll.events = POLLIN;
+  return (ppoll(&socket_poll, 1, &timeout, NULL) > 0) ? C_OK : C_NOK;
+}
+
+/* This function is ran by the thread of every connection, it sends requests until the run is over and then waits for the answers of the requests still running */
+/* Parameters: *arg - input/output (void* casted parameter containing a BenchConnectionType struct) */
+/* Return values: nothing since the function is void */
+/* Side effects: writes to and reads from the socket of the connection, then closes it */
+void *bench_connection_thread(void *arg) {
+  BenchConnectionType *connection = (BenchConnectionType *)arg;
+  const BenchOptionsType *options = connection->options;
+  int64_t interval = 0;                  //Time between two requests of the connection in open loop, 0 in closed loop
+  int64_t next_send = connection->begin; //Time the next request is meant to be sent at in open loop
+
+  /* In open loop every connection sends its share of the rate, their schedules are spread out so the requests don't arrive in bursts */
+  if(options->rate > 0) {
+    interval = (int64_t)(NANOSECONDS_PER_SECOND * options->number_of_connections / options->rate);
+    if(interval < 1) {
+      interval = 1;
+    }
+    next_send += interval * connection->index / options->number_of_connections;
+  }
+
+  while(connection->status == C_OK) {
+    int64_t now = bench_now();
+    int64_t until = connection->end;
+
+    if(now >= connection->end) {
+      break;
+    }
+
+    /* Closed loop sends a request as soon as one finishes, open loop sends every request due no matter how many are running */
+    if(interval == 0) {
+      while(connection->status == C_OK && BENCH_MAX_OUTSTANDING - connection->number_of_free_slots < options->depth) {
+        bench_send_request(connection, now);
+      }
+    }
+    else {
+      while(connection->status == C_OK && next_send <= now && connection->number_of_free_slots > 0) {
+        bench_send_request(connection, next_send);
+        next_send += interval;
+      }
+      if(connection->number_of_free_slots > 0 && next_send < until) {
+        until = next_send;
+      }
+    }
+
+    if(connection->status == C_OK && bench_wait(connection, until) == C_OK) {
+      bench_receive_response(connection);
+    }
+  }
+
+  /* Wait a little for the requests still running, so the server isn't answering a closed socket */
+  int64_t drain_end = connection->end + BENCH_DRAIN_SECONDS * NANOSECONDS_PER_SECOND;
+  while(connection->status == C_OK && connection->number_of_free_slots < BENCH_MAX_OUTSTANDING && bench_wait(connection, drain_end) == C_OK) {
+    bench_receive_response(connection);
+  }
+
+  /* Requests of the measurement still running now have no latency to record, they are reported instead of silently left out */
+  for(int id = 0; id < BENCH_MAX_OUTSTANDING; id++) {
+    if(connection->send_times[id] >= connection->start && connection->send_times[id] < connection->end) {
+      connection->unanswered++;
+    }
+  }
+
+  send_message(connection->socket, MESSAGE_STOP, 0, NULL, 0);
+  close(connection->socket);
+  return NULL;
+}
+
+/* This function prints the throughput and the latencies measured by every connection together */
+/* Parameters: *options - input (the options of the run), *connections - input (every connection of the run) */
+/* Return values: nothing since it's a void function */
+/* Side effects: prints to the terminal, allocates memory for the merged histogram, exits the program if it can't be allocated */
+void print_report(const BenchOptionsType *options, BenchConnectionType *connections) {
+  LatencyHistogramType *histogram = (LatencyHistogramType *)calloc(1, sizeof(LatencyHistogramType));
+  long requests = 0, errors = 0, rows = 0, bytes = 0, unanswered = 0;
+  static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(histogram == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < options->number_of_connections; i++) {
+    histogram_merge(histogram, &connections[i].histogram);
+    requests += connections[i].requests;
+    errors += connections[i].errors;
+    rows += connections[i].rows;
+    bytes += connections[i].bytes;
+    unanswered += connections[i].unanswered;
+  }
+
+  if(options->rate > 0) {
+    printf("Open loop: %d connections sending %.1f requests per second on schedule", options->number_of_connections, options->rate);
+  }
+  else {
+    printf("Closed loop: %d connections keeping %d request(s) running each", options->number_of_connections, options->depth);
+  }
+  printf(", %d%% filter queries, measured for %d seconds after %d seconds of warmup \n", options->filter_percent, options->seconds, options->warmup_seconds);
+  printf("Requests:  %ld answered, %ld errors, %.1f per second \n", requests, errors, (double)requests / options->seconds);
+  printf("Received:  %ld pokemon (%.1f per second), %.2f MB per second \n", rows, (double)rows / options->seconds, (double)bytes / options->seconds / (1024 * 1024));
+  if(unanswered > 0) {
+    printf("Unanswered: %ld requests sent during the measurement got no answer within %d seconds, their latency is missing below \n", unanswered, BENCH_DRAIN_SECONDS);
+  }
+  printf("Latency:   min %.1f us, mean %.1f us, max %.1f us \n", histogram->min / 1000.0, (histogram->total_count > 0) ? (double)histogram->sum / histogram->total_count / 1000.0 : 0.0, histogram->max / 1000.0);
+  for(int i = 0; i < (int)(sizeof(percentiles) / sizeof(percentiles[0])); i++) {
+    printf("           p%-6g %.1f us \n", percentiles[i], histogram_percentile(histogram, percentiles[i]) / 1000.0);
+  }
+  free(histogram);
+}
+
+/* This function is the function that is ran when the bench.c program is first started */
+/* Parameters: argc - input (the amount of command line arguments), *argv[] - input (the command line arguments, see the top of the file) */
+/* Return values: int, 0 if every connection worked until the end of the run and 1 if one failed */
+/* Side effects: opens a connection per thread to the server, creates and runs the threads, prints the results */
+int main(int argc, char *argv[]) {
+  BenchOptionsType options;           //Options of the run
+  BenchConnectionType *connections;   //Every connection of the run
+  struct sockaddr_in server_address;  //Address of the server the connections are opened to
+  int option;                         //Command line option being read
+  int result = 0;                     //Value returned by the program
+
+  memset(&options, 0, sizeof(options));
+  options.number_of_connections = BENCH_DEFAULT_CONNECTIONS;
+  options.depth = BENCH_DEFAULT_DEPTH;
+  options.seconds = BENCH_DEFAULT_SECONDS;
+  options.warmup_seconds = BENCH_DEFAULT_WARMUP_SECONDS;
+  options.filter_percent = BENCH_DEFAULT_FILTER_PERCENT;
+
+  /* Read the command line options */
+  while((option = getopt(argc, argv, "c:p:d:w:r:f:q:")) != -1) {
+    if(option == 'c' && atoi(optarg) > 0 && atoi(optarg) <= BENCH_MAX_CONNECTIONS) {
+      options.number_of_connections = atoi(optarg);
+    }
+    else if(option == 'p' && atoi(optarg) > 0 && atoi(optarg) <= BENCH_MAX_OUTSTANDING) {
+      options.depth = atoi(optarg);
+    }
+    else if(option == 'd' && atoi(optarg) > 0) {
+      options.seconds = atoi(optarg);
+    }
+    else if(option == 'w' && atoi(optarg) >= 0) {
+      options.warmup_seconds = atoi(optarg);
+    }
+    else if(option == 'r' && atof(optarg) >= 0) {
+      options.rate = atof(optarg);
+    }
+    else if(option == 'f' && atoi(optarg) >= 0 && atoi(optarg) <= 100) {
+      options.filter_percent = atoi(optarg);
+    }
+    else if(option == 'q' && options.number_of_filters < BENCH_MAX_FILTERS) {
+      options.filters[options.number_of_filters++] = optarg;
+    }
+    else {
+      printf("Usage: %s [-c connections] [-p requests_running_per_connection] [-d seconds] [-w warmup_seconds] [-r requests_per_second] [-f filter_percent] [-q filter_query]... \n", argv[0]);
+      printf("Without -r every connection keeps its requests running (closed loop), with -r the requests are sent on schedule (open loop) and their latency counts from the time they were due \n");
+      exit(1);
+    }
+  }
+  if(options.number_of_filters == 0) {
+    for(int i = 0; i < (int)(sizeof(default_filters) / sizeof(default_filters[0])); i++) {
+      options.filters[options.number_of_filters++] = default_filters[i];
+    }
+  }
+
+  connections = (BenchConnectionType *)calloc(options.number_of_connections, sizeof(BenchConnectionType));
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(connections == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* A connection closed by the server is reported by its thread instead of ending the program */
+  signal(SIGPIPE, SIG_IGN);
+
+  // Setup the address of the server
+  memset(&server_address, 0, sizeof(server_address));
+  server_address.sin_family = AF_INET;
+  server_address.sin_addr.s_addr = inet_addr(SERVER_IP);
+  server_address.sin_port = htons((unsigned short) SERVER_PORT);
+
+  /* Open every connection before the load starts, so connecting is never measured */
+  for(int i = 0; i < options.number_of_connections; i++) {
+    connections[i].socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(connections[i].socket < 0 || connect(connections[i].socket, (struct sockaddr *) &server_address, sizeof(server_address)) < 0) {
+      printf("Unable to establish connection %d to the PPS! \n", i + 1);
+      exit(1);
+    }
+    connections[i].index = i;
+    connections[i].options = &options;
+    connections[i].random_state = 2654435761u * (i + 1);
+    connections[i].status = C_OK;
+    for(int j = 0; j < BENCH_MAX_OUTSTANDING; j++) {
+      connections[i].send_times[j] = -1;
+      connections[i].free_slots[j] = BENCH_MAX_OUTSTANDING - 1 - j;
+    }
+    connections[i].number_of_free_slots = BENCH_MAX_OUTSTANDING;
+  }
+
+  int64_t begin = bench_now();
+  for(int i = 0; i < options.number_of_connections; i++) {
+    connections[i].begin = begin;
+    connections[i].start = begin + options.warmup_seconds * NANOSECONDS_PER_SECOND;
+    connections[i].end = connections[i].start + options.seconds * NANOSECONDS_PER_SECOND;
+    if(pthread_create(&connections[i].thread, NULL, bench_connection_thread, (void *)&connections[i]) != 0) {
+      printf("Unable to create the thread of connection %d \n", i + 1);
+      exit(1);
+    }
+  }
+
+  for(int i = 0; i < options.number_of_connections; i++) {
+    pthread_join(connections[i].thread, NULL);
+    if(connections[i].status == C_NOK) {
+      printf("Connection %d failed before the end of the run, its requests after the failure are missing \n", i + 1);
+      result = 1;
+    }
+  }
+
+  print_report(&options, connections);
+  free(connections);
+  return result;
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************/
+/* */
+/* bench.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the bench.c file */
+/* How to use: use #include "bench.h" at the top of any .c files that need to generate load against the server or record latencies */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef BENCH_H_
+#define BENCH_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+#include <pthread.h>
+
+//importing the header file of the protocol used to talk to the server
+#include "protocol.h"
+
+//Variety of constants defined
+#define BENCH_DEFAULT_CONNECTIONS 4       //Constant to represent the amount of connections, each driven by its own thread, opened when the user does not choose one
+#define BENCH_DEFAULT_DEPTH 1             //Constant to represent the amount of requests a connection keeps running at once in closed loop when the user does not choose one
+#define BENCH_DEFAULT_SECONDS 10          //Constant to represent the amount of seconds measured when the user does not choose one
+#define BENCH_DEFAULT_WARMUP_SECONDS 1    //Constant to represent the amount of seconds the load runs before anything is measured when the user does not choose one
+#define BENCH_DEFAULT_FILTER_PERCENT 20   //Constant to represent the percentage of requests sent as filter queries instead of type queries when the user does not choose one
+#define BENCH_MAX_CONNECTIONS 1024        //Constant to represent the most connections one run can open
+#define BENCH_MAX_OUTSTANDING MAX_PENDING_REQUESTS_PER_CONNECTION //Constant to represent the most requests a connection can have sent without their answer, the id of a request is the slot holding its send time. The server only runs this many per connection, the ones past it would wait unread inside the server and their wait would be counted as its latency
+#define BENCH_MAX_FILTERS 64              //Constant to represent the most filter queries the user can give
+#define BENCH_DRAIN_SECONDS 5             //Constant to represent the amount of seconds a connection waits for its last answers once the run is over
+#define BENCH_NUMBER_OF_TYPES 18          //Constant to represent the amount of pokemon types sent as type queries
+#define NANOSECONDS_PER_SECOND 1000000000LL //Constant to represent the amount of nanoseconds in a second
+#define HISTOGRAM_SUB_BUCKET_BITS 8       //Constant to represent the amount of bits of a latency kept exact, every value is recorded within 1/128 of itself
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS) //Constant to represent the amount of values recorded exactly, from 0 to HISTOGRAM_SUB_BUCKETS - 1 nanoseconds
+#define HISTOGRAM_HALF_SUB_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2) //Constant to represent the amount of counts every power of two above HISTOGRAM_SUB_BUCKETS is split into
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_BUCKETS + (64 - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_HALF_SUB_BUCKETS) //Constant to represent the amount of counts needed to record any 64-bit value
+
+/* This structure contains a histogram of latencies in nanoseconds, counts are exact for small values and split every power of two into HISTOGRAM_HALF_SUB_BUCKETS above them, like an HdrHistogram */
+typedef struct LatencyHistogram {
+  int64_t counts[HISTOGRAM_BUCKETS]; //Amount of latencies recorded inside every bucket
+  int64_t total_count;              //Amount of latencies recorded
+  int64_t min;                      //Smallest latency recorded
+  int64_t max;                      //Largest latency recorded
+  int64_t sum;                      //Sum of every latency recorded, used for the mean
+} LatencyHistogramType;
+
+/* This structure contains every option of a run, read from the command line */
+typedef struct BenchOptions {
+  int number_of_connections;        //Amount of connections opened, each driven by its own thread
+  int depth;                        //Amount of requests every connection keeps running at once in closed loop
+  int seconds;                      //Amount of seconds measured
+  int warmup_seconds;               //Amount of seconds the load runs before anything is measured
+  double rate;                      //Requests per second sent on schedule by all connections together in open loop, 0 for closed loop
+  int filter_percent;               //Percentage of requests sent as filter queries
+  const char *filters[BENCH_MAX_FILTERS]; //Filter queries picked from at random
+  int number_of_filters;            //Amount of filter queries inside filters
+} BenchOptionsType;
+
+/* This structure contains everything one thread needs to drive its connection and what it measured */
+typedef struct BenchConnection {
+  pthread_t thread;                 //Thread driving the connection
+  int socket;                       //Socket connected to the server
+  int index;                        //Index of the connection, used to seed its random numbers and spread its schedule
+  const BenchOptionsType *options;  //Options of the run
+  int64_t begin;                    //Time the load starts at
+  int64_t start;                    //Time the measurement starts at, after the warmup
+  int64_t end;                      //Time the measurement ends at and no more requests are sent
+  int64_t send_times[BENCH_MAX_OUTSTANDING]; //Time every running request was sent at, or was meant to be sent at in open loop, indexed by its id
+  int free_slots[BENCH_MAX_OUTSTANDING]; //Ids of send_times that are not used by a running request
+  int number_of_free_slots;         //Amount of ids inside free_slots
+  unsigned int random_state;        //State of the random numbers choosing every request
+  LatencyHistogramType histogram;   //Latency of every request sent during the measurement, even the ones answered after it ended
+  long unanswered;                  //Amount of requests sent during the measurement that were not answered before the connection stopped waiting
+  long requests;                    //Amount of requests answered during the measurement
+  long errors;                      //Amount of those requests answered with an error
+  long rows;                        //Amount of pokemon received during the measurement
+  long bytes;                       //Amount of bytes received during the measurement
+  int status;                       //C_OK while the connection works, C_NOK once it failed
+} BenchConnectionType;
+
+/* all function prototypes for functions in bench.c */
+int64_t bench_now(void);
+void histogram_record(LatencyHistogramType *histogram, int64_t value);
+void histogram_merge(LatencyHistogramType *destination, const LatencyHistogramType *source);
+int64_t histogram_percentile(const LatencyHistogramType *histogram, double percentile);
+int bench_send_request(BenchConnectionType *connection, int64_t send_time);
+int bench_receive_response(BenchConnectionType *connection);
+int bench_wait(BenchConnectionType *connection, int64_t until);
+void *bench_connection_thread(void *arg);
+void print_report(const BenchOptionsType *options, BenchConnectionType *connections);
+
+#endif //end of header file
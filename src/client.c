@@ -14,12 +14,15 @@
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
 //importing the header file included with the program to get access to its functions, constants and structs
 #include "client.h"
+#include "dynamic_array.h"
+#include "export.h"
 
 /* This function is the function that is ran when the client.c program is first started */
 /* Parameters: None */
@@ -36,14 +39,17 @@ int main() {
   char *type_choice = NULL;             //Pokemon type received from user
   char *user_file_name_choice = NULL;   //File name to save to recieved from the user 
 
-  /* Two threads, one to do reading operations and one to do saving operations */
-  pthread_t read_thread;
+  /* The thread doing saving operations, the responses of the server are read by the receive_thread inside extra_pokemon_data */
   pthread_t save_thread;
+  char save_thread_was_started = C_NOK; //Char representing whether save_thread was started and not joined yet
 
   /* The variable that contains the dynamic array but also all other properties to read files and write to files*/
   DynamicArrayType *dynamic_array = NULL;
   dynamic_array = (DynamicArrayType*)malloc(sizeof(DynamicArrayType)); /* Allocating memories to the dynamic_array*/
 
+  /* Messages of the receive and save threads are written by their own thread, so receiving responses never waits for the terminal */
+  logger_start(stdout);
+
   /* Check if memory is allocated properly, print error message and exit if not */
   if(dynamic_array == NULL) {
     printf("An error occured while allocating memory. The program will now exit \n");
@@ -52,7 +58,10 @@ int main() {
 
   /* Initializing the three elements of the DynamicArrayType struct to default values */
   dynamic_array->darray_size = 0;
+  dynamic_array->darray_capacity = 0;
   dynamic_array->darray_elements = NULL;
+  dynamic_array->saved_elements = NULL;
+  memset(&dynamic_array->strings, 0, sizeof(StringArenaType));
   dynamic_array->extra_pokemon_data = NULL;
   
   /* Allocating memory for the struct that will hold the additional data of the dynamic array including information needed to manipulate threads, read from files and save to files. */
@@ -68,17 +77,19 @@ int main() {
   dynamic_array->extra_pokemon_data->number_of_pokemon_sucesfully_saved = 0;
   dynamic_array->extra_pokemon_data->number_of_saved_files = 0;
   dynamic_array->extra_pokemon_data->number_of_successful_queries = 0;
-  dynamic_array->extra_pokemon_data->curr_type_being_read = 0;
   dynamic_array->extra_pokemon_data->all_types_being_read_size = 0;
   dynamic_array->extra_pokemon_data->all_types_being_read = NULL;
   dynamic_array->extra_pokemon_data->all_file_names = NULL;
+  dynamic_array->extra_pokemon_data->rows_saved_to_file = NULL;
   dynamic_array->extra_pokemon_data->name_of_saved_file = NULL;
-  dynamic_array->extra_pokemon_data->thread_is_paused = C_NOK;
-  dynamic_array->extra_pokemon_data->thread_is_running = C_NOK;
+  dynamic_array->extra_pokemon_data->receive_thread_is_running = C_NOK;
+  dynamic_array->extra_pokemon_data->pending_requests = NULL;
+  dynamic_array->extra_pokemon_data->number_of_pending_requests = 0;
 
   /* Initializing the mutex and cond variables */
   pthread_mutex_init(&dynamic_array->extra_pokemon_data->mutex, NULL);
-  pthread_cond_init(&dynamic_array->extra_pokemon_data->cond, NULL);
+  pthread_mutex_init(&dynamic_array->extra_pokemon_data->pending_mutex, NULL);
+  pthread_cond_init(&dynamic_array->extra_pokemon_data->pending_cond, NULL);
 
   /* Allocating memory to the pointer that will contain all the types that will be read */
   dynamic_array->extra_pokemon_data->all_types_being_read = (char **)malloc(sizeof(char *) *(dynamic_array->extra_pokemon_data->all_types_being_read_size + 1));
@@ -122,11 +133,18 @@ int main() {
   // Set the client_socket property of the dynamic_array to contain the socket the client connected to
   dynamic_array->extra_pokemon_data->client_socket = clientSocket;
 
+  /* Create the thread that receives every response of the server and hands it to the request it answers */
+  dynamic_array->extra_pokemon_data->receive_thread_is_running = C_OK;
+  if(pthread_create(&dynamic_array->extra_pokemon_data->receive_thread, NULL, receive_pokemon, (void *)dynamic_array) != 0) {
+    printf("*** CLIENT ERROR: Could not start the thread receiving responses.\n");
+    exit(-1);
+  }
+
   /* Loop forever until the user tells the program they want to quit */
   while (1) {
 
      /* Print the menu of options to the user and get the input of which options the user wants to do */
-    printf("What do you want to do? Here are the following options: \n a. Type search \n b. Save results \n c. Exit the program \n");
+    printf("What do you want to do? Here are the following options: \n a. Type search \n b. Save results \n c. Exit the program \n d. Filter search \n e. Statistics \n f. Server counters \n g. Reload the pokemon file on the server \n h. Change pokemon on the server \n i. Server metrics \n");
     scanf("%ms", &gamer_choice);
 
     /* If the user selects option a */
@@ -145,48 +163,137 @@ int main() {
           continue;
       }
 
-      /* Check whether this is not the first pokemon to be stored inside all_types_being_read */
-      /* if not, reallocate more space for all_types_being_read to handle a new type being added to the array */
-      if(dynamic_array->extra_pokemon_data->curr_type_being_read > 0) {
-          dynamic_array->extra_pokemon_data->all_types_being_read = realloc(dynamic_array->extra_pokemon_data->all_types_being_read, sizeof(char *) * (dynamic_array->extra_pokemon_data->all_types_being_read_size + 1));
+      /* Remember the type, its index inside all_types_being_read is used as the id of the request */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, type_choice);
 
-          /* Check if memory is allocated properly, print error message and exit if not */
-          if(dynamic_array->extra_pokemon_data->all_types_being_read == NULL) {
-            printf("An error occured while allocating memory. The program will now exit \n");
-            return C_NOK;
-          }
+      /* Send the request without waiting for its answer, the receive thread adds the pokemon once the server answers so many requests can be running at once */
+      if(read_pokemon(dynamic_array, MESSAGE_QUERY, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send pokemon type to server \n");
+        exit(EXIT_FAILURE);
       }
+    }
+    /* If the user selects the filter search option */
+    else if(strcmp(gamer_choice, "d") == 0) {
+      /* Free the memory allocated to the gamer_choice variable and type_choice variable if they have memory allocated to them*/
+      free_char_pointer(&gamer_choice);
+      free_char_pointer(&type_choice);
 
-      /* Allocate space inside all_tyeps_being_read to store the pokemon_type */
-      dynamic_array->extra_pokemon_data->all_types_being_read[dynamic_array->extra_pokemon_data->all_types_being_read_size] = malloc(sizeof(char) * (strlen(type_choice) + 1));
+      /* Get the whole line of conditions the pokemon have to match, the server checks the conditions and answers with an error if one is invalid */
+      printf("Enter the conditions to search for separated by spaces, for example: type=Water speed>=100 generation<=3 legendary=false name^=Char \n");
+      scanf(" %m[^\n]", &type_choice);
+      if(type_choice == NULL) {
+        printf("Invalid conditions. Please enter at least one condition. \n");
+        continue;
+      }
 
-      /* Check if memory is allocated properly, print error message and exit if not */
-      if(dynamic_array->extra_pokemon_data->all_types_being_read[dynamic_array->extra_pokemon_data->all_types_being_read_size] == NULL) {
-        printf("An error occured while allocating memory. The program will now exit \n");
-        return C_NOK;
+      /* Remember the query, its index inside all_types_being_read is used as the id of the request */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, type_choice);
+
+      /* Send the query without waiting for its answer, it is answered like a type search */
+      if(read_pokemon(dynamic_array, MESSAGE_FILTER, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send query to server \n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    /* If the user selects the statistics option */
+    else if(strcmp(gamer_choice, "e") == 0) {
+      /* Free the memory allocated to the gamer_choice variable and type_choice variable if they have memory allocated to them*/
+      free_char_pointer(&gamer_choice);
+      free_char_pointer(&type_choice);
+
+      /* Get the whole request, the statistics are computed by the server so no pokemon has to be downloaded */
+      printf("Enter the stat to compute statistics of, how to group the pokemon and which pokemon to use, for example: attack by type where generation<=3 \n");
+      scanf(" %m[^\n]", &type_choice);
+      if(type_choice == NULL) {
+        printf("Invalid request. Please enter at least a stat. \n");
+        continue;
       }
 
-      /* Copy the pokemon type the user inputted to the all_types_being_read double char pointer */
-      strcpy(dynamic_array->extra_pokemon_data->all_types_being_read[dynamic_array->extra_pokemon_data->all_types_being_read_size], type_choice);
-      dynamic_array->extra_pokemon_data->all_types_being_read_size++; // Increment the size counter for the all_types_being_read variable by 1 
+      /* Remember the request, its index inside all_types_being_read is used as the id of the request */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, type_choice);
 
-      /* Check if a thread has already been ran, if it is, join the thread so it frees up the thread resources and stops memory leaks from occuring */
-      if(dynamic_array->extra_pokemon_data->all_types_being_read_size > 0 && dynamic_array->extra_pokemon_data->number_of_successful_queries > 0 && dynamic_array->extra_pokemon_data->thread_is_running == C_NOK) {
-        pthread_join(read_thread, NULL);
+      /* Send the request without waiting for its answer, the receive thread prints the statistics once the server answers */
+      if(read_pokemon(dynamic_array, MESSAGE_AGGREGATE, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send request to server \n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    /* If the user selects the server counters option */
+    else if(strcmp(gamer_choice, "f") == 0) {
+      free_char_pointer(&gamer_choice);
+
+      /* The request has no payload, an empty entry inside all_types_being_read still gives it an id */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, "");
+      if(read_pokemon(dynamic_array, MESSAGE_STATS, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send request to server \n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    /* If the user selects the server metrics option */
+    else if(strcmp(gamer_choice, "i") == 0) {
+      free_char_pointer(&gamer_choice);
+
+      /* The request has no payload, the server answers with the latency of every stage of its requests in the Prometheus text format */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, "");
+      if(read_pokemon(dynamic_array, MESSAGE_METRICS, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send request to server \n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    /* If the user selects the reload option */
+    else if(strcmp(gamer_choice, "g") == 0) {
+      free_char_pointer(&gamer_choice);
+
+      /* The request has no payload, the server reads the pokemon file again while it keeps answering with the previous version */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, "");
+      if(read_pokemon(dynamic_array, MESSAGE_RELOAD, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send request to server \n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    /* If the user selects the change option */
+    else if(strcmp(gamer_choice, "h") == 0) {
+      /* Free the memory allocated to the gamer_choice variable and type_choice variable if they have memory allocated to them*/
+      free_char_pointer(&gamer_choice);
+      free_char_pointer(&type_choice);
+
+      /* Get every change on one line, the server applies all of them or none and answers with an error if one is invalid */
+      printf("Enter the changes separated by semicolons, for example: insert 9001,Sparkmon,Electric,,500,80,90,70,100,80,80,9,False; delete Pikachu \n");
+      scanf(" %m[^\n]", &type_choice);
+      if(type_choice == NULL) {
+        printf("Invalid changes. Please enter at least one change. \n");
+        continue;
+      }
+
+      /* The server expects one change per line */
+      for(char *separator = strchr(type_choice, ';'); separator != NULL; separator = strchr(separator + 1, ';')) {
+        *separator = '\n';
+      }
+
+      /* Remember the changes, their index inside all_types_being_read is used as the id of the request */
+      unsigned int request_id = add_type_being_read(dynamic_array->extra_pokemon_data, type_choice);
+
+      /* Send the changes without waiting for their answer, the receive thread prints it once the server logged them */
+      if(read_pokemon(dynamic_array, MESSAGE_CHANGE, request_id) == C_NOK) {
+        printf("SERVER ERROR: Failed to send changes to server \n");
+        exit(EXIT_FAILURE);
       }
-      
-      /* Create a thread to handle the reading operations with the server */
-      pthread_create(&read_thread, NULL, read_pokemon, (void*)dynamic_array);
     }
     /* If the user selected the saving operation */
     else if(strcmp(gamer_choice, "b") == 0) {
 
+      /* Wait for the previous save before reusing the file name it writes to, it only formats and writes the pokemon that are new to its file so it finishes quickly */
+      if(save_thread_was_started == C_OK) {
+        pthread_join(save_thread, NULL);
+        save_thread_was_started = C_NOK;
+      }
+
       /* Free the memory allocated to the gamer_choice variable and user_file_name_choice variable if they have memory allocated to them*/
       free_char_pointer(&gamer_choice);
       free_char_pointer(&user_file_name_choice);
 
       /* Stop the user from saving data if they haven't read any data into the program*/
-      if(dynamic_array->extra_pokemon_data->number_of_successful_queries == 0) {
+      if(__atomic_load_n(&dynamic_array->extra_pokemon_data->number_of_successful_queries, __ATOMIC_RELAXED) == 0) {
           printf("No queries have been completed yet so there is nothing to save. Wait for a query to finish. \n");
           continue;
       }
@@ -205,39 +312,63 @@ int main() {
           continue;
         }
 
-        /* Try to open a file with the name the user entered, if it doesn't open properly, get a new file name from the user and continue looping */
-        FILE *temporary_file = fopen(user_file_name_choice, "a");
-        if(!temporary_file) {
+        /* Try to open a file with the name the user entered, if it doesn't open properly, get a new file name from the user and continue looping. Binary columns are only moved over the chosen file once they are complete, so their temporary file is created instead and removed right away */
+        int file_can_be_written = C_NOK;
+        if(export_format(user_file_name_choice) == EXPORT_COLUMNS) {
+          char *temporary_name = (char *)malloc(strlen(user_file_name_choice) + strlen(EXPORT_COLUMNS_TEMPORARY_SUFFIX) + 1);
+
+          /* Check if memory is allocated properly, print error message and exit if not */
+          if(temporary_name == NULL) {
+            printf("An error occured while allocating memory. The program will now exit \n");
+            exit(EXIT_FAILURE);
+          }
+          sprintf(temporary_name, "%s%s", user_file_name_choice, EXPORT_COLUMNS_TEMPORARY_SUFFIX);
+          int temporary_fd = open(temporary_name, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+          if(temporary_fd >= 0) {
+            close(temporary_fd);
+            unlink(temporary_name);
+            file_can_be_written = C_OK;
+          }
+          free(temporary_name);
+        }
+        else {
+          FILE *temporary_file = fopen(user_file_name_choice, "a");
+          if(temporary_file) {
+            fclose(temporary_file); //Close the temporary file
+            file_can_be_written = C_OK;
+          }
+        }
+        if(file_can_be_written == C_NOK) {
           printf("Unable to create the new file. Please enter the name of the file again \n");
           free_char_pointer(&user_file_name_choice);
           scanf("%ms", &user_file_name_choice);
           continue;
         }
-        fclose(temporary_file); //Close the temporary file
         break;                  //Break out of the loop
       }
 
       /* Store the file name the user inputted inside the extra_pokemon_data struct */
       dynamic_array->extra_pokemon_data->name_of_saved_file = user_file_name_choice;
 
-      /* Check if a thread has already been ran, if it is, join the thread so it frees up the thread resources and stops memory leaks from occuring */
-      if(dynamic_array->extra_pokemon_data->number_of_saved_files > 0 && dynamic_array->extra_pokemon_data->thread_is_paused == C_NOK) {
-        pthread_join(save_thread, NULL);
-      }
-
       /* Create a thread to handle the saving operations to the disk */
-      pthread_create(&save_thread, NULL, write_pokemon, (void *)dynamic_array);
+      if(pthread_create(&save_thread, NULL, write_pokemon, (void *)dynamic_array) == 0) {
+        save_thread_was_started = C_OK;
+      }
     }
     /* If the user selects the exit the program option */
     else if(strcmp(gamer_choice, "c") == 0) {
       
-      /* Check if the read and save thread have been running and are finished, and join the threads to free up their resources and to avoid memory leaks */
-      if(dynamic_array->extra_pokemon_data->all_types_being_read_size > 0 && dynamic_array->extra_pokemon_data->number_of_successful_queries > 0 && dynamic_array->extra_pokemon_data->thread_is_running == C_OK) {
-        pthread_cancel(read_thread);
-      }
-      if(dynamic_array->extra_pokemon_data->number_of_saved_files > 0) {
+      /* Wait for the save thread and for the answers of every request that was already sent so they are counted in the final information */
+      if(save_thread_was_started == C_OK) {
         pthread_join(save_thread, NULL);
+        save_thread_was_started = C_NOK;
       }
+      wait_for_pending_requests(dynamic_array->extra_pokemon_data);
+
+      /* Send a stop message to the server to indicate that this client is disconnecting, then wake the receive thread up by shutting the socket down and join it */
+      send_client_message(dynamic_array->extra_pokemon_data, MESSAGE_STOP, 0, NULL, 0);
+      shutdown(clientSocket, SHUT_RDWR);
+      pthread_join(dynamic_array->extra_pokemon_data->receive_thread, NULL);
 
       /* Print the information about queries and files listed in Use Case 4 with the print_final_information function */
       print_final_information(dynamic_array);
@@ -263,34 +394,26 @@ int main() {
       /* Free the double char pointer, all_types_being_read */
       free(dynamic_array->extra_pokemon_data->all_types_being_read);
 
-      /* Freeing the memory associated with the dynamic array inside dynamic_array if the user read at least one pokemon */
-      if(dynamic_array->darray_size != 0) {
-        for (int i=0; i<dynamic_array->darray_size; ++i) {
-          free(dynamic_array->darray_elements[i]->name);
-          free(dynamic_array->darray_elements[i]->first_type);
-          free(dynamic_array->darray_elements[i]->second_type);
-          free(dynamic_array->darray_elements[i]);
-        }
-        free(dynamic_array->darray_elements);
-      }
+      /* Freeing the dynamic array and every block its strings point into, all at once */
+      free(dynamic_array->darray_elements);
+      string_arena_free(&dynamic_array->strings);
 
-      /* Destroy the mutex and cond variable  */
+      /* Destroy the mutex and cond variables  */
       if(pthread_mutex_destroy(&dynamic_array->extra_pokemon_data->mutex) != 0) {
         printf("An error occured while destroying the mutex. The program will now exit \n");
         return C_NOK;
       }
-      if(pthread_cond_destroy(&dynamic_array->extra_pokemon_data->cond) != 0) {
-        printf("An error occured while destroying the condition variable. The program will now exit \n");
-        return C_NOK;
-      }
+      pthread_mutex_destroy(&dynamic_array->extra_pokemon_data->pending_mutex);
+      pthread_cond_destroy(&dynamic_array->extra_pokemon_data->pending_cond);
       /* Free the all_file_names double pointer, then free the extra_pokemon_data struct and then free the DynamicArrayType struct itself */
       free(dynamic_array->extra_pokemon_data->all_file_names);
+      free(dynamic_array->extra_pokemon_data->rows_saved_to_file);
       free(dynamic_array->extra_pokemon_data);
       free(dynamic_array);
 
-      send(clientSocket, "stop", sizeof("stop"), 0);  //Send a stop message to the server to indicate that the server should shut down
       close(clientSocket);                            //Close the socket connecting to the server
-      printf("CLIENT: Shutting down.\n");             //Print a message recognizing the client program is shutting down
+      LOG_INFO("Shutting down.");                     //Log a message recognizing the client program is shutting down
+      logger_stop();                                  //Write every message left, the writer thread would keep the program running otherwise
       pthread_exit(NULL);                             //Quit the program
     }
     /* If the user inputted an invalid input, print a message and then return them to the loop where the menu sisi printed again */
@@ -314,230 +437,285 @@ void free_char_pointer(char **char_pointer) {
   }
 }
 
-/* This function checks if a input string matches the name of a pokemon type */
-/* Parameters: *input_type - input (the char pointer that is being checked) */
-/* Return values: int, return C_OK (0) if input_type is a valid pokemon type, return C_NOK (-1) if input_type is not a valid pokemon type */
-/* Side effects: lots of conditional checking */
-int check_valid_pokemon_type(char *input_type) {
-
-  /* Use strcmp to compare to all valid pokemon types according to the Pokemon franchise */
-  if (strcmp(input_type, "Normal") == 0 || strcmp(input_type, "Fire") == 0 || strcmp(input_type, "Water") == 0 || strcmp(input_type, "Grass") == 0 || strcmp(input_type, "Electric") == 0 || strcmp(input_type, "Ice") == 0 || strcmp(input_type, "Fighting") == 0 || strcmp(input_type, "Poison") == 0 || strcmp(input_type, "Ground") == 0 || strcmp(input_type, "Flying") == 0 || strcmp(input_type, "Psychic") == 0 || strcmp(input_type, "Bug") == 0 || strcmp(input_type, "Rock") == 0 || strcmp(input_type, "Ghost") == 0 || strcmp(input_type, "Dragon") == 0 || strcmp(input_type, "Dark") == 0 || strcmp(input_type, "Steel") == 0 || strcmp(input_type, "Fairy") == 0) {
-    return C_OK;
-  }
-  return C_NOK;
+/* This function sends one whole message to the server. Only the main thread sends messages, the save thread never talks to the server, so no lock is needed to keep messages from being mixed together on the socket */
+/* Parameters: *extra_pokemon_data - input/output (the struct containing the socket), type - input (the type of the message), request_id - input (the id of the request the message belongs to), *payload - input (the payload, can be NULL if payload_length is 0), payload_length - input (the amount of bytes inside payload) */
+/* Return values: int, C_OK (0) if the message was sent and C_NOK (-1) if the socket failed */
+/* Side effects: writes to the socket, blocks while the server is not reading the requests of this client */
+int send_client_message(ExpandedThreadType *extra_pokemon_data, int type, unsigned int request_id, const void *payload, unsigned int payload_length) {
+  return send_message(extra_pokemon_data->client_socket, type, request_id, payload, payload_length);
 }
 
-/* This function handles the reading operations for pokemon of a certain type through communication with a server and stores them inside a dynamic array */
-/* NOTE: This function is primarily copied from the function read_students from ReadCSV.c from the Professor's Sample Code */
-/* Parameters: *arg - input/output (void* casted parameter containing a DynamicArrayType struct) */
-/* Return values: nothing since the function is void  */
-/* Side effects: uses socket functions to communicate with the server, uses mutex and cond to pause/unpause the thread running this function */
-void *read_pokemon(void *arg) {
-
-  DynamicArrayType *dynamic_array = (DynamicArrayType *)arg; //variable containing the DynamicArrayType variable which is passed into the function as a void*
-  char buffer[MAX_MESSAGE_BUFFER_SIZE]; //variable containing the buffer that is used to get the number of bytes of the pokemon message being sent from the server
-  int bytesReceived = 0;                //variable that contains the return value of the recv function 
- 
-  /* Check if the mutex has been locked properly, print error message and exit program if not */
-  if(pthread_mutex_lock(&dynamic_array->extra_pokemon_data->mutex) != 0) {
-      printf("\n The mutex lock operation has failed\n");
-      exit(EXIT_FAILURE);
-  }
-  /* Make the thread idle waiting if the mutex_passing_condition is not met */
-  while(dynamic_array->extra_pokemon_data->thread_is_paused == C_OK) {
-    pthread_cond_wait(&dynamic_array->extra_pokemon_data->cond, &dynamic_array->extra_pokemon_data->mutex);
-  }
-
-  /* Set the thread_is_running variable to C_OK to indicate that the thread running the read_pokemon function is working */
-  dynamic_array->extra_pokemon_data->thread_is_running = C_OK;
+/* This function adds a pokemon type or a filter query to the list of everything read from the server during the session */
+/* Parameters: *extra_pokemon_data - input/output (the struct containing all_types_being_read), *type - input (the type or query being added) */
+/* Return values: unsigned int containing the index of the type inside all_types_being_read */
+/* Side effects: reallocates all_types_being_read and allocates a copy of the type, exits the program if memory can't be allocated */
+unsigned int add_type_being_read(ExpandedThreadType *extra_pokemon_data, const char *type) {
 
-  sleep(0.5); //Sleep for 0.5 seconds to allow the server time to receive the message to the server
+  /* Check whether this is not the first pokemon to be stored inside all_types_being_read */
+  /* if not, reallocate more space for all_types_being_read to handle a new type being added to the array */
+  if(extra_pokemon_data->all_types_being_read_size > 0) {
+    extra_pokemon_data->all_types_being_read = realloc(extra_pokemon_data->all_types_being_read, sizeof(char *) * (extra_pokemon_data->all_types_being_read_size + 1));
 
-  /* Send the pokemon_type that is currently being read over to the server and check if it sent properly */
-  if(send(dynamic_array->extra_pokemon_data->client_socket, dynamic_array->extra_pokemon_data->all_types_being_read[dynamic_array->extra_pokemon_data->curr_type_being_read], strlen(dynamic_array->extra_pokemon_data->all_types_being_read[dynamic_array->extra_pokemon_data->curr_type_being_read]), 0) == -1) {
-    printf("SERVER ERROR: Failed to send pokemon type to server \n");
-    exit(EXIT_FAILURE);
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if(extra_pokemon_data->all_types_being_read == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
   }
 
-  /* Store the amount of bytes of the next message inside the buffer variable and store the return output of the recv function inside bytesReceived*/
-  bytesReceived = recv(dynamic_array->extra_pokemon_data->client_socket, buffer, MAX_MESSAGE_BUFFER_SIZE, 0);
+  /* Allocate space inside all_types_being_read and copy the type into it */
+  extra_pokemon_data->all_types_being_read[extra_pokemon_data->all_types_being_read_size] = malloc(sizeof(char) * (strlen(type) + 1));
 
-  /* Check if the recv function returned properly, print error message and exit program if not */
-  if(bytesReceived < 0) {
-    printf("SERVER ERROR: Failed to receive pokemon type from server \n");
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(extra_pokemon_data->all_types_being_read[extra_pokemon_data->all_types_being_read_size] == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
+  strcpy(extra_pokemon_data->all_types_being_read[extra_pokemon_data->all_types_being_read_size], type);
 
-  /* Null terminate the buffer string */
-  buffer[bytesReceived] = '\0';
-
-  /* Convert the buffer to a (long) integer with atol and store it in bytes_from_message variable */
-  int bytes_from_message = atol(buffer); 
-  char *pokemon_message = (char *)malloc((bytes_from_message+1) * sizeof(char)); //allocate memory to a char pointer to hold the message containing all the pokemon data read from the server
-
-  /* Store the giant string containing the pokemon data read from the server inside pokemon_message and store the return output of the recv function inside bytesReceived*/
-  bytesReceived = recv(dynamic_array->extra_pokemon_data->client_socket, pokemon_message, bytes_from_message, 0);
-
-  /* Check if the recv function returned properly, print error message and exit program if not */
-  if(bytesReceived < 0) {
-    printf("SERVER ERROR: Failed to receive pokemon type from server \n");
-    exit(EXIT_FAILURE);
-  }
+  return extra_pokemon_data->all_types_being_read_size++; // Increment the size counter for the all_types_being_read variable by 1
+}
 
-  /* Null-terminate the pokemon_message string */
-  pokemon_message[bytesReceived] = '\0';
-  char *pointer_to_pokemon_message = pokemon_message; //create a new char pointer to point to the pokemon_message so we can free it later
+/* This function sends the request for the pokemon of a certain type, or matching a filter query, to the server without waiting for its answer */
+/* Parameters: *dynamic_array - input/output (the struct containing all_types_being_read and the pending requests), message_type - input (MESSAGE_QUERY for a type, MESSAGE_FILTER for a filter query, MESSAGE_AGGREGATE for statistics, MESSAGE_STATS for the counters of the server, MESSAGE_METRICS for its metrics, MESSAGE_RELOAD to reload the pokemon file or MESSAGE_CHANGE to change pokemon), request_id - input (the index of the type inside all_types_being_read, which is also used as the id of the request) */
+/* Return values: int, C_OK (0) if the request was sent and C_NOK (-1) if the socket failed */
+/* Side effects: adds the request to pending_requests, the receive_pokemon thread removes it once the server answers */
+int read_pokemon(DynamicArrayType *dynamic_array, int message_type, unsigned int request_id) {
+  ExpandedThreadType *extra_pokemon_data = dynamic_array->extra_pokemon_data;
+  char *pokemon_type = extra_pokemon_data->all_types_being_read[request_id];
 
-  /* Create a char pointer and allocate memory to it to store the number of pokemon sent message that is going to be sent from the server */
-  char *number_of_pokemon_message = (char *)malloc(MAX_MESSAGE_BUFFER_SIZE * sizeof(char));
+  PendingRequestType *request = (PendingRequestType *)malloc(sizeof(PendingRequestType));
 
   /* Check if memory is allocated properly, print error message and exit if not */
-  if(number_of_pokemon_message == NULL) {
-    printf("SERVER ERROR: Failed to allocate memory for number_of_pokemon_message \n");
+  if(request == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
-  
-  /* Store the number of pokemon sent message inside the number_of_pokemon_message variable and store the return output of the recv function inside bytesReceived*/
-  bytesReceived = recv(dynamic_array->extra_pokemon_data->client_socket, number_of_pokemon_message, MAX_MESSAGE_BUFFER_SIZE, 0);
+  request->request_id = request_id;
 
-  /* Check if the recv function returned properly, print error message and exit program if not */
-  if(bytesReceived < 0) {
-    printf("SERVER ERROR: Failed to receive number of pokemon from server \n");
-    exit(EXIT_FAILURE);
-  }
+  /* Remember the request before sending it, the answer can arrive before send_client_message returns */
+  pthread_mutex_lock(&extra_pokemon_data->pending_mutex);
+  request->next = extra_pokemon_data->pending_requests;
+  extra_pokemon_data->pending_requests = request;
+  extra_pokemon_data->number_of_pending_requests++;
+  pthread_mutex_unlock(&extra_pokemon_data->pending_mutex);
 
-  /* Null terminate the number_of_pokemon_message string */
-  number_of_pokemon_message[bytesReceived] = '\0';
-  int number_of_pokemon = strtol(number_of_pokemon_message, NULL, 10); //conver the number_of_pokemon message into an int and store it in a separate variable
+  return send_client_message(extra_pokemon_data, message_type, request_id, pokemon_type, strlen(pokemon_type));
+}
 
-  /* Loop through every pokemon in the pokemon_message */
-  for(int i = 0; i < number_of_pokemon; i++) {
-    char *pokemon_data_line = strsep(&pokemon_message, "|"); //Get the current pokemon and store it in the pokemon_data_line variable
-    PokemonType *curr_pokemon; //create a new variable to store the current pokemon being read
-    line_to_pokemon(pokemon_data_line, &curr_pokemon, SEPARATOR); //convert the string into a pokemon and store it in curr_pokemon
-    add_pokemon(curr_pokemon, dynamic_array); //add the pokemon to the dynamic array with add_pokemon
+/* This function checks whether a request is still waiting for its response, without removing it, for the batches of a result that more batches follow */
+/* Parameters: *extra_pokemon_data - input/output (the struct containing the pending requests), request_id - input (the id copied into the batch by the server) */
+/* Return values: int, C_OK (0) if a request with that id is waiting and C_NOK (-1) if not */
+/* Side effects: locks and unlocks the pending_mutex */
+int find_pending_request(ExpandedThreadType *extra_pokemon_data, unsigned int request_id) {
+  int result = C_NOK;
+
+  pthread_mutex_lock(&extra_pokemon_data->pending_mutex);
+  for(PendingRequestType *request = extra_pokemon_data->pending_requests; request != NULL; request = request->next) {
+    if(request->request_id == request_id) {
+      result = C_OK;
+      break;
+    }
   }
+  pthread_mutex_unlock(&extra_pokemon_data->pending_mutex);
 
+  return result;
+}
 
-  dynamic_array->extra_pokemon_data->number_of_successful_queries += 1;  //Increase the number of successful queries by 1
-  dynamic_array->extra_pokemon_data->number_of_pokemon_sucesfully_saved += number_of_pokemon;   /* Incrased the number of pokemon that are sucessfully saved by the amount that were added to the dynamic array during the function processs */
-  dynamic_array->extra_pokemon_data->curr_type_being_read += 1; //increase the index that the type is going to be read from in the all_types_being_read array by 1
-
-  pthread_mutex_unlock(&dynamic_array->extra_pokemon_data->mutex); //unlock the mutex
-  
-  /* Free the memory allocated to the pokemon_message via pointer_to_pokemon_message pointer and free the number_of_pokemon_message variable */
-  free(number_of_pokemon_message);
-  free(pointer_to_pokemon_message);
+/* This function removes the request a response answers from the pending requests */
+/* Parameters: *extra_pokemon_data - input/output (the struct containing the pending requests), request_id - input (the id copied into the response by the server) */
+/* Return values: int, C_OK (0) if a request was waiting for the response and C_NOK (-1) if no request has that id */
+/* Side effects: frees the pending request and wakes up every thread waiting for requests to be answered */
+int take_pending_request(ExpandedThreadType *extra_pokemon_data, unsigned int request_id) {
+  int result = C_NOK;
+
+  pthread_mutex_lock(&extra_pokemon_data->pending_mutex);
+  for(PendingRequestType **request = &extra_pokemon_data->pending_requests; *request != NULL; request = &(*request)->next) {
+    if((*request)->request_id == request_id) {
+      PendingRequestType *answered = *request;
+      *request = answered->next;
+      free(answered);
+      extra_pokemon_data->number_of_pending_requests--;
+      result = C_OK;
+      break;
+    }
+  }
+  pthread_cond_broadcast(&extra_pokemon_data->pending_cond);
+  pthread_mutex_unlock(&extra_pokemon_data->pending_mutex);
 
-  /* Set the thread_is_running variable to C_NOK to indicate that the thread is no longer working */
-  dynamic_array->extra_pokemon_data->thread_is_running = C_NOK;
+  return result;
+}
 
-  return C_OK;
+/* This function waits until the server answered every request sent so far, or until the connection to the server is lost */
+/* Parameters: *extra_pokemon_data - input/output (the struct containing the pending requests) */
+/* Return values: nothing since it's a void function */
+/* Side effects: blocks the calling thread on the pending_cond condition */
+void wait_for_pending_requests(ExpandedThreadType *extra_pokemon_data) {
+  pthread_mutex_lock(&extra_pokemon_data->pending_mutex);
+  while(extra_pokemon_data->number_of_pending_requests > 0 && extra_pokemon_data->receive_thread_is_running == C_OK) {
+    pthread_cond_wait(&extra_pokemon_data->pending_cond, &extra_pokemon_data->pending_mutex);
+  }
+  pthread_mutex_unlock(&extra_pokemon_data->pending_mutex);
 }
 
-/* This function writes all the pokemon that are succesfully read into the dynamic array into a file */
-/* NOTE: This function is primarily copied from the function write_students from ReadCSV.c from the Professor's Sample Code */
+/* This function is ran by the receive thread, it receives every response of the server in the order the server finishes them and stores the pokemon of each result inside the dynamic array. A large result arrives in batches and the pokemon of every batch are stored as soon as it arrives */
+/* NOTE: This function is primarily copied from the function read_students from ReadCSV.c from the Professor's Sample Code */
 /* Parameters: *arg - input/output (void* casted parameter containing a DynamicArrayType struct) */
 /* Return values: nothing since the function is void  */
-/* Side effects: opens and closes a file, dynamically allocates memory to multiple different structures, locks and unlocks a mutex and sends signals to other functions to unlock/lock their threads */
-void *write_pokemon(void *arg) {
-  DynamicArrayType *temporary = (DynamicArrayType *)arg; //variable containing the DynamicArrayType variable which is passed into the function as a void*
+/* Side effects: uses socket functions to communicate with the server, uses mutex and cond to pause/unpause the thread running this function, exits once the socket is shut down */
+void *receive_pokemon(void *arg) {
 
-  //change the mutex_passing_condition to n, which locks the other thread if its reading
-  temporary->extra_pokemon_data->thread_is_paused = C_OK;
-  
-  /* Officially lock the mutex */
-  pthread_mutex_lock(&temporary->extra_pokemon_data->mutex);
+  DynamicArrayType *dynamic_array = (DynamicArrayType *)arg; //variable containing the DynamicArrayType variable which is passed into the function as a void*
+  MessageHeaderType header;
+  char *pokemon_message = NULL;
+
+  /* Receive whole responses until the socket is shut down, the header tells how many bytes each result contains */
+  while(receive_message(dynamic_array->extra_pokemon_data->client_socket, &header, &pokemon_message) == C_OK) {
+    int is_last_batch = (header.type != MESSAGE_RESULT || (header.flags & RESULT_FLAG_MORE) == 0) ? C_OK : C_NOK;
+
+    /* Match the response to the request it answers with the id copied into it by the server, the request keeps waiting until the last batch of its result */
+    int is_pending = (is_last_batch == C_OK) ? take_pending_request(dynamic_array->extra_pokemon_data, header.request_id) : find_pending_request(dynamic_array->extra_pokemon_data, header.request_id);
+    if(is_pending == C_NOK) {
+      LOG_WARN("Received a response to an unknown request from the server");
+      free(pokemon_message);
+      continue;
+    }
+    if(header.type == MESSAGE_ERROR) {
+      printf("SERVER ERROR: %s \n", pokemon_message);
+      free(pokemon_message);
+      continue;
+    }
+    /* Statistics, counters, metrics, reload and change answers are only printed, they don't contain any pokemon to save */
+    if(header.type == MESSAGE_AGGREGATE_RESULT || header.type == MESSAGE_STATS_RESULT || header.type == MESSAGE_METRICS_RESULT || header.type == MESSAGE_RELOAD_RESULT || header.type == MESSAGE_CHANGE_RESULT) {
+      printf("%s", pokemon_message);
+      free(pokemon_message);
+      continue;
+    }
+    if(header.type != MESSAGE_RESULT || header.payload_length < RESULT_COUNT_SIZE) {
+      LOG_WARN("Received an unexpected response from the server");
+      free(pokemon_message);
+      continue;
+    }
 
-  sleep(0.25); //sleep for 0.25 seconds to give time for the server to receive commands
+    /* Check if the mutex has been locked properly, print error message and exit program if not. A running save only holds it to take the size of the dynamic array, so this never waits for the disk */
+    if(pthread_mutex_lock(&dynamic_array->extra_pokemon_data->mutex) != 0) {
+        LOG_ERROR("The mutex lock operation has failed");
+        exit(EXIT_FAILURE);
+    }
 
-  /* Send a request to the server to stop reading in pokemon while this writing operation is running */
-  if(send(temporary->extra_pokemon_data->client_socket, "pause", strlen("pause"), 0) == -1) {
-    printf("SERVER ERROR: Failed to send pokemon type to server \n");
-    exit(EXIT_FAILURE);
-  }
+    char *pointer_to_pokemon_message = pokemon_message; //create a new char pointer to point to the pokemon_message so we can free it later
+    int number_of_pokemon = protocol_read_count((unsigned char *)pokemon_message); //the number of pokemon inside the result is written at the start of the payload
+    pokemon_message += RESULT_COUNT_SIZE;
 
-  /* Open a new file at the location specified the user with the name_of_file variable in the appending mode */
-  FILE *data_csv_file = data_csv_file = fopen(temporary->extra_pokemon_data->name_of_saved_file, "a");
+    /* Make room for every pokemon of the result at once, then split each line in place straight into the dynamic array */
+    reserve_pokemon(dynamic_array, number_of_pokemon);
+    int number_of_pokemon_added = 0;
+    for(int i = 0; i < number_of_pokemon; i++) {
+      char *pokemon_data_line = strsep(&pokemon_message, "|"); //Get the current pokemon and store it in the pokemon_data_line variable
 
-  /* Loop through every pokemon that is sucessfully saved*/
-  for (int i = 0; i < temporary->extra_pokemon_data->number_of_pokemon_sucesfully_saved; i++)
-  {
-    /* If the data file is not opened properly, print error message and quit the program */
-    if (!data_csv_file) {
-      printf("File was not able to be opened. Program closing now!");
-      exit(EXIT_FAILURE);
+      /* Stop at the end of the payload if it holds fewer pokemon than its count says */
+      if(pokemon_data_line == NULL) {
+        break;
+      }
+      line_to_pokemon(pokemon_data_line, &dynamic_array->darray_elements[dynamic_array->darray_size], SEPARATOR); //convert the string into a pokemon stored inside the dynamic array
+      dynamic_array->darray_size++;
+      number_of_pokemon_added++;
     }
-    else
-    {
-      char line[MAX_LENGTH] = "";  //variable that will hold the char conversion of the pokemon
-      pokemon_to_line(line, temporary->darray_elements[i], SEPARATOR); //conver the pokemon to a string
 
-      /* Write the pokemon as a string to the file using fprintf */
-      fprintf(data_csv_file, "%s\n", line);
+    /* A query is only successful once every batch of its result arrived */
+    if(is_last_batch == C_OK) {
+      __atomic_add_fetch(&dynamic_array->extra_pokemon_data->number_of_successful_queries, 1, __ATOMIC_RELAXED);  //Increase the number of successful queries by 1, the main thread reads it without the mutex
     }
+    dynamic_array->extra_pokemon_data->number_of_pokemon_sucesfully_saved += number_of_pokemon_added;   /* Incrased the number of pokemon that are sucessfully saved by the amount that were added to the dynamic array during the function processs */
+
+    pthread_mutex_unlock(&dynamic_array->extra_pokemon_data->mutex); //unlock the mutex
+
+    /* The strings of the pokemon point into the payload of the batch, so the arena keeps it until the client exits */
+    string_arena_keep(&dynamic_array->strings, pointer_to_pokemon_message);
+    pokemon_message = NULL;
   }
 
-  /* If the file is opened properly, close the file*/
-  if (data_csv_file != NULL) {
-    fclose(data_csv_file);
-  } 
+  /* Wake up every thread waiting for an answer, no more answers can arrive */
+  pthread_mutex_lock(&dynamic_array->extra_pokemon_data->pending_mutex);
+  dynamic_array->extra_pokemon_data->receive_thread_is_running = C_NOK;
+  pthread_cond_broadcast(&dynamic_array->extra_pokemon_data->pending_cond);
+  pthread_mutex_unlock(&dynamic_array->extra_pokemon_data->pending_mutex);
 
-  /* Check if the program has a saved a file succesfully before */
-  if(temporary->extra_pokemon_data->number_of_saved_files == 0) {
-   
-    //Allocate memory for the all_file_names variable to store the name of a file
-    temporary->extra_pokemon_data->all_file_names[temporary->extra_pokemon_data->number_of_saved_files] = (char *)malloc(strlen(temporary->extra_pokemon_data->name_of_saved_file) + 1);
+  return NULL;
+}
 
-    /* Check if memory is allocated properly, print error message and exit if not */
-    if(temporary->extra_pokemon_data->all_file_names[temporary->extra_pokemon_data->number_of_saved_files] == NULL) {
-      printf("An error occured while allocating memory. The program will now exit \n");
-      exit(EXIT_FAILURE);
-    }
+/* This function writes the pokemon that are succesfully read into the dynamic array into a file, a file the user already saved to during the session only gets the pokemon received since that save */
+/* NOTE: This function is primarily copied from the function write_students from ReadCSV.c from the Professor's Sample Code */
+/* Parameters: *arg - input/output (void* casted parameter containing a DynamicArrayType struct) */
+/* Return values: nothing since the function is void  */
+/* Side effects: opens and closes a file, binary columns are written to a temporary file renamed over the chosen one, dynamically allocates memory to multiple different structures, holds the mutex only while taking the size of the dynamic array so results keep being received while the file is written */
+void *write_pokemon(void *arg) {
+  DynamicArrayType *temporary = (DynamicArrayType *)arg; //variable containing the DynamicArrayType variable which is passed into the function as a void*
+  ExpandedThreadType *extra_pokemon_data = temporary->extra_pokemon_data;
 
-    /* Copy the file name that the program just saved to the all_file_names double pointer */
-    strcpy(temporary->extra_pokemon_data->all_file_names[temporary->extra_pokemon_data->number_of_saved_files], temporary->extra_pokemon_data->name_of_saved_file);
-    temporary->extra_pokemon_data->number_of_saved_files++; //Increase the counter for number of saved files by 1
+  /* Only the pokemon received since the last save to the same file are added to it, a file that was never saved to gets every pokemon. The list of files is only changed by the save thread */
+  int file_index = find_saved_file(temporary, extra_pokemon_data->name_of_saved_file);
+  if(file_index == C_NOK) {
+    file_index = remember_saved_file(temporary, extra_pokemon_data->name_of_saved_file);
   }
-  else {
-    
-    /* Check if the file we just wrote to is a new file and has not already been saved inside name_of_file*/
-    if(check_for_previous_file(temporary, temporary->extra_pokemon_data->name_of_saved_file) == C_NOK) {
 
-    /* Allocate more memory to the all_file_names array */
-    temporary->extra_pokemon_data->all_file_names = realloc(temporary->extra_pokemon_data->all_file_names, sizeof(char *) * (temporary->extra_pokemon_data->number_of_saved_files + 1));
+  /* Take the pokemon received so far while holding the mutex, then let the receive thread keep adding pokemon while they are written. Pokemon never change once they are added, and if the dynamic array grows meanwhile the elements being saved are kept alive until the save is done */
+  pthread_mutex_lock(&extra_pokemon_data->mutex);
+  const PokemonType *elements = temporary->darray_elements;
+  int number_of_pokemon = temporary->darray_size;
+  temporary->saved_elements = temporary->darray_elements;
+  pthread_mutex_unlock(&extra_pokemon_data->mutex);
 
-    /* Check if memory is allocated properly, print error message and exit if not */
-    if(!temporary->extra_pokemon_data->all_file_names) {
-      printf("An error occured while allocating memory. The program will now exit \n");
-      exit(EXIT_FAILURE);
-    }
-  
-    /* Allocate memory inside the all_file_names array for the new file to be added*/
-    temporary->extra_pokemon_data->all_file_names[temporary->extra_pokemon_data->number_of_saved_files] = (char *)malloc(strlen(temporary->extra_pokemon_data->name_of_saved_file) + 1);
+  /* Binary columns can't be appended to, so that file is written again with every pokemon into a temporary file that is only moved over it once it is complete, a save that fails keeps the previous file */
+  ExportFormatType format = export_format(extra_pokemon_data->name_of_saved_file);
+  char *temporary_name = NULL;
+  if(format == EXPORT_COLUMNS) {
+    temporary_name = (char *)malloc(strlen(extra_pokemon_data->name_of_saved_file) + strlen(EXPORT_COLUMNS_TEMPORARY_SUFFIX) + 1);
 
     /* Check if memory is allocated properly, print error message and exit if not */
-    if(temporary->extra_pokemon_data->all_file_names[temporary->extra_pokemon_data->number_of_saved_files] == NULL) {
+    if(temporary_name == NULL) {
       printf("An error occured while allocating memory. The program will now exit \n");
       exit(EXIT_FAILURE);
     }
+    sprintf(temporary_name, "%s%s", extra_pokemon_data->name_of_saved_file, EXPORT_COLUMNS_TEMPORARY_SUFFIX);
+  }
 
-    /* Copy the file name that the program just saved to the all_file_names double pointer */
-    strcpy(temporary->extra_pokemon_data->all_file_names[temporary->extra_pokemon_data->number_of_saved_files], temporary->extra_pokemon_data->name_of_saved_file);
-    temporary->extra_pokemon_data->number_of_saved_files++; //Increase the counter for number of saved files by 1
-    }
+  /* Open the file the user chose in the appending mode, or the temporary file of the binary columns. If it is not opened properly, print error message and quit the program */
+  int data_csv_file = open((temporary_name != NULL) ? temporary_name : extra_pokemon_data->name_of_saved_file, O_WRONLY | O_CREAT | O_CLOEXEC | ((temporary_name != NULL) ? O_TRUNC : O_APPEND), 0644);
+  if(data_csv_file < 0) {
+    LOG_ERROR("File was not able to be opened. Program closing now!");
+    exit(EXIT_FAILURE);
   }
 
-  //change the mutex_passing_condition to n, which unlocks the other thread if its reading
-  temporary->extra_pokemon_data->thread_is_paused = C_NOK;
-  pthread_mutex_unlock(&temporary->extra_pokemon_data->mutex); //Unlock the mutex
-  pthread_cond_signal(&temporary->extra_pokemon_data->cond); //Send the signal over to the other thread to officially allow it to start reading again
+  /* Encode the new pokemon in the format of the file and write them to it */
+  int first_row = (format == EXPORT_COLUMNS) ? 0 : extra_pokemon_data->rows_saved_to_file[file_index];
+  int result = (format == EXPORT_COLUMNS) ? export_columns(data_csv_file, elements, number_of_pokemon) : export_pokemon(data_csv_file, elements + first_row, number_of_pokemon - first_row, format);
 
-  /* Send a unpause message to the server to unpause the thread containing reading operations in the server, to allow it to continue its work */
-  if(send(temporary->extra_pokemon_data->client_socket, "unpause", strlen("unpause"), 0) == -1) {
-    printf("SERVER ERROR: Failed to send pokemon type to server \n");
-    exit(EXIT_FAILURE);
+  /* The binary columns only replace the previous file once they reached the disk */
+  if(result == C_OK && temporary_name != NULL && (fsync(data_csv_file) < 0 || rename(temporary_name, extra_pokemon_data->name_of_saved_file) < 0)) {
+    result = C_NOK;
   }
+  if(result == C_OK) {
+    extra_pokemon_data->rows_saved_to_file[file_index] = number_of_pokemon;
+  }
+  else {
+    LOG_ERROR("File was not able to be written, the pokemon that are not in it yet will be added by the next save to it");
+  }
+  close(data_csv_file);
+  if(temporary_name != NULL) {
+    if(result == C_NOK) {
+      unlink(temporary_name);
+    }
+    free(temporary_name);
+  }
+
+  /* Free the elements that were saved if the dynamic array moved to larger ones while they were written */
+  pthread_mutex_lock(&extra_pokemon_data->mutex);
+  if(temporary->saved_elements != temporary->darray_elements) {
+    free(temporary->saved_elements);
+  }
+  temporary->saved_elements = NULL;
+  pthread_mutex_unlock(&extra_pokemon_data->mutex);
 
   return C_OK;
 }
@@ -559,196 +737,48 @@ void print_final_information(DynamicArrayType *temporary) {
   }
 }
 
-/* This function convers a string containing pokemon information into a pokemon struct containing information about all properties about a Pokemon */
-/* NOTE: This function is primarily copied from the function line_to_student from ReadCSV.c from the Professor's Sample Code */
-/* Parameters: *line - input (line that information is being parsed from), **new_pokemon - input/output (pokemon structure that is being initialized with memory and has its properties filled), *separator - input (the character that separates the infomration in the file) */
-/* Return values: nothing since the function is void  */
-/* Side effects: uses strsep which modifies the input string, allocate memory on the heap to PokemonType struct */
-void line_to_pokemon(char *line, PokemonType **new_pokemon, char *separator) {
-
-  /* Create a char pointer for each property of the pokemon being parsed from line using 
-  strsep function */
-  char *number = strsep(&line, separator);
-  char *name = strsep(&line, separator);
-  char *first_type = strsep(&line, separator);
-  char *second_type = strsep(&line, separator);
-  char *total_stats = strsep(&line, separator);
-  char *health_points = strsep(&line, separator);
-  char *attack = strsep(&line, separator);
-  char *defense = strsep(&line, separator);
-  char *special_attack = strsep(&line, separator);
-  char *special_defense = strsep(&line, separator);
-  char *speed = strsep(&line, separator);
-  char *generation = strsep(&line, separator);
-  char *legendary = strsep(&line, separator);
-
-  /* Allocate memory on the heap for the pokemon pointer */
-  *new_pokemon = (PokemonType*) malloc(sizeof(PokemonType));
-
-  /* Check if memory is allocated properly, print error message and exit if not */
-  if(*new_pokemon == NULL) {
-    printf("An error occured while allocating memory. The program will now exit \n");
-    exit(EXIT_FAILURE);
-  }
-
-   /* Allocate memory on the heap for each of the char * properties of the pokemon */ 
-  (*new_pokemon)->name = (char *)malloc(strlen(name) + 1);
-  (*new_pokemon)->first_type = (char *)malloc(strlen(first_type) + 1);
-  (*new_pokemon)->second_type = (char *)malloc(strlen(second_type) + 1);
-
-  /* Check if memory is allocated properly, print error message and exit if not */
-  if((*new_pokemon)->name == NULL || (*new_pokemon)->first_type == NULL || (*new_pokemon)->second_type == NULL) {
-    printf("An error occured while allocating memory. The program will now exit \n");
-    exit(EXIT_FAILURE);
-  }
+/* This function finds a file the user already saved to during the session */
+/* Parameters: *temporary - input (the DynamicArrayType containing the names of every file saved to), *check_file - input (the name of the file being looked for) */
+/* Return values: int, the index of the file inside all_file_names, or C_NOK (-1) if the user never saved to it */
+/* Side effects: none */
+int find_saved_file(DynamicArrayType *temporary, char *check_file) {
 
-  /* Setting the name, first_type and second_type char pointers to contain only the null terminating string so I don't have to manually put it in later after using memset */
-  memset((*new_pokemon)->name, '\0', strlen(name)+1);
-  memset((*new_pokemon)->first_type, '\0', strlen(first_type)+1);
-  memset((*new_pokemon)->second_type, '\0', strlen(second_type)+1);
-
-  /* Copying over the memory containing the characters for the name, first_type and second_type
-  properties */
-  memcpy((*new_pokemon)->name, name, strlen(name) + 1);
-  memcpy((*new_pokemon)->first_type, first_type, strlen(first_type) + 1);
-  memcpy((*new_pokemon)->second_type, second_type, strlen(second_type) + 1);
-
-  /* For all of the numeric properties of the pokemon, use strtol to convert the string containing the information about the property to a numeric data type */
-  (*new_pokemon)->number = strtol(number, NULL, 10);
-  (*new_pokemon)->total_stats = strtol(total_stats, NULL, 10);
-  (*new_pokemon)->health_points = strtol(health_points, NULL, 10);
-  (*new_pokemon)->attack = strtol(attack, NULL, 0);
-  (*new_pokemon)->defense = strtol(defense, NULL, 0);
-  (*new_pokemon)->special_attack = strtol(special_attack, NULL, 0);
-  (*new_pokemon)->special_defense = strtol(special_defense, NULL, 0);
-  (*new_pokemon)->speed = strtol(speed, NULL, 0);
-  (*new_pokemon)->generation = strtol(generation, NULL, 0);
-
-  /* Check if the pokemon is legendary or not, fill the legendary property in new_pokemon with a n char if its not a legendary and a y if it is a legendary*/
-  if (strcmp(legendary, "False") == 0)
-  {
-    (*new_pokemon)->legendary = 'n';
-    }
-    else {
-      (*new_pokemon)->legendary = 'y';
+  /* Loop through every saved file in the temporary DynamicArrayType and compare the names, if they match, then return the index of the file */
+  for (int i = 0; i < temporary->extra_pokemon_data->number_of_saved_files; i++) {
+    if (strcmp(temporary->extra_pokemon_data->all_file_names[i], check_file) == 0) {
+      return i;
     }
+  }
+  return C_NOK; /* If they're no matches, return C_NOK (-1) */
 }
 
-/* This function adds a pokemon to the end of the dynamic array and also resizes the dynamic array as necessary. */
-/* NOTE: This function is primarily copied from the function addStudent() of p7-dynArr.c from Module 9 */
-/* Parameters: *pokemon - input (a pointer to a pokemon), *pokemon_dynamic_array - input/output (a pointer to a dynamic array) */
-/* Return values: nothing since it's a void function */
-/* Side effects: expanding the size of the dynamic array, addition of memory to the heap */
-void add_pokemon(PokemonType *pokemon, DynamicArrayType *pokemon_dynamic_array) {
-
-  PokemonType **new_pokemon_array; //new pointer array of Pokemon pointers
-  int curr_index; //int representing the current index of the dynamic array
-
-  int insert_position = pokemon_dynamic_array->darray_size; //the position we will be inserting the new pokemon at
-
-  //checking for validity of inputs
-  if (insert_position < 0 || insert_position > pokemon_dynamic_array->darray_size) {
-    return;
+/* This function adds a file to the files the user saved to during the session, no pokemon have been written to it yet */
+/* Parameters: *temporary - input/output (the DynamicArrayType containing the names of every file saved to), *file_name - input (the name of the new file) */
+/* Return values: int, the index of the file inside all_file_names */
+/* Side effects: reallocates all_file_names and rows_saved_to_file, exits the program if memory can't be allocated */
+int remember_saved_file(DynamicArrayType *temporary, char *file_name) {
+  ExpandedThreadType *extra_pokemon_data = temporary->extra_pokemon_data;
+  int number_of_files = extra_pokemon_data->number_of_saved_files + 1;
+
+  /* Allocate more memory to the all_file_names array and to the amount of pokemon written to every file */
+  char **all_file_names = (char **)realloc(extra_pokemon_data->all_file_names, sizeof(char *) * number_of_files);
+  if(all_file_names != NULL) {
+    extra_pokemon_data->all_file_names = all_file_names;
   }
-
-  /*allocating meory for the new pointer array of pokemon pointers */
-  new_pokemon_array = calloc(pokemon_dynamic_array->darray_size+1, sizeof(PokemonType*));
+  int *rows_saved_to_file = (int *)realloc(extra_pokemon_data->rows_saved_to_file, sizeof(int) * number_of_files);
+  if(rows_saved_to_file != NULL) {
+    extra_pokemon_data->rows_saved_to_file = rows_saved_to_file;
+  }
+  char *name = strdup(file_name);
 
   /* Check if memory is allocated properly, print error message and exit if not */
-  if(new_pokemon_array == NULL) {
+  if(all_file_names == NULL || rows_saved_to_file == NULL || name == NULL) {
     printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
 
-  /* copying all the pokemon before the position of the newly inserted transaction */
-  for(curr_index=0; curr_index<insert_position; ++curr_index) {
-    new_pokemon_array[curr_index] = pokemon_dynamic_array->darray_elements[curr_index];
-  }
-
-  //inserting the new transaction at the specified position
-  new_pokemon_array[curr_index] = pokemon;
-
-  /* freeing the old dynamic array and then copying the new one over to the old DynamicArrayType structure and increasing the size by one*/
-  free(pokemon_dynamic_array->darray_elements);
-  pokemon_dynamic_array->darray_elements = new_pokemon_array;
-  pokemon_dynamic_array->darray_size++;
-}
-
-/* This function converts a pokemon struct to a string that contains all the properties of that Pokemon */
-/* NOTE: This function is primarily copied from the function student_to_line from ReadCSV.c from the Professor's Sample Code */
-/* Parameters: *line_to_write - input/output (the string that we will the pokemon properties to), *pokemon_to_write - input (the pokemon struct that we will read from), *separator - input (the character that separates each of the properties of the pokemon inside the line_to_write string) */
-/* Return values: nothing since the function is void  */
-/* Side effects: uses sprintf to copy over numeric data from the pokemon_to_write struct into a string format */
-void pokemon_to_line(char *line_to_write, const PokemonType *pokemon_to_write, char *separator) {
-
-  /* Creating a char array for each of the numeric properties from the Pokemon that we have to convert to a string */
-  char number[MAX_LENGTH];
-  char total[MAX_LENGTH];
-  char health_points[MAX_LENGTH];
-  char attack[MAX_LENGTH];
-  char defense[MAX_LENGTH];
-  char special_attack[MAX_LENGTH];
-  char special_defense[MAX_LENGTH];
-  char speed[MAX_LENGTH];
-  char generation[MAX_LENGTH];
-
-  /* Use sprintf to convert the numeric properties of the Pokemon into a char array */
-  sprintf(number, "%d", pokemon_to_write->number);
-  sprintf(total, "%d", pokemon_to_write->total_stats);
-  sprintf(health_points, "%d", pokemon_to_write->health_points);
-  sprintf(attack, "%d", pokemon_to_write->attack);
-  sprintf(defense, "%d", pokemon_to_write->defense);
-  sprintf(special_attack, "%d", pokemon_to_write->special_attack);
-  sprintf(special_defense, "%d", pokemon_to_write->special_defense);
-  sprintf(speed, "%d", pokemon_to_write->speed);
-  sprintf(generation, "%d", pokemon_to_write->generation);
-
-  /* Concatenate each of the properties (except the legendary property) to the line_to_wqrite variable */
-  line_to_write = strcat(line_to_write, number);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, pokemon_to_write->name);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, pokemon_to_write->first_type);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, pokemon_to_write->second_type);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, total);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, health_points);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, attack);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, defense);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, special_attack);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, special_defense);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, speed);
-  line_to_write = strcat(line_to_write, separator);
-  line_to_write = strcat(line_to_write, generation);
-  line_to_write = strcat(line_to_write, separator); 
-
-  /* Check the legendary variable, if its the 'y' char, concatenate the word True to the line_to_write, if its the 'n char, concatenate the word Fasle to the line_to_write */
-  if(pokemon_to_write->legendary == 'y') {
-    line_to_write = strcat(line_to_write, "True");
-  }
-  else {
-    line_to_write = strcat(line_to_write, "False");
-  }
-}
-
-/* This function checks if a file is already stored in a DynamicArrayType struct */
-/* Parameters: *temporary - input (the DynamicArrayType struct that is passed in), *check_file - input (the file that we're checking if it's already been saved) */
-/* Return values: int, representing whether the file has been stored or not */
-/* Side effects: looping through char double pointer, using strcmp function */
-int check_for_previous_file(DynamicArrayType *temporary, char *check_file) {
-
-  /* Loop through every saved file in the temporary DynamicArrayType and compare the names, if they match, then return C_OK (0)*/
-  for (int i = 0; i < temporary->extra_pokemon_data->number_of_saved_files; i++) {
-    if (strcmp(temporary->extra_pokemon_data->all_file_names[i], check_file) == 0) {
-      return C_OK;
-    }
-  }
-  return C_NOK; /* If they're no matches, return C_NOK (-1) */
+  /* Copy the file name that the program is saving to into the all_file_names double pointer */
+  all_file_names[extra_pokemon_data->number_of_saved_files] = name;
+  rows_saved_to_file[extra_pokemon_data->number_of_saved_files] = 0;
+  return extra_pokemon_data->number_of_saved_files++; //Increase the counter for number of saved files by 1
 }
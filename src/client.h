@@ -17,22 +17,23 @@
 #include <stdio.h>
 #include <pthread.h>
 
+//importing the header file for the messages sent between the server and the client
+#include "protocol.h"
+#include "logger.h"
+
 //Variety of constants defined
-#define C_NOK -1                      //Constant to represent an error/not correct value
-#define C_OK 0                        //Constant to represent a correct return value
 #define MAX_LENGTH 100                //Constant to represent the max length of a string
 #define SEPARATOR ","                 //Constant to represent a separator between values inside a file
-#define SERVER_IP "127.0.0.1"         //Constant to represent the IP address the client will connect to
-#define SERVER_PORT 6000              //Constant to represent the port that the client will connect to
-#define MAX_MESSAGE_BUFFER_SIZE 100   //Constant to represent the largest message that can be sent to the server without forewarning
+#define DYNAMIC_ARRAY_INITIAL_CAPACITY 64 //Constant to represent the amount of pokemon the dynamic array can hold before it has to grow
+#define STRING_ARENA_INITIAL_BLOCKS 16 //Constant to represent the amount of blocks the string arena can hold before its list of blocks has to grow
 
 /* This structure represents all the information a Pokemon has */
 /* Each variable is a characteristic that will be read in from a file */
 typedef struct Pokemon {
     short number;           //Number of pokemon
-    char *name;             //Name of pokemon
-    char *first_type;       //First type of pokemon
-    char *second_type;      //Second type of pokemon if appplicable
+    char *name;             //Name of pokemon, points into a block of the string arena
+    char *first_type;       //First type of pokemon, points into a block of the string arena
+    char *second_type;      //Second type of pokemon if appplicable, points into a block of the string arena
     short total_stats;      //Sum of all stats of pokemon
     short health_points;    //HP of the pokemon
     short attack;           //attack stat of the pokemon
@@ -44,42 +45,64 @@ typedef struct Pokemon {
     char legendary;         //char representing whether the pokemon is a legendary pokemon or not
 } PokemonType;
 
+/* This structure represents one request sent to the server that has not been answered yet */
+typedef struct PendingRequest {
+  unsigned int request_id;          //Id the request was sent with, the server copies it into its response
+  struct PendingRequest *next;      //Next request that has not been answered yet
+} PendingRequestType;
+
 /* This structure contains the information that is needed to read pokemon information and to write pokemon informatino */
-/* It also contains the mutex and condition variables to manipulate the running of threads */
+/* It also contains the mutexes and condition variables shared by the threads, none of them is held while reading or writing a socket or a file so a slow save never stops results from being received */
 typedef struct ExpandedThread {                    
   int number_of_pokemon_sucesfully_saved; //Number of pokemon that were successfully saved to the file
   int number_of_saved_files;              //Number of files that were successfully saved to disk
-  int number_of_successful_queries;       //Number of queries that were successfully completed
+  int number_of_successful_queries;       //Number of queries that were successfully completed, updated atomically by the receive thread
   int client_socket;                      //Socket that the client uses to communicate with the server
-  int curr_type_being_read;               //Current type of pokemon that is going to be read from the server
   int all_types_being_read_size;          //The number of types that will and have been read from the server
   char **all_types_being_read;            //Double pointer containing all the types that will and have been read from the server
   char **all_file_names;                  //Double pointer containing all file names saved to
+  int *rows_saved_to_file;                //Amount of pokemon of the dynamic array already written to each file of all_file_names, the next save to a file only adds the pokemon after them
   char *name_of_saved_file;               //Name of the current file being saved to
-  char thread_is_paused;                  //Char representing whether the thread is paused or not
-  char thread_is_running;                 //Char representing whether the thread is running or not
-  pthread_mutex_t mutex;                  //Mutex that determines who has acces to this struct
-  pthread_cond_t cond;                    //Condition that manipualtes the waiting of a thread
+  char receive_thread_is_running;         //Char representing whether the thread receiving responses is still connected to the server or not
+  pthread_t receive_thread;               //Thread receiving every response sent by the server, so many requests can be waiting for an answer at once
+  PendingRequestType *pending_requests;   //Requests sent to the server that have not been answered yet
+  int number_of_pending_requests;         //Amount of requests inside pending_requests
+  pthread_mutex_t mutex;                  //Mutex protecting the dynamic array while pokemon are added to it or a save takes its size, never held while reading or writing a socket or a file
+  pthread_mutex_t pending_mutex;          //Mutex that determines who has access to pending_requests
+  pthread_cond_t pending_cond;            //Condition signaled every time a request is answered
 } ExpandedThreadType;
 
-/* This structure contains a dynamic implementation from dynArr.c from Module 9 */
+/* This structure owns the blocks of characters the strings of the pokemon point into. Every result received from the server becomes one block, its fields are split in place instead of being copied, and every block is freed at once when the client exits */
+typedef struct StringArena {
+  char **blocks;                            //Every block owned by the arena
+  int number_of_blocks;                     //Amount of blocks inside blocks
+  int blocks_capacity;                      //Amount of blocks the list can hold before it has to grow
+} StringArenaType;
+
+/* This structure contains a dynamic implementation from dynArr.c from Module 9, the pokemon are stored one after the other and the array doubles in size when it is full */
 /* It also stores all the necessary variables to read from files, write to files, communicate
 with the server, and to manipulate threads. */
 typedef struct DynamicArray {
   int darray_size;                          //Number of elements inside dynamic array
-  PokemonType **darray_elements;            // Array of pokemon where pokemon read from files are stored
+  int darray_capacity;                      //Number of elements the dynamic array can hold before it has to grow
+  PokemonType *darray_elements;             // Array of pokemon where pokemon read from files are stored
+  StringArenaType strings;                  //Arena owning the names and types of every pokemon inside darray_elements
+  PokemonType *saved_elements;              //Elements a running save reads without holding the mutex, kept alive if the dynamic array grows meanwhile, NULL when no save is running
   ExpandedThreadType *extra_pokemon_data;   //Structure that contains all the extra data needed to read from files, write to files, communicate with the server, and to manipulate threads
 } DynamicArrayType;
 
 /* all function prototypes for functions in client.c */
 void free_char_pointer(char **char_pointer);
-int check_valid_pokemon_type(char *input_type);
-void *read_pokemon(void *arg);
+int send_client_message(ExpandedThreadType *extra_pokemon_data, int type, unsigned int request_id, const void *payload, unsigned int payload_length);
+unsigned int add_type_being_read(ExpandedThreadType *extra_pokemon_data, const char *type);
+int read_pokemon(DynamicArrayType *dynamic_array, int message_type, unsigned int request_id);
+void *receive_pokemon(void *arg);
+int find_pending_request(ExpandedThreadType *extra_pokemon_data, unsigned int request_id);
+int take_pending_request(ExpandedThreadType *extra_pokemon_data, unsigned int request_id);
+void wait_for_pending_requests(ExpandedThreadType *extra_pokemon_data);
 void *write_pokemon(void *arg);
 void print_final_information(DynamicArrayType *temporary);
-void line_to_pokemon(char *line, PokemonType **new_pokemon, char *separator);
-void add_pokemon(PokemonType *pokemon, DynamicArrayType *pokemon_dynamic_array);
-int check_for_previous_file(DynamicArrayType *temporary, char *check_file);
-void pokemon_to_line(char *line_to_write, const PokemonType *pokemon_to_write, char *separator);
+int find_saved_file(DynamicArrayType *temporary, char *check_file);
+int remember_saved_file(DynamicArrayType *temporary, char *file_name);
 
 #endif //end of header file
\ No newline at end of file
@@ -0,0 +1,392 @@
+/*****************************************************************************/
+/* */
+/* column_scan.c */
+/* Purpose: This file contains the kernels that scan a numeric column of the pokemon table and keep the rows whose value is inside a range, 64 rows per word of a selection bitmap, or add up the rows a bitmap selects. The kernels use AVX2 or SSE2 when the processor running the server supports them and plain C otherwise, the fastest one is picked the first time a column is scanned. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Fill a bitmap with bitmap_fill, narrow it with column_scan_range and combine bitmaps with bitmap_and and bitmap_or. Count, add up and bound the selected rows with column_scan_stats. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//importing the header file included with the program to get access to its functions and constants
+#include "column_scan.h"
+
+static RangeScanType range_scan = NULL;          //Kernel picked for the processor running the server
+static StatsScanType stats_scan = NULL;          //Kernel adding up selected rows picked for the processor running the server
+static const char *range_scan_name = "scalar";   //Name of the kernels picked, printed when the server starts
+static pthread_once_t range_scan_once = PTHREAD_ONCE_INIT; //Makes sure the kernels are picked only once even if several worker threads scan at the same time
+
+/* This function returns the amount of 64 bit words a selection bitmap needs to hold one bit per row */
+/* Parameters: number_of_rows - input (the amount of rows of the table) */
+/* Return values: int containing the amount of words of the bitmap */
+/* Side effects: none */
+int bitmap_words(int number_of_rows) {
+  return (number_of_rows + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+}
+
+/* This function selects every row of a bitmap, leaving the bits past the last row cleared */
+/* Parameters: *bitmap - output (the bitmap being filled, bitmap_words(number_of_rows) words), number_of_rows - input (the amount of rows of the table) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void bitmap_fill(uint64_t *bitmap, int number_of_rows) {
+  int words = bitmap_words(number_of_rows);
+
+  memset(bitmap, 0xff, sizeof(uint64_t) * words);
+  if(number_of_rows % BITMAP_WORD_BITS != 0) {
+    bitmap[words - 1] = ((uint64_t)1 << (number_of_rows % BITMAP_WORD_BITS)) - 1;
+  }
+}
+
+/* This function keeps the rows selected by both bitmaps */
+/* Parameters: *destination - input/output (the bitmap being narrowed), *source - input (the other bitmap), words - input (the amount of words of both bitmaps) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void bitmap_and(uint64_t *destination, const uint64_t *source, int words) {
+  for(int i = 0; i < words; i++) {
+    destination[i] &= source[i];
+  }
+}
+
+/* This function keeps the rows selected by either bitmap */
+/* Parameters: *destination - input/output (the bitmap being widened), *source - input (the other bitmap), words - input (the amount of words of both bitmaps) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void bitmap_or(uint64_t *destination, const uint64_t *source, int words) {
+  for(int i = 0; i < words; i++) {
+    destination[i] |= source[i];
+  }
+}
+
+/* This function counts the rows selected by a bitmap */
+/* Parameters: *bitmap - input (the bitmap being counted), words - input (the amount of words of the bitmap) */
+/* Return values: int containing the amount of bits set */
+/* Side effects: none */
+int bitmap_count(const uint64_t *bitmap, int words) {
+  int count = 0;
+  for(int i = 0; i < words; i++) {
+    count += __builtin_popcountll(bitmap[i]);
+  }
+  return count;
+}
+
+/* This function compares up to 64 rows of a column one at a time */
+/* Parameters: *column - input (the values of every row), first_row - input (the row stored in bit 0), last_row - input (one past the last row compared), minimum - input (the smallest value kept), maximum - input (the largest value kept) */
+/* Return values: uint64_t with bit i set if row first_row + i is inside the range */
+/* Side effects: none */
+static uint64_t range_word_scalar(const short *column, int first_row, int last_row, short minimum, short maximum) {
+  uint64_t bits = 0;
+  for(int row = first_row; row < last_row; row++) {
+    bits |= (uint64_t)(column[row] >= minimum && column[row] <= maximum) << (row - first_row);
+  }
+  return bits;
+}
+
+/* This function is the kernel used when the processor has no vector instructions */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), minimum - input (the smallest value kept), maximum - input (the largest value kept), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void scan_range_scalar(const short *column, int number_of_rows, short minimum, short maximum, uint64_t *bitmap) {
+  for(int word = 0; word < bitmap_words(number_of_rows); word++) {
+    int first_row = word * BITMAP_WORD_BITS;
+    int last_row = (first_row + BITMAP_WORD_BITS < number_of_rows) ? first_row + BITMAP_WORD_BITS : number_of_rows;
+
+    /* Words without any selected row are skipped */
+    if(bitmap[word] != 0) {
+      bitmap[word] &= range_word_scalar(column, first_row, last_row, minimum, maximum);
+    }
+  }
+}
+
+/* This function adds the rows of one bitmap word to the statistics one at a time */
+/* Parameters: *column - input (the values of every row), first_row - input (the row stored in bit 0), bits - input (the rows of the word that are selected), *stats - input/output (the statistics being added to) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void stats_word_scalar(const short *column, int first_row, uint64_t bits, ColumnStatsType *stats) {
+  for(; bits != 0; bits &= bits - 1) {
+    short value = column[first_row + __builtin_ctzll(bits)];
+    stats->sum += value;
+    stats->minimum = (value < stats->minimum) ? value : stats->minimum;
+    stats->maximum = (value > stats->maximum) ? value : stats->maximum;
+  }
+}
+
+/* This function is the kernel adding up selected rows used when the processor has no vector instructions */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), *bitmap - input (the rows selected), *stats - input/output (the sum, minimum and maximum being updated) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void scan_stats_scalar(const short *column, int number_of_rows, const uint64_t *bitmap, ColumnStatsType *stats) {
+  for(int word = 0; word < bitmap_words(number_of_rows); word++) {
+    stats_word_scalar(column, word * BITMAP_WORD_BITS, bitmap[word], stats);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* This function compares 16 rows of a column at once with SSE2 */
+/* Parameters: *values - input (the 16 values being compared), minimum - input (the smallest value kept in every lane), maximum - input (the largest value kept in every lane) */
+/* Return values: unsigned int with bit i set if value i is inside the range */
+/* Side effects: none */
+__attribute__((target("sse2")))
+static unsigned int range_mask_sse2(const short *values, __m128i minimum, __m128i maximum) {
+  __m128i low = _mm_loadu_si128((const __m128i *)values);
+  __m128i high = _mm_loadu_si128((const __m128i *)(values + 8));
+
+  /* A value is outside the range if the minimum is greater than it or if it is greater than the maximum */
+  __m128i low_outside = _mm_or_si128(_mm_cmpgt_epi16(minimum, low), _mm_cmpgt_epi16(low, maximum));
+  __m128i high_outside = _mm_or_si128(_mm_cmpgt_epi16(minimum, high), _mm_cmpgt_epi16(high, maximum));
+
+  /* Narrow the 16 bit lanes to bytes so one movemask gives one bit per value */
+  return ~(unsigned int)_mm_movemask_epi8(_mm_packs_epi16(low_outside, high_outside)) & 0xffff;
+}
+
+/* This function is the kernel used when the processor supports SSE2 but not AVX2 */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), minimum - input (the smallest value kept), maximum - input (the largest value kept), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+__attribute__((target("sse2")))
+static void scan_range_sse2(const short *column, int number_of_rows, short minimum, short maximum, uint64_t *bitmap) {
+  const __m128i minimums = _mm_set1_epi16(minimum);
+  const __m128i maximums = _mm_set1_epi16(maximum);
+  int full_words = number_of_rows / BITMAP_WORD_BITS;
+
+  for(int word = 0; word < full_words; word++) {
+    if(bitmap[word] == 0) {
+      continue;
+    }
+    const short *values = column + word * BITMAP_WORD_BITS;
+    uint64_t bits = 0;
+    for(int i = 0; i < 4; i++) {
+      bits |= (uint64_t)range_mask_sse2(values + i * 16, minimums, maximums) << (i * 16);
+    }
+    bitmap[word] &= bits;
+  }
+
+  /* The last rows that don't fill a whole word are compared one at a time */
+  if(number_of_rows % BITMAP_WORD_BITS != 0 && bitmap[full_words] != 0) {
+    bitmap[full_words] &= range_word_scalar(column, full_words * BITMAP_WORD_BITS, number_of_rows, minimum, maximum);
+  }
+}
+
+/* This function is the kernel adding up selected rows used when the processor supports SSE2 but not AVX2, 8 rows at a time */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), *bitmap - input (the rows selected), *stats - input/output (the sum, minimum and maximum being updated) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+__attribute__((target("sse2")))
+static void scan_stats_sse2(const short *column, int number_of_rows, const uint64_t *bitmap, ColumnStatsType *stats) {
+  const __m128i bit_values = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m128i largest = _mm_set1_epi16(SHRT_MAX);
+  const __m128i smallest = _mm_set1_epi16(SHRT_MIN);
+  const __m128i ones = _mm_set1_epi16(1);
+  __m128i minimums = largest;
+  __m128i maximums = smallest;
+  __m128i sums = _mm_setzero_si128();
+  int full_words = number_of_rows / BITMAP_WORD_BITS;
+  short lanes[8];
+  long long totals[2];
+
+  for(int word = 0; word < full_words; word++) {
+    uint64_t bits = bitmap[word];
+    if(bits == 0) {
+      continue;
+    }
+    const short *values = column + word * BITMAP_WORD_BITS;
+    __m128i word_sums = _mm_setzero_si128();
+    for(int i = 0; i < 8; i++) {
+      /* Turn 8 bits of the word into 8 lanes of all ones or all zeroes */
+      __m128i selected = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16((short)(bits >> (i * 8))), bit_values), bit_values);
+      __m128i value = _mm_loadu_si128((const __m128i *)(values + i * 8));
+      minimums = _mm_min_epi16(minimums, _mm_or_si128(_mm_and_si128(selected, value), _mm_andnot_si128(selected, largest)));
+      maximums = _mm_max_epi16(maximums, _mm_or_si128(_mm_and_si128(selected, value), _mm_andnot_si128(selected, smallest)));
+      word_sums = _mm_add_epi32(word_sums, _mm_madd_epi16(_mm_and_si128(selected, value), ones));
+    }
+
+    /* The 32 bit sums of one word can't overflow, widen them to 64 bits before adding them to the total */
+    __m128i signs = _mm_srai_epi32(word_sums, 31);
+    sums = _mm_add_epi64(sums, _mm_unpacklo_epi32(word_sums, signs));
+    sums = _mm_add_epi64(sums, _mm_unpackhi_epi32(word_sums, signs));
+  }
+
+  _mm_storeu_si128((__m128i *)totals, sums);
+  stats->sum += totals[0] + totals[1];
+  _mm_storeu_si128((__m128i *)lanes, minimums);
+  for(int i = 0; i < 8; i++) {
+    stats->minimum = (lanes[i] < stats->minimum) ? lanes[i] : stats->minimum;
+  }
+  _mm_storeu_si128((__m128i *)lanes, maximums);
+  for(int i = 0; i < 8; i++) {
+    stats->maximum = (lanes[i] > stats->maximum) ? lanes[i] : stats->maximum;
+  }
+
+  /* The last rows that don't fill a whole word are added one at a time */
+  if(number_of_rows % BITMAP_WORD_BITS != 0) {
+    stats_word_scalar(column, full_words * BITMAP_WORD_BITS, bitmap[full_words], stats);
+  }
+}
+
+/* This function compares 32 rows of a column at once with AVX2 */
+/* Parameters: *values - input (the 32 values being compared), minimum - input (the smallest value kept in every lane), maximum - input (the largest value kept in every lane) */
+/* Return values: unsigned int with bit i set if value i is inside the range */
+/* Side effects: none */
+__attribute__((target("avx2")))
+static unsigned int range_mask_avx2(const short *values, __m256i minimum, __m256i maximum) {
+  __m256i low = _mm256_loadu_si256((const __m256i *)values);
+  __m256i high = _mm256_loadu_si256((const __m256i *)(values + 16));
+
+  /* A value is outside the range if the minimum is greater than it or if it is greater than the maximum */
+  __m256i low_outside = _mm256_or_si256(_mm256_cmpgt_epi16(minimum, low), _mm256_cmpgt_epi16(low, maximum));
+  __m256i high_outside = _mm256_or_si256(_mm256_cmpgt_epi16(minimum, high), _mm256_cmpgt_epi16(high, maximum));
+
+  /* Narrowing to bytes works on each 128 bit half separately, the permute puts the 32 bytes back in row order */
+  __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low_outside, high_outside), 0xD8);
+  return ~(unsigned int)_mm256_movemask_epi8(packed);
+}
+
+/* This function is the kernel used when the processor supports AVX2 */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), minimum - input (the smallest value kept), maximum - input (the largest value kept), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+__attribute__((target("avx2")))
+static void scan_range_avx2(const short *column, int number_of_rows, short minimum, short maximum, uint64_t *bitmap) {
+  const __m256i minimums = _mm256_set1_epi16(minimum);
+  const __m256i maximums = _mm256_set1_epi16(maximum);
+  int full_words = number_of_rows / BITMAP_WORD_BITS;
+
+  for(int word = 0; word < full_words; word++) {
+    if(bitmap[word] == 0) {
+      continue;
+    }
+    const short *values = column + word * BITMAP_WORD_BITS;
+    uint64_t low = range_mask_avx2(values, minimums, maximums);
+    uint64_t high = range_mask_avx2(values + 32, minimums, maximums);
+    bitmap[word] &= low | (high << 32);
+  }
+
+  /* The last rows that don't fill a whole word are compared one at a time */
+  if(number_of_rows % BITMAP_WORD_BITS != 0 && bitmap[full_words] != 0) {
+    bitmap[full_words] &= range_word_scalar(column, full_words * BITMAP_WORD_BITS, number_of_rows, minimum, maximum);
+  }
+}
+
+/* This function is the kernel adding up selected rows used when the processor supports AVX2, 16 rows at a time */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), *bitmap - input (the rows selected), *stats - input/output (the sum, minimum and maximum being updated) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+__attribute__((target("avx2")))
+static void scan_stats_avx2(const short *column, int number_of_rows, const uint64_t *bitmap, ColumnStatsType *stats) {
+  const __m256i bit_values = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, (short)0x8000);
+  const __m256i largest = _mm256_set1_epi16(SHRT_MAX);
+  const __m256i smallest = _mm256_set1_epi16(SHRT_MIN);
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i minimums = largest;
+  __m256i maximums = smallest;
+  __m256i sums = _mm256_setzero_si256();
+  int full_words = number_of_rows / BITMAP_WORD_BITS;
+  short lanes[16];
+  long long totals[4];
+
+  for(int word = 0; word < full_words; word++) {
+    uint64_t bits = bitmap[word];
+    if(bits == 0) {
+      continue;
+    }
+    const short *values = column + word * BITMAP_WORD_BITS;
+    __m256i word_sums = _mm256_setzero_si256();
+    for(int i = 0; i < 4; i++) {
+      /* Turn 16 bits of the word into 16 lanes of all ones or all zeroes */
+      __m256i selected = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16((short)(bits >> (i * 16))), bit_values), bit_values);
+      __m256i value = _mm256_loadu_si256((const __m256i *)(values + i * 16));
+      minimums = _mm256_min_epi16(minimums, _mm256_blendv_epi8(largest, value, selected));
+      maximums = _mm256_max_epi16(maximums, _mm256_blendv_epi8(smallest, value, selected));
+      word_sums = _mm256_add_epi32(word_sums, _mm256_madd_epi16(_mm256_and_si256(selected, value), ones));
+    }
+
+    /* The 32 bit sums of one word can't overflow, widen them to 64 bits before adding them to the total */
+    sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(word_sums)));
+    sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(word_sums, 1)));
+  }
+
+  _mm256_storeu_si256((__m256i *)totals, sums);
+  stats->sum += totals[0] + totals[1] + totals[2] + totals[3];
+  _mm256_storeu_si256((__m256i *)lanes, minimums);
+  for(int i = 0; i < 16; i++) {
+    stats->minimum = (lanes[i] < stats->minimum) ? lanes[i] : stats->minimum;
+  }
+  _mm256_storeu_si256((__m256i *)lanes, maximums);
+  for(int i = 0; i < 16; i++) {
+    stats->maximum = (lanes[i] > stats->maximum) ? lanes[i] : stats->maximum;
+  }
+
+  /* The last rows that don't fill a whole word are added one at a time */
+  if(number_of_rows % BITMAP_WORD_BITS != 0) {
+    stats_word_scalar(column, full_words * BITMAP_WORD_BITS, bitmap[full_words], stats);
+  }
+}
+#endif
+
+/* This function picks the fastest kernels the processor running the server supports */
+/* Parameters: None */
+/* Return values: nothing since it's a void function */
+/* Side effects: sets range_scan, stats_scan and range_scan_name, only ran once through pthread_once */
+static void choose_range_scan(void) {
+  range_scan = scan_range_scalar;
+  stats_scan = scan_stats_scalar;
+  range_scan_name = "scalar";
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    range_scan = scan_range_avx2;
+    stats_scan = scan_stats_avx2;
+    range_scan_name = "avx2";
+  }
+  else if(__builtin_cpu_supports("sse2")) {
+    range_scan = scan_range_sse2;
+    stats_scan = scan_stats_sse2;
+    range_scan_name = "sse2";
+  }
+#endif
+}
+
+/* This function keeps the bits of the rows whose value inside a numeric column is inside a range */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), minimum - input (the smallest value kept), maximum - input (the largest value kept), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: picks the kernel the first time it is called */
+void column_scan_range(const short *column, int number_of_rows, short minimum, short maximum, uint64_t *bitmap) {
+  pthread_once(&range_scan_once, choose_range_scan);
+  range_scan(column, number_of_rows, minimum, maximum, bitmap);
+}
+
+/* This function counts the rows selected by a bitmap and finds the sum, the smallest and the largest of their values inside a numeric column */
+/* Parameters: *column - input (the values of every row), number_of_rows - input (the amount of rows), *bitmap - input (the rows selected, the bits past the last row must be cleared), *stats - output (the statistics of the rows selected) */
+/* Return values: nothing since it's a void function */
+/* Side effects: picks the kernel the first time it is called */
+void column_scan_stats(const short *column, int number_of_rows, const uint64_t *bitmap, ColumnStatsType *stats) {
+  pthread_once(&range_scan_once, choose_range_scan);
+
+  stats->count = bitmap_count(bitmap, bitmap_words(number_of_rows));
+  stats->sum = 0;
+  stats->minimum = SHRT_MAX;
+  stats->maximum = SHRT_MIN;
+  stats_scan(column, number_of_rows, bitmap, stats);
+
+  if(stats->count == 0) {
+    stats->minimum = 0;
+    stats->maximum = 0;
+  }
+}
+
+/* This function returns the name of the kernel used to scan columns */
+/* Parameters: None */
+/* Return values: char pointer to "avx2", "sse2" or "scalar" */
+/* Side effects: picks the kernel if no column was scanned yet */
+const char *column_scan_kernel_name(void) {
+  pthread_once(&range_scan_once, choose_range_scan);
+  return range_scan_name;
+}
@@ -0,0 +1,46 @@
+/*****************************************************************************/
+/* */
+/* column_scan.h */
+/* */
+/* Purpose: This is a header file that contains constants and declaration of all functions used in the column_scan.c file */
+/* How to use: use #include "column_scan.h" at the top of any .c files that scan the numeric columns of the pokemon table into selection bitmaps */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef COLUMN_SCAN_H_
+#define COLUMN_SCAN_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//Variety of constants defined
+#define BITMAP_WORD_BITS 64           //Constant to represent the amount of rows covered by one word of a selection bitmap
+
+/* This structure contains the statistics of the rows of a numeric column selected by a bitmap */
+typedef struct ColumnStats {
+  int count;                    //Amount of rows selected
+  long sum;                     //Sum of the values of the rows selected
+  short minimum;                //Smallest value of the rows selected, 0 if no row is selected
+  short maximum;                //Largest value of the rows selected, 0 if no row is selected
+} ColumnStatsType;
+
+/* This is the type of the kernels keeping the bits of the rows whose value inside a short column is inside a range */
+typedef void (*RangeScanType)(const short *column, int number_of_rows, short minimum, short maximum, uint64_t *bitmap);
+
+/* This is the type of the kernels adding up the rows of a short column selected by a bitmap */
+typedef void (*StatsScanType)(const short *column, int number_of_rows, const uint64_t *bitmap, ColumnStatsType *stats);
+
+/* all function prototypes for functions in column_scan.c */
+int bitmap_words(int number_of_rows);
+void bitmap_fill(uint64_t *bitmap, int number_of_rows);
+void bitmap_and(uint64_t *destination, const uint64_t *source, int words);
+void bitmap_or(uint64_t *destination, const uint64_t *source, int words);
+int bitmap_count(const uint64_t *bitmap, int words);
+void column_scan_range(const short *column, int number_of_rows, short minimum, short maximum, uint64_t *bitmap);
+void column_scan_stats(const short *column, int number_of_rows, const uint64_t *bitmap, ColumnStatsType *stats);
+const char *column_scan_kernel_name(void);
+
+#endif //end of header file
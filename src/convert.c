@@ -0,0 +1,120 @@
+/*****************************************************************************/
+/* */
+/* convert.c */
+/* Purpose: This file converts a pokemon file into a binary image that the server maps when it starts instead of parsing the text, and converts an image back into a pokemon file in text. */
+/* How to use: Make sure to compile the file and then link it with pokemon_table.c, table_image.c and protocol.c, this is already done for you in the MakeFile. Run ./convert pokemon.csv to write pokemon.pkb, or ./convert pokemon.pkb pokemon.csv to get the text back, then start the server with the file it writes. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "protocol.h"
+#include "pokemon_table.h"
+#include "table_image.h"
+
+/* This function writes the whole text of a table to a file, writing again after a partial write */
+/* Parameters: *table - input (the table whose text is written), fd - input (the file being written) */
+/* Return values: int, C_OK (0) if every byte was written and C_NOK (-1) if the file can't be written */
+/* Side effects: writes to the file */
+static int write_text(const PokemonTableType *table, int fd) {
+  const char *data = table->file;
+  long size = table->file_size;
+
+  while(size > 0) {
+    ssize_t written = write(fd, data, size);
+    if(written < 0 && errno == EINTR) {
+      continue;
+    }
+    if(written <= 0) {
+      return C_NOK;
+    }
+    data += written;
+    size -= written;
+  }
+  return C_OK;
+}
+
+/* This function names the image written for a pokemon file when no output is given, the name of the file with its extension replaced by IMAGE_FILE_EXTENSION */
+/* Parameters: *input_name - input (the name of the pokemon file) */
+/* Return values: char pointer to the name of the image */
+/* Side effects: allocates memory for the name, exits the program if it can't be allocated */
+static char *image_name(const char *input_name) {
+  const char *extension = strrchr(input_name, '.');
+  int length = (extension != NULL && strchr(extension, '/') == NULL) ? extension - input_name : strlen(input_name);
+  char *name = (char *)malloc(length + strlen(IMAGE_FILE_EXTENSION) + 1);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(name == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(name, input_name, length);
+  strcpy(name + length, IMAGE_FILE_EXTENSION);
+  return name;
+}
+
+/* Parameters: argc - input (the amount of command line arguments), *argv[] - input (the pokemon file or image being converted, followed by the name of the file written) */
+/* Return values: int, 0 if the file was converted and 1 if it wasn't */
+/* Side effects: writes the converted file next to its final name, then moves it over that name once it reached the disk so the server never reads a partial file */
+int main(int argc, char *argv[]) {
+  PokemonTableType table;
+
+  if(argc != 2 && argc != 3) {
+    printf("Usage: %s pokemon_file [output_file] \n", argv[0]);
+    printf("A pokemon file in text is converted into a binary image (%s by default), an image is converted back into text \n", IMAGE_FILE_EXTENSION);
+    return 1;
+  }
+
+  /* Read the input the way the server does, an image is mapped and text is parsed */
+  int input_is_image = image_is_file(argv[1]);
+  int result = (input_is_image == C_OK) ? image_load(&table, argv[1]) : table_load_csv(&table, argv[1]);
+  if(result == C_NOK) {
+    printf("Could not read %s \n", argv[1]);
+    return 1;
+  }
+  if(input_is_image == C_OK && argc != 3) {
+    printf("Give the name of the pokemon file to write the text of %s to \n", argv[1]);
+    table_free(&table);
+    return 1;
+  }
+
+  char *output_name = (argc == 3) ? strdup(argv[2]) : image_name(argv[1]);
+  char *temporary_name = (char *)malloc(strlen(output_name) + strlen(IMAGE_CONVERSION_SUFFIX) + 1);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(output_name == NULL || temporary_name == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  sprintf(temporary_name, "%s%s", output_name, IMAGE_CONVERSION_SUFFIX);
+
+  /* A server reloading the output never sees a file that is only partly written, the new one is moved over it in a single step */
+  int fd = open(temporary_name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  result = (fd < 0) ? C_NOK : (input_is_image == C_OK) ? write_text(&table, fd) : image_write(&table, fd);
+  if(result == C_NOK || fsync(fd) < 0 || rename(temporary_name, output_name) < 0) {
+    printf("Could not write %s \n", output_name);
+    if(fd >= 0) {
+      close(fd);
+      unlink(temporary_name);
+    }
+    result = C_NOK;
+  }
+  else {
+    close(fd);
+    printf("Converted %d pokemon from %s into %s \n", table.number_of_rows, argv[1], output_name);
+  }
+
+  table_free(&table);
+  free(output_name);
+  free(temporary_name);
+  return (result == C_OK) ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/*****************************************************************************/
+/* */
+/* dynamic_array.c */
+/* Purpose: This file contains the functions the client uses to parse the pokemon it receives and store them inside its dynamic array, kept apart from the menu and the sockets of client.c so they can be measured on their own by microbench.c. */
+/* How to use: Make sure to compile the file and then link this file when compiling the client and microbench executables. This is already done for you in the MakeFile. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+//importing the header file included with the program to get access to its functions, constants and structs
+#include "dynamic_array.h"
+
+/* This function checks if a input string matches the name of a pokemon type */
+/* Parameters: *input_type - input (the char pointer that is being checked) */
+/* Return values: int, return C_OK (0) if input_type is a valid pokemon type, return C_NOK (-1) if input_type is not a valid pokemon type */
+/* Side effects: lots of conditional checking */
+int check_valid_pokemon_type(char *input_type) {
+
+  /* Use strcmp to compare to all valid pokemon types according to the Pokemon franchise */
+  if (strcmp(input_type, "Normal") == 0 || strcmp(input_type, "Fire") == 0 || strcmp(input_type, "Water") == 0 || strcmp(input_type, "Grass") == 0 || strcmp(input_type, "Electric") == 0 || strcmp(input_type, "Ice") == 0 || strcmp(input_type, "Fighting") == 0 || strcmp(input_type, "Poison") == 0 || strcmp(input_type, "Ground") == 0 || strcmp(input_type, "Flying") == 0 || strcmp(input_type, "Psychic") == 0 || strcmp(input_type, "Bug") == 0 || strcmp(input_type, "Rock") == 0 || strcmp(input_type, "Ghost") == 0 || strcmp(input_type, "Dragon") == 0 || strcmp(input_type, "Dark") == 0 || strcmp(input_type, "Steel") == 0 || strcmp(input_type, "Fairy") == 0) {
+    return C_OK;
+  }
+  return C_NOK;
+}
+
+/* This function returns the next field of a line being split, or an empty string once the line has no field left */
+/* Parameters: **line - input/output (the rest of the line, moved past the field), *separator - input (the character that separates the fields) */
+/* Return values: char pointer to the null-terminated field, inside the line */
+/* Side effects: uses strsep which replaces the separator after the field with a null character */
+static char *next_field(char **line, char *separator) {
+  char *field = strsep(line, separator);
+  return (field == NULL) ? "" : field;
+}
+
+/* This function convers a string containing pokemon information into a pokemon struct containing information about all properties about a Pokemon */
+/* NOTE: This function is primarily copied from the function line_to_student from ReadCSV.c from the Professor's Sample Code */
+/* Parameters: *line - input/output (line that information is being parsed from, it must stay alive as long as the pokemon), *new_pokemon - output (pokemon structure that has its properties filled), *separator - input (the character that separates the infomration in the file) */
+/* Return values: nothing since the function is void  */
+/* Side effects: uses strsep which modifies the input string, the name and types of the pokemon point into it instead of being copied */
+void line_to_pokemon(char *line, PokemonType *new_pokemon, char *separator) {
+
+  /* Split the line into its fields in place using the next_field function */
+  char *number = next_field(&line, separator);
+  new_pokemon->name = next_field(&line, separator);
+  new_pokemon->first_type = next_field(&line, separator);
+  new_pokemon->second_type = next_field(&line, separator);
+  char *total_stats = next_field(&line, separator);
+  char *health_points = next_field(&line, separator);
+  char *attack = next_field(&line, separator);
+  char *defense = next_field(&line, separator);
+  char *special_attack = next_field(&line, separator);
+  char *special_defense = next_field(&line, separator);
+  char *speed = next_field(&line, separator);
+  char *generation = next_field(&line, separator);
+  char *legendary = next_field(&line, separator);
+
+  /* For all of the numeric properties of the pokemon, use strtol to convert the string containing the information about the property to a numeric data type */
+  new_pokemon->number = strtol(number, NULL, 10);
+  new_pokemon->total_stats = strtol(total_stats, NULL, 10);
+  new_pokemon->health_points = strtol(health_points, NULL, 10);
+  new_pokemon->attack = strtol(attack, NULL, 0);
+  new_pokemon->defense = strtol(defense, NULL, 0);
+  new_pokemon->special_attack = strtol(special_attack, NULL, 0);
+  new_pokemon->special_defense = strtol(special_defense, NULL, 0);
+  new_pokemon->speed = strtol(speed, NULL, 0);
+  new_pokemon->generation = strtol(generation, NULL, 0);
+
+  /* Check if the pokemon is legendary or not, fill the legendary property in new_pokemon with a n char if its not a legendary and a y if it is a legendary*/
+  new_pokemon->legendary = (strcmp(legendary, "False") == 0) ? 'n' : 'y';
+}
+
+/* This function makes sure the dynamic array can hold more pokemon without growing, doubling its capacity as many times as needed so adding pokemon one at a time stays linear */
+/* Parameters: *pokemon_dynamic_array - input/output (a pointer to a dynamic array), number_of_pokemon - input (the amount of pokemon about to be added) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may reallocate the elements of the dynamic array, which must only be done while holding the mutex, exits the program if memory can't be allocated */
+void reserve_pokemon(DynamicArrayType *pokemon_dynamic_array, int number_of_pokemon) {
+  long needed = (long)pokemon_dynamic_array->darray_size + number_of_pokemon;
+
+  if(number_of_pokemon <= 0 || needed <= pokemon_dynamic_array->darray_capacity) {
+    return;
+  }
+
+  long capacity = (pokemon_dynamic_array->darray_capacity > 0) ? pokemon_dynamic_array->darray_capacity : DYNAMIC_ARRAY_INITIAL_CAPACITY;
+  while(capacity < needed) {
+    capacity *= 2;
+  }
+  PokemonType *elements;
+
+  /* A running save reads the current elements without the mutex, so they are copied instead of being moved and the save frees them once it is done */
+  if(pokemon_dynamic_array->darray_elements != NULL && pokemon_dynamic_array->darray_elements == pokemon_dynamic_array->saved_elements) {
+    elements = (PokemonType *)malloc(sizeof(PokemonType) * capacity);
+    if(elements != NULL) {
+      memcpy(elements, pokemon_dynamic_array->darray_elements, sizeof(PokemonType) * pokemon_dynamic_array->darray_size);
+    }
+  }
+  else {
+    elements = (PokemonType *)realloc(pokemon_dynamic_array->darray_elements, sizeof(PokemonType) * capacity);
+  }
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(elements == NULL || capacity > INT_MAX) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  pokemon_dynamic_array->darray_elements = elements;
+  pokemon_dynamic_array->darray_capacity = (int)capacity;
+}
+
+/* This function adds a pokemon to the end of the dynamic array and also resizes the dynamic array as necessary. */
+/* NOTE: This function is primarily copied from the function addStudent() of p7-dynArr.c from Module 9 */
+/* Parameters: *pokemon - input (a pointer to a pokemon, copied into the array), *pokemon_dynamic_array - input/output (a pointer to a dynamic array) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may double the size of the dynamic array */
+void add_pokemon(const PokemonType *pokemon, DynamicArrayType *pokemon_dynamic_array) {
+  reserve_pokemon(pokemon_dynamic_array, 1);
+  pokemon_dynamic_array->darray_elements[pokemon_dynamic_array->darray_size++] = *pokemon;
+}
+
+/* This function gives a block of characters to the string arena, which frees it along with every other block */
+/* Parameters: *arena - input/output (the arena keeping the block), *block - input (the block allocated with malloc) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may reallocate the list of blocks, exits the program if memory can't be allocated */
+void string_arena_keep(StringArenaType *arena, char *block) {
+  if(arena->number_of_blocks == arena->blocks_capacity) {
+    int capacity = (arena->blocks_capacity > 0) ? arena->blocks_capacity * 2 : STRING_ARENA_INITIAL_BLOCKS;
+    char **blocks = (char **)realloc(arena->blocks, sizeof(char *) * capacity);
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if(blocks == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+    arena->blocks = blocks;
+    arena->blocks_capacity = capacity;
+  }
+  arena->blocks[arena->number_of_blocks++] = block;
+}
+
+/* This function frees every block of the string arena at once */
+/* Parameters: *arena - input/output (the arena being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees every block, every string pointing into them can't be used anymore */
+void string_arena_free(StringArenaType *arena) {
+  for(int i = 0; i < arena->number_of_blocks; i++) {
+    free(arena->blocks[i]);
+  }
+  free(arena->blocks);
+  memset(arena, 0, sizeof(StringArenaType));
+}
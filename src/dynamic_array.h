@@ -0,0 +1,27 @@
+/*****************************************************************************/
+/* */
+/* dynamic_array.h */
+/* */
+/* Purpose: This is a header file that contains the declaration of all functions used in the dynamic_array.c file */
+/* How to use: use #include "dynamic_array.h" at the top of any .c files that need to parse received pokemon or store them inside a dynamic array */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef DYNAMIC_ARRAY_H_
+#define DYNAMIC_ARRAY_H_
+
+//importing the header file of the client for the pokemon and the dynamic array
+#include "client.h"
+
+/* all function prototypes for functions in dynamic_array.c */
+int check_valid_pokemon_type(char *input_type);
+void line_to_pokemon(char *line, PokemonType *new_pokemon, char *separator);
+void reserve_pokemon(DynamicArrayType *pokemon_dynamic_array, int number_of_pokemon);
+void add_pokemon(const PokemonType *pokemon, DynamicArrayType *pokemon_dynamic_array);
+void string_arena_keep(StringArenaType *arena, char *block);
+void string_arena_free(StringArenaType *arena);
+
+#endif //end of header file
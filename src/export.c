@@ -0,0 +1,477 @@
+/*****************************************************************************/
+/* */
+/* export.c */
+/* Purpose: This file writes the pokemon received by the client into a saved file, as lines of the pokemon file, as JSON Lines or as binary columns that can be loaded with a single read. Large saves are encoded by several threads at once, each taking a range of pokemon, and the ranges are written one after the other. */
+/* How to use: Make sure to compile the file and then link it with client.c, this is already done for you in the MakeFile. The format of a saved file is chosen by the extension of its name: EXPORT_JSON_LINES_EXTENSION for JSON Lines, EXPORT_COLUMNS_EXTENSION for binary columns and anything else for lines of the pokemon file. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+//importing the header file included with the program to get access to its functions, constants and structs
+#include "export.h"
+
+/* This function chooses the format of a saved file from the extension of its name */
+/* Parameters: *file_name - input (the name of the saved file) */
+/* Return values: ExportFormatType, the format the file is written in */
+/* Side effects: none */
+ExportFormatType export_format(const char *file_name) {
+  const char *extension = strrchr(file_name, '.');
+
+  if(extension != NULL && strcmp(extension, EXPORT_JSON_LINES_EXTENSION) == 0) {
+    return EXPORT_JSON_LINES;
+  }
+  if(extension != NULL && strcmp(extension, EXPORT_COLUMNS_EXTENSION) == 0) {
+    return EXPORT_COLUMNS;
+  }
+  return EXPORT_CSV;
+}
+
+/* This function writes a number in decimal two digits at a time, the way printf would write it with %d but without parsing a format */
+/* Parameters: *buffer - output (where the digits are written, it must have room for MAX_NUMBER_LENGTH characters), value - input (the number being written) */
+/* Return values: int, the amount of characters written, no null character is added */
+/* Side effects: none */
+static int format_number(char *buffer, int value) {
+  static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+  char digits[MAX_NUMBER_LENGTH];
+  int position = MAX_NUMBER_LENGTH;
+  unsigned int magnitude = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+
+  /* Write the digits from the end of the number, two of them for every division */
+  while (magnitude >= 100) {
+    unsigned int pair = (magnitude % 100) * 2;
+    magnitude /= 100;
+    digits[--position] = digit_pairs[pair + 1];
+    digits[--position] = digit_pairs[pair];
+  }
+  if (magnitude >= 10) {
+    digits[--position] = digit_pairs[magnitude * 2 + 1];
+    digits[--position] = digit_pairs[magnitude * 2];
+  }
+  else {
+    digits[--position] = '0' + magnitude;
+  }
+  if (value < 0) {
+    digits[--position] = '-';
+  }
+
+  memcpy(buffer, digits + position, MAX_NUMBER_LENGTH - position);
+  return MAX_NUMBER_LENGTH - position;
+}
+
+/* This function converts a pokemon struct to a string that contains all the properties of that Pokemon */
+/* NOTE: This function is primarily copied from the function student_to_line from ReadCSV.c from the Professor's Sample Code */
+/* Parameters: *line_to_write - output (where the pokemon properties are written, it must have room for the name, the types and MAX_LINE_NUMBERS_SIZE more characters), *pokemon_to_write - input (the pokemon struct that we will read from), *separator - input (the character that separates each of the properties of the pokemon inside the line_to_write string) */
+/* Return values: int, the amount of characters written, no null character or new line is added */
+/* Side effects: none, every property is copied once to the end of the line instead of searching for the end of the line every time */
+int pokemon_to_line(char *line_to_write, const PokemonType *pokemon_to_write, char *separator) {
+  const char separator_character = separator[0];
+  char *end = line_to_write;
+  int length;
+
+  /* Write each of the properties (except the legendary property) followed by the separator */
+  end += format_number(end, pokemon_to_write->number);
+  *end++ = separator_character;
+  length = strlen(pokemon_to_write->name);
+  memcpy(end, pokemon_to_write->name, length);
+  end += length;
+  *end++ = separator_character;
+  length = strlen(pokemon_to_write->first_type);
+  memcpy(end, pokemon_to_write->first_type, length);
+  end += length;
+  *end++ = separator_character;
+  length = strlen(pokemon_to_write->second_type);
+  memcpy(end, pokemon_to_write->second_type, length);
+  end += length;
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->total_stats);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->health_points);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->attack);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->defense);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->special_attack);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->special_defense);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->speed);
+  *end++ = separator_character;
+  end += format_number(end, pokemon_to_write->generation);
+  *end++ = separator_character;
+
+  /* Check the legendary variable, if its the 'y' char, write the word True to the line_to_write, if its the 'n char, write the word False */
+  if(pokemon_to_write->legendary == 'y') {
+    memcpy(end, "True", 4);
+    end += 4;
+  }
+  else {
+    memcpy(end, "False", 5);
+    end += 5;
+  }
+  return end - line_to_write;
+}
+
+/* This function writes a string between quotes, escaping the characters JSON doesn't allow inside a string */
+/* Parameters: *buffer - output (where the string is written, it must have room for JSON_ESCAPE_SIZE characters per character of the string and 2 quotes), *string - input (the string being written) */
+/* Return values: int, the amount of characters written, no null character is added */
+/* Side effects: none */
+static int format_json_string(char *buffer, const char *string) {
+  static const char hexadecimal_digits[] = "0123456789abcdef";
+  char *end = buffer;
+
+  *end++ = '"';
+  for(const unsigned char *character = (const unsigned char *)string; *character != '\0'; character++) {
+    if(*character == '"' || *character == '\\') {
+      *end++ = '\\';
+      *end++ = *character;
+    }
+    else if(*character < 0x20) {
+      memcpy(end, "\\u00", 4);
+      end[4] = hexadecimal_digits[*character >> 4];
+      end[5] = hexadecimal_digits[*character & 0xf];
+      end += JSON_ESCAPE_SIZE;
+    }
+    else {
+      *end++ = *character;
+    }
+  }
+  *end++ = '"';
+  return end - buffer;
+}
+
+/* This function writes a property of a JSON object whose value is a number, followed by a comma */
+/* Parameters: *buffer - output (where the property is written), *key - input (the name of the property with its quotes and colon, like "hp":), value - input (the value of the property) */
+/* Return values: int, the amount of characters written, no null character is added */
+/* Side effects: none */
+static int format_json_number(char *buffer, const char *key, int value) {
+  int length = strlen(key);
+  memcpy(buffer, key, length);
+  length += format_number(buffer + length, value);
+  buffer[length++] = ',';
+  return length;
+}
+
+/* This function converts a pokemon struct to a JSON object on one line, its properties are named like the stats of a filter query */
+/* Parameters: *line_to_write - output (where the object is written, it must have room for the escaped name and types and MAX_JSON_LINE_FIXED_SIZE more characters), *pokemon_to_write - input (the pokemon struct that we will read from) */
+/* Return values: int, the amount of characters written, no null character or new line is added */
+/* Side effects: none */
+int pokemon_to_json(char *line_to_write, const PokemonType *pokemon_to_write) {
+  char *end = line_to_write;
+
+  end += format_json_number(end, "{\"number\":", pokemon_to_write->number);
+  memcpy(end, "\"name\":", 7);
+  end += 7;
+  end += format_json_string(end, pokemon_to_write->name);
+  memcpy(end, ",\"type1\":", 9);
+  end += 9;
+  end += format_json_string(end, pokemon_to_write->first_type);
+  memcpy(end, ",\"type2\":", 9);
+  end += 9;
+  end += format_json_string(end, pokemon_to_write->second_type);
+  *end++ = ',';
+  end += format_json_number(end, "\"total\":", pokemon_to_write->total_stats);
+  end += format_json_number(end, "\"hp\":", pokemon_to_write->health_points);
+  end += format_json_number(end, "\"attack\":", pokemon_to_write->attack);
+  end += format_json_number(end, "\"defense\":", pokemon_to_write->defense);
+  end += format_json_number(end, "\"sp_attack\":", pokemon_to_write->special_attack);
+  end += format_json_number(end, "\"sp_defense\":", pokemon_to_write->special_defense);
+  end += format_json_number(end, "\"speed\":", pokemon_to_write->speed);
+  end += format_json_number(end, "\"generation\":", pokemon_to_write->generation);
+
+  const char *legendary = (pokemon_to_write->legendary == 'y') ? "\"legendary\":true}" : "\"legendary\":false}";
+  int length = strlen(legendary);
+  memcpy(end, legendary, length);
+  end += length;
+  return end - line_to_write;
+}
+
+/* This function writes the whole content of a buffer to a file, writing again after a partial write */
+/* Parameters: fd - input (the file being written), *buffer - input (the characters being written), size - input (the amount of characters inside buffer) */
+/* Return values: int, C_OK (0) if every character was written and C_NOK (-1) if the file can't be written */
+/* Side effects: writes to the file */
+static int write_export_buffer(int fd, const char *buffer, long size) {
+  while(size > 0) {
+    ssize_t written = write(fd, buffer, size);
+    if(written < 0 && errno == EINTR) {
+      continue;
+    }
+    if(written <= 0) {
+      return C_NOK;
+    }
+    buffer += written;
+    size -= written;
+  }
+  return C_OK;
+}
+
+/* This function is ran by the threads encoding a save in text, it encodes the range of pokemon of its task into the buffer of the task */
+/* Parameters: *arg - input/output (void* casted parameter containing an ExportTaskType struct) */
+/* Return values: NULL since the result is stored inside the task */
+/* Side effects: may grow the buffer of the task, exits the program if memory can't be allocated */
+void *encode_text(void *arg) {
+  ExportTaskType *task = (ExportTaskType *)arg;
+  task->size = 0;
+
+  for(int i = 0; i < task->number_of_pokemon; i++) {
+    const PokemonType *pokemon = &task->pokemon[i];
+    long strings_length = strlen(pokemon->name) + strlen(pokemon->first_type) + strlen(pokemon->second_type);
+    long longest_line = (task->format == EXPORT_JSON_LINES) ? strings_length * JSON_ESCAPE_SIZE + MAX_JSON_LINE_FIXED_SIZE : strings_length + MAX_LINE_NUMBERS_SIZE;
+
+    /* Double the size of the buffer once the next line may not fit in it anymore */
+    if(task->size + longest_line > task->capacity) {
+      long capacity = (task->capacity > 0) ? task->capacity : EXPORT_BUFFER_SIZE;
+      while(task->size + longest_line > capacity) {
+        capacity *= 2;
+      }
+      char *buffer = (char *)realloc(task->buffer, capacity);
+
+      /* Check if memory is allocated properly, print error message and exit if not */
+      if(buffer == NULL) {
+        printf("An error occured while allocating memory. The program will now exit \n");
+        exit(EXIT_FAILURE);
+      }
+      task->buffer = buffer;
+      task->capacity = capacity;
+    }
+
+    task->size += (task->format == EXPORT_JSON_LINES) ? pokemon_to_json(task->buffer + task->size, pokemon) : pokemon_to_line(task->buffer + task->size, pokemon, SEPARATOR);
+    task->buffer[task->size++] = '\n';
+  }
+  return NULL;
+}
+
+/* This function chooses how many threads encode a save, one per processor up to EXPORT_MAX_THREADS and no more than there are ranges of EXPORT_ROWS_PER_TASK pokemon */
+/* Parameters: number_of_pokemon - input (the amount of pokemon being saved) */
+/* Return values: int, the amount of threads, 1 for a small save which is encoded by the save thread alone */
+/* Side effects: none */
+int export_thread_count(int number_of_pokemon) {
+  long number_of_processors = sysconf(_SC_NPROCESSORS_ONLN);
+  long number_of_ranges = (number_of_pokemon + (long)EXPORT_ROWS_PER_TASK - 1) / EXPORT_ROWS_PER_TASK;
+  long number_of_threads = (number_of_processors < EXPORT_MAX_THREADS) ? number_of_processors : EXPORT_MAX_THREADS;
+
+  if(number_of_threads > number_of_ranges) {
+    number_of_threads = number_of_ranges;
+  }
+  return (number_of_threads > 1) ? (int)number_of_threads : 1;
+}
+
+/* This function runs a function on every task at once, the calling thread runs the first task itself and waits for the others */
+/* Parameters: *tasks - input/output (the tasks being ran), number_of_tasks - input (the amount of tasks), *function - input (the function ran on every task) */
+/* Return values: nothing since it's a void function */
+/* Side effects: starts and joins a thread per task after the first, a task whose thread can't be started is ran by the calling thread */
+void run_export_tasks(ExportTaskType *tasks, int number_of_tasks, void *(*function)(void *)) {
+  pthread_t threads[EXPORT_MAX_THREADS];
+  char thread_was_started[EXPORT_MAX_THREADS];
+
+  for(int i = 1; i < number_of_tasks; i++) {
+    thread_was_started[i] = (pthread_create(&threads[i], NULL, function, &tasks[i]) == 0) ? C_OK : C_NOK;
+  }
+  function(&tasks[0]);
+  for(int i = 1; i < number_of_tasks; i++) {
+    if(thread_was_started[i] == C_OK) {
+      pthread_join(threads[i], NULL);
+    }
+    else {
+      function(&tasks[i]);
+    }
+  }
+}
+
+/* This function appends pokemon to a saved file in text, as lines of the pokemon file or as JSON Lines. The pokemon are encoded EXPORT_ROWS_PER_TASK at a time by every thread at once, then the text of every range is written in order */
+/* Parameters: fd - input (the file being written), *pokemon - input (the first pokemon being written), number_of_pokemon - input (the amount of pokemon being written), format - input (EXPORT_CSV or EXPORT_JSON_LINES) */
+/* Return values: int, C_OK (0) if every pokemon was written and C_NOK (-1) if the file can't be written */
+/* Side effects: starts threads, allocates a buffer per thread and frees them before returning, exits the program if memory can't be allocated, writes to the file */
+int export_pokemon(int fd, const PokemonType *pokemon, int number_of_pokemon, ExportFormatType format) {
+  ExportTaskType tasks[EXPORT_MAX_THREADS];
+  int number_of_threads = export_thread_count(number_of_pokemon);
+  int result = C_OK;
+
+  memset(tasks, 0, sizeof(tasks));
+  for(int i = 0; i < number_of_threads; i++) {
+    tasks[i].format = format;
+  }
+
+  /* Give every thread the next range of pokemon, then write what they encoded before giving them the ranges after it, so at most one range per thread is held in memory */
+  int first_pokemon = 0;
+  while(first_pokemon < number_of_pokemon && result == C_OK) {
+    int number_of_tasks = 0;
+    while(number_of_tasks < number_of_threads && first_pokemon < number_of_pokemon) {
+      int remaining = number_of_pokemon - first_pokemon;
+      tasks[number_of_tasks].pokemon = pokemon + first_pokemon;
+      tasks[number_of_tasks].number_of_pokemon = (remaining < EXPORT_ROWS_PER_TASK) ? remaining : EXPORT_ROWS_PER_TASK;
+      first_pokemon += tasks[number_of_tasks].number_of_pokemon;
+      number_of_tasks++;
+    }
+
+    run_export_tasks(tasks, number_of_tasks, encode_text);
+    for(int i = 0; i < number_of_tasks && result == C_OK; i++) {
+      result = write_export_buffer(fd, tasks[i].buffer, tasks[i].size);
+    }
+  }
+
+  for(int i = 0; i < number_of_threads; i++) {
+    free(tasks[i].buffer);
+  }
+  return result;
+}
+
+/* This function rounds an offset inside a binary columns file up to the alignment of its columns */
+/* Parameters: offset - input (the offset being rounded) */
+/* Return values: long, the smallest multiple of EXPORT_COLUMNS_ALIGNMENT that is not smaller than offset */
+/* Side effects: none */
+static long align_column(long offset) {
+  return (offset + EXPORT_COLUMNS_ALIGNMENT - 1) / EXPORT_COLUMNS_ALIGNMENT * EXPORT_COLUMNS_ALIGNMENT;
+}
+
+/* This function is ran by the threads encoding a save in binary columns, it counts the bytes the names and types of the range of its task take inside the strings column */
+/* Parameters: *arg - input/output (void* casted parameter containing an ExportTaskType struct) */
+/* Return values: NULL since the result is stored inside strings_offset of the task */
+/* Side effects: none */
+void *measure_strings(void *arg) {
+  ExportTaskType *task = (ExportTaskType *)arg;
+  long size = 0;
+
+  for(int i = 0; i < task->number_of_pokemon; i++) {
+    size += strlen(task->pokemon[i].name) + strlen(task->pokemon[i].first_type) + strlen(task->pokemon[i].second_type) + 3;
+  }
+  task->strings_offset = size;
+  return NULL;
+}
+
+/* This function copies a string to the strings column of a binary columns file and returns where it starts */
+/* Parameters: *strings - output (the strings column), *offset - input/output (where the string is copied, moved past its null character), *string - input (the string being copied) */
+/* Return values: int32_t, the offset of the string inside the strings column */
+/* Side effects: none */
+static int32_t copy_column_string(char *strings, long *offset, const char *string) {
+  int32_t start = *offset;
+  int length = strlen(string) + 1;
+  memcpy(strings + start, string, length);
+  *offset += length;
+  return start;
+}
+
+/* This function is ran by the threads encoding a save in binary columns, it writes the range of pokemon of its task into every column of the file, where the rows and the strings of the range start */
+/* Parameters: *arg - input/output (void* casted parameter containing an ExportTaskType struct) */
+/* Return values: NULL since the range is written into the columns shared by every task */
+/* Side effects: none, every task writes to different bytes of the columns */
+void *encode_columns(void *arg) {
+  ExportTaskType *task = (ExportTaskType *)arg;
+  const ExportColumnsHeaderType *header = task->header;
+  int16_t *numbers[EXPORT_NUMERIC_COLUMNS];
+  long strings_offset = task->strings_offset;
+
+  for(int column = 0; column < EXPORT_NUMERIC_COLUMNS; column++) {
+    numbers[column] = (int16_t *)(task->columns + header->columns[column]) + task->first_row;
+  }
+  char *legendary = task->columns + header->columns[EXPORT_COLUMN_LEGENDARY] + task->first_row;
+  int32_t *names = (int32_t *)(task->columns + header->columns[EXPORT_COLUMN_NAME]) + task->first_row;
+  int32_t *first_types = (int32_t *)(task->columns + header->columns[EXPORT_COLUMN_FIRST_TYPE]) + task->first_row;
+  int32_t *second_types = (int32_t *)(task->columns + header->columns[EXPORT_COLUMN_SECOND_TYPE]) + task->first_row;
+  char *strings = task->columns + header->columns[EXPORT_COLUMN_STRINGS];
+
+  for(int i = 0; i < task->number_of_pokemon; i++) {
+    const PokemonType *pokemon = &task->pokemon[i];
+    numbers[EXPORT_COLUMN_NUMBER][i] = pokemon->number;
+    numbers[EXPORT_COLUMN_TOTAL][i] = pokemon->total_stats;
+    numbers[EXPORT_COLUMN_HP][i] = pokemon->health_points;
+    numbers[EXPORT_COLUMN_ATTACK][i] = pokemon->attack;
+    numbers[EXPORT_COLUMN_DEFENSE][i] = pokemon->defense;
+    numbers[EXPORT_COLUMN_SP_ATTACK][i] = pokemon->special_attack;
+    numbers[EXPORT_COLUMN_SP_DEFENSE][i] = pokemon->special_defense;
+    numbers[EXPORT_COLUMN_SPEED][i] = pokemon->speed;
+    numbers[EXPORT_COLUMN_GENERATION][i] = pokemon->generation;
+    legendary[i] = (pokemon->legendary == 'y') ? 1 : 0;
+    names[i] = copy_column_string(strings, &strings_offset, pokemon->name);
+    first_types[i] = copy_column_string(strings, &strings_offset, pokemon->first_type);
+    second_types[i] = copy_column_string(strings, &strings_offset, pokemon->second_type);
+  }
+  return NULL;
+}
+
+/* This function writes every pokemon into a binary columns file: an ExportColumnsHeaderType followed by one aligned column per field of PokemonType and the strings the names and types point into. Every thread measures the strings of its range, then writes its range where the ranges before it end */
+/* Parameters: fd - input (the file being written, it must be empty), *pokemon - input (the first pokemon being written), number_of_pokemon - input (the amount of pokemon being written) */
+/* Return values: int, C_OK (0) if the file was written and C_NOK (-1) if the file can't be written or its strings don't fit its offsets */
+/* Side effects: starts threads, allocates the whole file in memory and frees it before returning, exits the program if memory can't be allocated, writes to the file */
+int export_columns(int fd, const PokemonType *pokemon, int number_of_pokemon) {
+  ExportTaskType tasks[EXPORT_MAX_THREADS];
+  ExportColumnsHeaderType header;
+  int number_of_tasks = export_thread_count(number_of_pokemon);
+
+  /* Split the pokemon into one range per thread */
+  memset(tasks, 0, sizeof(tasks));
+  for(int i = 0; i < number_of_tasks; i++) {
+    tasks[i].first_row = (long)number_of_pokemon * i / number_of_tasks;
+    tasks[i].pokemon = pokemon + tasks[i].first_row;
+    tasks[i].number_of_pokemon = (long)number_of_pokemon * (i + 1) / number_of_tasks - tasks[i].first_row;
+    tasks[i].format = EXPORT_COLUMNS;
+  }
+
+  /* Measure the strings of every range, the strings of a range start where the ones of the ranges before it end */
+  run_export_tasks(tasks, number_of_tasks, measure_strings);
+  long strings_size = 0;
+  for(int i = 0; i < number_of_tasks; i++) {
+    long range_size = tasks[i].strings_offset;
+    tasks[i].strings_offset = strings_size;
+    strings_size += range_size;
+  }
+  if(strings_size > INT32_MAX) {
+    return C_NOK;
+  }
+
+  /* Lay every column out after the header */
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, EXPORT_COLUMNS_MAGIC, sizeof(EXPORT_COLUMNS_MAGIC));
+  header.format_version = EXPORT_COLUMNS_VERSION;
+  header.byte_order = EXPORT_BYTE_ORDER;
+  header.number_of_rows = number_of_pokemon;
+  header.strings_size = strings_size;
+  long offset = align_column(sizeof(header));
+  for(int column = 0; column < EXPORT_NUMBER_OF_COLUMNS; column++) {
+    header.columns[column] = offset;
+    if(column < EXPORT_NUMERIC_COLUMNS) {
+      offset += sizeof(int16_t) * (long)number_of_pokemon;
+    }
+    else if(column == EXPORT_COLUMN_LEGENDARY) {
+      offset += number_of_pokemon;
+    }
+    else if(column == EXPORT_COLUMN_STRINGS) {
+      offset += strings_size;
+    }
+    else {
+      offset += sizeof(int32_t) * (long)number_of_pokemon;
+    }
+    offset = align_column(offset);
+  }
+  header.file_size = offset;
+
+  /* The padding between the columns stays zeroed so the same pokemon always give the same file */
+  char *columns = (char *)calloc(1, header.file_size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(columns == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(columns, &header, sizeof(header));
+  for(int i = 0; i < number_of_tasks; i++) {
+    tasks[i].columns = columns;
+    tasks[i].header = &header;
+  }
+
+  run_export_tasks(tasks, number_of_tasks, encode_columns);
+  int result = write_export_buffer(fd, columns, header.file_size);
+  free(columns);
+  return result;
+}
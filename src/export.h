@@ -0,0 +1,103 @@
+/*****************************************************************************/
+/* */
+/* export.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the export.c file */
+/* How to use: use #include "export.h" at the top of any .c files that need to write the pokemon received by the client into a saved file */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef EXPORT_H_
+#define EXPORT_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//importing the header file of the client for the pokemon being written
+#include "client.h"
+
+//Variety of constants defined
+#define EXPORT_JSON_LINES_EXTENSION ".jsonl" //Constant to represent the extension of a saved file written as JSON Lines, one object per pokemon
+#define EXPORT_COLUMNS_EXTENSION ".pkc"   //Constant to represent the extension of a saved file written as binary columns
+#define EXPORT_COLUMNS_MAGIC "PKMNCOL"    //Constant to represent the first bytes of every binary columns file, followed by a null character
+#define EXPORT_COLUMNS_MAGIC_SIZE 8       //Constant to represent the amount of bytes of the magic at the start of every binary columns file
+#define EXPORT_COLUMNS_VERSION 1          //Constant to represent the version of the layout of the binary columns files
+#define EXPORT_COLUMNS_TEMPORARY_SUFFIX ".tmp" //Constant to represent what is added to the name of a binary columns file while a save is writing it
+#define EXPORT_BYTE_ORDER 0x01020304u     //Constant to represent a word written in the byte order of the machine, so a reader can tell which byte order the columns were written in
+#define EXPORT_COLUMNS_ALIGNMENT 8        //Constant to represent the alignment of every column inside a binary columns file
+#define EXPORT_MAX_THREADS 8              //Constant to represent the most threads encoding one save at once
+#define EXPORT_ROWS_PER_TASK 16384        //Constant to represent the amount of pokemon encoded by one thread at once, saves with fewer pokemon are encoded without starting any thread
+#define EXPORT_BUFFER_SIZE (1024 * 1024)  //Constant to represent the amount of characters a thread can encode before its buffer has to grow
+#define MAX_NUMBER_LENGTH 11              //Constant to represent the most characters a number written in decimal can take, like -2147483648
+#define MAX_LINE_NUMBERS_SIZE 128         //Constant to represent the most characters a saved line takes besides the name and the types of its pokemon, its numbers, separators, legendary word and new line
+#define MAX_JSON_LINE_FIXED_SIZE 256      //Constant to represent the most characters a JSON line takes besides the escaped name and types of its pokemon
+#define JSON_ESCAPE_SIZE 6                //Constant to represent the most characters one character of a string takes once escaped inside JSON, like \u001f
+
+/* This enum names every format a saved file can be written in, chosen by the extension of its name */
+typedef enum ExportFormat {
+  EXPORT_CSV,             //Lines of the pokemon file, appended to by every save
+  EXPORT_JSON_LINES,      //One JSON object per pokemon and per line, appended to by every save
+  EXPORT_COLUMNS          //Binary columns of every pokemon, written again by every save
+} ExportFormatType;
+
+/* This enum names every column of a binary columns file in the order they are stored, the numeric columns come first and hold one int16_t per pokemon in the order of the fields of PokemonType */
+typedef enum ExportColumn {
+  EXPORT_COLUMN_NUMBER,           //Number of every pokemon
+  EXPORT_COLUMN_TOTAL,            //Sum of all stats of every pokemon
+  EXPORT_COLUMN_HP,               //HP of every pokemon
+  EXPORT_COLUMN_ATTACK,           //Attack stat of every pokemon
+  EXPORT_COLUMN_DEFENSE,          //Defense stat of every pokemon
+  EXPORT_COLUMN_SP_ATTACK,        //Special attack stat of every pokemon
+  EXPORT_COLUMN_SP_DEFENSE,       //Special defense stat of every pokemon
+  EXPORT_COLUMN_SPEED,            //Speed stat of every pokemon
+  EXPORT_COLUMN_GENERATION,       //Generation of every pokemon
+  EXPORT_NUMERIC_COLUMNS,         //Amount of numeric columns, must stay after them
+  EXPORT_COLUMN_LEGENDARY = EXPORT_NUMERIC_COLUMNS, //One byte per pokemon, 1 for a legendary and 0 otherwise
+  EXPORT_COLUMN_NAME,             //Offset of the name of every pokemon inside the strings, one int32_t per pokemon
+  EXPORT_COLUMN_FIRST_TYPE,       //Offset of the first type of every pokemon inside the strings, one int32_t per pokemon
+  EXPORT_COLUMN_SECOND_TYPE,      //Offset of the second type of every pokemon inside the strings, one int32_t per pokemon
+  EXPORT_COLUMN_STRINGS,          //Every name and type, each followed by a null character
+  EXPORT_NUMBER_OF_COLUMNS        //Amount of columns, must stay last
+} ExportColumnType;
+
+/* This structure is written at the start of every binary columns file, a reader loads the whole file with a single read and finds every column at its offset */
+typedef struct ExportColumnsHeader {
+  char magic[EXPORT_COLUMNS_MAGIC_SIZE]; //EXPORT_COLUMNS_MAGIC
+  uint32_t format_version;            //EXPORT_COLUMNS_VERSION
+  uint32_t byte_order;                //EXPORT_BYTE_ORDER
+  int32_t number_of_rows;             //Amount of pokemon inside the file
+  int32_t strings_size;               //Amount of bytes inside the strings column
+  int64_t columns[EXPORT_NUMBER_OF_COLUMNS]; //Offset of every column from the start of the file
+  int64_t file_size;                  //Amount of bytes inside the file
+} ExportColumnsHeaderType;
+
+/* This structure contains the part of a save encoded by one thread, a range of pokemon and what they were encoded into */
+typedef struct ExportTask {
+  const PokemonType *pokemon;         //First pokemon of the range
+  int number_of_pokemon;              //Amount of pokemon inside the range
+  ExportFormatType format;            //Format the pokemon are encoded in
+  char *buffer;                       //Text encoded for the range, reused by the next range the task gets
+  long size;                          //Amount of characters inside buffer
+  long capacity;                      //Amount of characters buffer can hold before it has to grow
+  char *columns;                      //Binary columns file the range is written into, shared by every task
+  const ExportColumnsHeaderType *header; //Header of the binary columns file, telling where every column starts
+  int first_row;                      //Index of the first pokemon of the range inside the binary columns file
+  long strings_offset;                //Offset inside the strings column where the strings of the range start
+} ExportTaskType;
+
+/* all function prototypes for functions in export.c */
+ExportFormatType export_format(const char *file_name);
+int pokemon_to_line(char *line_to_write, const PokemonType *pokemon_to_write, char *separator);
+int pokemon_to_json(char *line_to_write, const PokemonType *pokemon_to_write);
+int export_pokemon(int fd, const PokemonType *pokemon, int number_of_pokemon, ExportFormatType format);
+int export_columns(int fd, const PokemonType *pokemon, int number_of_pokemon);
+int export_thread_count(int number_of_pokemon);
+void run_export_tasks(ExportTaskType *tasks, int number_of_tasks, void *(*function)(void *));
+void *encode_text(void *arg);
+void *measure_strings(void *arg);
+void *encode_columns(void *arg);
+
+#endif //end of header file
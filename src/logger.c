@@ -0,0 +1,515 @@
+/*****************************************************************************/
+/* */
+/* logger.c */
+/* Purpose: This file logs the messages of the server and the client without making the threads that log them wait for the terminal or for each other. Every thread copies its messages as fixed-size records into a ring of its own, and one writer thread formats them and writes them out in the order they were logged. */
+/* How to use: Make sure to compile the file and then link this file when compiling any executable that logs messages. This is already done for you in the MakeFile. Start the writer thread with logger_start once, log with LOG_DEBUG, LOG_INFO, LOG_WARN and LOG_ERROR from any thread, and stop it with logger_stop once the other threads are done. Messages logged while the writer thread is not running are written right away. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "protocol.h"
+#include "logger.h"
+
+static LogRingType *rings = NULL;               //List of the ring of every thread that logged a message, newest first
+static int number_of_rings = 0;                 //Amount of rings inside the list, used to number them
+static __thread LogRingType *current_ring = NULL; //Ring of the calling thread, NULL until it logs a message
+static pthread_key_t ring_key;                  //Key whose destructor releases the ring of a thread when it exits
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT; //Makes sure ring_key is only created once
+static FILE *log_output = NULL;                 //File the writer thread writes to
+static pthread_t writer_thread;                 //Thread writing every message
+static int writer_is_running = C_NOK;           //C_OK while the writer thread takes the messages out of the rings
+static int writer_is_stopping = C_NOK;          //C_OK once the writer thread has been told to write what is left and exit
+static int exit_handler_is_registered = C_NOK;  //C_OK once logger_stop runs when the program exits
+
+/* Name of every level, written with every message */
+static const char *level_names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+/* This function returns the time of the clock of the system, used to date every message */
+/* Parameters: None */
+/* Return values: int64_t containing the time in nanoseconds since the epoch */
+/* Side effects: none */
+static int64_t logger_now(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* This function reads one conversion of a format, the same way for the thread logging a message and for the writer thread writing it */
+/* Parameters: *format - input (the format, starting at the '%' of the conversion), *conversion - output (every part of the conversion) */
+/* Return values: int containing the amount of characters of the conversion */
+/* Side effects: none */
+int logger_parse_conversion(const char *format, LogConversionType *conversion) {
+  const char *character = format + 1;
+  int number_of_flags = 0;
+
+  memset(conversion, 0, sizeof(LogConversionType));
+  conversion->width = LOG_NO_VALUE;
+  conversion->precision = LOG_NO_VALUE;
+
+  while (*character != '\0' && strchr("-+ #0", *character) != NULL) {
+    if (number_of_flags < (int)sizeof(conversion->flags) - 1) {
+      conversion->flags[number_of_flags++] = *character;
+    }
+    character++;
+  }
+
+  if (*character == '*') {
+    conversion->width = LOG_STAR_VALUE;
+    character++;
+  }
+  else if (*character >= '0' && *character <= '9') {
+    conversion->width = strtol(character, (char **)&character, 10);
+  }
+
+  if (*character == '.') {
+    character++;
+    if (*character == '*') {
+      conversion->precision = LOG_STAR_VALUE;
+      character++;
+    }
+    else {
+      conversion->precision = strtol(character, (char **)&character, 10);
+    }
+  }
+
+  /* hh and ll are kept as a single character */
+  if (*character == 'h' && character[1] == 'h') {
+    conversion->modifier = 'H';
+    character += 2;
+  }
+  else if (*character == 'l' && character[1] == 'l') {
+    conversion->modifier = 'q';
+    character += 2;
+  }
+  else if (*character != '\0' && strchr("hljztL", *character) != NULL) {
+    conversion->modifier = *character++;
+  }
+
+  conversion->specifier = *character;
+  if (*character != '\0') {
+    character++;
+  }
+  conversion->length = character - format;
+  return conversion->length;
+}
+
+/* This function copies the arguments of a message into its record, reading each with the type its conversion gives it */
+/* Parameters: *record - output (the record of the message), level - input (the level of the message), *format - input (the format of the message), arguments - input (the arguments of the message) */
+/* Return values: nothing since it's a void function */
+/* Side effects: stops at the first conversion it doesn't know or once LOG_MAX_ARGUMENTS arguments are copied, the rest of the message is left out when it is written */
+static void logger_capture(LogRecordType *record, int level, const char *format, va_list arguments) {
+  record->time = logger_now();
+  record->format = format;
+  record->level = level;
+  record->number_of_arguments = 0;
+  record->strings_size = 0;
+  record->strings[LOG_STRINGS_SIZE - 1] = '\0';
+
+  for (const char *character = strchr(format, '%'); character != NULL; character = strchr(character, '%')) {
+    LogConversionType conversion;
+    character += logger_parse_conversion(character, &conversion);
+
+    if (conversion.specifier == '%') {
+      continue;
+    }
+    int number_of_stars = (conversion.width == LOG_STAR_VALUE) + (conversion.precision == LOG_STAR_VALUE);
+    if (conversion.specifier == '\0' || (conversion.specifier == 's' && conversion.modifier != 0) || record->number_of_arguments + number_of_stars + 1 > LOG_MAX_ARGUMENTS) {
+      return;
+    }
+
+    /* A width or a precision given with '*' comes before the value */
+    int precision = conversion.precision;
+    if (conversion.width == LOG_STAR_VALUE) {
+      record->arguments[record->number_of_arguments++].integer = va_arg(arguments, int);
+    }
+    if (conversion.precision == LOG_STAR_VALUE) {
+      precision = va_arg(arguments, int);
+      record->arguments[record->number_of_arguments++].integer = precision;
+    }
+
+    LogArgumentType *argument = &record->arguments[record->number_of_arguments];
+    switch (conversion.specifier) {
+      case 'd':
+      case 'i':
+        switch (conversion.modifier) {
+          case 'l': argument->integer = va_arg(arguments, long); break;
+          case 'q': argument->integer = va_arg(arguments, long long); break;
+          case 'j': argument->integer = va_arg(arguments, intmax_t); break;
+          case 'z': argument->integer = va_arg(arguments, ssize_t); break;
+          case 't': argument->integer = va_arg(arguments, ptrdiff_t); break;
+          default: argument->integer = va_arg(arguments, int); break;
+        }
+        break;
+
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        switch (conversion.modifier) {
+          case 'l': argument->unsigned_integer = va_arg(arguments, unsigned long); break;
+          case 'q': argument->unsigned_integer = va_arg(arguments, unsigned long long); break;
+          case 'j': argument->unsigned_integer = va_arg(arguments, uintmax_t); break;
+          case 'z': argument->unsigned_integer = va_arg(arguments, size_t); break;
+          case 't': argument->unsigned_integer = va_arg(arguments, ptrdiff_t); break;
+          default: argument->unsigned_integer = va_arg(arguments, unsigned int); break;
+        }
+        break;
+
+      case 'c':
+        argument->integer = va_arg(arguments, int);
+        break;
+
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        argument->real = (conversion.modifier == 'L') ? (double)va_arg(arguments, long double) : va_arg(arguments, double);
+        break;
+
+      case 'p':
+        argument->pointer = va_arg(arguments, const void *);
+        break;
+
+      /* Strings are copied up to their precision, since they can be freed or not be null-terminated, the last character of strings is always an empty string for the ones that don't fit */
+      case 's': {
+        const char *string = va_arg(arguments, const char *);
+        int room = LOG_STRINGS_SIZE - 1 - record->strings_size - 1;
+        int length = 0;
+
+        if (string == NULL) {
+          string = "(null)";
+        }
+        if (room <= 0) {
+          argument->string = LOG_STRINGS_SIZE - 1;
+          break;
+        }
+        while (length < room && (precision < 0 || length < precision) && string[length] != '\0') {
+          length++;
+        }
+        argument->string = record->strings_size;
+        memcpy(record->strings + record->strings_size, string, length);
+        record->strings[record->strings_size + length] = '\0';
+        record->strings_size += length + 1;
+        break;
+      }
+
+      /* %n and the wide characters have no argument that can be copied */
+      default:
+        return;
+    }
+    record->number_of_arguments++;
+  }
+}
+
+/* This function formats a record into a line, with the time, the level and the thread of the message before it */
+/* Parameters: *record - input (the record of the message), ring_index - input (the number of the thread that logged the message), *line - output (the line), size - input (the amount of characters line can hold) */
+/* Return values: int containing the amount of characters written into line, which always ends with a newline */
+/* Side effects: cuts the message if it doesn't fit */
+int logger_format_record(const LogRecordType *record, int ring_index, char *line, int size) {
+  time_t seconds = record->time / 1000000000LL;
+  struct tm date;
+  int used;
+  int argument_index = 0;
+
+  localtime_r(&seconds, &date);
+  used = strftime(line, size, "%Y-%m-%d %H:%M:%S", &date);
+  used += snprintf(line + used, size - used, ".%06ld %-5s [%d] ", (long)(record->time % 1000000000LL / 1000), level_names[record->level], ring_index);
+
+  /* Keep room for the newline */
+  size--;
+  for (const char *character = record->format; *character != '\0' && used < size; ) {
+    if (*character != '%') {
+      line[used++] = *character++;
+      continue;
+    }
+
+    LogConversionType conversion;
+    character += logger_parse_conversion(character, &conversion);
+    if (conversion.specifier == '%') {
+      line[used++] = '%';
+      continue;
+    }
+
+    /* Leave the rest of the message out once an argument was not copied */
+    int number_of_stars = (conversion.width == LOG_STAR_VALUE) + (conversion.precision == LOG_STAR_VALUE);
+    if (argument_index + number_of_stars + 1 > record->number_of_arguments) {
+      break;
+    }
+
+    /* Rebuild the conversion with its width and precision written out, and every integer read as a long long */
+    char specification[32];
+    int width = conversion.width;
+    int precision = conversion.precision;
+    if (width == LOG_STAR_VALUE) {
+      width = record->arguments[argument_index++].integer;
+    }
+    if (precision == LOG_STAR_VALUE) {
+      precision = record->arguments[argument_index++].integer;
+    }
+    int length = snprintf(specification, sizeof(specification), "%%%s%s", conversion.flags, (width < 0 && width != LOG_NO_VALUE) ? "-" : "");
+    if (width != LOG_NO_VALUE) {
+      length += snprintf(specification + length, sizeof(specification) - length, "%d", abs(width));
+    }
+    if (precision >= 0) {
+      length += snprintf(specification + length, sizeof(specification) - length, ".%d", precision);
+    }
+    snprintf(specification + length, sizeof(specification) - length, "%s%c", (strchr("diuoxX", conversion.specifier) != NULL) ? "ll" : "", conversion.specifier);
+
+    const LogArgumentType *argument = &record->arguments[argument_index++];
+    switch (conversion.specifier) {
+      case 'd':
+      case 'i':
+        used += snprintf(line + used, size - used + 1, specification, argument->integer);
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        used += snprintf(line + used, size - used + 1, specification, argument->unsigned_integer);
+        break;
+      case 'c':
+        used += snprintf(line + used, size - used + 1, specification, (int)argument->integer);
+        break;
+      case 'p':
+        used += snprintf(line + used, size - used + 1, specification, argument->pointer);
+        break;
+      case 's':
+        used += snprintf(line + used, size - used + 1, specification, record->strings + argument->string);
+        break;
+      default:
+        used += snprintf(line + used, size - used + 1, specification, argument->real);
+        break;
+    }
+  }
+
+  /* snprintf returns the length the conversion would have had, even when it was cut */
+  if (used > size) {
+    used = size;
+  }
+  line[used++] = '\n';
+  return used;
+}
+
+/* This function releases the ring of a thread that exits, it is the destructor of ring_key */
+/* Parameters: *arg - input (void* casted parameter containing the LogRingType of the thread) */
+/* Return values: nothing since it's a void function */
+/* Side effects: the ring stays in the list until the writer thread emptied it, then the next thread that logs takes it over instead of allocating one */
+static void logger_release_ring(void *arg) {
+  LogRingType *ring = (LogRingType *)arg;
+
+  current_ring = NULL;
+  __atomic_store_n(&ring->is_released, C_OK, __ATOMIC_RELEASE);
+}
+
+/* This function creates the key releasing the ring of every thread when it exits */
+/* Parameters: None */
+/* Return values: nothing since it's a void function */
+/* Side effects: creates ring_key */
+static void logger_create_ring_key(void) {
+  pthread_key_create(&ring_key, logger_release_ring);
+}
+
+/* This function returns the ring of the calling thread, taking over the ring of a thread that exited or adding a new one to the list the first time the thread logs a message */
+/* Parameters: None */
+/* Return values: LogRingType pointer to the ring of the thread */
+/* Side effects: allocates a ring only when no released ring is empty, so threads that come and go like the save threads of the client don't leak one each, exits the program if memory can't be allocated */
+static LogRingType *logger_ring(void) {
+  if (current_ring != NULL) {
+    return current_ring;
+  }
+  pthread_once(&ring_key_once, logger_create_ring_key);
+
+  /* Rings are never taken out of the list since the writer thread reads it without a lock, a released ring is only taken once every record and drop of its previous thread was written so they keep their own index */
+  LogRingType *ring = NULL;
+  for (LogRingType *candidate = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); candidate != NULL && ring == NULL; candidate = candidate->next) {
+    int is_released = C_OK;
+    if (__atomic_load_n(&candidate->is_released, __ATOMIC_ACQUIRE) == C_OK &&
+        __atomic_load_n(&candidate->tail, __ATOMIC_ACQUIRE) == candidate->head && __atomic_load_n(&candidate->reported_dropped, __ATOMIC_ACQUIRE) == candidate->dropped &&
+        __atomic_compare_exchange_n(&candidate->is_released, &is_released, C_NOK, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      ring = candidate;
+    }
+  }
+
+  if (ring != NULL) {
+    /* The index is read by the writer thread only for records published after it, through the release of head */
+    ring->index = __atomic_add_fetch(&number_of_rings, 1, __ATOMIC_RELAXED);
+  }
+  else {
+    if (posix_memalign((void **)&ring, LOG_CACHE_LINE_SIZE, sizeof(LogRingType)) != 0) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+    ring->head = 0;
+    ring->dropped = 0;
+    ring->is_released = C_NOK;
+    ring->tail = 0;
+    ring->reported_dropped = 0;
+    ring->index = __atomic_add_fetch(&number_of_rings, 1, __ATOMIC_RELAXED);
+
+    /* Push the ring onto the list without a lock, the writer thread only ever reads the list */
+    ring->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&rings, &ring->next, ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+  }
+  pthread_setspecific(ring_key, ring);
+  current_ring = ring;
+  return ring;
+}
+
+/* This function logs a message, it only copies the message into the ring of the calling thread, the writer thread formats it and writes it */
+/* Parameters: level - input (the level of the message), *format - input (the format of the message like printf, a string literal without the ending newline), ... - input (the arguments of the message) */
+/* Return values: nothing since it's a void function */
+/* Side effects: never waits for the writer thread or another thread, drops the message and counts it if the ring of the thread is full, writes the message right away if the writer thread is not running */
+void logger_write(int level, const char *format, ...) {
+  va_list arguments;
+
+  /* Without a writer thread the message is written right away, before logger_start and after logger_stop */
+  if (__atomic_load_n(&writer_is_running, __ATOMIC_ACQUIRE) == C_NOK) {
+    LogRecordType record;
+    char line[LOG_LINE_SIZE];
+
+    va_start(arguments, format);
+    logger_capture(&record, level, format, arguments);
+    va_end(arguments);
+    fwrite(line, 1, logger_format_record(&record, 0, line, sizeof(line)), (log_output != NULL) ? log_output : stdout);
+    return;
+  }
+
+  LogRingType *ring = logger_ring();
+  unsigned long head = ring->head;
+  if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_RECORDS) {
+    __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  va_start(arguments, format);
+  logger_capture(&ring->records[head % LOG_RING_RECORDS], level, format, arguments);
+  va_end(arguments);
+
+  /* Publish the record once it is whole */
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* This function writes every message waiting inside the rings when it is called, oldest first across every thread */
+/* Parameters: None */
+/* Return values: int containing the amount of messages written */
+/* Side effects: writes to log_output and flushes it once, takes the written records out of the rings */
+static int logger_drain(void) {
+  char line[LOG_LINE_SIZE];
+  int written = 0;
+  long waiting = 0;
+
+  /* Only write what was waiting when the drain started, so the output is flushed even when threads keep logging */
+  for (LogRingType *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+    waiting += __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+
+    /* Tell how many messages a thread lost while its ring was full */
+    unsigned long dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    if (dropped != ring->reported_dropped) {
+      fprintf(log_output, "%lu messages of thread %d were dropped because it logged them faster than they could be written \n", dropped - ring->reported_dropped, ring->index);
+      __atomic_store_n(&ring->reported_dropped, dropped, __ATOMIC_RELEASE);
+    }
+  }
+
+  /* Take the oldest first record of every ring until everything that was waiting is written */
+  for (; waiting > 0; waiting--) {
+    LogRingType *oldest = NULL;
+    for (LogRingType *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+      if (ring->tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) && (oldest == NULL || ring->records[ring->tail % LOG_RING_RECORDS].time < oldest->records[oldest->tail % LOG_RING_RECORDS].time)) {
+        oldest = ring;
+      }
+    }
+    if (oldest == NULL) {
+      break;
+    }
+    fwrite(line, 1, logger_format_record(&oldest->records[oldest->tail % LOG_RING_RECORDS], oldest->index, line, sizeof(line)), log_output);
+
+    /* Give the slot back to the thread once the record was formatted */
+    __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+    written++;
+  }
+
+  if (written > 0) {
+    fflush(log_output);
+  }
+  return written;
+}
+
+/* This function is ran by the writer thread, it writes the messages of every ring until the logger is stopped */
+/* Parameters: *arg - input (unused) */
+/* Return values: nothing since the function is void  */
+/* Side effects: sleeps LOG_IDLE_MILLISECONDS whenever every ring is empty, so the threads logging never have to wake it up */
+static void *logger_writer(void *arg) {
+  struct timespec idle = {0, LOG_IDLE_MILLISECONDS * 1000000L};
+
+  while (1) {
+    /* Read the flag before draining, so every message logged before logger_stop is written */
+    int is_stopping = __atomic_load_n(&writer_is_stopping, __ATOMIC_ACQUIRE);
+    if (logger_drain() > 0) {
+      continue;
+    }
+    if (is_stopping == C_OK) {
+      return NULL;
+    }
+    nanosleep(&idle, NULL);
+  }
+}
+
+/* This function starts the writer thread, every message logged afterwards goes through the ring of the thread that logged it */
+/* Parameters: *output - input (the file the messages are written to, like stdout) */
+/* Return values: int, C_OK (0) if the writer thread started and C_NOK (-1) if not, messages are then still written right away */
+/* Side effects: creates the writer thread, makes the program stop it when it exits so no message is lost */
+int logger_start(FILE *output) {
+  log_output = output;
+  if (writer_is_running == C_OK) {
+    return C_OK;
+  }
+
+  writer_is_stopping = C_NOK;
+  if (pthread_create(&writer_thread, NULL, logger_writer, NULL) != 0) {
+    return C_NOK;
+  }
+  __atomic_store_n(&writer_is_running, C_OK, __ATOMIC_RELEASE);
+
+  if (exit_handler_is_registered == C_NOK) {
+    atexit(logger_stop);
+    exit_handler_is_registered = C_OK;
+  }
+  return C_OK;
+}
+
+/* This function writes every message still waiting and stops the writer thread */
+/* Parameters: None */
+/* Return values: nothing since it's a void function */
+/* Side effects: joins the writer thread, messages logged afterwards are written right away. The rings are kept since this also runs when another thread calls exit and a thread can still be inside one */
+void logger_stop(void) {
+  if (__atomic_load_n(&writer_is_running, __ATOMIC_ACQUIRE) == C_NOK) {
+    return;
+  }
+
+  __atomic_store_n(&writer_is_stopping, C_OK, __ATOMIC_RELEASE);
+  pthread_join(writer_thread, NULL);
+  __atomic_store_n(&writer_is_running, C_NOK, __ATOMIC_RELEASE);
+
+  /* A thread that checked the writer thread was running just before it stopped can still add a record, write it too */
+  logger_drain();
+  fflush(log_output);
+}
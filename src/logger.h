@@ -0,0 +1,106 @@
+/*****************************************************************************/
+/* */
+/* logger.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the logger.c file */
+/* How to use: use #include "logger.h" at the top of any .c files that log messages, and log them with LOG_DEBUG, LOG_INFO, LOG_WARN or LOG_ERROR like printf, without the ending newline */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+//Other libraries that we will need
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+//Variety of constants defined
+#define LOG_LEVEL_DEBUG 0                //Constant to represent the level of messages only useful while debugging, like every request received
+#define LOG_LEVEL_INFO 1                 //Constant to represent the level of messages describing what the program does
+#define LOG_LEVEL_WARN 2                 //Constant to represent the level of messages about something unexpected the program recovered from
+#define LOG_LEVEL_ERROR 3                //Constant to represent the level of messages about something that failed
+#define LOG_MAX_ARGUMENTS 8              //Constant to represent the most arguments a message can have, the conversions after them are left out
+#define LOG_STRINGS_SIZE 160             //Constant to represent the amount of characters of the strings of a message kept inside its record, longer strings are cut
+#define LOG_RING_RECORDS 1024            //Constant to represent the amount of records the ring of every thread holds before its messages are dropped
+#define LOG_LINE_SIZE 1024               //Constant to represent the most characters of a line written by the writer thread, longer lines are cut
+#define LOG_IDLE_MILLISECONDS 5          //Constant to represent the amount of milliseconds the writer thread sleeps when every ring is empty
+#define LOG_NO_VALUE -1                  //Constant to represent a conversion without a width or a precision
+#define LOG_STAR_VALUE -2                //Constant to represent a width or a precision given as an argument with '*'
+#define LOG_CACHE_LINE_SIZE 64           //Constant to represent the size of a cache line, the position written by a thread and the one read by the writer thread never share one
+
+//Messages below this level are compiled out, build with -DLOG_LEVEL=LOG_LEVEL_DEBUG to keep every message
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logger_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) logger_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) logger_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#define LOG_ERROR(...) logger_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+/* This union contains one argument of a message, which member is used is given by its conversion inside the format */
+typedef union LogArgument {
+  long long integer;              //Argument of an integer or character conversion, or a width or precision given with '*'
+  unsigned long long unsigned_integer; //Argument of an unsigned integer conversion
+  double real;                    //Argument of a floating point conversion
+  const void *pointer;            //Argument of a %p conversion
+  int string;                     //Offset of the copy of the argument of a %s conversion inside the strings of the record
+} LogArgumentType;
+
+/* This structure contains one message as it was logged, the format is only applied by the writer thread so logging never formats text or writes to a file */
+typedef struct LogRecord {
+  int64_t time;                   //Time the message was logged at, in nanoseconds since the epoch
+  const char *format;             //Format of the message, it must be a string literal since it is only read once the message is written
+  int level;                      //Level of the message
+  int number_of_arguments;        //Amount of arguments inside arguments
+  LogArgumentType arguments[LOG_MAX_ARGUMENTS]; //Every argument of the message, in the order of the format
+  int strings_size;               //Amount of characters used inside strings
+  char strings[LOG_STRINGS_SIZE]; //Copy of every string argument, each null-terminated, since they can be freed before the message is written
+} LogRecordType;
+
+/* This structure is the ring of records of one thread. Only that thread adds records and only the writer thread removes them, so they never lock */
+typedef struct LogRing {
+  unsigned long head __attribute__((aligned(LOG_CACHE_LINE_SIZE))); //Amount of records ever added, only changed by the thread that owns the ring
+  unsigned long dropped;          //Amount of records the thread could not add because the ring was full
+  int is_released;                //C_OK once the thread owning the ring exited, the next thread that logs takes the ring over once the writer thread emptied it
+  unsigned long tail __attribute__((aligned(LOG_CACHE_LINE_SIZE))); //Amount of records ever removed, only changed by the writer thread
+  unsigned long reported_dropped; //Amount of dropped records the writer thread already reported
+  int index;                      //Index of the ring, written with every message of its thread
+  struct LogRing *next;           //Next ring inside the list of every ring
+  LogRecordType records[LOG_RING_RECORDS] __attribute__((aligned(LOG_CACHE_LINE_SIZE))); //Records waiting for the writer thread, record i is at i % LOG_RING_RECORDS
+} LogRingType;
+
+/* This structure describes one conversion of a format, like %-10s or %.*s */
+typedef struct LogConversion {
+  int length;                     //Amount of characters of the conversion inside the format, starting with '%'
+  char flags[8];                  //Flags of the conversion, like "-" or "0", null-terminated
+  int width;                      //Width of the conversion, LOG_NO_VALUE if there is none or LOG_STAR_VALUE if it is given as an argument
+  int precision;                  //Precision of the conversion, LOG_NO_VALUE if there is none or LOG_STAR_VALUE if it is given as an argument
+  char modifier;                  //Length modifier, 'H' for hh, 'h', 'l', 'q' for ll, 'j', 'z', 't', 'L' or 0 if there is none
+  char specifier;                 //Conversion specifier, like 'd' or 's', 0 if the format ends inside the conversion
+} LogConversionType;
+
+/* all function prototypes for functions in logger.c */
+int logger_start(FILE *output);
+void logger_stop(void);
+void logger_write(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+int logger_parse_conversion(const char *format, LogConversionType *conversion);
+int logger_format_record(const LogRecordType *record, int ring_index, char *line, int size);
+
+#endif //end of header file
@@ -0,0 +1,201 @@
+/*****************************************************************************/
+/* */
+/* metrics.c */
+/* Purpose: This file counts the events of the server and times every stage of its requests, accepting clients, waiting for a worker thread, parsing, querying, serializing and sending, so where the time goes under load can be seen without a profiler. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Count events with metrics_count and time stages with metrics_record_since from any thread, a client gets the text of every metric in the Prometheus text format by sending a metrics request. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+//importing the header file included with the program to get access to its functions, constants and structs
+#include "metrics.h"
+
+static MetricsThreadType metrics_threads[METRICS_MAX_THREADS]; //Counters and histograms of every thread
+static int number_of_threads = 0;                              //Amount of threads that counted something, shared by every thread
+static __thread MetricsThreadType *current_thread = NULL;      //Counters and histograms of the calling thread, NULL until it counts something
+
+/* Name and description of every counter, in the order of MetricsCounterType. Counters with a label are printed as one metric per label */
+static const struct {
+  const char *name;
+  const char *label;
+  const char *help;
+} counter_names[NUMBER_OF_COUNTERS] = {
+  {"connections_accepted_total", NULL, "Clients accepted"},
+  {"received_bytes_total", NULL, "Bytes read from every client"},
+  {"sent_bytes_total", NULL, "Bytes written to every client"},
+  {"requests_total", "type=\"query\"", "Messages received from every client, by type"},
+  {"requests_total", "type=\"filter\"", NULL},
+  {"requests_total", "type=\"aggregate\"", NULL},
+  {"requests_total", "type=\"stats\"", NULL},
+  {"requests_total", "type=\"metrics\"", NULL},
+  {"requests_total", "type=\"reload\"", NULL},
+  {"requests_total", "type=\"change\"", NULL},
+  {"requests_total", "type=\"control\"", NULL},
+  {"requests_total", "type=\"unknown\"", NULL},
+  {"throttled_total", NULL, "Times a client had a request left unread because too many of its requests were running or its responses were not sent yet"}
+};
+
+/* Name of every stage, in the order of MetricsStageType */
+static const char *stage_names[NUMBER_OF_STAGES] = {"accept", "queue", "parse", "query", "serialize", "send", "request"};
+
+/* This function returns the time of a monotonic clock, used to time every stage */
+/* Parameters: None */
+/* Return values: int64_t containing the time in nanoseconds */
+/* Side effects: none */
+int64_t metrics_now(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* This function returns the counters and histograms of the calling thread, giving it its own the first time it counts something */
+/* Parameters: None */
+/* Return values: MetricsThreadType pointer to the counters of the thread */
+/* Side effects: takes the next counters of metrics_threads once per thread */
+static MetricsThreadType *metrics_thread(void) {
+  if (current_thread == NULL) {
+    int index = __atomic_fetch_add(&number_of_threads, 1, __ATOMIC_RELAXED);
+    current_thread = &metrics_threads[index % METRICS_MAX_THREADS];
+  }
+  return current_thread;
+}
+
+/* This function adds to a counter of the calling thread */
+/* Parameters: counter - input (the counter), amount - input (the amount added) */
+/* Return values: nothing since it's a void function */
+/* Side effects: changes the counter, never waits for another thread */
+void metrics_count(MetricsCounterType counter, uint64_t amount) {
+  __atomic_fetch_add(&metrics_thread()->counters[counter], amount, __ATOMIC_RELAXED);
+}
+
+/* This function counts the latency of a stage inside the histogram of the calling thread */
+/* Parameters: stage - input (the stage), nanoseconds - input (the latency) */
+/* Return values: nothing since it's a void function */
+/* Side effects: changes the histogram, never waits for another thread */
+void metrics_record(MetricsStageType stage, int64_t nanoseconds) {
+  MetricsHistogramType *histogram = &metrics_thread()->stages[stage];
+  /* Round up to whole microseconds, truncating would count 1.9 microseconds inside the bucket of at most 1 */
+  uint64_t microseconds = (nanoseconds > 0) ? ((uint64_t)nanoseconds + 999) / 1000 : 0;
+
+  /* Bucket i holds the latencies of at most 2^i microseconds */
+  int bucket = (microseconds <= 1) ? 0 : 64 - __builtin_clzll(microseconds - 1);
+  if (bucket >= METRICS_BUCKETS) {
+    bucket = METRICS_BUCKETS - 1;
+  }
+  __atomic_fetch_add(&histogram->buckets[bucket], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&histogram->sum, (nanoseconds > 0) ? (uint64_t)nanoseconds : 0, __ATOMIC_RELAXED);
+}
+
+/* This function counts the latency of a stage that started at a given time and ends now */
+/* Parameters: stage - input (the stage), start - input (the time the stage started at, from metrics_now) */
+/* Return values: int64_t containing the current time, so the next stage can start from it */
+/* Side effects: changes the histogram, never waits for another thread */
+int64_t metrics_record_since(MetricsStageType stage, int64_t start) {
+  int64_t now = metrics_now();
+
+  metrics_record(stage, now - start);
+  return now;
+}
+
+/* This function adds formatted characters to the end of the text of the metrics */
+/* Parameters: *text - input/output (the text being written), *format - input (the format of the characters, like printf), ... - input (the values of the format) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may reallocate the text, exits the program if memory can't be allocated */
+static void metrics_append(MetricsTextType *text, const char *format, ...) {
+  va_list arguments;
+
+  while (1) {
+    va_start(arguments, format);
+    int length = vsnprintf(text->text + text->size, text->capacity - text->size, format, arguments);
+    va_end(arguments);
+
+    if (length < text->capacity - text->size) {
+      text->size += length;
+      return;
+    }
+    text->capacity *= 2;
+    text->text = (char *)realloc(text->text, text->capacity);
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if (text->text == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+/* This function adds up the counters and histograms of every thread and writes them in the Prometheus text format */
+/* Parameters: *size - output (the amount of characters inside the text) */
+/* Return values: char pointer to the text (not null-terminated), which must be freed by the caller */
+/* Side effects: reads the counters of every thread while they keep counting, so a metric can already include events that happened while the text was written, allocates memory for the text */
+char *metrics_format(int *size) {
+  MetricsTextType text;
+  int threads = __atomic_load_n(&number_of_threads, __ATOMIC_RELAXED);
+
+  if (threads > METRICS_MAX_THREADS) {
+    threads = METRICS_MAX_THREADS;
+  }
+  text.size = 0;
+  text.capacity = METRICS_INITIAL_TEXT_SIZE;
+  text.text = (char *)malloc(text.capacity);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if (text.text == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (int counter = 0; counter < NUMBER_OF_COUNTERS; counter++) {
+    uint64_t total = 0;
+    for (int thread = 0; thread < threads; thread++) {
+      total += __atomic_load_n(&metrics_threads[thread].counters[counter], __ATOMIC_RELAXED);
+    }
+
+    /* Labelled counters share the help and type lines of the first one */
+    if (counter_names[counter].help != NULL) {
+      metrics_append(&text, "# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX "%s counter\n", counter_names[counter].name, counter_names[counter].help, counter_names[counter].name);
+    }
+    if (counter_names[counter].label != NULL) {
+      metrics_append(&text, METRICS_PREFIX "%s{%s} %llu\n", counter_names[counter].name, counter_names[counter].label, (unsigned long long)total);
+    }
+    else {
+      metrics_append(&text, METRICS_PREFIX "%s %llu\n", counter_names[counter].name, (unsigned long long)total);
+    }
+  }
+
+  metrics_append(&text, "# HELP " METRICS_PREFIX "stage_seconds Time spent in every stage of a request\n# TYPE " METRICS_PREFIX "stage_seconds histogram\n");
+  for (int stage = 0; stage < NUMBER_OF_STAGES; stage++) {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    /* Buckets are cumulative, and the count is taken from them so it always matches the last one */
+    for (int bucket = 0; bucket < METRICS_BUCKETS; bucket++) {
+      for (int thread = 0; thread < threads; thread++) {
+        count += __atomic_load_n(&metrics_threads[thread].stages[stage].buckets[bucket], __ATOMIC_RELAXED);
+      }
+      if (bucket < METRICS_BUCKETS - 1) {
+        metrics_append(&text, METRICS_PREFIX "stage_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n", stage_names[stage], (double)(1L << bucket) / 1000000.0, (unsigned long long)count);
+      }
+      else {
+        metrics_append(&text, METRICS_PREFIX "stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n", stage_names[stage], (unsigned long long)count);
+      }
+    }
+    for (int thread = 0; thread < threads; thread++) {
+      sum += __atomic_load_n(&metrics_threads[thread].stages[stage].sum, __ATOMIC_RELAXED);
+    }
+    metrics_append(&text, METRICS_PREFIX "stage_seconds_sum{stage=\"%s\"} %.9f\n" METRICS_PREFIX "stage_seconds_count{stage=\"%s\"} %llu\n", stage_names[stage], sum / 1000000000.0, stage_names[stage], (unsigned long long)count);
+  }
+
+  metrics_append(&text, "# HELP " METRICS_PREFIX "threads Threads that counted something\n# TYPE " METRICS_PREFIX "threads gauge\n" METRICS_PREFIX "threads %d\n", threads);
+  *size = text.size;
+  return text.text;
+}
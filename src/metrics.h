@@ -0,0 +1,82 @@
+/*****************************************************************************/
+/* */
+/* metrics.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the metrics.c file */
+/* How to use: use #include "metrics.h" at the top of any .c files that count events of the server or time the stages of its requests */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef METRICS_H_
+#define METRICS_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//Variety of constants defined
+#define METRICS_MAX_THREADS 256           //Constant to represent the amount of threads with their own counters, threads started after them share the counters of earlier ones
+#define METRICS_BUCKETS 26                //Constant to represent the amount of buckets of every latency histogram, bucket i counts the latencies of at most 2^i microseconds and the last one every longer latency
+#define METRICS_CACHE_LINE_SIZE 64        //Constant to represent the size of a cache line, the counters of two threads never share one
+#define METRICS_INITIAL_TEXT_SIZE 16384   //Constant to represent the amount of characters the text of the metrics can hold before it has to grow
+#define METRICS_PREFIX "pokemon_server_"  //Constant to represent the prefix of the name of every metric
+
+/* This enum names every counter of the server */
+typedef enum MetricsCounter {
+  COUNTER_CONNECTIONS_ACCEPTED,   //Clients accepted
+  COUNTER_BYTES_RECEIVED,         //Bytes read from every client
+  COUNTER_BYTES_SENT,             //Bytes written to every client
+  COUNTER_REQUESTS_QUERY,         //Type queries received
+  COUNTER_REQUESTS_FILTER,        //Filter queries received
+  COUNTER_REQUESTS_AGGREGATE,     //Aggregation requests received
+  COUNTER_REQUESTS_STATS,         //Stats requests received
+  COUNTER_REQUESTS_METRICS,       //Metrics requests received
+  COUNTER_REQUESTS_RELOAD,        //Reload requests received
+  COUNTER_REQUESTS_CHANGE,        //Change requests received
+  COUNTER_REQUESTS_CONTROL,       //Pause, unpause and stop messages received
+  COUNTER_REQUESTS_UNKNOWN,       //Messages of an unknown type received
+  COUNTER_THROTTLED,              //Times a client had a request left unread because it had no credit
+  NUMBER_OF_COUNTERS              //Amount of counters, must stay last
+} MetricsCounterType;
+
+/* This enum names every stage of a request that is timed */
+typedef enum MetricsStage {
+  STAGE_ACCEPT,                   //Accepting a client and watching its socket
+  STAGE_QUEUE,                    //Waiting for a worker thread once the request was read
+  STAGE_PARSE,                    //Parsing a filter query or an aggregation request
+  STAGE_QUERY,                    //Finding the matching pokemon or computing the statistics
+  STAGE_SERIALIZE,                //Writing the matching pokemon or the statistics into the response
+  STAGE_SEND,                     //Waiting for the response to be written to the socket once it is queued, including while the client is paused
+  STAGE_REQUEST,                  //Whole request, from reading it to writing the last byte of its response
+  NUMBER_OF_STAGES                //Amount of stages, must stay last
+} MetricsStageType;
+
+/* This structure contains the latencies of one stage counted by one thread */
+typedef struct MetricsHistogram {
+  uint64_t buckets[METRICS_BUCKETS]; //Amount of latencies inside every bucket
+  uint64_t sum;                   //Sum of every latency counted, in nanoseconds
+} MetricsHistogramType;
+
+/* This structure contains the counters and histograms of one thread. Only that thread adds to them, with atomic adds so threads started after METRICS_MAX_THREADS can share them, and they are only read when the metrics are asked for, so they are never locked */
+typedef struct MetricsThread {
+  uint64_t counters[NUMBER_OF_COUNTERS];      //Every counter, indexed with MetricsCounterType
+  MetricsHistogramType stages[NUMBER_OF_STAGES]; //Latencies of every stage, indexed with MetricsStageType
+} __attribute__((aligned(METRICS_CACHE_LINE_SIZE))) MetricsThreadType;
+
+/* This structure contains the text of the metrics while it is written */
+typedef struct MetricsText {
+  char *text;                     //Characters written so far
+  int size;                       //Amount of characters inside text
+  int capacity;                   //Amount of characters text can hold before it has to grow
+} MetricsTextType;
+
+/* all function prototypes for functions in metrics.c */
+int64_t metrics_now(void);
+void metrics_count(MetricsCounterType counter, uint64_t amount);
+void metrics_record(MetricsStageType stage, int64_t nanoseconds);
+int64_t metrics_record_since(MetricsStageType stage, int64_t start);
+char *metrics_format(int *size);
+
+#endif //end of header file
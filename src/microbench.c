@@ -0,0 +1,577 @@
+/*****************************************************************************/
+/* */
+/* microbench.c */
+/* Purpose: This file measures the functions every request goes through on their own, checking types, parsing and writing lines, adding pokemon to the dynamic array, loading the table and assembling responses, on datasets scaled from the pokemon file up to millions of pokemon, so a function that grows faster than linearly is found before it reaches the server. */
+/* How to use: Make sure to compile the file and then link it with the files it measures, this is already done for you in the MakeFile with make microbench. Run ./microbench to print the nanoseconds and allocations per operation of every kernel on every dataset as JSON. -i sets the pokemon file the datasets are scaled from, -s the amount of pokemon of every dataset (like -s 1000,1000000), -t the least milliseconds every kernel is measured for and -o the file the JSON is written to. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+
+//importing the header file included with the program to get access to its functions, constants and structs
+#include "microbench.h"
+#include "column_scan.h"
+
+/* The allocator of the C library, called by the counting versions below */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+static long number_of_allocations = 0;  //Amount of allocations made by the program, every kernel runs on the main thread
+static long number_of_bytes = 0;        //Amount of bytes allocated by the program
+
+/* Every type a type query is sent for, the same types check_valid_pokemon_type accepts */
+static const char *pokemon_types[] = {
+  "Normal", "Fire", "Water", "Grass", "Electric", "Ice", "Fighting", "Poison", "Ground",
+  "Flying", "Psychic", "Bug", "Rock", "Ghost", "Dragon", "Dark", "Steel", "Fairy"
+};
+
+/* Every kernel measured, in the order they are printed */
+static const struct {
+  const char *name;
+  MicrobenchKernelType function;
+} kernels[] = {
+  {"check_valid_pokemon_type", kernel_check_valid_pokemon_type},
+  {"line_to_pokemon", kernel_line_to_pokemon},
+  {"pokemon_to_line", kernel_pokemon_to_line},
+  {"add_pokemon", kernel_add_pokemon},
+  {"table_load_text", kernel_table_load},
+  {"type_response", kernel_type_response},
+  {"filter_response", kernel_filter_response},
+  {"sorted_filter_response", kernel_sorted_response}
+};
+#define NUMBER_OF_KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+/* These functions replace malloc, calloc and realloc for the whole program, the C library sends its own allocations through them too, so every allocation made by a kernel is counted */
+/* Parameters: the same as the functions they replace */
+/* Return values: the same as the functions they replace */
+/* Side effects: count the allocation and its size */
+void *malloc(size_t size) {
+  number_of_allocations++;
+  number_of_bytes += size;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  number_of_allocations++;
+  number_of_bytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+  number_of_allocations++;
+  number_of_bytes += size;
+  return __libc_realloc(pointer, size);
+}
+
+/* This function returns the time of a monotonic clock */
+/* Parameters: None */
+/* Return values: int64_t containing the time in nanoseconds */
+/* Side effects: none */
+int64_t microbench_now(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* This function starts the measured part of a pass */
+/* Parameters: *timer - input/output (the timer of the kernel) */
+/* Return values: nothing since it's a void function */
+/* Side effects: remembers the time and the amount of allocations made so far */
+void timer_start(MicrobenchTimerType *timer) {
+  timer->allocations_at_start = number_of_allocations;
+  timer->bytes_at_start = number_of_bytes;
+  timer->started_at = microbench_now();
+}
+
+/* This function ends the measured part of a pass and adds it to the timer */
+/* Parameters: *timer - input/output (the timer of the kernel) */
+/* Return values: nothing since it's a void function */
+/* Side effects: changes the totals of the timer */
+void timer_stop(MicrobenchTimerType *timer) {
+  timer->nanoseconds += microbench_now() - timer->started_at;
+  timer->allocations += number_of_allocations - timer->allocations_at_start;
+  timer->bytes += number_of_bytes - timer->bytes_at_start;
+}
+
+/* This function allocates memory for a dataset */
+/* Parameters: size - input (the amount of bytes) */
+/* Return values: void pointer to the memory */
+/* Side effects: allocates memory, exits the program if it can't be allocated */
+static void *checked_malloc(size_t size) {
+  void *memory = malloc(size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(memory == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+/* This function builds a dataset by repeating the lines of the pokemon file until it holds the amount of pokemon asked for, every copy after the first gets its copy number added to its name so names stay distinct */
+/* Parameters: *dataset - output (the dataset being built), **lines - input (every line of the pokemon file without its header and line break), number_of_lines - input (the amount of lines), number_of_rows - input (the amount of pokemon of the dataset) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates memory for the dataset which must be released with free_dataset, exits the program if it can't be allocated or the table can't be built */
+void build_dataset(MicrobenchDatasetType *dataset, char **lines, int number_of_lines, int number_of_rows) {
+  static const char header[] = "#,Name,Type 1,Type 2,Total,HP,Attack,Defense,Sp. Atk,Sp. Def,Speed,Generation,Legendary\n";
+  long longest_line = 0;
+
+  memset(dataset, 0, sizeof(MicrobenchDatasetType));
+  dataset->number_of_rows = number_of_rows;
+  for(int i = 0; i < number_of_lines; i++) {
+    long length = strlen(lines[i]);
+    longest_line = (length > longest_line) ? length : longest_line;
+  }
+
+  /* Every line takes at most its length, a copy number and a separator */
+  long capacity = sizeof(header) + (long)number_of_rows * (longest_line + MAX_NUMBER_LENGTH + 2);
+  dataset->text = (char *)checked_malloc(capacity);
+  dataset->received = (char *)checked_malloc(capacity);
+  memcpy(dataset->text, header, sizeof(header) - 1);
+  dataset->text_size = sizeof(header) - 1;
+
+  for(int i = 0; i < number_of_rows; i++) {
+    const char *line = lines[i % number_of_lines];
+    int copy = i / number_of_lines;
+    char *start = dataset->received + dataset->received_size;
+    char *end = start;
+
+    /* The name is the second field, the copy number goes right after it */
+    const char *after_name = strchr(line, ',');
+    after_name = (after_name != NULL) ? strchr(after_name + 1, ',') : NULL;
+    if(copy == 0 || after_name == NULL) {
+      end += sprintf(end, "%s", line);
+    }
+    else {
+      memcpy(end, line, after_name - line);
+      end += after_name - line;
+      end += sprintf(end, "-%d%s", copy, after_name);
+    }
+
+    memcpy(dataset->text + dataset->text_size, start, end - start);
+    dataset->text_size += end - start;
+    dataset->text[dataset->text_size++] = '\n';
+    *end++ = '|';
+    dataset->received_size = end - dataset->received;
+  }
+
+  /* The last line has no separator after it, like the last line of a result */
+  if(dataset->received_size > 0) {
+    dataset->received_size--;
+  }
+  dataset->received[dataset->received_size] = '\0';
+
+  /* Parse every pokemon once for the kernels that start from pokemon */
+  dataset->work = (char *)checked_malloc(dataset->received_size + 1);
+  dataset->strings = (char *)checked_malloc(dataset->received_size + 1);
+  dataset->pokemon = (PokemonType *)checked_malloc(sizeof(PokemonType) * (number_of_rows + 1));
+  dataset->parsed = (PokemonType *)checked_malloc(sizeof(PokemonType) * (number_of_rows + 1));
+  dataset->line = (char *)checked_malloc(MICROBENCH_LINE_SIZE);
+  memcpy(dataset->strings, dataset->received, dataset->received_size + 1);
+  char *position = dataset->strings;
+  for(int i = 0; i < number_of_rows; i++) {
+    line_to_pokemon(strsep(&position, "|"), &dataset->pokemon[i], SEPARATOR);
+  }
+
+  /* Build the table the server answers from once for the kernels that query it */
+  char *text = table_allocate_text(dataset->text_size);
+  if(text == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(text, dataset->text, dataset->text_size);
+  table_load_text(&dataset->table, text, dataset->text_size);
+  if(dataset->table.number_of_rows != number_of_rows) {
+    printf("The dataset of %d pokemon was loaded as %d pokemon \n", number_of_rows, dataset->table.number_of_rows);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/* This function frees every form of a dataset */
+/* Parameters: *dataset - input/output (the dataset being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees dynamically allocated data */
+void free_dataset(MicrobenchDatasetType *dataset) {
+  free(dataset->text);
+  free(dataset->received);
+  free(dataset->work);
+  free(dataset->pokemon);
+  free(dataset->parsed);
+  free(dataset->strings);
+  free(dataset->line);
+  table_free(&dataset->table);
+  memset(dataset, 0, sizeof(MicrobenchDatasetType));
+}
+
+/* This function measures check_valid_pokemon_type on the first type of every pokemon, one operation per pokemon */
+/* Parameters: *dataset - input (the dataset), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: none */
+long kernel_check_valid_pokemon_type(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  int number_of_valid = 0;
+
+  timer_start(timer);
+  for(int i = 0; i < dataset->number_of_rows; i++) {
+    number_of_valid += (check_valid_pokemon_type(dataset->pokemon[i].first_type) == C_OK);
+  }
+  timer_stop(timer);
+  return (number_of_valid >= 0) ? dataset->number_of_rows : 0;
+}
+
+/* This function measures splitting a result into lines and parsing every line with line_to_pokemon, the way the receive thread of the client does, one operation per pokemon */
+/* Parameters: *dataset - input/output (the dataset, work is overwritten), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: changes work and parsed */
+long kernel_line_to_pokemon(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  memcpy(dataset->work, dataset->received, dataset->received_size + 1);
+  char *position = dataset->work;
+
+  timer_start(timer);
+  for(int i = 0; i < dataset->number_of_rows; i++) {
+    line_to_pokemon(strsep(&position, "|"), &dataset->parsed[i], SEPARATOR);
+  }
+  timer_stop(timer);
+  return dataset->number_of_rows;
+}
+
+/* This function measures writing every pokemon back into a line with pokemon_to_line, the way a save does, one operation per pokemon */
+/* Parameters: *dataset - input/output (the dataset, line is overwritten), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: changes line */
+long kernel_pokemon_to_line(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  long characters = 0;
+
+  timer_start(timer);
+  for(int i = 0; i < dataset->number_of_rows; i++) {
+    characters += pokemon_to_line(dataset->line, &dataset->pokemon[i], SEPARATOR);
+  }
+  timer_stop(timer);
+  return (characters >= 0) ? dataset->number_of_rows : 0;
+}
+
+/* This function measures adding every pokemon one at a time to an empty dynamic array with add_pokemon, one operation per pokemon */
+/* Parameters: *dataset - input (the dataset), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: allocates and frees the elements of a dynamic array */
+long kernel_add_pokemon(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  DynamicArrayType dynamic_array;
+
+  memset(&dynamic_array, 0, sizeof(DynamicArrayType));
+  timer_start(timer);
+  for(int i = 0; i < dataset->number_of_rows; i++) {
+    add_pokemon(&dataset->pokemon[i], &dynamic_array);
+  }
+  timer_stop(timer);
+  free(dynamic_array.darray_elements);
+  return dataset->number_of_rows;
+}
+
+/* This function measures building the table of the server out of the text of the pokemon file, splitting the lines, indexing the types with their serialized responses and ordering the rows, one operation per pokemon */
+/* Parameters: *dataset - input (the dataset), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: allocates and frees a table */
+long kernel_table_load(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  PokemonTableType table;
+  char *text = table_allocate_text(dataset->text_size);
+
+  if(text == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(text, dataset->text, dataset->text_size);
+
+  timer_start(timer);
+  table_load_text(&table, text, dataset->text_size);
+  timer_stop(timer);
+  table_free(&table);
+  return dataset->number_of_rows;
+}
+
+/* This function measures answering type queries the way server_read_pokemon does, finding the type inside the type index whose response was serialized when the table was loaded, one operation per query and one query per pokemon */
+/* Parameters: *dataset - input (the dataset), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: none */
+long kernel_type_response(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  long response_bytes = 0;
+  int number_of_types = sizeof(pokemon_types) / sizeof(pokemon_types[0]);
+
+  timer_start(timer);
+  for(int i = 0; i < dataset->number_of_rows; i++) {
+    const TypeIndexEntryType *entry = table_find_type(&dataset->table, pokemon_types[i % number_of_types]);
+    response_bytes += (entry != NULL) ? entry->response_size : 0;
+  }
+  timer_stop(timer);
+  return (response_bytes >= 0) ? dataset->number_of_rows : 0;
+}
+
+/* This function answers a filter query the way server_filter_pokemon does without the cache, parsing it, scanning the columns and serializing the matches */
+/* Parameters: *table - input (the table), *text - input (the query) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates and frees the bitmap, the ordered rows and the response, exits the program if the query is invalid */
+static void answer_filter_query(const PokemonTableType *table, const char *text) {
+  char error[MAX_QUERY_ERROR_SIZE];
+  QueryType query;
+  char *response;
+  int size;
+
+  if(query_parse(table, text, strlen(text), &query, error) == C_NOK) {
+    printf("Could not parse %s: %s \n", text, error);
+    exit(EXIT_FAILURE);
+  }
+  uint64_t *bitmap = (uint64_t *)checked_malloc(sizeof(uint64_t) * (bitmap_words(table->number_of_rows) + 1));
+  int number_of_matches = query_execute(table, &query, bitmap);
+  if(query.sort_column != QUERY_NO_SORT || query.limit != QUERY_NO_LIMIT) {
+    int *rows = (int *)checked_malloc(sizeof(int) * (number_of_matches + 1));
+    int number_of_rows = query_order(table, &query, bitmap, number_of_matches, rows);
+    response = query_serialize_rows(table, rows, number_of_rows, &size);
+    free(rows);
+  }
+  else {
+    response = query_serialize(table, bitmap, number_of_matches, &size);
+  }
+  free(bitmap);
+  free(response);
+}
+
+/* This function measures answering MICROBENCH_FILTER_QUERY, which is serialized straight from the bitmap of its matches, one operation per pokemon of the table */
+/* Parameters: *dataset - input (the dataset), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: allocates and frees the response */
+long kernel_filter_response(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  timer_start(timer);
+  answer_filter_query(&dataset->table, MICROBENCH_FILTER_QUERY);
+  timer_stop(timer);
+  return dataset->number_of_rows;
+}
+
+/* This function measures answering MICROBENCH_SORTED_QUERY, which orders its matches before serializing the first ones, one operation per pokemon of the table */
+/* Parameters: *dataset - input (the dataset), *timer - input/output (the timer of the kernel) */
+/* Return values: long containing the amount of operations */
+/* Side effects: allocates and frees the response */
+long kernel_sorted_response(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer) {
+  timer_start(timer);
+  answer_filter_query(&dataset->table, MICROBENCH_SORTED_QUERY);
+  timer_stop(timer);
+  return dataset->number_of_rows;
+}
+
+/* This function prints a string as a JSON string, escaping quotes, backslashes and control characters */
+/* Parameters: *output - input/output (the file being printed to), *string - input (the string being printed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: prints to output */
+void print_json_string(FILE *output, const char *string) {
+  fputc('"', output);
+  for(; *string != '\0'; string++) {
+    if(*string == '"' || *string == '\\') {
+      fprintf(output, "\\%c", *string);
+    }
+    else if((unsigned char)*string < 0x20) {
+      fprintf(output, "\\u%04x", (unsigned char)*string);
+    }
+    else {
+      fputc(*string, output);
+    }
+  }
+  fputc('"', output);
+}
+
+/* This function prints every measurement as one JSON object, followed by how fast the time per operation of every kernel grows with the amount of pokemon */
+/* Parameters: *output - input/output (the file being printed to), *file_name - input (the pokemon file the datasets were scaled from), source_rows - input (the amount of pokemon inside it), milliseconds - input (the least time every kernel was measured for), *results - input (every measurement, the datasets of a kernel from smallest to largest), number_of_results - input (the amount of measurements) */
+/* Return values: nothing since it's a void function */
+/* Side effects: prints to output, prints a warning for every kernel growing faster than linearly */
+void print_results(FILE *output, const char *file_name, int source_rows, long milliseconds, const MicrobenchResultType *results, int number_of_results) {
+  fprintf(output, "{\n  \"benchmark\": \"microbench\",\n  \"source\": ");
+  print_json_string(output, file_name);
+  fprintf(output, ",\n  \"source_rows\": %d,\n  \"min_milliseconds\": %ld,\n  \"column_scan_kernel\": ", source_rows, milliseconds);
+  print_json_string(output, column_scan_kernel_name());
+  fprintf(output, ",\n  \"compiler\": ");
+  print_json_string(output, __VERSION__);
+  fprintf(output, ",\n  \"results\": [\n");
+  for(int i = 0; i < number_of_results; i++) {
+    fprintf(output, "    {\"kernel\": \"%s\", \"rows\": %d, \"passes\": %ld, \"operations\": %ld, \"ns_per_op\": %.3f, \"allocs_per_op\": %.6f, \"bytes_per_op\": %.3f}%s\n", results[i].kernel, results[i].number_of_rows, results[i].passes, results[i].operations, results[i].nanoseconds_per_operation, results[i].allocations_per_operation, results[i].bytes_per_operation, (i + 1 < number_of_results) ? "," : "");
+  }
+  fprintf(output, "  ],\n  \"scaling\": [\n");
+
+  /* Linear work keeps the same time per operation on every dataset, the exponent is the fastest growth of the time per operation between two datasets that follow each other, 1 for a quadratic kernel */
+  int is_first = C_OK;
+  for(int i = 0; i < number_of_results; ) {
+    int last = i;
+    double exponent = 0.0;
+    while(last + 1 < number_of_results && strcmp(results[last + 1].kernel, results[i].kernel) == 0) {
+      const MicrobenchResultType *smaller = &results[last];
+      const MicrobenchResultType *larger = &results[last + 1];
+      if(smaller->nanoseconds_per_operation > 0 && larger->nanoseconds_per_operation > 0 && larger->number_of_rows != smaller->number_of_rows) {
+        double step = log(larger->nanoseconds_per_operation / smaller->nanoseconds_per_operation) / log((double)larger->number_of_rows / smaller->number_of_rows);
+        exponent = (step > exponent) ? step : exponent;
+      }
+      last++;
+    }
+    int is_superlinear = (exponent > MICROBENCH_MAX_EXPONENT);
+    fprintf(output, "%s    {\"kernel\": \"%s\", \"smallest_rows\": %d, \"largest_rows\": %d, \"exponent\": %.3f, \"superlinear\": %s}", (is_first == C_OK) ? "" : ",\n", results[i].kernel, results[i].number_of_rows, results[last].number_of_rows, exponent, is_superlinear ? "true" : "false");
+    if(is_superlinear) {
+      fprintf(stderr, "WARNING: the time per operation of %s grows like the amount of pokemon to the power of %.2f \n", results[i].kernel, exponent);
+    }
+    is_first = C_NOK;
+    i = last + 1;
+  }
+  fprintf(output, "\n  ]\n}\n");
+}
+
+/* This function reads every line of the pokemon file except its header */
+/* Parameters: *file_name - input (the name of the pokemon file), *number_of_lines - output (the amount of lines read) */
+/* Return values: char double pointer to every line without its line break, NULL if the file can't be read or has no pokemon */
+/* Side effects: allocates memory for every line, exits the program if it can't be allocated */
+static char **read_lines(const char *file_name, int *number_of_lines) {
+  FILE *file = fopen(file_name, "r");
+  char **lines = NULL;
+  int capacity = 0;
+  char *line = NULL;
+  size_t line_capacity = 0;
+  ssize_t length;
+
+  *number_of_lines = 0;
+  if(file == NULL) {
+    return NULL;
+  }
+
+  /* Skip the header */
+  if(getline(&line, &line_capacity, file) < 0) {
+    free(line);
+    fclose(file);
+    return NULL;
+  }
+  while((length = getline(&line, &line_capacity, file)) >= 0) {
+    while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+      line[--length] = '\0';
+    }
+    if(length == 0) {
+      continue;
+    }
+    if(*number_of_lines == capacity) {
+      capacity = (capacity > 0) ? capacity * 2 : DYNAMIC_ARRAY_INITIAL_CAPACITY;
+      lines = (char **)realloc(lines, sizeof(char *) * capacity);
+      if(lines == NULL) {
+        printf("An error occured while allocating memory. The program will now exit \n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    lines[(*number_of_lines)++] = strdup(line);
+  }
+  free(line);
+  fclose(file);
+  return lines;
+}
+
+/* This function is the function that is ran when the microbench.c program is first started */
+/* Parameters: argc - input (the amount of command line arguments), *argv[] - input (the command line arguments, see the top of the file) */
+/* Return values: int, 0 if every kernel was measured and 1 if the options or the pokemon file are invalid */
+/* Side effects: builds every dataset, runs every kernel on it and prints the results */
+int main(int argc, char *argv[]) {
+  const char *file_name = MICROBENCH_DEFAULT_FILE;  //Pokemon file the datasets are scaled from
+  char *scales_text = strdup(MICROBENCH_DEFAULT_SCALES); //Amount of pokemon of every dataset, separated by commas
+  const char *output_name = NULL;                   //File the JSON is written to, NULL for the terminal
+  long milliseconds = MICROBENCH_DEFAULT_MILLISECONDS; //Least time every kernel is measured for on every dataset
+  int scales[MICROBENCH_MAX_SCALES];                //Amount of pokemon of every dataset
+  int number_of_scales = 0;                         //Amount of datasets
+  int option;                                       //Command line option being read
+
+  /* Read the command line options */
+  while((option = getopt(argc, argv, "i:s:t:o:")) != -1) {
+    if(option == 'i') {
+      file_name = optarg;
+    }
+    else if(option == 's') {
+      free(scales_text);
+      scales_text = strdup(optarg);
+    }
+    else if(option == 't' && atol(optarg) > 0) {
+      milliseconds = atol(optarg);
+    }
+    else if(option == 'o') {
+      output_name = optarg;
+    }
+    else {
+      printf("Usage: %s [-i pokemon_file] [-s rows,rows,...] [-t milliseconds] [-o output.json] \n", argv[0]);
+      return 1;
+    }
+  }
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(scales_text == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  char *position = scales_text;
+  char *scale;
+  while((scale = strsep(&position, ",")) != NULL) {
+    if(number_of_scales == MICROBENCH_MAX_SCALES || atoi(scale) <= 0 || atoi(scale) > MICROBENCH_MAX_ROWS) {
+      printf("Give between 1 and %d amounts of pokemon, each between 1 and %d \n", MICROBENCH_MAX_SCALES, MICROBENCH_MAX_ROWS);
+      return 1;
+    }
+    scales[number_of_scales++] = atoi(scale);
+  }
+  free(scales_text);
+
+  int number_of_lines;
+  char **lines = read_lines(file_name, &number_of_lines);
+  if(lines == NULL) {
+    printf("Could not read any pokemon from %s \n", file_name);
+    return 1;
+  }
+
+  MicrobenchResultType *results = (MicrobenchResultType *)checked_malloc(sizeof(MicrobenchResultType) * NUMBER_OF_KERNELS * number_of_scales);
+
+  /* Build each dataset once and measure every kernel on it, each kernel runs passes until it was measured for long enough */
+  for(int s = 0; s < number_of_scales; s++) {
+    MicrobenchDatasetType dataset;
+
+    fprintf(stderr, "Measuring %d pokemon \n", scales[s]);
+    build_dataset(&dataset, lines, number_of_lines, scales[s]);
+    for(int k = 0; k < NUMBER_OF_KERNELS; k++) {
+      MicrobenchTimerType timer;
+      MicrobenchResultType *result = &results[k * number_of_scales + s];
+
+      memset(&timer, 0, sizeof(timer));
+      memset(result, 0, sizeof(MicrobenchResultType));
+      result->kernel = kernels[k].name;
+      result->number_of_rows = scales[s];
+      while(result->passes == 0 || timer.nanoseconds < milliseconds * 1000000LL) {
+        result->operations += kernels[k].function(&dataset, &timer);
+        result->passes++;
+      }
+      if(result->operations > 0) {
+        result->nanoseconds_per_operation = (double)timer.nanoseconds / result->operations;
+        result->allocations_per_operation = (double)timer.allocations / result->operations;
+        result->bytes_per_operation = (double)timer.bytes / result->operations;
+      }
+    }
+    free_dataset(&dataset);
+  }
+
+  FILE *output = (output_name != NULL) ? fopen(output_name, "w") : stdout;
+  if(output == NULL) {
+    printf("Could not write %s \n", output_name);
+    return 1;
+  }
+  print_results(output, file_name, number_of_lines, milliseconds, results, NUMBER_OF_KERNELS * number_of_scales);
+  if(output != stdout) {
+    fclose(output);
+  }
+
+  for(int i = 0; i < number_of_lines; i++) {
+    free(lines[i]);
+  }
+  free(lines);
+  free(results);
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*****************************************************************************/
+/* */
+/* microbench.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the microbench.c file */
+/* How to use: use #include "microbench.h" at the top of any .c files that need to measure the parsing, filtering and serialization functions on their own */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef MICROBENCH_H_
+#define MICROBENCH_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//importing the header files of every function being measured
+#include "dynamic_array.h"
+#include "export.h"
+#include "pokemon_table.h"
+#include "query.h"
+
+//Variety of constants defined
+#define MICROBENCH_DEFAULT_FILE "pokemon.csv" //Constant to represent the pokemon file the datasets are scaled from when the user does not choose one
+#define MICROBENCH_DEFAULT_SCALES "1000,10000,100000,1000000" //Constant to represent the amount of pokemon of every dataset measured when the user does not choose them
+#define MICROBENCH_DEFAULT_MILLISECONDS 200  //Constant to represent the least amount of time every kernel is measured for on every dataset when the user does not choose one
+#define MICROBENCH_MAX_SCALES 8              //Constant to represent the most datasets one run can measure
+#define MICROBENCH_MAX_ROWS 50000000         //Constant to represent the most pokemon a dataset can hold
+#define MICROBENCH_MAX_EXPONENT 0.75         //Constant to represent the most the time per operation of a kernel can grow between two datasets, as the power of their ratio of pokemon, before it is reported as growing faster than linearly. A quadratic kernel grows with a power of 1, cache misses on larger datasets stay well below it
+#define MICROBENCH_LINE_SIZE 4096            //Constant to represent the amount of characters of the line every pokemon is written into
+#define MICROBENCH_FILTER_QUERY "speed>=100"  //Constant to represent the filter query whose response is assembled straight from the bitmap of the matches
+#define MICROBENCH_SORTED_QUERY "type=Water sort=-speed limit=20" //Constant to represent the filter query whose response is assembled from ordered rows
+
+/* This structure contains one dataset scaled from the pokemon file, in every form the kernels start from */
+typedef struct MicrobenchDataset {
+  int number_of_rows;           //Amount of pokemon inside the dataset
+  char *text;                   //Whole pokemon file with its header, as the server reads it
+  long text_size;               //Amount of characters inside text
+  char *received;               //Every line separated by '|', as the client receives them inside a result
+  long received_size;           //Amount of characters inside received, without its null character
+  char *work;                   //Copy of received the kernels split in place
+  PokemonType *pokemon;         //Every pokemon parsed once, pointing into strings
+  char *strings;                //Copy of received the names and types of pokemon point into
+  PokemonType *parsed;          //Pokemon the kernels parse work into
+  PokemonTableType table;       //Table the server builds from text
+  char *line;                   //Line every pokemon is written into
+} MicrobenchDatasetType;
+
+/* This structure adds up the time and allocations of the measured part of every pass of a kernel */
+typedef struct MicrobenchTimer {
+  int64_t started_at;           //Time the current measured part started at
+  long allocations_at_start;    //Amount of allocations made before the current measured part
+  long bytes_at_start;          //Amount of bytes allocated before the current measured part
+  int64_t nanoseconds;          //Time spent inside every measured part
+  long allocations;             //Amount of allocations made inside every measured part
+  long bytes;                   //Amount of bytes allocated inside every measured part
+} MicrobenchTimerType;
+
+/* This is the type of every kernel, it runs one pass over a dataset, measuring only the work being benchmarked, and returns how many operations it did */
+typedef long (*MicrobenchKernelType)(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+
+/* This structure contains the measurements of one kernel on one dataset */
+typedef struct MicrobenchResult {
+  const char *kernel;           //Name of the kernel
+  int number_of_rows;           //Amount of pokemon inside the dataset
+  long passes;                  //Amount of passes ran over the dataset
+  long operations;              //Amount of operations done by every pass together
+  double nanoseconds_per_operation; //Average time of one operation
+  double allocations_per_operation; //Average amount of allocations of one operation
+  double bytes_per_operation;   //Average amount of bytes allocated by one operation
+} MicrobenchResultType;
+
+/* all function prototypes for functions in microbench.c */
+int64_t microbench_now(void);
+void timer_start(MicrobenchTimerType *timer);
+void timer_stop(MicrobenchTimerType *timer);
+void build_dataset(MicrobenchDatasetType *dataset, char **lines, int number_of_lines, int number_of_rows);
+void free_dataset(MicrobenchDatasetType *dataset);
+long kernel_check_valid_pokemon_type(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_line_to_pokemon(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_pokemon_to_line(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_add_pokemon(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_table_load(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_type_response(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_filter_response(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+long kernel_sorted_response(MicrobenchDatasetType *dataset, MicrobenchTimerType *timer);
+void print_json_string(FILE *output, const char *string);
+void print_results(FILE *output, const char *file_name, int source_rows, long milliseconds, const MicrobenchResultType *results, int number_of_results);
+
+#endif //end of header file
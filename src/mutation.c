@@ -0,0 +1,462 @@
+/*****************************************************************************/
+/* */
+/* mutation.c */
+/* Purpose: This file contains the functions that insert, update and delete pokemon. A table never changes once it is built, so changes are applied to a batch of rows pointing into the current table and a new table is built out of the batch, the same way a table is built out of the pokemon file. Every request is applied completely or not at all. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Parse the text of a request with mutation_parse, apply it to a batch started with mutation_batch_init and build the new table with mutation_batch_build. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "mutation.h"
+
+/* Word every kind of change starts with, indexed with MutationKindType */
+static const char *kind_names[NUMBER_OF_MUTATION_KINDS] = {"insert", "update", "delete"};
+
+/* Name of every field of a line of the pokemon file, used to describe the field that is wrong */
+static const char *field_names[NUMBER_OF_CSV_FIELDS] = {"number", "name", "type1", "type2", "total", "hp", "attack", "defense", "sp_attack", "sp_defense", "speed", "generation", "legendary"};
+
+/* This function reallocates a buffer and exits the program if the memory can't be allocated */
+/* Parameters: *buffer - input (the buffer being reallocated, can be NULL), size - input (the new size of the buffer in bytes) */
+/* Return values: pointer to the reallocated buffer */
+/* Side effects: reallocates memory, exits the program if memory can't be allocated */
+static void *checked_realloc(void *buffer, size_t size) {
+  void *new_buffer = realloc(buffer, size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(new_buffer == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  return new_buffer;
+}
+
+/* This function checks that a line has every field of a line of the pokemon file, the same fields the server reads when it loads the file */
+/* Parameters: *line - input (the line being checked, not null-terminated), length - input (the amount of characters inside line), number - input (the position of the change inside the request, used in the error), *mutation - output (the name of the pokemon is written into it), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if the line is valid and C_NOK (-1) if it is not */
+/* Side effects: none */
+static int mutation_check_line(const char *line, int length, int number, MutationType *mutation, char *error) {
+  int starts[NUMBER_OF_CSV_FIELDS];  //Position of the first character of every field
+  int lengths[NUMBER_OF_CSV_FIELDS]; //Amount of characters inside every field
+  int field = 0;
+
+  /* The client splits the lines of a result on '|', so a line can't contain one */
+  if(memchr(line, '|', length) != NULL || memchr(line, '\0', length) != NULL) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: a pokemon can't contain the '|' character", number);
+    return C_NOK;
+  }
+
+  starts[0] = 0;
+  for(int i = 0; i < length; i++) {
+    if(line[i] == ',') {
+      if(field == NUMBER_OF_CSV_FIELDS - 1) {
+        field++;
+        break;
+      }
+      lengths[field] = i - starts[field];
+      starts[++field] = i + 1;
+    }
+  }
+  if(field != NUMBER_OF_CSV_FIELDS - 1) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: a pokemon must have %d fields separated by commas, like the lines of the pokemon file", number, NUMBER_OF_CSV_FIELDS);
+    return C_NOK;
+  }
+  lengths[field] = length - starts[field];
+
+  /* The first field and the fifth to the twelfth are numbers stored inside a short */
+  for(int i = 0; i < NUMBER_OF_CSV_FIELDS; i++) {
+    if(i != 0 && (i < COLUMN_TOTAL + 3 || i > COLUMN_GENERATION + 3)) {
+      continue;
+    }
+    int value = 0;
+    for(int j = 0; j < lengths[i] && value <= SHRT_MAX; j++) {
+      value = (line[starts[i] + j] >= '0' && line[starts[i] + j] <= '9') ? value * 10 + (line[starts[i] + j] - '0') : SHRT_MAX + 1;
+    }
+    if(lengths[i] == 0 || value > SHRT_MAX) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: %s must be a number between 0 and %d", number, field_names[i], SHRT_MAX);
+      return C_NOK;
+    }
+  }
+
+  if(lengths[1] == 0 || lengths[2] == 0) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: a pokemon must have a name and a first type", number);
+    return C_NOK;
+  }
+  if(!(lengths[12] == 4 && memcmp(line + starts[12], "True", 4) == 0) && !(lengths[12] == 5 && memcmp(line + starts[12], "False", 5) == 0)) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: legendary must be True or False", number);
+    return C_NOK;
+  }
+
+  mutation->line = line;
+  mutation->line_length = length;
+  mutation->name = line + starts[1];
+  mutation->name_length = lengths[1];
+  return C_OK;
+}
+
+/* This function parses the text of a change request, one change per line: "insert <line>", "update <line>" or "delete <name>", where <line> is written like a line of the pokemon file and an update replaces the pokemon with the same name */
+/* Parameters: *text - input (the text of the request, not null-terminated), length - input (the amount of characters inside text), **mutations - output (the parsed changes, pointing into text, which must be freed by the caller), *number_of_mutations - output (the amount of changes), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if every change was parsed and C_NOK (-1) if one is invalid, in which case nothing has to be freed */
+/* Side effects: allocates memory for the changes */
+int mutation_parse(const char *text, int length, MutationType **mutations, int *number_of_mutations, char *error) {
+  int capacity = 1;
+
+  /* Every line holds at most one change */
+  for(int i = 0; i < length; i++) {
+    capacity += (text[i] == '\n');
+  }
+  *mutations = (MutationType *)checked_realloc(NULL, sizeof(MutationType) * capacity);
+  *number_of_mutations = 0;
+
+  for(int start = 0; start < length; ) {
+    const char *line_break = (const char *)memchr(text + start, '\n', length - start);
+    int end = (line_break == NULL) ? length : (int)(line_break - text);
+    int next = end + 1;
+
+    /* Remove the blanks around the change, blank lines are skipped */
+    while(start < end && memchr(QUERY_BLANKS, text[start], sizeof(QUERY_BLANKS) - 1) != NULL) {
+      start++;
+    }
+    while(end > start && memchr(QUERY_BLANKS, text[end - 1], sizeof(QUERY_BLANKS) - 1) != NULL) {
+      end--;
+    }
+    if(start == end) {
+      start = next;
+      continue;
+    }
+
+    /* The first word is the kind of change, the rest of the line is what it changes */
+    MutationType *mutation = &(*mutations)[*number_of_mutations];
+    int number = *number_of_mutations + 1;
+    int word_end = start;
+    while(word_end < end && memchr(QUERY_BLANKS, text[word_end], sizeof(QUERY_BLANKS) - 1) == NULL) {
+      word_end++;
+    }
+    mutation->kind = NUMBER_OF_MUTATION_KINDS;
+    for(int kind = 0; kind < NUMBER_OF_MUTATION_KINDS; kind++) {
+      if((int)strlen(kind_names[kind]) == word_end - start && strncasecmp(text + start, kind_names[kind], word_end - start) == 0) {
+        mutation->kind = kind;
+      }
+    }
+    int argument = word_end;
+    while(argument < end && memchr(QUERY_BLANKS, text[argument], sizeof(QUERY_BLANKS) - 1) != NULL) {
+      argument++;
+    }
+
+    if(mutation->kind == NUMBER_OF_MUTATION_KINDS || argument == end) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: expected 'insert <pokemon>', 'update <pokemon>' or 'delete <name>'", number);
+      free(*mutations);
+      return C_NOK;
+    }
+    if(mutation->kind == MUTATION_DELETE) {
+      if(memchr(text + argument, ',', end - argument) != NULL || memchr(text + argument, '|', end - argument) != NULL) {
+        snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: delete only takes the name of the pokemon", number);
+        free(*mutations);
+        return C_NOK;
+      }
+      mutation->line = NULL;
+      mutation->line_length = 0;
+      mutation->name = text + argument;
+      mutation->name_length = end - argument;
+    }
+    else if(mutation_check_line(text + argument, end - argument, number, mutation, error) == C_NOK) {
+      free(*mutations);
+      return C_NOK;
+    }
+
+    (*number_of_mutations)++;
+    start = next;
+  }
+
+  if(*number_of_mutations == 0) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "A change request must contain at least one change");
+    free(*mutations);
+    return C_NOK;
+  }
+  return C_OK;
+}
+
+/* This function writes a change the same way it is written inside a request, followed by a line break */
+/* Parameters: *mutation - input (the change being written), *output - output (the text, at least the length of the line or name plus MUTATION_LINE_EXTRA characters) */
+/* Return values: int containing the amount of characters written */
+/* Side effects: none */
+int mutation_format(const MutationType *mutation, char *output) {
+  const char *argument = (mutation->kind == MUTATION_DELETE) ? mutation->name : mutation->line;
+  int length = (mutation->kind == MUTATION_DELETE) ? mutation->name_length : mutation->line_length;
+  int kind_length = strlen(kind_names[mutation->kind]);
+
+  memcpy(output, kind_names[mutation->kind], kind_length);
+  output[kind_length] = ' ';
+  memcpy(output + kind_length + 1, argument, length);
+  output[kind_length + 1 + length] = '\n';
+  return kind_length + length + 2;
+}
+
+/* This function looks for the slot of a name inside the name index of a batch */
+/* Parameters: *batch - input (the batch being searched), *name - input (the name being searched for, not null-terminated), length - input (the amount of characters inside name) */
+/* Return values: int containing the index of the slot holding the name, or of the empty slot where it would be stored */
+/* Side effects: none */
+static int mutation_find_slot(const MutationBatchType *batch, const char *name, int length) {
+  int mask = batch->slots_capacity - 1;
+  int slot = hash_string(name, length) & mask;
+
+  /* Linear probing until either the name or an empty slot is found */
+  while(batch->slots[slot] != 0) {
+    const MutationRowType *row = &batch->rows[batch->slots[slot] - 1];
+    if(row->name_length == length && memcmp(row->name, name, length) == 0) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/* This function makes room inside a batch for the rows and the names a request can add */
+/* Parameters: *batch - input/output (the batch being grown), additional_rows - input (the amount of rows that can be added) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may reallocate the rows and rebuild the name index, so it is only called before a request is applied */
+static void mutation_reserve(MutationBatchType *batch, int additional_rows) {
+  int needed = batch->number_of_rows + additional_rows;
+
+  if(needed > batch->rows_capacity) {
+    int capacity = (batch->rows_capacity > 0) ? batch->rows_capacity : MUTATION_INITIAL_ROWS;
+    while(needed > capacity) {
+      capacity *= 2;
+    }
+    batch->rows = (MutationRowType *)checked_realloc(batch->rows, sizeof(MutationRowType) * capacity);
+    batch->rows_capacity = capacity;
+  }
+
+  /* Keep the name index at most half full, growing it moves every name so it is rebuilt from the rows */
+  if(needed * 2 > batch->slots_capacity) {
+    int capacity = (batch->slots_capacity > 0) ? batch->slots_capacity : MUTATION_INITIAL_ROWS * 2;
+    while(needed * 2 > capacity) {
+      capacity *= 2;
+    }
+    free(batch->slots);
+    batch->slots = (int *)calloc(capacity, sizeof(int));
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if(batch->slots == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+    batch->slots_capacity = capacity;
+
+    /* A name deleted and inserted again has two rows, the last one is the one the index points to */
+    for(int row = 0; row < batch->number_of_rows; row++) {
+      batch->slots[mutation_find_slot(batch, batch->rows[row].name, batch->rows[row].name_length)] = row + 1;
+    }
+  }
+}
+
+/* This function starts a batch holding every row of a table */
+/* Parameters: *batch - output (the batch being started), *base - input (the table the changes are applied to, it must stay alive until the new table is built) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates the rows and the name index of the batch, which must be released with mutation_batch_free */
+void mutation_batch_init(MutationBatchType *batch, const PokemonTableType *base) {
+  memset(batch, 0, sizeof(MutationBatchType));
+  batch->base = base;
+
+  mutation_reserve(batch, base->number_of_rows);
+  for(int row = 0; row < base->number_of_rows; row++) {
+    MutationRowType *batch_row = &batch->rows[row];
+    batch_row->line = table_view(base, base->line[row]);
+    batch_row->line_length = base->line[row].length;
+    batch_row->name = table_view(base, base->name[row]);
+    batch_row->name_length = base->name[row].length;
+    batch->text_size += batch_row->line_length + 1;
+    batch->slots[mutation_find_slot(batch, batch_row->name, batch_row->name_length)] = row + 1;
+  }
+  batch->number_of_rows = base->number_of_rows;
+}
+
+/* This function replaces the line of a row, remembering the previous line so the change can be taken back */
+/* Parameters: *batch - input/output (the batch being changed), row - input (the row being changed), slot - input (the slot of the name index being changed, -1 if none), slot_value - input (the new value of the slot), *line - input (the new line, NULL to delete the row), line_length - input (the amount of characters inside line) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may grow the undo list of the batch */
+static void mutation_change_row(MutationBatchType *batch, int row, int slot, int slot_value, const char *line, int line_length) {
+  if(batch->undo_size == batch->undo_capacity) {
+    batch->undo_capacity = (batch->undo_capacity > 0) ? batch->undo_capacity * 2 : MUTATION_INITIAL_UNDO;
+    batch->undo = (MutationUndoType *)checked_realloc(batch->undo, sizeof(MutationUndoType) * batch->undo_capacity);
+  }
+
+  MutationUndoType *undo = &batch->undo[batch->undo_size++];
+  MutationRowType *changed = &batch->rows[row];
+  undo->row = row;
+  undo->line = changed->line;
+  undo->line_length = changed->line_length;
+  undo->slot = slot;
+  undo->slot_value = (slot >= 0) ? batch->slots[slot] : 0;
+
+  batch->text_size -= (changed->line != NULL) ? changed->line_length + 1 : 0;
+  batch->text_size += (line != NULL) ? line_length + 1 : 0;
+  changed->line = line;
+  changed->line_length = line_length;
+  if(slot >= 0) {
+    batch->slots[slot] = slot_value;
+  }
+}
+
+/* This function checks that the types of a pokemon can be indexed, a table can only hold TYPE_INDEX_SLOTS / 2 different types */
+/* Parameters: *batch - input/output (the batch the pokemon is added to, it remembers the new types), *mutation - input (the change adding the pokemon), number - input (the position of the change inside the request, used in the error), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if the types fit and C_NOK (-1) if they don't */
+/* Side effects: interns the types the base table doesn't have, they are still counted if the request fails */
+static int mutation_check_types(MutationBatchType *batch, const MutationType *mutation, int number, char *error) {
+  const char *type = (const char *)memchr(mutation->line, ',', mutation->line_length);
+  type = (const char *)memchr(type + 1, ',', mutation->line_length - (type + 1 - mutation->line)) + 1;
+
+  /* The first type and the second type follow the name, the second one can be empty */
+  for(int i = 0; i < 2; i++) {
+    const char *comma = (const char *)memchr(type, ',', mutation->line_length - (type - mutation->line));
+    int length = comma - type;
+    char name[MAX_MESSAGE_BUFFER_SIZE];
+
+    /* A client can't ask for a longer type, so the pokemon could never be found by its type */
+    if(length >= MAX_MESSAGE_BUFFER_SIZE) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: a type can't be longer than %d characters", number, MAX_MESSAGE_BUFFER_SIZE - 1);
+      return C_NOK;
+    }
+    memcpy(name, type, length);
+    name[length] = '\0';
+    if(length > 0 && table_find_type(batch->base, name) == NULL) {
+      string_pool_intern(&batch->new_types, type, length);
+      if(batch->base->number_of_types + batch->new_types.number_of_interned > TYPE_INDEX_SLOTS / 2) {
+        snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: the table can't hold more than %d different types", number, TYPE_INDEX_SLOTS / 2);
+        return C_NOK;
+      }
+    }
+    type = comma + 1;
+  }
+  return C_OK;
+}
+
+/* This function applies the changes of one request to a batch, either every change is applied or none of them is */
+/* Parameters: *batch - input/output (the batch being changed), *mutations - input (the changes, their lines must stay alive until the new table is built), number_of_mutations - input (the amount of changes), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if every change was applied and C_NOK (-1) if one of them can't be, in which case the batch is left as it was */
+/* Side effects: may grow the rows, the name index and the undo list of the batch */
+int mutation_batch_apply(MutationBatchType *batch, const MutationType *mutations, int number_of_mutations, char *error) {
+  int number_of_rows = batch->number_of_rows;
+  int result = C_OK;
+
+  mutation_reserve(batch, number_of_mutations);
+  batch->undo_size = 0;
+
+  for(int i = 0; i < number_of_mutations && result == C_OK; i++) {
+    const MutationType *mutation = &mutations[i];
+    int slot = mutation_find_slot(batch, mutation->name, mutation->name_length);
+    int row = batch->slots[slot] - 1;
+    char exists = (row >= 0 && batch->rows[row].line != NULL) ? C_OK : C_NOK;
+
+    if(mutation->kind == MUTATION_INSERT && exists == C_OK) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: %.*s is already inside the table, use update to change it", i + 1, mutation->name_length > 100 ? 100 : mutation->name_length, mutation->name);
+      result = C_NOK;
+    }
+    else if(mutation->kind != MUTATION_INSERT && exists == C_NOK) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Change %d: %.*s is not inside the table", i + 1, mutation->name_length > 100 ? 100 : mutation->name_length, mutation->name);
+      result = C_NOK;
+    }
+    else if(mutation->kind != MUTATION_DELETE && mutation_check_types(batch, mutation, i + 1, error) == C_NOK) {
+      result = C_NOK;
+    }
+    else if(mutation->kind == MUTATION_INSERT) {
+      /* An inserted pokemon gets a new row at the end, even if a pokemon with its name was deleted before */
+      row = batch->number_of_rows++;
+      batch->rows[row].line = NULL;
+      batch->rows[row].line_length = 0;
+      batch->rows[row].name = mutation->name;
+      batch->rows[row].name_length = mutation->name_length;
+      mutation_change_row(batch, row, slot, row + 1, mutation->line, mutation->line_length);
+    }
+    else {
+      mutation_change_row(batch, row, -1, 0, mutation->line, mutation->line_length);
+    }
+  }
+
+  /* Take every change of the request back, newest first */
+  if(result == C_NOK) {
+    for(int i = batch->undo_size - 1; i >= 0; i--) {
+      const MutationUndoType *undo = &batch->undo[i];
+      MutationRowType *changed = &batch->rows[undo->row];
+      batch->text_size -= (changed->line != NULL) ? changed->line_length + 1 : 0;
+      batch->text_size += (undo->line != NULL) ? undo->line_length + 1 : 0;
+      changed->line = undo->line;
+      changed->line_length = undo->line_length;
+      if(undo->slot >= 0) {
+        batch->slots[undo->slot] = undo->slot_value;
+      }
+    }
+    batch->number_of_rows = number_of_rows;
+    return C_NOK;
+  }
+
+  batch->number_of_changes += number_of_mutations;
+  return C_OK;
+}
+
+/* This function builds a new table out of the rows of a batch, the header of the base table followed by the line of every row that was not deleted */
+/* Parameters: *batch - input (the batch holding the changed rows), *table - output (the new table) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates memory for the text and the table which must be released with table_free, exits the program if it can't be allocated */
+void mutation_batch_build(const MutationBatchType *batch, PokemonTableType *table) {
+  const PokemonTableType *base = batch->base;
+  const char *header = POKEMON_CSV_HEADER;
+  long header_length = strlen(POKEMON_CSV_HEADER);
+
+  /* Keep the header of the base table, the first line of its file */
+  if(base->file_size > 0) {
+    const char *line_break = (const char *)memchr(base->file, '\n', base->file_size);
+    header = base->file;
+    header_length = (line_break == NULL) ? base->file_size : line_break - base->file;
+    if(header_length > 0 && header[header_length - 1] == '\r') {
+      header_length--;
+    }
+  }
+
+  long size = header_length + 1 + batch->text_size;
+  char *text = table_allocate_text(size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(text == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  char *position = text;
+  memcpy(position, header, header_length);
+  position[header_length] = '\n';
+  position += header_length + 1;
+  for(int row = 0; row < batch->number_of_rows; row++) {
+    const MutationRowType *batch_row = &batch->rows[row];
+    if(batch_row->line != NULL) {
+      memcpy(position, batch_row->line, batch_row->line_length);
+      position[batch_row->line_length] = '\n';
+      position += batch_row->line_length + 1;
+    }
+  }
+
+  /* The batch already refused every change adding more types than the type index holds, so the table is always built */
+  table_load_text(table, text, size);
+}
+
+/* This function frees the rows, the name index and the undo list of a batch */
+/* Parameters: *batch - input/output (the batch being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees dynamically allocated data */
+void mutation_batch_free(MutationBatchType *batch) {
+  free(batch->rows);
+  free(batch->slots);
+  free(batch->undo);
+  free(batch->new_types.characters);
+  free(batch->new_types.slots);
+  memset(batch, 0, sizeof(MutationBatchType));
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/* */
+/* mutation.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the mutation.c file */
+/* How to use: use #include "mutation.h" at the top of any .c files that need to insert, update or delete pokemon of the table */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef MUTATION_H_
+#define MUTATION_H_
+
+//importing the header files of the table being changed and of the strings it interns
+#include "pokemon_table.h"
+
+//Variety of constants defined
+#define MUTATION_INITIAL_ROWS 64          //Constant to represent the amount of rows a batch can hold before it has to grow
+#define MUTATION_INITIAL_UNDO 16          //Constant to represent the amount of changes a batch can remember before its undo list has to grow
+#define MUTATION_LINE_EXTRA 8             //Constant to represent the amount of characters a change adds in front of the line or the name it writes, the longest kind and a blank, plus its line break
+#define POKEMON_CSV_HEADER "#,Name,Type 1,Type 2,Total,HP,Attack,Defense,Sp. Atk,Sp. Def,Speed,Generation,Legendary" //Constant to represent the header written in front of a table that was built from an empty file
+
+/* This enum names every kind of change a request can make */
+typedef enum MutationKind {
+  MUTATION_INSERT,        //Adds a pokemon whose name is not inside the table yet
+  MUTATION_UPDATE,        //Replaces the line of the pokemon with the same name
+  MUTATION_DELETE,        //Removes the pokemon with a name
+  NUMBER_OF_MUTATION_KINDS//Amount of kinds, must stay last
+} MutationKindType;
+
+/* This structure contains one change parsed from the text of a request, it points into that text instead of copying it */
+typedef struct Mutation {
+  MutationKindType kind;  //Kind of the change
+  const char *line;       //Line of the pokemon in the format of the pokemon file, NULL for a delete
+  int line_length;        //Amount of characters inside line
+  const char *name;       //Name of the pokemon being changed
+  int name_length;        //Amount of characters inside name
+} MutationType;
+
+/* This structure contains one row of a batch, the line it currently has and the name it is found by */
+typedef struct MutationRow {
+  const char *line;       //Line of the pokemon, NULL once the pokemon is deleted
+  int line_length;        //Amount of characters inside line
+  const char *name;       //Name of the pokemon, kept after a delete so the name index can still be probed
+  int name_length;        //Amount of characters inside name
+} MutationRowType;
+
+/* This structure remembers what one change replaced, so the changes of a request that fails halfway can be taken back */
+typedef struct MutationUndo {
+  int row;                //Row whose line was replaced, -1 if only a slot changed
+  const char *line;       //Line the row had before the change
+  int line_length;        //Amount of characters inside line
+  int slot;               //Slot of the name index that changed, -1 if no slot changed
+  int slot_value;         //Value the slot had before the change
+} MutationUndoType;
+
+/* This structure contains the rows of a table while changes are applied to them. The rows are never copied: lines point into the base table or into the text of the requests, and a new table is built out of them once every change is applied.
+   Rows keep the order of the base table, inserted pokemon are added at the end */
+typedef struct MutationBatch {
+  const PokemonTableType *base;   //Table the changes are applied to, it must stay alive until the new table is built
+  MutationRowType *rows;          //Every row of the base table followed by every inserted row
+  int number_of_rows;             //Amount of rows inside rows, including deleted ones
+  int rows_capacity;              //Amount of rows rows can hold before it has to grow
+  int *slots;                     //Open addressing hash table of row indexes plus one by name, 0 marks an empty slot
+  int slots_capacity;             //Amount of slots inside slots, always at least twice the amount of rows
+  long text_size;                 //Amount of characters of the lines of every row that is not deleted, including their line breaks
+  StringPoolType new_types;       //Types that the base table doesn't have, so a batch can't add more types than the table can index
+  MutationUndoType *undo;         //Changes applied by the request being applied, taken back if one of its changes fails
+  int undo_size;                  //Amount of changes inside undo
+  int undo_capacity;              //Amount of changes undo can hold before it has to grow
+  int number_of_changes;          //Amount of changes applied to the batch
+} MutationBatchType;
+
+/* all function prototypes for functions in mutation.c */
+int mutation_parse(const char *text, int length, MutationType **mutations, int *number_of_mutations, char *error);
+int mutation_format(const MutationType *mutation, char *output);
+void mutation_batch_init(MutationBatchType *batch, const PokemonTableType *base);
+int mutation_batch_apply(MutationBatchType *batch, const MutationType *mutations, int number_of_mutations, char *error);
+void mutation_batch_build(const MutationBatchType *batch, PokemonTableType *table);
+void mutation_batch_free(MutationBatchType *batch);
+
+#endif //end of header file
@@ -0,0 +1,675 @@
+/*****************************************************************************/
+/* */
+/* pokemon_table.c */
+/* Purpose: This file loads the pokemon file chosen when the server starts into an in-memory table once, so that every query afterwards is answered from RAM instead of re-reading the file. The file is read once into private memory and split into rows and fields with a vectorized scan for commas and line breaks, names and lines are kept as views into that memory instead of being copied. Since the table owns its copy of the file, rewriting the file while the table is used can't change it. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Call table_load_csv once, or table_load_text with text from table_allocate_text to build a table that isn't read from a file, and then read the columns of the PokemonTableType directly. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "pokemon_table.h"
+
+static long number_of_loads = 0;  //Amount of tables loaded so far, used to give every table its own version
+
+/* This function computes the FNV-1a hash of a string */
+/* Parameters: *string - input (the characters being hashed), length - input (the amount of characters being hashed) */
+/* Return values: unsigned int containing the hash of the string */
+/* Side effects: none */
+unsigned int hash_string(const char *string, long length) {
+  unsigned int hash = 2166136261u;
+  for(long i = 0; i < length; i++) {
+    hash ^= (unsigned char)string[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/* This function reallocates a buffer and exits the program if the memory can't be allocated */
+/* Parameters: *buffer - input (the buffer being reallocated, can be NULL), size - input (the new size of the buffer in bytes) */
+/* Return values: pointer to the reallocated buffer */
+/* Side effects: reallocates memory, exits the program if memory can't be allocated */
+static void *checked_realloc(void *buffer, size_t size) {
+  void *new_buffer = realloc(buffer, size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(new_buffer == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  return new_buffer;
+}
+
+/* This function appends a copy of a string to the string pool without checking whether it is already stored */
+/* Parameters: *pool - input/output (the string pool the string is added to), *string - input (the characters being added), length - input (the amount of characters being added) */
+/* Return values: int containing the offset of the new string inside the pool */
+/* Side effects: may reallocate the characters buffer of the pool */
+int string_pool_add(StringPoolType *pool, const char *string, int length) {
+  int offset = pool->characters_size;
+
+  /* Double the characters buffer until the new string fits */
+  if(pool->characters_size + length + 1 > pool->characters_capacity) {
+    int capacity = (pool->characters_capacity > 0) ? pool->characters_capacity : STRING_POOL_INITIAL_SIZE;
+    while(pool->characters_size + length + 1 > capacity) {
+      capacity *= 2;
+    }
+    pool->characters = (char *)checked_realloc(pool->characters, capacity);
+    pool->characters_capacity = capacity;
+  }
+  memcpy(pool->characters + offset, string, length);
+  pool->characters[offset + length] = '\0';
+  pool->characters_size += length + 1;
+
+  return offset;
+}
+
+/* This function looks for the slot of a string inside the hash table of the string pool */
+/* Parameters: *pool - input (the string pool being searched), *string - input (the characters being searched for), length - input (the amount of characters being searched for) */
+/* Return values: int containing the index of the slot holding the string, or of the empty slot where it would be stored */
+/* Side effects: none */
+static int string_pool_find_slot(const StringPoolType *pool, const char *string, int length) {
+  int mask = pool->slots_capacity - 1;
+  int slot = hash_string(string, length) & mask;
+
+  /* Linear probing until either the string or an empty slot is found */
+  while(pool->slots[slot] != 0) {
+    const char *stored = pool->characters + pool->slots[slot] - 1;
+    if(strncmp(stored, string, length) == 0 && stored[length] == '\0') {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/* This function doubles the hash table of the string pool and re-inserts every interned string */
+/* Parameters: *pool - input/output (the string pool being grown) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates a new slots array and frees the old one */
+static void string_pool_grow_slots(StringPoolType *pool) {
+  int *old_slots = pool->slots;
+  int old_capacity = pool->slots_capacity;
+
+  pool->slots_capacity = (old_capacity > 0) ? old_capacity * 2 : STRING_POOL_INITIAL_SLOTS;
+  pool->slots = (int *)calloc(pool->slots_capacity, sizeof(int));
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(pool->slots == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < old_capacity; i++) {
+    if(old_slots[i] != 0) {
+      const char *stored = pool->characters + old_slots[i] - 1;
+      pool->slots[string_pool_find_slot(pool, stored, strlen(stored))] = old_slots[i];
+    }
+  }
+  free(old_slots);
+}
+
+/* This function stores a string inside the string pool only once, returning the existing copy if the string was interned before */
+/* Parameters: *pool - input/output (the string pool the string is interned in), *string - input (the characters being interned), length - input (the amount of characters being interned) */
+/* Return values: int containing the offset of the interned string inside the pool */
+/* Side effects: may reallocate the characters buffer and the hash table of the pool */
+int string_pool_intern(StringPoolType *pool, const char *string, int length) {
+
+  /* Keep the hash table at most half full so probing stays short */
+  if((pool->number_of_interned + 1) * 2 > pool->slots_capacity) {
+    string_pool_grow_slots(pool);
+  }
+
+  int slot = string_pool_find_slot(pool, string, length);
+  if(pool->slots[slot] == 0) {
+    pool->slots[slot] = string_pool_add(pool, string, length) + 1;
+    pool->number_of_interned++;
+  }
+  return pool->slots[slot] - 1;
+}
+
+/* This function returns the string stored at an offset of the string pool of a table */
+/* Parameters: *table - input (the table owning the string), offset - input (the offset of the string) */
+/* Return values: pointer to the null-terminated string */
+/* Side effects: none */
+const char *table_string(const PokemonTableType *table, int offset) {
+  return table->strings.characters + offset;
+}
+
+/* This function returns the first character of a view into the loaded file of a table */
+/* Parameters: *table - input (the table owning the loaded file), view - input (the view being read) */
+/* Return values: pointer to the first of view.length characters, which are not null-terminated */
+/* Side effects: none */
+const char *table_view(const PokemonTableType *table, StringViewType view) {
+  return table->file + view.offset;
+}
+
+/* This function looks up an interned string of a table without adding it */
+/* Parameters: *table - input (the table being searched), *string - input (the null-terminated string being searched for) */
+/* Return values: int containing the offset of the interned string, C_NOK (-1) if the table does not contain it */
+/* Side effects: none */
+int table_find_string(const PokemonTableType *table, const char *string) {
+  if(table->strings.slots_capacity == 0) {
+    return C_NOK;
+  }
+
+  int slot = string_pool_find_slot(&table->strings, string, strlen(string));
+  return table->strings.slots[slot] - 1;
+}
+
+/* This function looks for the slot of a type inside the type index hash table of a table */
+/* Parameters: *table - input (the table being searched), *type_name - input (the null-terminated name of the type) */
+/* Return values: int containing the index of the slot holding the type, or of the empty slot where it would be stored */
+/* Side effects: none */
+static int table_find_type_slot(const PokemonTableType *table, const char *type_name) {
+  int slot = hash_string(type_name, strlen(type_name)) & (TYPE_INDEX_SLOTS - 1);
+
+  /* Linear probing until either the type or an empty slot is found */
+  while(table->type_slots[slot] != 0) {
+    const TypeIndexEntryType *entry = &table->types[table->type_slots[slot] - 1];
+    if(strcmp(table_string(table, entry->type), type_name) == 0) {
+      break;
+    }
+    slot = (slot + 1) & (TYPE_INDEX_SLOTS - 1);
+  }
+  return slot;
+}
+
+/* This function looks up the index entry of a pokemon type */
+/* Parameters: *table - input (the table being searched), *type_name - input (the null-terminated name of the type) */
+/* Return values: pointer to the index entry of the type, NULL if no pokemon has that type */
+/* Side effects: none */
+const TypeIndexEntryType *table_find_type(const PokemonTableType *table, const char *type_name) {
+  int slot = table_find_type_slot(table, type_name);
+
+  if(table->type_slots[slot] == 0) {
+    return NULL;
+  }
+  return &table->types[table->type_slots[slot] - 1];
+}
+
+/* This function returns the index entry of an interned type, creating an empty entry the first time the type is seen */
+/* Parameters: *table - input/output (the table owning the index), type - input (the string pool offset of the interned type) */
+/* Return values: int containing the index of the entry inside the types array, C_NOK (-1) if the type index hash table is full */
+/* Side effects: may reallocate the types array */
+static int table_type_entry(PokemonTableType *table, int type) {
+  int slot = table_find_type_slot(table, table_string(table, type));
+
+  if(table->type_slots[slot] == 0) {
+    /* Keep the hash table at most half full, there are only 18 pokemon types so this only fails on a corrupt file */
+    if((table->number_of_types + 1) * 2 > TYPE_INDEX_SLOTS) {
+      LOG_ERROR("The pokemon file contains too many different types");
+      return C_NOK;
+    }
+    table->types = (TypeIndexEntryType *)checked_realloc(table->types, sizeof(TypeIndexEntryType) * (table->number_of_types + 1));
+    memset(&table->types[table->number_of_types], 0, sizeof(TypeIndexEntryType));
+    table->types[table->number_of_types].type = type;
+    table->number_of_types++;
+    table->type_slots[slot] = table->number_of_types;
+  }
+  return table->type_slots[slot] - 1;
+}
+
+/* This function builds the type index of a table and serializes the response of every type, so a type query only has to look the type up */
+/* Parameters: *table - input/output (the table whose index is being built) */
+/* Return values: int, C_OK (0) if the index was built and C_NOK (-1) if the file contains too many different types */
+/* Side effects: allocates the row lists and responses of every index entry */
+static int table_build_type_index(PokemonTableType *table) {
+
+  /* First pass counts the rows of every type so each row list is allocated once, it creates every entry so only this pass can run out of them */
+  for(int row = 0; row < table->number_of_rows; row++) {
+    int index = table_type_entry(table, table->first_type[row]); //Kept separate since creating an entry can move the types array
+    if(index == C_NOK) {
+      return C_NOK;
+    }
+    table->types[index].number_of_first_type_rows++;
+    if(table_string(table, table->second_type[row])[0] != '\0') {
+      index = table_type_entry(table, table->second_type[row]);
+      if(index == C_NOK) {
+        return C_NOK;
+      }
+      table->types[index].number_of_second_type_rows++;
+    }
+  }
+
+  for(int i = 0; i < table->number_of_types; i++) {
+    TypeIndexEntryType *entry = &table->types[i];
+    entry->first_type_rows = (int *)checked_realloc(NULL, sizeof(int) * (entry->number_of_first_type_rows + 1));
+    entry->second_type_rows = (int *)checked_realloc(NULL, sizeof(int) * (entry->number_of_second_type_rows + 1));
+    entry->number_of_first_type_rows = 0;
+    entry->number_of_second_type_rows = 0;
+  }
+
+  /* Second pass fills the row lists and adds up the size of every response */
+  for(int i = 0; i < table->number_of_types; i++) {
+    table->types[i].response_size = RESULT_COUNT_SIZE;
+  }
+  for(int row = 0; row < table->number_of_rows; row++) {
+    TypeIndexEntryType *entry = &table->types[table_type_entry(table, table->first_type[row])];
+    entry->first_type_rows[entry->number_of_first_type_rows++] = row;
+    entry->response_size += table->line[row].length + 1;
+
+    if(table_string(table, table->second_type[row])[0] != '\0') {
+      entry = &table->types[table_type_entry(table, table->second_type[row])];
+      entry->second_type_rows[entry->number_of_second_type_rows++] = row;
+    }
+  }
+
+  /* Serialize the result payload of every type, the pokemon count followed by each line and the '|' separator the client splits on */
+  for(int i = 0; i < table->number_of_types; i++) {
+    TypeIndexEntryType *entry = &table->types[i];
+    entry->response = (char *)checked_realloc(NULL, entry->response_size);
+    protocol_write_count((unsigned char *)entry->response, entry->number_of_first_type_rows);
+    char *position = entry->response + RESULT_COUNT_SIZE;
+
+    for(int j = 0; j < entry->number_of_first_type_rows; j++) {
+      StringViewType line = table->line[entry->first_type_rows[j]];
+      int length = line.length;
+      memcpy(position, table_view(table, line), length);
+      position[length] = '|';
+      position += length + 1;
+    }
+  }
+  return C_OK;
+}
+
+/* This function orders the rows of a table by every numeric column, so sorted queries can walk the rows in order instead of sorting them */
+/* Parameters: *table - input/output (the table whose orderings are being built) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates the sorted_rows array of every column */
+static void table_build_sorted_rows(PokemonTableType *table) {
+  int *counts = (int *)checked_realloc(NULL, sizeof(int) * (NUMBER_OF_SHORT_VALUES + 1));
+
+  for(int column = 0; column < NUMBER_OF_COLUMNS; column++) {
+    const short *values = table->columns[column];
+    table->sorted_rows[column] = (int *)checked_realloc(NULL, sizeof(int) * (table->number_of_rows + 1));
+
+    /* Counting sort, a short only has 65536 values: count every value, turn the counts into the first position of every value, then place the rows in file order so equal values keep it */
+    memset(counts, 0, sizeof(int) * (NUMBER_OF_SHORT_VALUES + 1));
+    for(int row = 0; row < table->number_of_rows; row++) {
+      counts[values[row] + 32768 + 1]++;
+    }
+    for(int value = 0; value < NUMBER_OF_SHORT_VALUES; value++) {
+      counts[value + 1] += counts[value];
+    }
+    for(int row = 0; row < table->number_of_rows; row++) {
+      table->sorted_rows[column][counts[values[row] + 32768]++] = row;
+    }
+  }
+  free(counts);
+}
+
+/* This function doubles the amount of rows every column of a table can hold */
+/* Parameters: *table - input/output (the table being grown) */
+/* Return values: nothing since it's a void function */
+/* Side effects: reallocates every column of the table */
+static void table_grow_rows(PokemonTableType *table) {
+  int capacity = (table->rows_capacity > 0) ? table->rows_capacity * 2 : TABLE_INITIAL_ROWS;
+
+  for(int i = 0; i < NUMBER_OF_COLUMNS; i++) {
+    table->columns[i] = (short *)checked_realloc(table->columns[i], sizeof(short) * capacity);
+  }
+  table->name = (StringViewType *)checked_realloc(table->name, sizeof(StringViewType) * capacity);
+  table->first_type = (int *)checked_realloc(table->first_type, sizeof(int) * capacity);
+  table->second_type = (int *)checked_realloc(table->second_type, sizeof(int) * capacity);
+  table->line = (StringViewType *)checked_realloc(table->line, sizeof(StringViewType) * capacity);
+  table->legendary = (char *)checked_realloc(table->legendary, sizeof(char) * capacity);
+  table->rows_capacity = capacity;
+}
+
+/* This function converts a field of the loaded file holding a whole number into a short, the field is not null-terminated so strtol can't be used */
+/* Parameters: *field - input (the first character of the field), length - input (the amount of characters inside the field) */
+/* Return values: short containing the number, the digits before the first character that is not a digit */
+/* Side effects: none */
+static short parse_short(const char *field, int length) {
+  int value = 0;
+  int sign = 1;
+  int i = 0;
+
+  if(length > 0 && (field[0] == '-' || field[0] == '+')) {
+    sign = (field[0] == '-') ? -1 : 1;
+    i++;
+  }
+  for(; i < length && field[i] >= '0' && field[i] <= '9'; i++) {
+    value = value * 10 + (field[i] - '0');
+  }
+  return (short)(sign * value);
+}
+
+/* This function appends a line of the pokemon file that was already split into fields as a new row of the table */
+/* Parameters: *table - input/output (the table the row is added to), line_start - input (offset of the line inside the loaded file), line_end - input (offset one past the last character of the line, without its line break), *commas - input (offset of every comma separating the fields of the line) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may grow the columns of the table, interns the types of the row */
+static void table_add_row(PokemonTableType *table, long line_start, long line_end, const long *commas) {
+  long starts[NUMBER_OF_CSV_FIELDS]; //Offset of the first character of every field
+  int lengths[NUMBER_OF_CSV_FIELDS]; //Amount of characters inside every field
+  const char *file = table->file;
+
+  /* Every field runs from the character after the previous comma up to the next comma, the last one runs up to the end of the line */
+  for(int i = 0; i < NUMBER_OF_CSV_FIELDS; i++) {
+    starts[i] = (i == 0) ? line_start : commas[i - 1] + 1;
+    lengths[i] = ((i == NUMBER_OF_CSV_FIELDS - 1) ? line_end : commas[i]) - starts[i];
+  }
+
+  /* Grow every column if the table is full */
+  int row = table->number_of_rows;
+  if(row == table->rows_capacity) {
+    table_grow_rows(table);
+  }
+
+  /* Names and lines are only viewed inside the loaded file, types repeat so they are interned */
+  table->name[row].offset = starts[1];
+  table->name[row].length = lengths[1];
+  table->line[row].offset = line_start;
+  table->line[row].length = line_end - line_start;
+  table->first_type[row] = string_pool_intern(&table->strings, file + starts[2], lengths[2]);
+  table->second_type[row] = string_pool_intern(&table->strings, file + starts[3], lengths[3]);
+
+  /* Convert every numeric field, the numeric fields are the first one and the fifth to the twelfth */
+  table->columns[COLUMN_NUMBER][row] = parse_short(file + starts[0], lengths[0]);
+  for(int i = COLUMN_TOTAL; i < NUMBER_OF_COLUMNS; i++) {
+    table->columns[i][row] = parse_short(file + starts[i + 3], lengths[i + 3]);
+  }
+  table->legendary[row] = (lengths[12] == 5 && memcmp(file + starts[12], "False", 5) == 0) ? 'n' : 'y';
+
+  table->number_of_rows++;
+}
+
+/* This function finds the commas and line breaks inside 64 bytes of the file one byte at a time, used when the processor has no vector instructions */
+/* Parameters: *block - input (the 64 bytes being scanned) */
+/* Return values: uint64_t with bit i set if byte i of the block is a comma or a line break */
+/* Side effects: none */
+static uint64_t scan_delimiters_scalar(const char *block) {
+  uint64_t mask = 0;
+  for(int i = 0; i < 64; i++) {
+    if(block[i] == ',' || block[i] == '\n') {
+      mask |= (uint64_t)1 << i;
+    }
+  }
+  return mask;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* This function finds the commas and line breaks inside 64 bytes of the file 16 bytes at a time with SSE2 */
+/* Parameters: *block - input (the 64 bytes being scanned) */
+/* Return values: uint64_t with bit i set if byte i of the block is a comma or a line break */
+/* Side effects: none */
+__attribute__((target("sse2")))
+static uint64_t scan_delimiters_sse2(const char *block) {
+  const __m128i commas = _mm_set1_epi8(',');
+  const __m128i line_breaks = _mm_set1_epi8('\n');
+  uint64_t mask = 0;
+
+  for(int i = 0; i < 4; i++) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *)(block + i * 16));
+    __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, commas), _mm_cmpeq_epi8(bytes, line_breaks));
+    mask |= (uint64_t)(unsigned int)_mm_movemask_epi8(matches) << (i * 16);
+  }
+  return mask;
+}
+
+/* This function finds the commas and line breaks inside 64 bytes of the file 32 bytes at a time with AVX2 */
+/* Parameters: *block - input (the 64 bytes being scanned) */
+/* Return values: uint64_t with bit i set if byte i of the block is a comma or a line break */
+/* Side effects: none */
+__attribute__((target("avx2")))
+static uint64_t scan_delimiters_avx2(const char *block) {
+  const __m256i commas = _mm256_set1_epi8(',');
+  const __m256i line_breaks = _mm256_set1_epi8('\n');
+
+  __m256i low = _mm256_loadu_si256((const __m256i *)block);
+  __m256i high = _mm256_loadu_si256((const __m256i *)(block + 32));
+  __m256i low_matches = _mm256_or_si256(_mm256_cmpeq_epi8(low, commas), _mm256_cmpeq_epi8(low, line_breaks));
+  __m256i high_matches = _mm256_or_si256(_mm256_cmpeq_epi8(high, commas), _mm256_cmpeq_epi8(high, line_breaks));
+  return (uint64_t)(unsigned int)_mm256_movemask_epi8(low_matches) | ((uint64_t)(unsigned int)_mm256_movemask_epi8(high_matches) << 32);
+}
+#endif
+
+/* This function picks the fastest delimiter scan the processor running the server supports */
+/* Parameters: None */
+/* Return values: DelimiterScanType pointing to the AVX2, SSE2 or scalar scan */
+/* Side effects: none */
+static DelimiterScanType choose_delimiter_scan(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    return scan_delimiters_avx2;
+  }
+  if(__builtin_cpu_supports("sse2")) {
+    return scan_delimiters_sse2;
+  }
+#endif
+  return scan_delimiters_scalar;
+}
+
+/* This function ends the current line of the file and adds it to the table, unless it is the header or an empty line */
+/* Parameters: *table - input/output (the table the row is added to), *splitter - input/output (the state of the line being split), line_end - input (offset of the line break ending the line, or of the end of the file) */
+/* Return values: nothing since it's a void function */
+/* Side effects: prints a message for lines missing fields, resets the splitter for the next line */
+static void table_end_line(PokemonTableType *table, LineSplitterType *splitter, long line_end) {
+
+  /* Remove a carriage return left by files saved on Windows */
+  if(line_end > splitter->line_start && table->file[line_end - 1] == '\r') {
+    line_end--;
+  }
+
+  if(splitter->line_number > 1 && line_end > splitter->line_start) {
+    if(splitter->number_of_commas < NUMBER_OF_CSV_FIELDS - 1) {
+      LOG_ERROR("Line %d of the pokemon file is missing fields", splitter->line_number);
+    }
+    else {
+      table_add_row(table, splitter->line_start, line_end, splitter->commas);
+    }
+  }
+
+  splitter->line_number++;
+  splitter->number_of_commas = 0;
+}
+
+/* This function handles one comma or line break of the file */
+/* Parameters: *table - input/output (the table rows are added to), *splitter - input/output (the state of the line being split), position - input (offset of the delimiter inside the loaded file) */
+/* Return values: nothing since it's a void function */
+/* Side effects: adds a row to the table when the delimiter is a line break */
+static inline void table_split_at(PokemonTableType *table, LineSplitterType *splitter, long position) {
+  if(table->file[position] == '\n') {
+    table_end_line(table, splitter, position);
+    splitter->line_start = position + 1;
+  }
+  else if(splitter->number_of_commas < NUMBER_OF_CSV_FIELDS - 1) {
+    splitter->commas[splitter->number_of_commas++] = position;
+  }
+}
+
+/* This function splits the whole loaded file into rows and fields, visiting only the commas and line breaks found by the vectorized scan */
+/* Parameters: *table - input/output (the table the rows are added to, its file must already be loaded) */
+/* Return values: nothing since it's a void function */
+/* Side effects: adds every row of the file to the table */
+static void table_split_file(PokemonTableType *table) {
+  DelimiterScanType scan_delimiters = choose_delimiter_scan();
+  LineSplitterType splitter;
+  long position = 0;
+
+  memset(&splitter, 0, sizeof(LineSplitterType));
+  splitter.line_number = 1;
+
+  /* Scan 64 bytes at a time and visit every delimiter inside them in order */
+  for(; position + 64 <= table->file_size; position += 64) {
+    uint64_t mask = scan_delimiters(table->file + position);
+    while(mask != 0) {
+      table_split_at(table, &splitter, position + __builtin_ctzll(mask));
+      mask &= mask - 1;
+    }
+  }
+
+  /* Finish the last bytes that don't fill a whole block one at a time */
+  for(; position < table->file_size; position++) {
+    if(table->file[position] == ',' || table->file[position] == '\n') {
+      table_split_at(table, &splitter, position);
+    }
+  }
+
+  /* The last line of the file might not end with a line break */
+  if(splitter.line_start < table->file_size) {
+    table_end_line(table, &splitter, table->file_size);
+  }
+}
+
+/* This function gives a table that is being loaded its own version */
+/* Parameters: None */
+/* Return values: long containing a version no other table had */
+/* Side effects: increments the amount of tables loaded, which is shared by every thread */
+long table_next_version(void) {
+  return __atomic_add_fetch(&number_of_loads, 1, __ATOMIC_RELAXED);
+}
+
+/* This function allocates private memory for the text of a table, which becomes read-only once the table is built from it */
+/* Parameters: size - input (the amount of bytes of text, more than 0) */
+/* Return values: char pointer to the memory, NULL if it can't be allocated */
+/* Side effects: maps anonymous memory that is unmapped by table_free once a table is built from it */
+char *table_allocate_text(long size) {
+  void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return (mapping == MAP_FAILED) ? NULL : (char *)mapping;
+}
+
+/* This function reads the whole content of a file into memory, retrying reads that were interrupted */
+/* Parameters: fd - input (the file, read from its current position), *destination - output (the memory receiving the content), size - input (the amount of bytes to read) */
+/* Return values: int, C_OK (0) if every byte was read and C_NOK (-1) if the file could not be read or ended before size bytes */
+/* Side effects: reads from the file */
+int table_read_file(int fd, char *destination, long size) {
+  long bytes_read = 0;
+  while(bytes_read < size) {
+    ssize_t result = read(fd, destination + bytes_read, size - bytes_read);
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+    if(result <= 0) {
+      return C_NOK;
+    }
+    bytes_read += result;
+  }
+  return C_OK;
+}
+
+/* This function builds a table out of the text of a pokemon file that is already in memory */
+/* Parameters: *table - output (the table being filled), *text - input (the text of the file, allocated with table_allocate_text, or NULL for an empty file), size - input (the amount of bytes inside text) */
+/* Return values: int, C_OK (0) if the table was built and C_NOK (-1) if the file contains too many different types */
+/* Side effects: the table takes the text over and makes it read-only, allocates memory for the table which must be released with table_free. If the table can't be built the text and everything allocated for it are already freed */
+int table_load_text(PokemonTableType *table, char *text, long size) {
+  memset(table, 0, sizeof(PokemonTableType));
+  table->version = table_next_version();
+
+  /* The table never changes its text once it is built */
+  if(text != NULL) {
+    mprotect(text, size, PROT_READ);
+  }
+  table->file = text;
+  table->file_size = size;
+  table->file_hash = (size > 0) ? hash_string(text, size) : hash_string("", 0);
+
+  /* Split every line of the file into fields, skipping the header */
+  table_split_file(table);
+
+  /* Index the rows of every type once so queries never have to scan the table */
+  if(table_build_type_index(table) == C_NOK) {
+    table_free(table);
+    return C_NOK;
+  }
+
+  /* Order the rows by every numeric column once so sorted queries never have to sort the whole table */
+  table_build_sorted_rows(table);
+  return C_OK;
+}
+
+/* This function reads a pokemon file into memory once and stores every pokemon inside a table */
+/* Parameters: *table - output (the table being filled), *file_name - input (the name of the pokemon file) */
+/* Return values: int, C_OK (0) if the file was loaded and C_NOK (-1) if the file could not be read, changed size while it was read or contains too many different types */
+/* Side effects: allocates private memory holding the file and memory for the table, both must be released with table_free */
+int table_load_csv(PokemonTableType *table, char *file_name) {
+  struct stat file_information;
+  char *text = NULL;
+
+  memset(table, 0, sizeof(PokemonTableType));
+
+  /* Open the file in read mode */
+  int fd = open(file_name, O_RDONLY);
+  if(fd < 0) {
+    return C_NOK;
+  }
+  if(fstat(fd, &file_information) < 0) {
+    close(fd);
+    return C_NOK;
+  }
+
+  /* Copy the whole file into private memory instead of mapping it, a mapping of the file would change, or fault, if the file is rewritten while the table is still answering queries. An empty file has nothing to copy and gives an empty table */
+  long size = file_information.st_size;
+  if(size > 0) {
+    text = table_allocate_text(size);
+    if(text == NULL) {
+      close(fd);
+      return C_NOK;
+    }
+
+    /* A file that got shorter while it was read is being rewritten, the next reload reads it again once it is complete */
+    if(table_read_file(fd, text, size) == C_NOK) {
+      munmap(text, size);
+      close(fd);
+      return C_NOK;
+    }
+  }
+  close(fd);
+
+  return table_load_text(table, text, size);
+}
+
+/* This function frees every column and string of a table and unmaps its file */
+/* Parameters: *table - input/output (the table being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees dynamically allocated data, unmaps the pokemon file or the binary image */
+void table_free(PokemonTableType *table) {
+
+  /* A table loaded from an image only allocated its type entries, every array points into the image */
+  if(table->image != NULL) {
+    free(table->types);
+    munmap(table->image, table->image_size);
+    memset(table, 0, sizeof(PokemonTableType));
+    return;
+  }
+
+  for(int i = 0; i < NUMBER_OF_COLUMNS; i++) {
+    free(table->columns[i]);
+  }
+  free(table->name);
+  free(table->first_type);
+  free(table->second_type);
+  free(table->line);
+  free(table->legendary);
+  free(table->strings.characters);
+  free(table->strings.slots);
+  for(int i = 0; i < table->number_of_types; i++) {
+    free(table->types[i].first_type_rows);
+    free(table->types[i].second_type_rows);
+    free(table->types[i].response);
+  }
+  free(table->types);
+  for(int i = 0; i < NUMBER_OF_COLUMNS; i++) {
+    free(table->sorted_rows[i]);
+  }
+  if(table->file != NULL) {
+    munmap((void *)table->file, table->file_size);
+  }
+  memset(table, 0, sizeof(PokemonTableType));
+}
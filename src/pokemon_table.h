@@ -0,0 +1,117 @@
+/*****************************************************************************/
+/* */
+/* pokemon_table.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the pokemon_table.c file */
+/* How to use: use #include "pokemon_table.h" at the top of any .c files that need to load the pokemon file into memory and query it */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef POKEMON_TABLE_H_
+#define POKEMON_TABLE_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//Variety of constants defined
+#define TABLE_INITIAL_ROWS 64          //Constant to represent the amount of rows the table can hold before it has to grow
+#define STRING_POOL_INITIAL_SIZE 4096  //Constant to represent the amount of characters the string pool can hold before it has to grow
+#define STRING_POOL_INITIAL_SLOTS 256  //Constant to represent the amount of slots inside the string pool hash table before it has to grow
+#define NUMBER_OF_CSV_FIELDS 13        //Constant to represent the amount of comma separated fields on every line of the pokemon file
+#define TYPE_INDEX_SLOTS 64            //Constant to represent the amount of slots inside the type index hash table, must be a power of two
+#define NUMBER_OF_SHORT_VALUES 65536   //Constant to represent the amount of different values a numeric column can hold
+
+/* This enum names every numeric column stored inside a PokemonTableType, in the order they appear in the pokemon file */
+typedef enum PokemonColumn {
+  COLUMN_NUMBER,          //Number of the pokemon
+  COLUMN_TOTAL,           //Sum of all stats of the pokemon
+  COLUMN_HP,              //HP of the pokemon
+  COLUMN_ATTACK,          //attack stat of the pokemon
+  COLUMN_DEFENSE,         //defense stat of the pokemon
+  COLUMN_SP_ATTACK,       //special attack stat of the pokemon
+  COLUMN_SP_DEFENSE,      //special defense stat of the pokemon
+  COLUMN_SPEED,           //speed stat of the pokemon
+  COLUMN_GENERATION,      //generation the pokemon originated from
+  NUMBER_OF_COLUMNS       //Amount of numeric columns, must stay last
+} PokemonColumnType;
+
+/* This structure stores every string of the table back to back inside one buffer. Strings are referred to by their offset inside the buffer, and strings added with string_pool_intern are only ever stored once. */
+typedef struct StringPool {
+  char *characters;       //Buffer containing every null-terminated string in the pool
+  int characters_size;    //Amount of characters used inside the characters buffer
+  int characters_capacity;//Amount of characters the characters buffer can hold
+  int *slots;             //Open addressing hash table of interned string offsets plus one, 0 marks an empty slot
+  int slots_capacity;     //Amount of slots inside the slots hash table
+  int number_of_interned; //Amount of strings stored inside the slots hash table
+} StringPoolType;
+
+/* This structure refers to a string inside the pokemon file loaded into memory without copying it, the string is not null-terminated */
+typedef struct StringView {
+  long offset;            //Offset of the first character of the string inside the loaded file
+  int length;             //Amount of characters inside the string
+} StringViewType;
+
+/* This is the type of the functions finding the commas and line breaks inside 64 bytes of the file */
+typedef uint64_t (*DelimiterScanType)(const char *block);
+
+/* This structure keeps track of the line being split while the delimiters of the file are visited in order */
+typedef struct LineSplitter {
+  long line_start;                          //Offset of the first character of the current line
+  long commas[NUMBER_OF_CSV_FIELDS - 1];    //Offset of every comma found on the current line that separates two fields
+  int number_of_commas;                     //Amount of commas found on the current line, extra commas belong to the last field
+  int line_number;                          //Number of the current line inside the file, starting at 1
+} LineSplitterType;
+
+/* This structure contains every row of a single pokemon type, along with the response the server sends when a client asks for that type, serialized once when the table is loaded */
+typedef struct TypeIndexEntry {
+  int type;                                   //String pool offset of the interned name of the type
+  int *first_type_rows;                       //Rows whose first type is this type, in file order
+  int number_of_first_type_rows;              //Amount of rows inside first_type_rows
+  int *second_type_rows;                      //Rows whose second type is this type, in file order
+  int number_of_second_type_rows;             //Amount of rows inside second_type_rows
+  char *response;                             //Result payload sent for this type: the pokemon count followed by the line of every pokemon inside first_type_rows, each followed by the '|' separator
+  int response_size;                          //Amount of bytes inside response
+} TypeIndexEntryType;
+
+/* This structure contains every pokemon from the pokemon file, stored as one array per property (structure-of-arrays) so that a query only touches the columns it needs */
+typedef struct PokemonTable {
+  int number_of_rows;                   //Amount of pokemon stored inside the table
+  int rows_capacity;                    //Amount of pokemon the columns can hold before they have to grow
+  short *columns[NUMBER_OF_COLUMNS];    //Numeric columns, indexed with PokemonColumnType
+  StringViewType *name;                 //Name of every pokemon inside the loaded file
+  int *first_type;                      //String pool offset of the interned first type of every pokemon
+  int *second_type;                     //String pool offset of the interned second type of every pokemon, "" if it has none
+  StringViewType *line;                 //Line every pokemon was read from inside the loaded file, without its line break
+  char *legendary;                      //'y' if the pokemon is a legendary pokemon, 'n' if it is not
+  StringPoolType strings;               //Pool that owns every interned string of the table
+  const char *file;                     //Copy of the pokemon file inside private memory, the name and line views point into it
+  long file_size;                       //Amount of bytes inside file
+  unsigned int file_hash;               //Hash of the text inside file, computed once so the change log can tell which file it applies to
+  TypeIndexEntryType *types;            //Index entry of every distinct type found in either type column
+  int number_of_types;                  //Amount of entries inside types
+  int type_slots[TYPE_INDEX_SLOTS];     //Open addressing hash table of indexes inside types plus one, 0 marks an empty slot
+  long version;                         //Number of the load that filled the table, every load gets a new number so results cached for another table are never reused
+  int *sorted_rows[NUMBER_OF_COLUMNS];  //Every row ordered by its value inside each numeric column from smallest to largest, rows with the same value stay in file order
+  void *image;                          //Private copy of the binary image every array of the table points into, NULL if the table was built from text and owns its arrays
+  long image_size;                      //Amount of bytes inside image
+} PokemonTableType;
+
+/* all function prototypes for functions in pokemon_table.c */
+unsigned int hash_string(const char *string, long length);
+long table_next_version(void);
+char *table_allocate_text(long size);
+int table_read_file(int fd, char *destination, long size);
+int table_load_text(PokemonTableType *table, char *text, long size);
+int table_load_csv(PokemonTableType *table, char *file_name);
+void table_free(PokemonTableType *table);
+const char *table_string(const PokemonTableType *table, int offset);
+const char *table_view(const PokemonTableType *table, StringViewType view);
+int table_find_string(const PokemonTableType *table, const char *string);
+const TypeIndexEntryType *table_find_type(const PokemonTableType *table, const char *type_name);
+int string_pool_add(StringPoolType *pool, const char *string, int length);
+int string_pool_intern(StringPoolType *pool, const char *string, int length);
+
+#endif //end of header file
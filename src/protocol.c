@@ -0,0 +1,201 @@
+/*****************************************************************************/
+/* */
+/* protocol.c */
+/* Purpose: This file contains the framing used between the server and the client. Every message starts with a fixed-size header giving its type, the id of the request it belongs to and the length of its payload, so message boundaries never depend on how TCP splits the data. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server and client executables. This is already done for you in the MakeFile. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+
+//importing the header file included with the program to get access to its functions, constants and structs
+#include "protocol.h"
+
+/* This function writes a header into a buffer in network byte order */
+/* Parameters: *buffer - output (at least PROTOCOL_HEADER_SIZE bytes), *header - input (the fields being written) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void protocol_write_header(unsigned char *buffer, const MessageHeaderType *header) {
+  unsigned short flags = htons(header->flags);
+  unsigned int request_id = htonl(header->request_id);
+  unsigned int payload_length = htonl(header->payload_length);
+
+  buffer[0] = header->version;
+  buffer[1] = header->type;
+  memcpy(buffer + 2, &flags, sizeof(flags));
+  memcpy(buffer + 4, &request_id, sizeof(request_id));
+  memcpy(buffer + 8, &payload_length, sizeof(payload_length));
+}
+
+/* This function reads a header written by protocol_write_header */
+/* Parameters: *buffer - input (PROTOCOL_HEADER_SIZE bytes received from the other side), *header - output (the fields that were read) */
+/* Return values: int, C_OK (0) if the header is valid and C_NOK (-1) if it was written with another version of the protocol */
+/* Side effects: none */
+int protocol_read_header(const unsigned char *buffer, MessageHeaderType *header) {
+  unsigned short flags;
+  unsigned int request_id;
+  unsigned int payload_length;
+
+  memcpy(&flags, buffer + 2, sizeof(flags));
+  memcpy(&request_id, buffer + 4, sizeof(request_id));
+  memcpy(&payload_length, buffer + 8, sizeof(payload_length));
+
+  header->version = buffer[0];
+  header->type = buffer[1];
+  header->flags = ntohs(flags);
+  header->request_id = ntohl(request_id);
+  header->payload_length = ntohl(payload_length);
+
+  return (header->version == PROTOCOL_VERSION) ? C_OK : C_NOK;
+}
+
+/* This function writes the pokemon count found at the start of a result payload */
+/* Parameters: *buffer - output (at least RESULT_COUNT_SIZE bytes), count - input (the amount of pokemon inside the result) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void protocol_write_count(unsigned char *buffer, unsigned int count) {
+  unsigned int network_count = htonl(count);
+  memcpy(buffer, &network_count, sizeof(network_count));
+}
+
+/* This function reads the pokemon count found at the start of a result payload */
+/* Parameters: *buffer - input (RESULT_COUNT_SIZE bytes from the start of the payload) */
+/* Return values: unsigned int containing the amount of pokemon inside the result */
+/* Side effects: none */
+unsigned int protocol_read_count(const unsigned char *buffer) {
+  unsigned int network_count;
+  memcpy(&network_count, buffer, sizeof(network_count));
+  return ntohl(network_count);
+}
+
+/* This function keeps sending until every byte of a buffer has been sent on a blocking socket */
+/* Parameters: socket - input (the socket being sent to), *buffer - input (the bytes being sent), size - input (the amount of bytes being sent) */
+/* Return values: int, C_OK (0) if every byte was sent and C_NOK (-1) if the socket failed */
+/* Side effects: writes to the socket */
+int send_all(int socket, const void *buffer, size_t size) {
+  const char *position = (const char *)buffer; //next byte to send
+
+  while(size > 0) {
+    ssize_t bytes_sent = send(socket, position, size, 0);
+    if(bytes_sent < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return C_NOK;
+    }
+    position += bytes_sent;
+    size -= bytes_sent;
+  }
+  return C_OK;
+}
+
+/* This function keeps receiving until exactly the requested amount of bytes has arrived on a blocking socket */
+/* Parameters: socket - input (the socket being received from), *buffer - output (the bytes received), size - input (the amount of bytes to receive) */
+/* Return values: int, C_OK (0) if every byte was received and C_NOK (-1) if the socket failed or the other side disconnected */
+/* Side effects: reads from the socket */
+int receive_all(int socket, void *buffer, size_t size) {
+  char *position = (char *)buffer; //where the next byte is stored
+
+  while(size > 0) {
+    ssize_t bytes_received = recv(socket, position, size, 0);
+    if(bytes_received < 0 && errno == EINTR) {
+      continue;
+    }
+    if(bytes_received <= 0) {
+      return C_NOK;
+    }
+    position += bytes_received;
+    size -= bytes_received;
+  }
+  return C_OK;
+}
+
+/* This function sends one whole message, header and payload, on a blocking socket. Both are given to the kernel in one call, a header sent on its own would wait for the acknowledgement of the previous message before the payload can follow */
+/* Parameters: socket - input (the socket being sent to), type - input (the type of the message), request_id - input (the id of the request the message belongs to), *payload - input (the payload, can be NULL if payload_length is 0), payload_length - input (the amount of bytes inside payload) */
+/* Return values: int, C_OK (0) if the message was sent and C_NOK (-1) if the socket failed */
+/* Side effects: writes to the socket */
+int send_message(int socket, int type, unsigned int request_id, const void *payload, unsigned int payload_length) {
+  unsigned char buffer[PROTOCOL_HEADER_SIZE];
+  MessageHeaderType header;
+  struct iovec parts[2];      //header and payload of the message
+  struct msghdr message;      //parts of the message still to send
+
+  header.version = PROTOCOL_VERSION;
+  header.type = type;
+  header.flags = 0;
+  header.request_id = request_id;
+  header.payload_length = payload_length;
+  protocol_write_header(buffer, &header);
+
+  parts[0].iov_base = buffer;
+  parts[0].iov_len = PROTOCOL_HEADER_SIZE;
+  parts[1].iov_base = (void *)payload;
+  parts[1].iov_len = payload_length;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = parts;
+  message.msg_iovlen = (payload_length > 0) ? 2 : 1;
+
+  while(message.msg_iovlen > 0) {
+    ssize_t bytes_sent = sendmsg(socket, &message, 0);
+    if(bytes_sent < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return C_NOK;
+    }
+
+    /* Skip the parts that were sent completely and start the next call where the last one stopped */
+    while(message.msg_iovlen > 0 && bytes_sent >= (ssize_t)message.msg_iov->iov_len) {
+      bytes_sent -= message.msg_iov->iov_len;
+      message.msg_iov++;
+      message.msg_iovlen--;
+    }
+    if(message.msg_iovlen > 0) {
+      message.msg_iov->iov_base = (char *)message.msg_iov->iov_base + bytes_sent;
+      message.msg_iov->iov_len -= bytes_sent;
+    }
+  }
+  return C_OK;
+}
+
+/* This function receives one whole message, header and payload, from a blocking socket */
+/* Parameters: socket - input (the socket being received from), *header - output (the header of the message), **payload - output (the null-terminated payload, which must be freed by the caller) */
+/* Return values: int, C_OK (0) if a message was received and C_NOK (-1) if the socket failed or the message is invalid */
+/* Side effects: reads from the socket, allocates memory for the payload */
+int receive_message(int socket, MessageHeaderType *header, char **payload) {
+  unsigned char buffer[PROTOCOL_HEADER_SIZE];
+
+  *payload = NULL;
+  if(receive_all(socket, buffer, PROTOCOL_HEADER_SIZE) == C_NOK) {
+    return C_NOK;
+  }
+  if(protocol_read_header(buffer, header) == C_NOK || header->payload_length > MAX_RESPONSE_PAYLOAD_SIZE) {
+    return C_NOK;
+  }
+
+  /* Allocate one extra byte so text payloads can be used as strings */
+  *payload = (char *)malloc(header->payload_length + 1);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(*payload == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  if(receive_all(socket, *payload, header->payload_length) == C_NOK) {
+    free(*payload);
+    *payload = NULL;
+    return C_NOK;
+  }
+  (*payload)[header->payload_length] = '\0';
+  return C_OK;
+}
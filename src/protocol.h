@@ -0,0 +1,73 @@
+/*****************************************************************************/
+/* */
+/* protocol.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the protocol.c file, which both the server and the client use to talk to each other */
+/* How to use: use #include "protocol.h" at the top of any .c files that send or receive messages between the server and the client */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+//Other libraries that we will need
+#include <stddef.h>
+
+//Variety of constants defined
+#define C_NOK -1                          //Constant to represent an error/not correct value
+#define C_OK 0                            //Constant to represent a correct return value
+#define SERVER_IP "127.0.0.1"             //Constant to represent the IP address the client will connect to
+#define SERVER_PORT 6000                  //Constant to represent the port that the client will connect to
+#define PROTOCOL_VERSION 1                //Constant to represent the version of the protocol written inside every header
+#define PROTOCOL_HEADER_SIZE 12           //Constant to represent the amount of bytes of every header
+#define MAX_REQUEST_PAYLOAD_SIZE 65536    //Constant to represent the largest payload a client can send to the server
+#define MAX_RESPONSE_PAYLOAD_SIZE (64 * 1024 * 1024) //Constant to represent the largest payload the server can send to a client
+#define RESULT_COUNT_SIZE 4               //Constant to represent the amount of bytes of the pokemon count at the start of every result payload
+#define RESULT_BATCH_ROWS 1024            //Constant to represent the most pokemon the server sends inside one result message, larger results are split into batches
+#define RESULT_FLAG_MORE 0x0001           //Constant to represent the flag set on every batch of a result except the last one
+#define MAX_PENDING_REQUESTS_PER_CONNECTION 32 //Constant to represent the most requests of one client that can be ran at once, the server stops reading its requests until one of them is answered. The unsent bytes of a client can go past MAX_QUEUED_BYTES_PER_CONNECTION by the responses of this many requests
+
+/* This enum names every type of message, the ones sent by the client come first and the ones sent by the server start at 16 */
+typedef enum MessageType {
+  MESSAGE_QUERY = 1,          //Client asks for every pokemon of a type, the payload is the name of the type
+  MESSAGE_PAUSE = 2,          //Client asks the server to hold its responses, no payload
+  MESSAGE_UNPAUSE = 3,        //Client asks the server to send its responses again, no payload
+  MESSAGE_STOP = 4,           //Client is disconnecting, no payload
+  MESSAGE_FILTER = 5,         //Client asks for every pokemon matching a filter query, the payload is the text of the query (see query.h)
+  MESSAGE_AGGREGATE = 6,      //Client asks for the statistics of a stat for every group of pokemon, the payload is the text of the request (see aggregate.h)
+  MESSAGE_STATS = 7,          //Client asks for the counters of the server, like the hit rate of its cache, no payload
+  MESSAGE_RELOAD = 8,         //Client asks the server to read the pokemon file again, no payload
+  MESSAGE_CHANGE = 9,         //Client inserts, updates or deletes pokemon, the payload is one change per line
+  MESSAGE_METRICS = 10,       //Client asks for the counters and stage latencies of the server, no payload
+  MESSAGE_RESULT = 16,        //Server answers a request, the payload is the pokemon count followed by every pokemon line ending with '|'. A result with more than RESULT_BATCH_ROWS pokemon is sent as several of these messages, every one but the last with RESULT_FLAG_MORE set
+  MESSAGE_ERROR = 17,         //Server could not answer a request, the payload is a description of the error
+  MESSAGE_AGGREGATE_RESULT = 18, //Server answers an aggregation request, the payload is the text of the statistics with one line per group
+  MESSAGE_STATS_RESULT = 19,  //Server answers a stats request, the payload is text with one "name value" line per counter
+  MESSAGE_RELOAD_RESULT = 20, //Server answers a reload request as soon as the reload is started, the payload is text describing it
+  MESSAGE_CHANGE_RESULT = 21, //Server answers a change request once its changes are logged to the disk, the payload is text describing them
+  MESSAGE_METRICS_RESULT = 22 //Server answers a metrics request, the payload is every metric in the Prometheus text format
+} MessageTypeType;
+
+/* This structure contains every field of the header sent in front of each message. On the wire it is PROTOCOL_HEADER_SIZE bytes in network byte order: version (1 byte), type (1 byte), flags (2 bytes), request id (4 bytes), payload length (4 bytes). */
+typedef struct MessageHeader {
+  unsigned char version;          //Version of the protocol the message was written with
+  unsigned char type;             //Type of the message, one of MessageTypeType
+  unsigned short flags;           //Flags of the message, RESULT_FLAG_MORE or 0
+  unsigned int request_id;        //Id chosen by the client for a request and copied into the response to it, responses can arrive in any order
+  unsigned int payload_length;    //Amount of bytes following the header
+} MessageHeaderType;
+
+/* all function prototypes for functions in protocol.c */
+void protocol_write_header(unsigned char *buffer, const MessageHeaderType *header);
+int protocol_read_header(const unsigned char *buffer, MessageHeaderType *header);
+void protocol_write_count(unsigned char *buffer, unsigned int count);
+unsigned int protocol_read_count(const unsigned char *buffer);
+int send_all(int socket, const void *buffer, size_t size);
+int receive_all(int socket, void *buffer, size_t size);
+int send_message(int socket, int type, unsigned int request_id, const void *payload, unsigned int payload_length);
+int receive_message(int socket, MessageHeaderType *header, char **payload);
+
+#endif //end of header file
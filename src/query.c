@@ -0,0 +1,668 @@
+/*****************************************************************************/
+/* */
+/* query.c */
+/* Purpose: This file parses the filter queries clients send and runs them over the columns of the in-memory pokemon table. Every condition is evaluated by scanning a single column into a selection bitmap with one bit per row, the conditions of a group are combined with AND and the groups with OR so only the matching rows are ever serialized. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Parse a query with query_parse, run it with query_execute and turn the matching rows into a result payload with query_serialize, or put them in order with query_order and serialize them with query_serialize_rows. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "query.h"
+
+/* This structure links the name a query uses for a numeric column to the column */
+typedef struct ColumnName {
+  const char *name;                 //Name of the column inside a query
+  PokemonColumnType column;         //Column of the table the name refers to
+} ColumnNameType;
+
+/* Every name a query can use for a numeric column, the names of the header of the pokemon file are accepted too */
+static const ColumnNameType column_names[] = {
+  {"number", COLUMN_NUMBER}, {"total", COLUMN_TOTAL}, {"hp", COLUMN_HP}, {"attack", COLUMN_ATTACK},
+  {"defense", COLUMN_DEFENSE}, {"sp_attack", COLUMN_SP_ATTACK}, {"sp.atk", COLUMN_SP_ATTACK},
+  {"sp_defense", COLUMN_SP_DEFENSE}, {"sp.def", COLUMN_SP_DEFENSE}, {"speed", COLUMN_SPEED},
+  {"generation", COLUMN_GENERATION}
+};
+
+/* This function looks up the numeric column a query names */
+/* Parameters: *name - input (the null-terminated name of the column) */
+/* Return values: int containing the PokemonColumnType of the column, C_NOK (-1) if no column has that name */
+/* Side effects: none */
+int query_find_column(const char *name) {
+  for(int i = 0; i < (int)(sizeof(column_names) / sizeof(column_names[0])); i++) {
+    if(strcasecmp(name, column_names[i].name) == 0) {
+      return column_names[i].column;
+    }
+  }
+  return C_NOK;
+}
+
+/* This function rewrites the text of a request so requests that only differ by their spacing or by the case of their names are written the same way, the values are kept as they are since types are case sensitive */
+/* Parameters: *text - input (the text of the request, not null-terminated), length - input (the amount of characters inside text), *normalized - output (the rewritten text, not null-terminated, room for length characters) */
+/* Return values: int containing the amount of characters written to normalized */
+/* Side effects: none */
+int query_normalize(const char *text, int length, char *normalized) {
+  int size = 0;
+  int i = 0;
+
+  while(i < length) {
+    /* Words are separated by a single space, whatever separated them before */
+    while(i < length && memchr(QUERY_BLANKS, text[i], sizeof(QUERY_BLANKS) - 1) != NULL) {
+      i++;
+    }
+    if(i == length) {
+      break;
+    }
+    if(size > 0) {
+      normalized[size++] = ' ';
+    }
+
+    /* Everything before the operator of a condition is a name, and words without an operator are keywords */
+    char is_name = C_OK;
+    while(i < length && memchr(QUERY_BLANKS, text[i], sizeof(QUERY_BLANKS) - 1) == NULL) {
+      if(memchr(QUERY_OPERATORS, text[i], sizeof(QUERY_OPERATORS) - 1) != NULL) {
+        is_name = C_NOK;
+      }
+      normalized[size++] = (is_name == C_OK) ? tolower((unsigned char)text[i]) : text[i];
+      i++;
+    }
+  }
+  return size;
+}
+
+/* This function looks up the interned type a query condition names */
+/* Parameters: *table - input (the table the query runs over), *type_name - input (the null-terminated name of the type, "none" for no second type) */
+/* Return values: int containing the string pool offset of the type, QUERY_TYPE_UNKNOWN if no pokemon has the type */
+/* Side effects: none */
+static int query_find_type(const PokemonTableType *table, const char *type_name) {
+  if(strcasecmp(type_name, "none") == 0) {
+    type_name = "";
+  }
+  int type = table_find_string(table, type_name);
+  return (type < 0) ? QUERY_TYPE_UNKNOWN : type;
+}
+
+/* This function sets a type condition of a query, a condition given twice with two different types can't match anything */
+/* Parameters: *query - input/output (the query being built), *condition - input/output (the type condition being set), type - input (the interned type or QUERY_TYPE_UNKNOWN) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void query_set_type(QueryClauseType *query, int *condition, int type) {
+  if(type == QUERY_TYPE_UNKNOWN || (*condition != QUERY_TYPE_ANY && *condition != type)) {
+    query->matches_nothing = C_OK;
+  }
+  *condition = type;
+}
+
+/* This function narrows the range a numeric column of a query can have */
+/* Parameters: *query - input/output (the query being built), column - input (the column being narrowed), *operator - input (one of = < <= > >=), value - input (the number on the right of the operator) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void query_set_range(QueryClauseType *query, PokemonColumnType column, const char *operator, long value) {
+  long minimum = query->minimum[column];
+  long maximum = query->maximum[column];
+
+  /* Any number outside of what a short can hold matches like the one just past it, clamping it first keeps value - 1 and value + 1 from overflowing when strtol saturated */
+  if(value < (long)SHRT_MIN - 1) {
+    value = (long)SHRT_MIN - 1;
+  }
+  else if(value > (long)SHRT_MAX + 1) {
+    value = (long)SHRT_MAX + 1;
+  }
+
+  if(strcmp(operator, "=") == 0) {
+    minimum = (value > minimum) ? value : minimum;
+    maximum = (value < maximum) ? value : maximum;
+  }
+  else if(strcmp(operator, "<") == 0 && value - 1 < maximum) {
+    maximum = value - 1;
+  }
+  else if(strcmp(operator, "<=") == 0 && value < maximum) {
+    maximum = value;
+  }
+  else if(strcmp(operator, ">") == 0 && value + 1 > minimum) {
+    minimum = value + 1;
+  }
+  else if(strcmp(operator, ">=") == 0 && value > minimum) {
+    minimum = value;
+  }
+
+  /* A range that is empty or outside of what a short can hold can't match anything */
+  if(minimum > maximum || minimum > SHRT_MAX || maximum < SHRT_MIN) {
+    query->matches_nothing = C_OK;
+    return;
+  }
+  query->minimum[column] = (minimum < SHRT_MIN) ? SHRT_MIN : minimum;
+  query->maximum[column] = (maximum > SHRT_MAX) ? SHRT_MAX : maximum;
+}
+
+/* This function parses one condition of a query, like "speed>=100" */
+/* Parameters: *table - input (the table the query runs over), *condition - input (the null-terminated condition, it is modified), *query - input/output (the query the condition is added to), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if the condition was added and C_NOK (-1) if it is invalid */
+/* Side effects: modifies the condition string */
+static int query_parse_condition(const PokemonTableType *table, char *condition, QueryClauseType *query, char *error) {
+  char operator[3] = "";      //Operator between the name and the value
+  int name_length = strcspn(condition, QUERY_OPERATORS);
+  char *value = condition + name_length;
+
+  /* Split the condition into its name, its operator and its value */
+  if(*value == '\0' || name_length == 0) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Invalid condition '%s'", condition);
+    return C_NOK;
+  }
+  operator[0] = *value++;
+  if(*value == '=' && operator[0] != '=') {
+    operator[1] = *value++;
+  }
+  condition[name_length] = '\0';
+
+  if(*value == '\0') {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Condition '%s' has no value", condition);
+    return C_NOK;
+  }
+
+  /* Numeric columns accept every operator except the prefix operator */
+  for(int i = 0; i < (int)(sizeof(column_names) / sizeof(column_names[0])); i++) {
+    if(strcasecmp(condition, column_names[i].name) == 0) {
+      char *end = NULL;
+      long number = strtol(value, &end, 10);
+      if(strcmp(operator, "^=") == 0 || *end != '\0') {
+        snprintf(error, MAX_QUERY_ERROR_SIZE, "Invalid condition on '%s'", condition);
+        return C_NOK;
+      }
+      query_set_range(query, column_names[i].column, operator, number);
+      return C_OK;
+    }
+  }
+
+  /* Every other condition only accepts = except the name which only accepts ^= */
+  if(strcasecmp(condition, "name") == 0 && strcmp(operator, "^=") == 0) {
+    int length = strlen(value);
+    if(length > MAX_QUERY_NAME_PREFIX) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Name prefix is longer than %d characters", MAX_QUERY_NAME_PREFIX);
+      return C_NOK;
+    }
+    memcpy(query->name_prefix, value, length);
+    query->name_prefix_length = length;
+    return C_OK;
+  }
+  if(strcmp(operator, "=") != 0) {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Invalid operator on '%s'", condition);
+    return C_NOK;
+  }
+
+  if(strcasecmp(condition, "legendary") == 0) {
+    char legendary;
+    if(strcasecmp(value, "true") == 0 || strcasecmp(value, "yes") == 0) {
+      legendary = 'y';
+    }
+    else if(strcasecmp(value, "false") == 0 || strcasecmp(value, "no") == 0) {
+      legendary = 'n';
+    }
+    else {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Legendary must be true or false");
+      return C_NOK;
+    }
+    if(query->legendary != 0 && query->legendary != legendary) {
+      query->matches_nothing = C_OK;
+    }
+    query->legendary = legendary;
+  }
+  else if(strcasecmp(condition, "type") == 0) {
+    query_set_type(query, &query->any_type, query_find_type(table, value));
+  }
+  else if(strcasecmp(condition, "type1") == 0) {
+    query_set_type(query, &query->first_type, query_find_type(table, value));
+  }
+  else if(strcasecmp(condition, "type2") == 0) {
+    query_set_type(query, &query->second_type, query_find_type(table, value));
+  }
+  else if(strcasecmp(condition, "types") == 0) {
+    char *second = strchr(value, '/');
+    if(second == NULL) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Types must be written as <type>/<type>");
+      return C_NOK;
+    }
+    *second++ = '\0';
+    query_set_type(query, &query->dual_types[0], query_find_type(table, value));
+    query_set_type(query, &query->dual_types[1], query_find_type(table, second));
+  }
+  else {
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Unknown condition '%s'", condition);
+    return C_NOK;
+  }
+  return C_OK;
+}
+
+/* This function parses the order or the limit of a query, like "sort=-speed" or "limit=20" */
+/* Parameters: *condition - input (the null-terminated condition), *query - input/output (the query the order or the limit is set on), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if the order or the limit was set and C_NOK (-1) if it is invalid */
+/* Side effects: none */
+static int query_parse_order(const char *condition, QueryType *query, char *error) {
+
+  if(strncasecmp(condition, "limit=", 6) == 0) {
+    char *end = NULL;
+    long limit = strtol(condition + 6, &end, 10);
+    if(condition[6] == '\0' || *end != '\0' || limit < 0 || limit > INT_MAX) {
+      snprintf(error, MAX_QUERY_ERROR_SIZE, "Limit must be a number of 0 or more");
+      return C_NOK;
+    }
+    query->limit = limit;
+    return C_OK;
+  }
+
+  /* A minus sign in front of the column orders from largest to smallest */
+  const char *column = condition + 5;
+  query->sort_descending = (*column == '-') ? C_OK : C_NOK;
+  if(*column == '-' || *column == '+') {
+    column++;
+  }
+  query->sort_column = query_find_column(column);
+  if(query->sort_column == C_NOK) {
+    query->sort_column = QUERY_NO_SORT;
+    snprintf(error, MAX_QUERY_ERROR_SIZE, "Can't sort by '%s'", column);
+    return C_NOK;
+  }
+  return C_OK;
+}
+
+/* This function sets a group of conditions up so every pokemon matches it */
+/* Parameters: *clause - output (the group being cleared) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void query_clear_clause(QueryClauseType *clause) {
+  memset(clause, 0, sizeof(QueryClauseType));
+  for(int i = 0; i < NUMBER_OF_COLUMNS; i++) {
+    clause->minimum[i] = SHRT_MIN;
+    clause->maximum[i] = SHRT_MAX;
+  }
+  clause->any_type = QUERY_TYPE_ANY;
+  clause->first_type = QUERY_TYPE_ANY;
+  clause->second_type = QUERY_TYPE_ANY;
+  clause->dual_types[0] = QUERY_TYPE_ANY;
+  clause->dual_types[1] = QUERY_TYPE_ANY;
+  clause->matches_nothing = C_NOK;
+}
+
+/* This function parses the text of a filter query sent by a client */
+/* Parameters: *table - input (the table the query runs over), *text - input (the query, not null-terminated), length - input (the amount of characters inside text), *query - output (the parsed groups of conditions), *error - output (description of the problem, at least MAX_QUERY_ERROR_SIZE characters) */
+/* Return values: int, C_OK (0) if the query is valid and C_NOK (-1) if it is not */
+/* Side effects: allocates and frees a copy of the text */
+int query_parse(const PokemonTableType *table, const char *text, int length, QueryType *query, char *error) {
+  char *copy = (char *)malloc(length + 1);  //null-terminated copy of the text split into conditions
+  char *position = copy;
+  char *condition;
+  int result = C_OK;
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(copy == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+
+  /* Start from a single group every pokemon matches, in file order */
+  query->number_of_clauses = 1;
+  query_clear_clause(&query->clauses[0]);
+  query->sort_column = QUERY_NO_SORT;
+  query->sort_descending = C_NOK;
+  query->limit = QUERY_NO_LIMIT;
+
+  /* Add every condition separated by spaces to the current group, "or" starts a new group */
+  while(result == C_OK && (condition = strsep(&position, QUERY_BLANKS)) != NULL) {
+    if(*condition == '\0' || strcasecmp(condition, "and") == 0) {
+      continue;
+    }
+    if(strcasecmp(condition, "or") == 0) {
+      if(query->number_of_clauses == MAX_QUERY_CLAUSES) {
+        snprintf(error, MAX_QUERY_ERROR_SIZE, "A query can't join more than %d groups with 'or'", MAX_QUERY_CLAUSES);
+        result = C_NOK;
+        break;
+      }
+      query_clear_clause(&query->clauses[query->number_of_clauses++]);
+      continue;
+    }
+
+    /* The order and the limit apply to the whole query and not to a group */
+    if(strncasecmp(condition, "sort=", 5) == 0 || strncasecmp(condition, "limit=", 6) == 0) {
+      result = query_parse_order(condition, query, error);
+      continue;
+    }
+    result = query_parse_condition(table, condition, &query->clauses[query->number_of_clauses - 1], error);
+  }
+
+  free(copy);
+  return result;
+}
+
+/* This function keeps the bits of the rows whose interned value inside a type column is a certain type */
+/* Parameters: *column - input (the interned type of every row), number_of_rows - input (the amount of rows), type - input (the interned type kept), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void scan_type(const int *column, int number_of_rows, int type, uint64_t *bitmap) {
+  for(int word = 0; word < bitmap_words(number_of_rows); word++) {
+    int first_row = word * BITMAP_WORD_BITS;
+    int last_row = (first_row + BITMAP_WORD_BITS < number_of_rows) ? first_row + BITMAP_WORD_BITS : number_of_rows;
+    uint64_t bits = 0;
+
+    if(bitmap[word] == 0) {
+      continue;
+    }
+    for(int row = first_row; row < last_row; row++) {
+      bits |= (uint64_t)(column[row] == type) << (row - first_row);
+    }
+    bitmap[word] &= bits;
+  }
+}
+
+/* This function keeps the bits of the rows that have a certain type as either their first or their second type */
+/* Parameters: *table - input (the table being scanned), type - input (the interned type kept), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void scan_either_type(const PokemonTableType *table, int type, uint64_t *bitmap) {
+  for(int word = 0; word < bitmap_words(table->number_of_rows); word++) {
+    int first_row = word * BITMAP_WORD_BITS;
+    int last_row = (first_row + BITMAP_WORD_BITS < table->number_of_rows) ? first_row + BITMAP_WORD_BITS : table->number_of_rows;
+    uint64_t bits = 0;
+
+    if(bitmap[word] == 0) {
+      continue;
+    }
+    for(int row = first_row; row < last_row; row++) {
+      bits |= (uint64_t)(table->first_type[row] == type || table->second_type[row] == type) << (row - first_row);
+    }
+    bitmap[word] &= bits;
+  }
+}
+
+/* This function keeps the bits of the rows that are legendary or that are not legendary */
+/* Parameters: *table - input (the table being scanned), legendary - input ('y' to keep legendary pokemon or 'n' to keep the others), *bitmap - input/output (the selection bitmap being narrowed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+void scan_legendary(const PokemonTableType *table, char legendary, uint64_t *bitmap) {
+  for(int word = 0; word < bitmap_words(table->number_of_rows); word++) {
+    int first_row = word * BITMAP_WORD_BITS;
+    int last_row = (first_row + BITMAP_WORD_BITS < table->number_of_rows) ? first_row + BITMAP_WORD_BITS : table->number_of_rows;
+    uint64_t bits = 0;
+
+    if(bitmap[word] == 0) {
+      continue;
+    }
+    for(int row = first_row; row < last_row; row++) {
+      bits |= (uint64_t)(table->legendary[row] == legendary) << (row - first_row);
+    }
+    bitmap[word] &= bits;
+  }
+}
+
+/* This function selects the rows of a table that match every condition of a group */
+/* Parameters: *table - input (the table being queried), *query - input (the group of conditions rows must match), *bitmap - output (selection bitmap with bitmap_words(number_of_rows) words, bit i of word j is set if row j * 64 + i matches) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void query_execute_clause(const PokemonTableType *table, const QueryClauseType *query, uint64_t *bitmap) {
+  int number_of_rows = table->number_of_rows;
+  int words = bitmap_words(number_of_rows);
+
+  /* Start with every row selected, except the bits past the last row */
+  if(query->matches_nothing == C_OK) {
+    memset(bitmap, 0, sizeof(uint64_t) * words);
+    return;
+  }
+  bitmap_fill(bitmap, number_of_rows);
+
+  /* Narrow the selection with every column that has a condition, one column at a time */
+  for(int i = 0; i < NUMBER_OF_COLUMNS; i++) {
+    if(query->minimum[i] != SHRT_MIN || query->maximum[i] != SHRT_MAX) {
+      column_scan_range(table->columns[i], number_of_rows, query->minimum[i], query->maximum[i], bitmap);
+    }
+  }
+  if(query->first_type != QUERY_TYPE_ANY) {
+    scan_type(table->first_type, number_of_rows, query->first_type, bitmap);
+  }
+  if(query->second_type != QUERY_TYPE_ANY) {
+    scan_type(table->second_type, number_of_rows, query->second_type, bitmap);
+  }
+  if(query->any_type != QUERY_TYPE_ANY) {
+    scan_either_type(table, query->any_type, bitmap);
+  }
+  for(int i = 0; i < 2; i++) {
+    if(query->dual_types[i] != QUERY_TYPE_ANY) {
+      scan_either_type(table, query->dual_types[i], bitmap);
+    }
+  }
+
+  /* The legendary flag and the name prefix are only checked on the rows still selected */
+  for(int word = 0; word < words; word++) {
+    uint64_t bits = bitmap[word];
+    while(bits != 0 && (query->legendary != 0 || query->name_prefix_length > 0)) {
+      int row = word * BITMAP_WORD_BITS + __builtin_ctzll(bits);
+      StringViewType name = table->name[row];
+      if((query->legendary != 0 && table->legendary[row] != query->legendary) || name.length < query->name_prefix_length || strncasecmp(table_view(table, name), query->name_prefix, query->name_prefix_length) != 0) {
+        bitmap[word] &= ~((uint64_t)1 << (row % BITMAP_WORD_BITS));
+      }
+      bits &= bits - 1;
+    }
+  }
+}
+
+/* This function runs a parsed query over every row of a table */
+/* Parameters: *table - input (the table being queried), *query - input (the groups of conditions rows must match), *bitmap - output (selection bitmap with bitmap_words(number_of_rows) words, bit i of word j is set if row j * 64 + i matches) */
+/* Return values: int containing the amount of rows that match */
+/* Side effects: allocates and frees a second bitmap when the query has more than one group */
+int query_execute(const PokemonTableType *table, const QueryType *query, uint64_t *bitmap) {
+  int words = bitmap_words(table->number_of_rows);
+
+  query_execute_clause(table, &query->clauses[0], bitmap);
+
+  /* Every other group is selected into its own bitmap and added to the rows already selected */
+  if(query->number_of_clauses > 1) {
+    uint64_t *clause_bitmap = (uint64_t *)malloc(sizeof(uint64_t) * (words + 1));
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if(clause_bitmap == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+    for(int i = 1; i < query->number_of_clauses; i++) {
+      query_execute_clause(table, &query->clauses[i], clause_bitmap);
+      bitmap_or(bitmap, clause_bitmap, words);
+    }
+    free(clause_bitmap);
+  }
+  return bitmap_count(bitmap, words);
+}
+
+/* This function serializes the rows selected by a bitmap into a result payload, the pokemon count followed by the line of every row and the '|' separator the client splits on */
+/* Parameters: *table - input (the table the rows belong to), *bitmap - input (the selection bitmap returned by query_execute), number_of_matches - input (the amount of bits set inside bitmap), *size - output (the amount of bytes inside the payload) */
+/* Return values: char pointer to the payload, which must be freed by the caller */
+/* Side effects: allocates memory for the payload, exits the program if it can't be allocated */
+char *query_serialize(const PokemonTableType *table, const uint64_t *bitmap, int number_of_matches, int *size) {
+  int words = bitmap_words(table->number_of_rows);
+
+  /* Add up the size of every line first so the payload is allocated once */
+  *size = RESULT_COUNT_SIZE;
+  for(int word = 0; word < words; word++) {
+    for(uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+      *size += table->line[word * BITMAP_WORD_BITS + __builtin_ctzll(bits)].length + 1;
+    }
+  }
+
+  char *payload = (char *)malloc(*size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(payload == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  protocol_write_count((unsigned char *)payload, number_of_matches);
+  char *position = payload + RESULT_COUNT_SIZE;
+  for(int word = 0; word < words; word++) {
+    for(uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+      StringViewType line = table->line[word * BITMAP_WORD_BITS + __builtin_ctzll(bits)];
+      memcpy(position, table_view(table, line), line.length);
+      position[line.length] = '|';
+      position += line.length + 1;
+    }
+  }
+  return payload;
+}
+
+/* This function serializes a list of rows into a result payload in the order they are listed, the pokemon count followed by the line of every row and the '|' separator the client splits on */
+/* Parameters: *table - input (the table the rows belong to), *rows - input (the rows being serialized), number_of_rows - input (the amount of rows inside rows), *size - output (the amount of bytes inside the payload) */
+/* Return values: char pointer to the payload, which must be freed by the caller */
+/* Side effects: allocates memory for the payload, exits the program if it can't be allocated */
+char *query_serialize_rows(const PokemonTableType *table, const int *rows, int number_of_rows, int *size) {
+
+  /* Add up the size of every line first so the payload is allocated once */
+  *size = RESULT_COUNT_SIZE;
+  for(int i = 0; i < number_of_rows; i++) {
+    *size += table->line[rows[i]].length + 1;
+  }
+
+  char *payload = (char *)malloc(*size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(payload == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  protocol_write_count((unsigned char *)payload, number_of_rows);
+  char *position = payload + RESULT_COUNT_SIZE;
+  for(int i = 0; i < number_of_rows; i++) {
+    StringViewType line = table->line[rows[i]];
+    memcpy(position, table_view(table, line), line.length);
+    position[line.length] = '|';
+    position += line.length + 1;
+  }
+  return payload;
+}
+
+/* This function tells whether a row comes before another one in the order asked for by a query, rows with the same value are ordered by their position inside the file, reversed when sorting from largest to smallest */
+/* Parameters: *values - input (the column the rows are ordered by), descending - input (C_OK if larger values come first), first - input (a row), second - input (another row) */
+/* Return values: int, 1 if first comes before second and 0 otherwise */
+/* Side effects: none */
+static inline int row_comes_before(const short *values, char descending, int first, int second) {
+  if(values[first] != values[second]) {
+    return (descending == C_OK) ? values[first] > values[second] : values[first] < values[second];
+  }
+  return (descending == C_OK) ? first > second : first < second;
+}
+
+/* This function moves the row at the top of a heap down until the row that comes last is at the top again */
+/* Parameters: *heap - input/output (the rows of the heap, the row coming last is at index 0), size - input (the amount of rows inside heap), position - input (the index of the row being moved down), *values - input (the column the rows are ordered by), descending - input (C_OK if larger values come first) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void heap_sift_down(int *heap, int size, int position, const short *values, char descending) {
+  while(1) {
+    int last = position;
+    int left = position * 2 + 1;
+    int right = left + 1;
+
+    if(left < size && row_comes_before(values, descending, heap[last], heap[left])) {
+      last = left;
+    }
+    if(right < size && row_comes_before(values, descending, heap[last], heap[right])) {
+      last = right;
+    }
+    if(last == position) {
+      return;
+    }
+    int row = heap[position];
+    heap[position] = heap[last];
+    heap[last] = row;
+    position = last;
+  }
+}
+
+/* This function returns the amount of bits needed to write a number, a cheap estimate of its logarithm */
+/* Parameters: number - input (the number being measured, at least 1) */
+/* Return values: int containing the amount of bits */
+/* Side effects: none */
+static int bit_length(unsigned int number) {
+  return 32 - __builtin_clz(number | 1);
+}
+
+/* This function puts the rows matching a query in the order and under the limit the query asks for.
+   Rows are either taken by walking the ordering of the column built when the table was loaded, stopping once enough rows matched, or by keeping the best rows seen inside a heap, whichever visits fewer rows */
+/* Parameters: *table - input (the table being queried), *query - input (the order and the limit), *bitmap - input (the rows matching the query, returned by query_execute), number_of_matches - input (the amount of bits set inside bitmap), *rows - output (the ordered rows, room for number_of_matches rows) */
+/* Return values: int containing the amount of rows written to rows */
+/* Side effects: none */
+int query_order(const PokemonTableType *table, const QueryType *query, const uint64_t *bitmap, int number_of_matches, int *rows) {
+  int limit = (query->limit == QUERY_NO_LIMIT || query->limit > number_of_matches) ? number_of_matches : query->limit;
+  int number_of_rows = 0;
+
+  if(limit == 0) {
+    return 0;
+  }
+
+  /* Without an order the first rows inside the file are kept */
+  if(query->sort_column == QUERY_NO_SORT) {
+    for(int word = 0; number_of_rows < limit; word++) {
+      for(uint64_t bits = bitmap[word]; bits != 0 && number_of_rows < limit; bits &= bits - 1) {
+        rows[number_of_rows++] = word * BITMAP_WORD_BITS + __builtin_ctzll(bits);
+      }
+    }
+    return number_of_rows;
+  }
+
+  const short *values = table->columns[query->sort_column];
+  char descending = query->sort_descending;
+
+  /* Matching rows are spread evenly through the ordering on average, so the walk visits about limit * rows / matches rows while the heap visits every match and pays a logarithm for the ones it keeps */
+  long walk_cost = (long)limit * table->number_of_rows / number_of_matches;
+  long heap_cost = (long)number_of_matches + (long)limit * bit_length(limit);
+
+  if(walk_cost <= heap_cost) {
+    const int *ordering = table->sorted_rows[query->sort_column];
+    for(int i = 0; i < table->number_of_rows && number_of_rows < limit; i++) {
+      int row = ordering[(descending == C_OK) ? table->number_of_rows - 1 - i : i];
+      if((bitmap[row / BITMAP_WORD_BITS] >> (row % BITMAP_WORD_BITS)) & 1) {
+        rows[number_of_rows++] = row;
+      }
+    }
+    return number_of_rows;
+  }
+
+  /* Keep the best limit rows seen so far inside a heap whose top is the row that comes last, so a better row replaces it */
+  for(int word = 0; word < bitmap_words(table->number_of_rows); word++) {
+    for(uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+      int row = word * BITMAP_WORD_BITS + __builtin_ctzll(bits);
+      if(number_of_rows < limit) {
+        /* Move the new row up until its parent comes after it */
+        int position = number_of_rows++;
+        rows[position] = row;
+        while(position > 0 && row_comes_before(values, descending, rows[(position - 1) / 2], rows[position])) {
+          int parent = (position - 1) / 2;
+          rows[position] = rows[parent];
+          rows[parent] = row;
+          position = parent;
+        }
+      }
+      else if(row_comes_before(values, descending, row, rows[0])) {
+        rows[0] = row;
+        heap_sift_down(rows, number_of_rows, 0, values, descending);
+      }
+    }
+  }
+
+  /* Take the row coming last off the top of the heap and put it at the end, until the rows are in order */
+  for(int size = number_of_rows - 1; size > 0; size--) {
+    int row = rows[0];
+    rows[0] = rows[size];
+    rows[size] = row;
+    heap_sift_down(rows, size, 0, values, descending);
+  }
+  return number_of_rows;
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************/
+/* */
+/* query.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the query.c file */
+/* How to use: use #include "query.h" at the top of any .c files that need to parse or run filter queries over the pokemon table */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef QUERY_H_
+#define QUERY_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//importing the header files of the table the queries run over and of the kernels scanning its columns
+#include "pokemon_table.h"
+#include "column_scan.h"
+
+//Variety of constants defined
+#define MAX_QUERY_NAME_PREFIX 100     //Constant to represent the longest name prefix a query can contain
+#define MAX_QUERY_ERROR_SIZE 200      //Constant to represent the longest description of an error found while parsing a query
+#define QUERY_TYPE_ANY -2             //Constant to represent a type condition that was not given, so every type matches
+#define QUERY_TYPE_UNKNOWN -1         //Constant to represent a type the table doesn't contain, so no pokemon matches
+#define MAX_QUERY_CLAUSES 8           //Constant to represent the largest amount of groups of conditions a query can join with "or"
+#define QUERY_NO_SORT -1              //Constant to represent a query whose results stay in file order
+#define QUERY_NO_LIMIT -1             //Constant to represent a query that returns every matching pokemon
+#define QUERY_BLANKS " \t\r\n"        //Constant to represent the characters separating the conditions of a query
+#define QUERY_OPERATORS "<>=^"        //Constant to represent the characters the operator of a condition is made of
+
+/* This structure contains one group of conditions of a filter query, a pokemon matches the group if it matches every condition of it.
+
+   A group is a list of conditions separated by spaces (an "and" between two conditions is allowed), for example "speed>=100 generation<=3 legendary=false type=Water name^=Char":
+     <stat><op><number>   range on number, total, hp, attack, defense, sp_attack, sp_defense, speed or generation, op is one of = < <= > >=
+     legendary=<bool>     true/false (or yes/no)
+     type=<type>          the first or the second type is <type>
+     type1=<type>         the first type is <type>
+     type2=<type>         the second type is <type>, use "none" for pokemon with a single type
+     types=<type>/<type>  the pokemon has both types, in either order
+     name^=<prefix>       the name starts with <prefix> */
+typedef struct QueryClause {
+  short minimum[NUMBER_OF_COLUMNS];   //Smallest value every numeric column can have, indexed with PokemonColumnType
+  short maximum[NUMBER_OF_COLUMNS];   //Largest value every numeric column can have, indexed with PokemonColumnType
+  char legendary;                     //'y' or 'n' if only legendary or only non legendary pokemon match, 0 if both match
+  int any_type;                       //Interned type the first or the second type must be, or QUERY_TYPE_ANY/QUERY_TYPE_UNKNOWN
+  int first_type;                     //Interned type the first type must be, or QUERY_TYPE_ANY/QUERY_TYPE_UNKNOWN
+  int second_type;                    //Interned type the second type must be, or QUERY_TYPE_ANY/QUERY_TYPE_UNKNOWN
+  int dual_types[2];                  //Interned types the pokemon must have both of, or QUERY_TYPE_ANY/QUERY_TYPE_UNKNOWN
+  char name_prefix[MAX_QUERY_NAME_PREFIX]; //Characters the name must start with, not null-terminated
+  int name_prefix_length;             //Amount of characters inside name_prefix, 0 if every name matches
+  char matches_nothing;               //C_OK if the conditions contradict each other so no pokemon can match, C_NOK otherwise
+} QueryClauseType;
+
+/* This structure contains a whole filter query, groups of conditions joined with "or", for example "speed>100 generation<=3 or legendary=true". A pokemon matches the query if it matches any group.
+   The results can be ordered and cut anywhere inside the query with:
+     sort=<stat>          order by a numeric column from smallest to largest, sort=-<stat> orders from largest to smallest
+     limit=<number>       only return the first <number> results, for example "type=Water sort=-speed limit=20" */
+typedef struct Query {
+  QueryClauseType clauses[MAX_QUERY_CLAUSES]; //Every group of conditions of the query
+  int number_of_clauses;                      //Amount of groups inside clauses
+  int sort_column;                            //Numeric column the results are ordered by, or QUERY_NO_SORT
+  char sort_descending;                       //C_OK if the results go from largest to smallest, C_NOK otherwise
+  int limit;                                  //Largest amount of results returned, or QUERY_NO_LIMIT
+} QueryType;
+
+/* all function prototypes for functions in query.c */
+int query_normalize(const char *text, int length, char *normalized);
+int query_find_column(const char *name);
+void scan_either_type(const PokemonTableType *table, int type, uint64_t *bitmap);
+void scan_legendary(const PokemonTableType *table, char legendary, uint64_t *bitmap);
+int query_parse(const PokemonTableType *table, const char *text, int length, QueryType *query, char *error);
+int query_execute(const PokemonTableType *table, const QueryType *query, uint64_t *bitmap);
+char *query_serialize(const PokemonTableType *table, const uint64_t *bitmap, int number_of_matches, int *size);
+int query_order(const PokemonTableType *table, const QueryType *query, const uint64_t *bitmap, int number_of_matches, int *rows);
+char *query_serialize_rows(const PokemonTableType *table, const int *rows, int number_of_rows, int *size);
+
+#endif //end of header file
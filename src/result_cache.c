@@ -0,0 +1,275 @@
+/*****************************************************************************/
+/* */
+/* result_cache.c */
+/* Purpose: This file contains the functions of a bounded cache of serialized responses, so a request identical to an earlier one is answered by copying the earlier response instead of scanning the table again. The cache is split into shards that are locked separately, and every shard evicts its least recently used responses once they use more memory than it is allowed to. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Set a cache up with result_cache_init, look a normalized request up with result_cache_lookup and keep its response with result_cache_store once it is computed. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "result_cache.h"
+
+/* This function allocates memory and exits the program if it can't be allocated */
+/* Parameters: size - input (the amount of bytes allocated) */
+/* Return values: pointer to the allocated memory */
+/* Side effects: allocates memory, exits the program if memory can't be allocated */
+static void *checked_malloc(size_t size) {
+  void *memory = malloc(size);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(memory == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+/* This function returns the amount of memory an entry uses, counted against the capacity of its shard */
+/* Parameters: key_length - input (the amount of characters of the key), response_size - input (the amount of bytes of the response) */
+/* Return values: long containing the amount of bytes */
+/* Side effects: none */
+static long entry_bytes(int key_length, int response_size) {
+  return (long)sizeof(ResultCacheEntryType) + key_length + response_size;
+}
+
+/* This function returns the shard a hash belongs to, the low bits of the hash pick the bucket inside the shard so the high bits pick the shard */
+/* Parameters: *cache - input (the cache), hash - input (the hash of a key) */
+/* Return values: pointer to the shard */
+/* Side effects: none */
+static ResultCacheShardType *cache_shard(ResultCacheType *cache, unsigned int hash) {
+  return &cache->shards[(hash >> 24) & (RESULT_CACHE_SHARDS - 1)];
+}
+
+/* This function sets up an empty cache */
+/* Parameters: *cache - output (the cache being set up), capacity - input (the amount of memory in bytes every response kept can use together, 0 to keep nothing) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates the hash buckets and initializes the mutex of every shard */
+void result_cache_init(ResultCacheType *cache, long capacity) {
+  memset(cache, 0, sizeof(ResultCacheType));
+
+  for(int i = 0; i < RESULT_CACHE_SHARDS; i++) {
+    ResultCacheShardType *shard = &cache->shards[i];
+    pthread_mutex_init(&shard->lock, NULL);
+    shard->number_of_buckets = RESULT_CACHE_INITIAL_BUCKETS;
+    shard->buckets = (ResultCacheEntryType **)checked_malloc(sizeof(ResultCacheEntryType *) * shard->number_of_buckets);
+    memset(shard->buckets, 0, sizeof(ResultCacheEntryType *) * shard->number_of_buckets);
+    shard->capacity = capacity / RESULT_CACHE_SHARDS;
+  }
+}
+
+/* This function frees every response kept inside a cache */
+/* Parameters: *cache - input/output (the cache being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees dynamically allocated data, destroys the mutex of every shard */
+void result_cache_free(ResultCacheType *cache) {
+  for(int i = 0; i < RESULT_CACHE_SHARDS; i++) {
+    ResultCacheShardType *shard = &cache->shards[i];
+    ResultCacheEntryType *entry = shard->most_recent;
+    while(entry != NULL) {
+      ResultCacheEntryType *less_recent = entry->less_recent;
+      free(entry->key);
+      free(entry->response);
+      free(entry);
+      entry = less_recent;
+    }
+    free(shard->buckets);
+    pthread_mutex_destroy(&shard->lock);
+  }
+  memset(cache, 0, sizeof(ResultCacheType));
+}
+
+/* This function takes an entry out of the recently used list of its shard */
+/* Parameters: *shard - input/output (the shard of the entry), *entry - input/output (the entry being unlinked) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void unlink_recent(ResultCacheShardType *shard, ResultCacheEntryType *entry) {
+  if(entry->more_recent != NULL) {
+    entry->more_recent->less_recent = entry->less_recent;
+  }
+  else {
+    shard->most_recent = entry->less_recent;
+  }
+  if(entry->less_recent != NULL) {
+    entry->less_recent->more_recent = entry->more_recent;
+  }
+  else {
+    shard->least_recent = entry->more_recent;
+  }
+}
+
+/* This function puts an entry at the front of the recently used list of its shard */
+/* Parameters: *shard - input/output (the shard of the entry), *entry - input/output (the entry that was just used) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void link_most_recent(ResultCacheShardType *shard, ResultCacheEntryType *entry) {
+  entry->more_recent = NULL;
+  entry->less_recent = shard->most_recent;
+  if(shard->most_recent != NULL) {
+    shard->most_recent->more_recent = entry;
+  }
+  shard->most_recent = entry;
+  if(shard->least_recent == NULL) {
+    shard->least_recent = entry;
+  }
+}
+
+/* This function finds the entry of a key inside a shard */
+/* Parameters: *shard - input (the shard being searched), *key - input (the key, not null-terminated), key_length - input (the amount of characters inside key), hash - input (the hash of the key) */
+/* Return values: pointer to the link pointing to the entry, the link points to NULL if the key isn't inside the shard */
+/* Side effects: none */
+static ResultCacheEntryType **find_entry(ResultCacheShardType *shard, const char *key, int key_length, unsigned int hash) {
+  ResultCacheEntryType **link = &shard->buckets[hash & (shard->number_of_buckets - 1)];
+
+  while(*link != NULL && ((*link)->hash != hash || (*link)->key_length != key_length || memcmp((*link)->key, key, key_length) != 0)) {
+    link = &(*link)->next_in_bucket;
+  }
+  return link;
+}
+
+/* This function removes the least recently used entry of a shard */
+/* Parameters: *shard - input/output (the shard an entry is evicted from, it must not be empty) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees the entry */
+static void evict_least_recent(ResultCacheShardType *shard) {
+  ResultCacheEntryType *entry = shard->least_recent;
+  ResultCacheEntryType **link = find_entry(shard, entry->key, entry->key_length, entry->hash);
+
+  *link = entry->next_in_bucket;
+  unlink_recent(shard, entry);
+  shard->bytes -= entry_bytes(entry->key_length, entry->response_size);
+  shard->number_of_entries--;
+  shard->evictions++;
+  free(entry->key);
+  free(entry->response);
+  free(entry);
+}
+
+/* This function doubles the amount of hash buckets of a shard so the hash chains stay short */
+/* Parameters: *shard - input/output (the shard being grown) */
+/* Return values: nothing since it's a void function */
+/* Side effects: reallocates the buckets of the shard */
+static void grow_buckets(ResultCacheShardType *shard) {
+  int number_of_buckets = shard->number_of_buckets * 2;
+  ResultCacheEntryType **buckets = (ResultCacheEntryType **)checked_malloc(sizeof(ResultCacheEntryType *) * number_of_buckets);
+
+  memset(buckets, 0, sizeof(ResultCacheEntryType *) * number_of_buckets);
+  for(int i = 0; i < shard->number_of_buckets; i++) {
+    ResultCacheEntryType *entry = shard->buckets[i];
+    while(entry != NULL) {
+      ResultCacheEntryType *next = entry->next_in_bucket;
+      entry->next_in_bucket = buckets[entry->hash & (number_of_buckets - 1)];
+      buckets[entry->hash & (number_of_buckets - 1)] = entry;
+      entry = next;
+    }
+  }
+  free(shard->buckets);
+  shard->buckets = buckets;
+  shard->number_of_buckets = number_of_buckets;
+}
+
+/* This function looks for the response of a request answered earlier */
+/* Parameters: *cache - input/output (the cache being searched), *key - input (the normalized request, not null-terminated), key_length - input (the amount of characters inside key), *type - output (the type of the message the response is sent with), *size - output (the amount of bytes inside the response) */
+/* Return values: char pointer to a copy of the response which must be freed by the caller, NULL if the response isn't inside the cache */
+/* Side effects: locks the mutex of one shard, marks the entry as the most recently used one and counts the hit or the miss, allocates the copy */
+char *result_cache_lookup(ResultCacheType *cache, const char *key, int key_length, int *type, int *size) {
+  unsigned int hash = hash_string(key, key_length);
+  ResultCacheShardType *shard = cache_shard(cache, hash);
+  char *copy = NULL;
+
+  pthread_mutex_lock(&shard->lock);
+  ResultCacheEntryType *entry = *find_entry(shard, key, key_length, hash);
+  if(entry != NULL) {
+    unlink_recent(shard, entry);
+    link_most_recent(shard, entry);
+    shard->hits++;
+
+    /* The output queue frees the response once it is sent, so every hit gets its own copy */
+    copy = (char *)checked_malloc(entry->response_size + 1);
+    memcpy(copy, entry->response, entry->response_size);
+    *type = entry->type;
+    *size = entry->response_size;
+  }
+  else {
+    shard->misses++;
+  }
+  pthread_mutex_unlock(&shard->lock);
+
+  return copy;
+}
+
+/* This function keeps the response of a request, evicting the least recently used responses of its shard until it fits */
+/* Parameters: *cache - input/output (the cache the response is kept inside), *key - input (the normalized request, not null-terminated), key_length - input (the amount of characters inside key), type - input (the type of the message the response is sent with), *response - input (the response, copied into the cache), size - input (the amount of bytes inside response) */
+/* Return values: nothing since it's a void function */
+/* Side effects: locks the mutex of one shard, may free other entries, allocates the entry, a response too large for its shard is not kept */
+void result_cache_store(ResultCacheType *cache, const char *key, int key_length, int type, const char *response, int size) {
+  unsigned int hash = hash_string(key, key_length);
+  ResultCacheShardType *shard = cache_shard(cache, hash);
+  long bytes = entry_bytes(key_length, size);
+
+  /* A single huge response would evict everything else, don't keep it */
+  if(bytes > shard->capacity / RESULT_CACHE_LARGEST_ENTRY_SHARE) {
+    return;
+  }
+
+  pthread_mutex_lock(&shard->lock);
+
+  /* Another worker thread may have stored the same response while this one was computing it */
+  if(*find_entry(shard, key, key_length, hash) != NULL) {
+    pthread_mutex_unlock(&shard->lock);
+    return;
+  }
+  while(shard->bytes + bytes > shard->capacity) {
+    evict_least_recent(shard);
+  }
+
+  ResultCacheEntryType *entry = (ResultCacheEntryType *)checked_malloc(sizeof(ResultCacheEntryType));
+  entry->key = (char *)checked_malloc(key_length + 1);
+  memcpy(entry->key, key, key_length);
+  entry->key_length = key_length;
+  entry->hash = hash;
+  entry->type = type;
+  entry->response = (char *)checked_malloc(size + 1);
+  memcpy(entry->response, response, size);
+  entry->response_size = size;
+
+  ResultCacheEntryType **bucket = &shard->buckets[hash & (shard->number_of_buckets - 1)];
+  entry->next_in_bucket = *bucket;
+  *bucket = entry;
+  link_most_recent(shard, entry);
+  shard->bytes += bytes;
+  shard->number_of_entries++;
+
+  /* Keep at most one entry per bucket on average */
+  if(shard->number_of_entries > shard->number_of_buckets) {
+    grow_buckets(shard);
+  }
+  pthread_mutex_unlock(&shard->lock);
+}
+
+/* This function adds up the counters of every shard of a cache */
+/* Parameters: *cache - input/output (the cache), *stats - output (the counters added up) */
+/* Return values: nothing since it's a void function */
+/* Side effects: locks the mutex of every shard one at a time */
+void result_cache_stats(ResultCacheType *cache, ResultCacheStatsType *stats) {
+  memset(stats, 0, sizeof(ResultCacheStatsType));
+
+  for(int i = 0; i < RESULT_CACHE_SHARDS; i++) {
+    ResultCacheShardType *shard = &cache->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    stats->hits += shard->hits;
+    stats->misses += shard->misses;
+    stats->evictions += shard->evictions;
+    stats->entries += shard->number_of_entries;
+    stats->bytes += shard->bytes;
+    stats->capacity += shard->capacity;
+    pthread_mutex_unlock(&shard->lock);
+  }
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************/
+/* */
+/* result_cache.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the result_cache.c file */
+/* How to use: use #include "result_cache.h" at the top of any .c files that need to keep serialized responses so identical requests are not computed again */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef RESULT_CACHE_H_
+#define RESULT_CACHE_H_
+
+//Other libraries that we will need
+#include <pthread.h>
+
+//Variety of constants defined
+#define RESULT_CACHE_SHARDS 16                          //Constant to represent the amount of independently locked parts of the cache, must be a power of two
+#define RESULT_CACHE_INITIAL_BUCKETS 64                 //Constant to represent the amount of hash buckets of every shard before it has to grow, must be a power of two
+#define RESULT_CACHE_DEFAULT_MEGABYTES 64               //Constant to represent the amount of memory the cache can use when no size is given
+#define RESULT_CACHE_LARGEST_ENTRY_SHARE 4              //Constant to represent the share of a shard the largest response kept can use, a response larger than 1/4 of a shard is never kept
+
+/* This structure represents one response kept inside the cache, it is inside the hash chain of its bucket and inside the list of its shard ordered from most to least recently used */
+typedef struct ResultCacheEntry {
+  char *key;                              //Normalized request the response answers, not null-terminated
+  int key_length;                         //Amount of characters inside key
+  unsigned int hash;                      //Hash of the key
+  int type;                               //Type of the message the response is sent with
+  char *response;                         //Serialized payload of the response
+  int response_size;                      //Amount of bytes inside response
+  struct ResultCacheEntry *next_in_bucket;//Next entry inside the same hash bucket
+  struct ResultCacheEntry *more_recent;   //Entry used right after this one, NULL for the most recently used entry
+  struct ResultCacheEntry *less_recent;   //Entry used right before this one, NULL for the least recently used entry
+} ResultCacheEntryType;
+
+/* This structure contains one part of the cache, requests are spread over the shards by their hash so worker threads rarely wait for each other */
+typedef struct ResultCacheShard {
+  pthread_mutex_t lock;                   //Mutex protecting every other field of the shard
+  ResultCacheEntryType **buckets;         //Hash table of the entries of the shard
+  int number_of_buckets;                  //Amount of buckets inside buckets
+  int number_of_entries;                  //Amount of entries inside the shard
+  ResultCacheEntryType *most_recent;      //Entry used last, the first one of the recently used list
+  ResultCacheEntryType *least_recent;     //Entry used first, the next one evicted
+  long bytes;                             //Amount of memory used by the entries of the shard
+  long capacity;                          //Amount of memory the entries of the shard can use before the least recently used ones are evicted
+  long hits;                              //Amount of lookups that found their response
+  long misses;                            //Amount of lookups that didn't find their response
+  long evictions;                         //Amount of entries evicted to make room for newer ones
+} ResultCacheShardType;
+
+/* This structure contains a bounded cache of serialized responses with least recently used eviction */
+typedef struct ResultCache {
+  ResultCacheShardType shards[RESULT_CACHE_SHARDS]; //Every part of the cache
+} ResultCacheType;
+
+/* This structure contains the counters of every shard of a cache added up */
+typedef struct ResultCacheStats {
+  long hits;                              //Amount of lookups that found their response
+  long misses;                            //Amount of lookups that didn't find their response
+  long evictions;                         //Amount of entries evicted to make room for newer ones
+  long entries;                           //Amount of responses inside the cache
+  long bytes;                             //Amount of memory used by the responses inside the cache
+  long capacity;                          //Amount of memory the cache can use
+} ResultCacheStatsType;
+
+/* all function prototypes for functions in result_cache.c */
+void result_cache_init(ResultCacheType *cache, long capacity);
+void result_cache_free(ResultCacheType *cache);
+char *result_cache_lookup(ResultCacheType *cache, const char *key, int key_length, int *type, int *size);
+void result_cache_store(ResultCacheType *cache, const char *key, int key_length, int type, const char *response, int size);
+void result_cache_stats(ResultCacheType *cache, ResultCacheStatsType *stats);
+
+#endif //end of header file
@@ -8,38 +8,76 @@
 /* */
 /*****************************************************************************/
 
+//needed for accept4 and getopt
+#define _GNU_SOURCE
+
 //libraries that will be used in the program
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
+#include <errno.h>
+#include <signal.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
-#include <sys/select.h>
 
 //importing the header file included with the program to get access to its functions, constants and structs
 #include "server.h"
 
+static volatile sig_atomic_t server_running = 1; //Set to 0 by the signal handler to shut the server down
+
+/* This function is called when the server receives SIGINT or SIGTERM and tells the event loop to shut the server down */
+/* Parameters: signal_number - input (the signal that was received) */
+/* Return values: nothing since it's a void function */
+/* Side effects: changes the server_running variable */
+static void handle_shutdown_signal(int signal_number) {
+  (void)signal_number;
+  server_running = 0;
+}
+
 /* This function is the function that is ran when the server.c program is first started */
-/* Parameters: None */
+/* Parameters: argc - input (the amount of command line arguments), *argv[] - input (the command line arguments, -w sets the amount of worker threads, -c the megabytes of responses cached and -l the megabytes of changes logged before they are written into the pokemon file) */
 /* Return values: int which determines whether the program ran sucessfully  */
-/* Side effets: creates variables which allocates memory, create and run threads, create sockets to communicate with other programs */
-int main() {
+/* Side effets: creates variables which allocates memory, create and run threads, create sockets to communicate with other programs, runs the event loop until the server is told to shut down */
+int main(int argc, char *argv[]) {
 
   char *file_name = NULL;                             // name of the file that will be read from
-  int serverSocket;                                   // the socket of the server
-  int clientSocket;                                   // the socket of the client that the server will connect to
-  int status;                                         // return variable from bind and listen functions
-  int bytesRcv;                                       // return variable from recv function
-  socklen_t addrSize;                                 // size of address 
-  int new_request = 0;                                // amount of new pokemon types that have not been read
-  struct sockaddr_in serverAddress;                   // address of the server
-  struct sockaddr_in clientAddr;                      // address of the client
-  ServerReadType *readStruct;                         // struct that contains all information to read from the file
-  ServerReadType readAddress;                         // struct that readStruct pointer points to
-  pthread_t server_read_thread;                       // thread to read from a file
+  TableSnapshotType *snapshot = NULL;                 // first snapshot of the table containing every pokemon inside the file
+  ServerType server;                                  // state shared by every connection of the server
+  struct sigaction shutdown_action;                   // action taken when the server is told to shut down
+  struct rlimit file_limit;                           // limit on the amount of sockets the server can have open
+  int number_of_workers = worker_pool_default_size(); // amount of worker threads running requests, one per core by default
+  long cache_megabytes = RESULT_CACHE_DEFAULT_MEGABYTES; // amount of memory the cached responses can use
+  long log_megabytes = WAL_DEFAULT_COMPACTION_MEGABYTES; // size the change log can reach before it is written into the pokemon file
+  FileIdentityType file_identity;                     // identity of the pokemon file when it was read
+  int option;                                         // command line option being read
+
+  /* Read the command line options */
+  while((option = getopt(argc, argv, "w:c:l:")) != -1) {
+    if(option == 'w' && atoi(optarg) > 0) {
+      number_of_workers = atoi(optarg);
+    }
+    else if(option == 'c' && atol(optarg) >= 0) {
+      cache_megabytes = atol(optarg);
+    }
+    else if(option == 'l' && atol(optarg) >= 0) {
+      log_megabytes = atol(optarg);
+    }
+    else {
+      printf("Usage: %s [-w number_of_worker_threads] [-c cache_megabytes] [-l change_log_megabytes] \n", argv[0]);
+      exit(C_NOK);
+    }
+  }
+
+  /* Messages are written by their own thread from now on, so the event loop and the worker threads never wait for the terminal */
+  logger_start(stdout);
 
   /* Loop forever until the user tells the user they want to quit the program or input a valid file name*/
   while(1) {
@@ -58,34 +96,172 @@ int main() {
       printf("Pokemon file is not found. Please enter the name of the file again. \n");
       continue;
     }
+    /* Read every pokemon inside the file into memory once, print message and prompt again if the file can't be read */
+    wal_identify(file_name, &file_identity);
+    snapshot = load_snapshot(file_name);
+    if(snapshot == NULL) {
+      free_char_pointer(&file_name);
+      printf("Pokemon file could not be read. Please enter the name of the file again. \n");
+      continue;
+    }
     /* Exit the loop if a file exists and can be opened */
     break; 
   }
 
-  /* Initializing the readStruct variable with default values*/
-  readStruct = &readAddress;
-  readStruct->boolean_counter = 0;
-  readStruct->file_name = file_name;
-  readStruct->pokemon_types_array = NULL;
-  readStruct->curr_number_of_pokemon_types = 0;
-  readStruct->pokemon_types_array_size = 0;
-  readStruct->thread_is_paused = C_NOK;
+  /* Apply the changes logged since the pokemon file was last written */
+  wal_open(&server.change_log, file_name, log_megabytes * 1024 * 1024);
+  server.change_log.data_file = file_identity;
+  snapshot = recover_snapshot(&server.change_log, snapshot);
 
-  //Allocates memory for the pokemon_types_array double char pointer inside the readStruct struct
-  readStruct->pokemon_types_array = (char **)malloc(sizeof(char *) *(readStruct->pokemon_types_array_size + 1));
+  LOG_INFO("Loaded %d pokemon from %s", snapshot->table.number_of_rows, file_name);
 
-  /* Check if memory is allocated properly, print error message and exit if not */
-  if(readStruct->pokemon_types_array == NULL) {
-    printf("Error allocating memory for pokemon_types_array. \n");
-    exit(C_NOK);
+  /* Raise the limit on open files as far as allowed so thousands of clients can be connected at once */
+  if(getrlimit(RLIMIT_NOFILE, &file_limit) == 0 && file_limit.rlim_cur < file_limit.rlim_max) {
+    file_limit.rlim_cur = file_limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &file_limit);
+  }
+
+  /* Shut down cleanly on SIGINT and SIGTERM, and don't die when writing to a client that disconnected */
+  memset(&shutdown_action, 0, sizeof(shutdown_action));
+  shutdown_action.sa_handler = handle_shutdown_signal;
+  sigaction(SIGINT, &shutdown_action, NULL);
+  sigaction(SIGTERM, &shutdown_action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  /* Initializing the server variable with default values */
+  server.snapshot = snapshot;
+  server.file_name = file_name;
+  server.published_snapshot = NULL;
+  server.number_of_connections = 0;
+  server.server_socket = open_server_socket();
+
+  /* Create the epoll instance and watch the server socket for new clients */
+  server.epoll_fd = epoll_create1(0);
+  if (server.epoll_fd < 0) {
+    LOG_ERROR("Could not create epoll instance.");
+    close(server.server_socket);
+    exit(-1);
+  }
+
+  struct epoll_event server_event;
+  memset(&server_event, 0, sizeof(server_event));
+  server_event.events = EPOLLIN | EPOLLET;
+  server_event.data.ptr = NULL; // the server socket is the only event without a connection
+  if (epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.server_socket, &server_event) < 0) {
+    LOG_ERROR("Could not watch the server socket.");
+    close(server.server_socket);
+    exit(-1);
+  }
+
+  /* Create the eventfd the worker threads wake the event loop up with, and watch it */
+  server.completed_requests = NULL;
+  server.free_requests = NULL;
+  server.freed_connections = NULL;
+  result_cache_init(&server.result_cache, cache_megabytes * 1024 * 1024);
+  server.wakeup_fd = eventfd(0, EFD_NONBLOCK);
+  if (server.wakeup_fd < 0 || pthread_mutex_init(&server.completed_lock, NULL) != 0) {
+    LOG_ERROR("Could not create the worker wakeup event.");
+    close(server.server_socket);
+    exit(-1);
+  }
+  server_event.events = EPOLLIN | EPOLLET;
+  server_event.data.ptr = &server.wakeup_fd; // the wakeup event is told apart by its address
+  if (epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.wakeup_fd, &server_event) < 0) {
+    LOG_ERROR("Could not watch the worker wakeup event.");
+    close(server.server_socket);
+    exit(-1);
+  }
+
+  /* Reload the pokemon file whenever it is written or replaced */
+  watch_pokemon_file(&server);
+
+  /* Start the worker threads that run the requests of every client */
+  worker_pool_start(&server.pool, number_of_workers);
+
+  /* Start the writer thread that makes every change to the table */
+  server.pending_changes = NULL;
+  server.reload_requested = C_NOK;
+  server.writer_stopping = C_NOK;
+  server.writer_snapshot = snapshot;
+  if (pthread_mutex_init(&server.writer_lock, NULL) != 0 || pthread_cond_init(&server.writer_wakeup, NULL) != 0 ||
+      pthread_create(&server.writer_thread, NULL, run_table_writer, (void *)&server) != 0) {
+    LOG_ERROR("Could not start the writer thread.");
+    close(server.server_socket);
+    exit(-1);
+  }
+
+  LOG_INFO("Starting server with %d worker threads and %ld MB of cached responses, scanning columns with %s", number_of_workers, cache_megabytes, column_scan_kernel_name());
+  LOG_INFO("Logging changes to %s, written into %s every %ld MB", server.change_log.log_file_name, file_name, log_megabytes);
+  run_event_loop(&server);
+
+  /* Let the worker threads finish what they are running before freeing anything they use */
+  worker_pool_stop(&server.pool);
+
+  /* Let the writer thread finish the changes it was given, every change a client sent is logged before the server stops */
+  pthread_mutex_lock(&server.writer_lock);
+  server.writer_stopping = C_OK;
+  pthread_cond_signal(&server.writer_wakeup);
+  pthread_mutex_unlock(&server.writer_lock);
+  pthread_join(server.writer_thread, NULL);
+  if (server.published_snapshot != NULL) {
+    free_snapshot(server.published_snapshot);
+  }
+  wal_close(&server.change_log);
+  if (server.inotify_fd >= 0) {
+    close(server.inotify_fd);
   }
 
+  /* Free memory from the name of the file the user entered and the pokemon read from it */
+  free_char_pointer(&file_name);
+  result_cache_free(&server.result_cache);
+  free_snapshot(server.snapshot);
+
+  /* Free the requests that were finished after the event loop stopped */
+  while (server.completed_requests != NULL) {
+    ServerRequestType *request = server.completed_requests;
+    server.completed_requests = request->next_completed;
+    free(request->query);
+    free(request->response);
+    free(request);
+  }
+
+  /* Free the requests kept for reuse */
+  while (server.free_requests != NULL) {
+    ServerRequestType *request = server.free_requests;
+    server.free_requests = request->next_completed;
+    free(request);
+  }
+
+  // Don't forget to close the sockets!
+  pthread_mutex_destroy(&server.completed_lock);
+  pthread_mutex_destroy(&server.writer_lock);
+  pthread_cond_destroy(&server.writer_wakeup);
+  close(server.wakeup_fd);
+  close(server.epoll_fd);
+  close(server.server_socket);
+  LOG_INFO("Shutting down.");
+  logger_stop();
+  return C_OK;
+}
+
+/* This function creates the non-blocking socket the server accepts clients on */
+/* Parameters: None */
+/* Return values: int containing the server socket */
+/* Side effects: creates, binds and listens on a socket, exits the program if any of those fail */
+int open_server_socket(void) {
+
+  int serverSocket;                                   // the socket of the server
+  int status;                                         // return variable from bind and listen functions
+  int reuse_address = 1;                              // lets the server restart without waiting for old connections to time out
+  struct sockaddr_in serverAddress;                   // address of the server
+
   // Create the server socket
-  serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  serverSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
   if (serverSocket < 0) {
-    printf("*** SERVER ERROR: Could not open socket.\n");
+    LOG_ERROR("Could not open socket.");
     exit(-1);
   }
+  setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse_address, sizeof(reuse_address));
 
   // Setup the server address
   memset(&serverAddress, 0, sizeof(serverAddress)); // zeros the struct
@@ -96,125 +272,389 @@ int main() {
   // Bind the server socket
   status = bind(serverSocket,  (struct sockaddr *)&serverAddress, sizeof(serverAddress));
   if (status < 0) {
-    printf("*** SERVER ERROR: Could not bind socket.\n");
+    LOG_ERROR("Could not bind socket.");
     close(serverSocket);
     exit(-1);
   }
 
-  // Set up the line-up to handle up to 5 clients in line 
-  status = listen(serverSocket, 5);
+  // Set up the line-up to handle as many clients in line as the system allows
+  status = listen(serverSocket, SOMAXCONN);
   if (status < 0) {
-    printf("*** SERVER ERROR: Could not listen on socket.\n");
+    LOG_ERROR("Could not listen on socket.");
     close(serverSocket);
     exit(-1);
   }
+  return serverSocket;
+}
 
-  // Waiting for a client to connect, and checking if the connection was successful
-  addrSize = sizeof(clientAddr);
-  clientSocket = accept(serverSocket, (struct sockaddr *) &clientAddr, &addrSize);
-  if (clientSocket < 0) {
-      printf("*** SERVER ERROR: Could not accept incoming client connection.\n");
-      exit(-1);
-  }
+/* This function waits for activity on the server socket and on every client socket and handles it, until the server is told to shut down */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: nothing since it's a void function */
+/* Side effects: accepts, reads from, writes to and closes client sockets */
+void run_event_loop(ServerType *server) {
 
-  printf("SERVER: Received client connection.\n");
-  readStruct->client_socket = clientSocket; // storing the client socket in readStruct
+  struct epoll_event events[MAX_EPOLL_EVENTS]; // events returned by epoll_wait
 
-  /* Initializing the mutex and cond variables inside readStruct and checking whether they initialized properly */
-  if(pthread_mutex_init(&readStruct->lock, NULL) != 0) {
-      printf("SERVER ERROR: mutex failed to initialize \n");
-      exit(EXIT_FAILURE);
+  while (server_running) {
+    int number_of_events = epoll_wait(server->epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+
+    /* epoll_wait is interrupted when the server is told to shut down */
+    if (number_of_events < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR("Epoll_wait failed.");
+      break;
+    }
+
+    for (int i = 0; i < number_of_events; i++) {
+      ConnectionType *connection = (ConnectionType *)events[i].data.ptr;
+
+      /* The server socket has no connection attached, it means new clients are waiting */
+      if (connection == NULL) {
+        accept_connections(server);
+        continue;
+      }
+      /* The wakeup event means worker threads finished some requests, or the reload thread finished loading */
+      if (events[i].data.ptr == &server->wakeup_fd) {
+        handle_completed_requests(server);
+        continue;
+      }
+      /* The inotify event means something inside the directory of the pokemon file changed */
+      if (events[i].data.ptr == &server->inotify_fd) {
+        handle_file_events(server);
+        continue;
+      }
+
+      /* The client was closed by an earlier event of this batch, like the wakeup event failing to send it its responses */
+      if (connection->is_closed == C_OK) {
+        continue;
+      }
+
+      /* Read everything the client sent, closing the connection if the client left */
+      if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        if (read_connection(server, connection) == C_NOK) {
+          close_connection(server, connection);
+          continue;
+        }
+      }
+
+      /* Send whatever is queued now that the socket may have room again, then handle the requests that were waiting for the client to take its responses */
+      if (flush_connection(connection) == C_NOK || resume_connection(server, connection) == C_NOK) {
+        close_connection(server, connection);
+      }
+    }
+
+    /* Every event of the batch is handled, no event left points to the clients that were closed */
+    while (server->freed_connections != NULL) {
+      ConnectionType *connection = server->freed_connections;
+      server->freed_connections = connection->next_freed;
+      free_connection(connection);
+    }
   }
-  if(pthread_cond_init(&readStruct->cond, NULL) != 0) {
-      printf("SERVER ERROR: cond failed to initialize \n");
+}
+
+/* This function accepts every client waiting on the server socket and starts watching their sockets */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: nothing since it's a void function */
+/* Side effects: accepts sockets, allocates memory for a ConnectionType per client */
+void accept_connections(ServerType *server) {
+
+  /* The server socket is edge-triggered so keep accepting until there is no client left waiting */
+  while (1) {
+    int64_t started_at = metrics_now();     // time accepting the client started at
+    struct sockaddr_in clientAddr;          // address of the client
+    socklen_t addrSize = sizeof(clientAddr); // size of address
+    int clientSocket = accept4(server->server_socket, (struct sockaddr *) &clientAddr, &addrSize, SOCK_NONBLOCK);
+
+    if (clientSocket < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG_ERROR("Could not accept incoming client connection.");
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    /* Every flush already writes all the queued responses in one call, so they are sent right away instead of waiting for the client to acknowledge the previous ones */
+    int no_delay = 1;
+    setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    /* Allocate the state of the new client with default values */
+    ConnectionType *connection = (ConnectionType *)calloc(1, sizeof(ConnectionType));
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if (connection == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
       exit(EXIT_FAILURE);
+    }
+    connection->client_socket = clientSocket;
+    connection->thread_is_paused = C_NOK;
+    connection->is_closed = C_NOK;
+    connection->is_ready = C_NOK;
+    connection->is_throttled = C_NOK;
+
+    struct epoll_event client_event;
+    memset(&client_event, 0, sizeof(client_event));
+    client_event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    client_event.data.ptr = connection;
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, clientSocket, &client_event) < 0) {
+      LOG_ERROR("Could not watch the client socket.");
+      close(clientSocket);
+      free(connection);
+      continue;
+    }
+
+    server->number_of_connections++;
+    metrics_count(COUNTER_CONNECTIONS_ACCEPTED, 1);
+    metrics_record_since(STAGE_ACCEPT, started_at);
+    LOG_INFO("Received client connection.");
   }
+}
 
-  printf("SERVER: Starting server \n");
-  
-  // Go into infinite loop to talk to client
+/* This function reads everything a client sent and handles every whole message inside it, as long as the client has credit for its requests */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client being read from) */
+/* Return values: int, C_OK (0) if the connection stays open and C_NOK (-1) if it has to be closed */
+/* Side effects: reads from the client socket, may grow the input buffer of the connection, stops reading once a client without credit sent more than MAX_THROTTLED_INPUT_SIZE bytes */
+int read_connection(ServerType *server, ConnectionType *connection) {
+
+  /* The client socket is edge-triggered so keep reading until there is nothing left */
   while (1) {
-    char buffer[MAX_MESSAGE_BUFFER_SIZE];               // buffer to store data that is received from a client program
-    // Get the message from the client
-    bytesRcv = recv(clientSocket, buffer, sizeof(buffer), 0);
-    buffer[bytesRcv] = '\0'; // null terminate the message
-
-    /* Check whether the message is a valid message, if not, print an error message and then wait for new messages to come in */
-    if(strcmp(buffer, " ") == 0 || strcmp(buffer, "") == 0) {
-      printf("DEBUG: Empty message received. \n");
-      continue;
+
+    /* Handle the messages already buffered first, they may be left from when the client had no credit */
+    if (handle_input(server, connection) == C_NOK) {
+      return C_NOK;
     }
 
-    printf("SERVER: Received client request: %s\n", buffer); //print the message the server received from the client
+    /* Leave the rest inside the socket so the client stops sending, resume_connection reads it once the client has credit again */
+    if (connection->is_throttled == C_OK && connection->input_size >= MAX_THROTTLED_INPUT_SIZE) {
+      return C_OK;
+    }
+
+    /* Double the input buffer whenever it is full */
+    if (connection->input_size == connection->input_capacity) {
+      int capacity = (connection->input_capacity > 0) ? connection->input_capacity * 2 : INPUT_BUFFER_INITIAL_SIZE;
+      unsigned char *input = (unsigned char *)realloc(connection->input, capacity);
 
-    /* If the message was pause */
-    if(strcmp(buffer,"pause") == 0) {
-      if(readStruct->boolean_counter == 1) { //Check if the read thread is already running
-        pthread_mutex_lock(&readStruct->lock); //lock the mutex
-        readStruct->thread_is_paused = C_OK; //set the thread_is_paused variable to C_OK to indicate that the thread is paused
+      /* Check if memory is allocated properly, print error message and exit if not */
+      if (input == NULL) {
+        printf("An error occured while allocating memory. The program will now exit \n");
+        exit(EXIT_FAILURE);
       }
+      connection->input = input;
+      connection->input_capacity = capacity;
     }
-    /* If the message was unapuse */
-    else if(strcmp(buffer, "unpause") == 0) {
-      if(readStruct->boolean_counter == 1) { //Check is the read thread is already running
-        pthread_mutex_lock(&readStruct->lock); //lock the mutex
-        readStruct->thread_is_paused = C_NOK; //set the thread_is_paused variable to C_NOK to indicate that the thread is unpaused
-        pthread_cond_signal(&readStruct->cond); //signal the cond variable to unpause/wake the thread
+
+    int bytesRcv = recv(connection->client_socket, connection->input + connection->input_size, connection->input_capacity - connection->input_size, 0);
+
+    if (bytesRcv < 0) {
+      if (errno == EINTR) {
+        continue;
       }
+      return (errno == EAGAIN || errno == EWOULDBLOCK) ? C_OK : C_NOK;
     }
-    /* If the message was stop, print a message and then break out of the infinite loop to close the server */
-    else if(strcmp(buffer, "stop") == 0) {
-      printf("SERVER: Received stop request. \n");
-      break;
+    /* The client closed its side of the connection */
+    if (bytesRcv == 0) {
+      return C_NOK;
     }
-    /* If it was not any of the messages above, assume that the message was a pokemon type*/
-    else {
+    connection->input_size += bytesRcv;
+    metrics_count(COUNTER_BYTES_RECEIVED, bytesRcv);
+  }
+}
 
-      readStruct->pokemon_types_array_size += 1; //increase the pokemon_types_array_size variable by 1
-      new_request += 1;                          //increase the new_request variable by 1
+/* This function handles every whole message inside the input buffer of a client, stopping at the first request the client has no credit for */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client whose messages are handled) */
+/* Return values: int, C_OK (0) if the connection stays open and C_NOK (-1) if it has to be closed */
+/* Side effects: removes the handled messages from the input buffer, marks the connection as throttled if a request has to wait */
+int handle_input(ServerType *server, ConnectionType *connection) {
+  int consumed = 0; //Amount of bytes of input belonging to messages that were handled
+  int result = C_OK;
 
-      /* If there is already a pokemon type stored inside pokemon_types_array, reallocate more memory to store another pokemon type */
-      if(readStruct->pokemon_types_array_size > 1) {
-        readStruct->pokemon_types_array = (char **)realloc(readStruct->pokemon_types_array, sizeof(char *) *(readStruct->pokemon_types_array_size + 1));
-      }
+  while (connection->input_size - consumed >= PROTOCOL_HEADER_SIZE) {
+    MessageHeaderType header;
 
-      /* Allocate memory to store the pokemon type inside pokemon_types_array */
-      readStruct->pokemon_types_array[readStruct->pokemon_types_array_size - 1] = (char *)malloc(sizeof(char) * (strlen(buffer) + 1));
-      strcpy(readStruct->pokemon_types_array[readStruct->pokemon_types_array_size - 1], buffer); //copy the pokemon type into the pokemon_types_array
+    /* Close the connection on a header from another version of the protocol or a payload too big to be a request */
+    if (protocol_read_header(connection->input + consumed, &header) == C_NOK || header.payload_length > MAX_REQUEST_PAYLOAD_SIZE) {
+      LOG_WARN("Received an invalid message header from a client");
+      return C_NOK;
     }
-    /* Check whether there is a new pokemon_type for the read thread to read */
-    if(readStruct->boolean_counter == 0 && new_request > 0 && readStruct->thread_is_paused == C_NOK) {
-      
-      /* If there is a pokemon_type that has been read, join the read thread once it's finished to collect the resources and to avoid memory leaks */
-      if(readStruct->curr_number_of_pokemon_types > 0) {
-        pthread_join(server_read_thread, NULL);
+    if (connection->input_size - consumed < PROTOCOL_HEADER_SIZE + (int)header.payload_length) {
+      break;
+    }
+
+    /* A request has to wait for credit, the pause and unpause messages behind it are still handled so a paused client can always unpause */
+    int is_control_message = (header.type == MESSAGE_PAUSE || header.type == MESSAGE_UNPAUSE || header.type == MESSAGE_STOP);
+    if (!is_control_message && connection_has_credit(connection) == C_NOK) {
+      if (connection->is_throttled == C_NOK) {
+        metrics_count(COUNTER_THROTTLED, 1);
       }
-      
-      /* Create a thread to read pokemon of a certain type */
-      pthread_create(&server_read_thread, NULL, server_read_pokemon, (void *)readStruct); 
-      new_request -= 1; //reduce the amount of new requests to read by 1
-      readStruct->curr_number_of_pokemon_types += 1; //increase the index to read inside pokemon_types_array by 1
+      connection->is_throttled = C_OK;
+      handle_control_messages(connection, consumed);
+      break;
+    }
+
+    if (handle_client_message(server, connection, &header, (const char *)connection->input + consumed + PROTOCOL_HEADER_SIZE) == C_NOK) {
+      result = C_NOK;
+      break;
     }
+    consumed += PROTOCOL_HEADER_SIZE + header.payload_length;
   }
 
-  /* Join a thread if a pokemon_type has been stored inside the pokemon_types_arary */
-  if(readStruct->pokemon_types_array_size > 0) {
-    pthread_join(server_read_thread, NULL);
+  /* Move the start of the next message back to the front of the buffer */
+  if (consumed > 0) {
+    memmove(connection->input, connection->input + consumed, connection->input_size - consumed);
+    connection->input_size -= consumed;
   }
+  return result;
+}
 
-  /* Free memory from the name of the file the user entered */
-  free_char_pointer(&file_name);
+/* This function tells whether a client can have another request ran, its credit is the amount of requests it can have running and the amount of unsent bytes it can leave in its output queue */
+/* Parameters: *connection - input (the client being checked) */
+/* Return values: int, C_OK (0) if its next request can be handled and C_NOK (-1) if it has to wait */
+/* Side effects: none */
+int connection_has_credit(const ConnectionType *connection) {
+  if (connection->number_of_pending_requests >= MAX_PENDING_REQUESTS_PER_CONNECTION || connection->queued_bytes >= MAX_QUEUED_BYTES_PER_CONNECTION) {
+    return C_NOK;
+  }
+  return C_OK;
+}
+
+/* This function handles the pause and unpause messages buffered behind a request that waits for credit, and removes them from the input buffer. They only decide whether responses are sent, so handling them before the request changes nothing else */
+/* Parameters: *connection - input/output (the client whose messages are handled), offset - input (the offset of the request waiting for credit inside the input buffer) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may pause or unpause the responses of the client, moves the rest of the input buffer over every message handled */
+void handle_control_messages(ConnectionType *connection, int offset) {
+  MessageHeaderType header;
+
+  /* Skip the request waiting for credit, it was already checked by handle_input */
+  protocol_read_header(connection->input + offset, &header);
+  offset += PROTOCOL_HEADER_SIZE + header.payload_length;
+
+  while (connection->input_size - offset >= PROTOCOL_HEADER_SIZE) {
+    if (protocol_read_header(connection->input + offset, &header) == C_NOK || header.payload_length > MAX_REQUEST_PAYLOAD_SIZE || connection->input_size - offset < PROTOCOL_HEADER_SIZE + (int)header.payload_length) {
+      return;
+    }
+    int length = PROTOCOL_HEADER_SIZE + header.payload_length;
+
+    if (header.type == MESSAGE_PAUSE || header.type == MESSAGE_UNPAUSE) {
+      connection->thread_is_paused = (header.type == MESSAGE_PAUSE) ? C_OK : C_NOK;
+      memmove(connection->input + offset, connection->input + offset + length, connection->input_size - offset - length);
+      connection->input_size -= length;
+    }
+    else {
+      offset += length;
+    }
+  }
+}
 
-  /* Free the memory from all the pokemon types stored inside pokemon_types_array then free the double char pointer itself */
-  for(int i = 0; i < readStruct->pokemon_types_array_size; i++) {
-    free_char_pointer(&readStruct->pokemon_types_array[i]);
+/* This function handles the requests a throttled client left waiting once it has credit again, and reads whatever else it sent meanwhile */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client being resumed) */
+/* Return values: int, C_OK (0) if the connection stays open and C_NOK (-1) if it has to be closed */
+/* Side effects: may read from the client socket and submit its requests */
+int resume_connection(ServerType *server, ConnectionType *connection) {
+  if (connection->is_throttled == C_NOK || connection_has_credit(connection) == C_NOK) {
+    return C_OK;
   }
-  free(readStruct->pokemon_types_array);
+  connection->is_throttled = C_NOK;
 
-  // Don't forget to close the sockets!
-  close(serverSocket);
-  printf("SERVER: Shutting down.\n");
-  pthread_exit(NULL);
+  /* The socket is edge-triggered and may already have been read up to MAX_THROTTLED_INPUT_SIZE, so read it again until it is empty */
+  return read_connection(server, connection);
+}
+
+/* This function handles one message received from a client */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client that sent the message), *header - input (the header of the message), *payload - input (the payload of the message, header->payload_length bytes) */
+/* Return values: int, C_OK (0) if the connection stays open and C_NOK (-1) if the client asked to stop */
+/* Side effects: may queue a response for the client */
+int handle_client_message(ServerType *server, ConnectionType *connection, const MessageHeaderType *header, const char *payload) {
+
+  switch (header->type) {
+    /* If the message was pause, hold every response queued for this client until it unpauses */
+    case MESSAGE_PAUSE:
+      LOG_DEBUG("Received client request: pause");
+      metrics_count(COUNTER_REQUESTS_CONTROL, 1);
+      connection->thread_is_paused = C_OK;
+      break;
+
+    /* If the message was unpause, let the queued responses go out again */
+    case MESSAGE_UNPAUSE:
+      LOG_DEBUG("Received client request: unpause");
+      metrics_count(COUNTER_REQUESTS_CONTROL, 1);
+      connection->thread_is_paused = C_NOK;
+      break;
+
+    /* If the message was stop, close this client only, other clients keep being served */
+    case MESSAGE_STOP:
+      LOG_DEBUG("Received stop request");
+      metrics_count(COUNTER_REQUESTS_CONTROL, 1);
+      return C_NOK;
+
+    /* If the message was a query, the payload is the pokemon type */
+    case MESSAGE_QUERY:
+      LOG_DEBUG("Received client request: %.*s", (int)header->payload_length, payload);
+      metrics_count(COUNTER_REQUESTS_QUERY, 1);
+      submit_request(server, connection, header->request_id, payload, header->payload_length);
+      break;
+
+    /* The client asks for every pokemon matching a filter query */
+    case MESSAGE_FILTER:
+      LOG_DEBUG("Received client filter: %.*s", (int)header->payload_length, payload);
+      metrics_count(COUNTER_REQUESTS_FILTER, 1);
+      submit_filter_request(server, connection, header->request_id, payload, header->payload_length, server_filter_pokemon);
+      break;
+
+    /* The client asks for the statistics of a stat, computed on the server */
+    case MESSAGE_AGGREGATE:
+      LOG_DEBUG("Received client aggregation: %.*s", (int)header->payload_length, payload);
+      metrics_count(COUNTER_REQUESTS_AGGREGATE, 1);
+      submit_filter_request(server, connection, header->request_id, payload, header->payload_length, server_aggregate_pokemon);
+      break;
+
+    /* The client asks for the counters of the server, they are read right away without a worker thread */
+    case MESSAGE_STATS: {
+      metrics_count(COUNTER_REQUESTS_STATS, 1);
+      int size;
+      char *stats = server_stats(server, &size);
+      queue_owned_message(connection, MESSAGE_STATS_RESULT, header->request_id, stats, size);
+      break;
+    }
+
+    /* The client asks for the counters and stage latencies of every thread, they are added up right away without a worker thread */
+    case MESSAGE_METRICS: {
+      metrics_count(COUNTER_REQUESTS_METRICS, 1);
+      int size;
+      char *metrics = metrics_format(&size);
+      queue_owned_message(connection, MESSAGE_METRICS_RESULT, header->request_id, metrics, size);
+      break;
+    }
+
+    /* The client asks the server to read the pokemon file again, it is answered as soon as the reload is requested */
+    case MESSAGE_RELOAD:
+      LOG_DEBUG("Received client request: reload");
+      metrics_count(COUNTER_REQUESTS_RELOAD, 1);
+      if (start_reload(server) == C_OK) {
+        queue_message(connection, MESSAGE_RELOAD_RESULT, header->request_id, RELOAD_STARTED, strlen(RELOAD_STARTED));
+      }
+      else {
+        queue_message(connection, MESSAGE_RELOAD_RESULT, header->request_id, RELOAD_QUEUED, strlen(RELOAD_QUEUED));
+      }
+      break;
+
+    /* The client inserts, updates or deletes pokemon, it is answered once the changes are logged */
+    case MESSAGE_CHANGE:
+      LOG_DEBUG("Received client changes: %.*s", (int)header->payload_length, payload);
+      metrics_count(COUNTER_REQUESTS_CHANGE, 1);
+      submit_change_request(server, connection, header->request_id, payload, header->payload_length);
+      break;
+
+    /* Tell the client about messages the server doesn't know, instead of closing the connection */
+    default:
+      metrics_count(COUNTER_REQUESTS_UNKNOWN, 1);
+      LOG_WARN("Received unknown message type %d", header->type);
+      queue_message(connection, MESSAGE_ERROR, header->request_id, UNKNOWN_MESSAGE_ERROR, strlen(UNKNOWN_MESSAGE_ERROR));
+      break;
+  }
+  return C_OK;
 }
 
 /* This function checks if a file exists at a specified location  */
@@ -237,172 +677,1012 @@ int file_exists(char *location) {
     return C_OK;
 }
 
-/* This function handles the reading pokemon from a file and then store those pokemon inside a string and then send the information to a client program */
-/* NOTE: This function is primarily copied from the function read_students from ReadCSV.c from the Professor's Sample Code */
-/* Parameters: *arg - input/output (void* casted parameter containing a ServerReadType struct) */
-/* Return values: nothing since the function is void  */
-/* Side effects: uses socket functions to communicate with the server, uses mutex and cond to pause/unpause the thread running this function, uses FileIO functions to read from a file */
-void *server_read_pokemon(void *arg) {
+/* This function reads a pokemon file into a new snapshot that no request uses yet, a binary image made by the converter is mapped instead of parsed */
+/* Parameters: *file_name - input (the name of the pokemon file) */
+/* Return values: TableSnapshotType pointer to the new snapshot, NULL if the file can't be read */
+/* Side effects: allocates memory for the snapshot and its table, exits the program if it can't be allocated */
+TableSnapshotType *load_snapshot(char *file_name) {
+  TableSnapshotType *snapshot = allocate_snapshot();
+  int result = (image_is_file(file_name) == C_OK) ? image_load(&snapshot->table, file_name) : table_load_csv(&snapshot->table, file_name);
+
+  if (result == C_NOK) {
+    free(snapshot);
+    return NULL;
+  }
+  return snapshot;
+}
+
+/* This function allocates a snapshot that no request uses yet, its table is filled by the caller */
+/* Parameters: None */
+/* Return values: TableSnapshotType pointer to the new snapshot */
+/* Side effects: allocates memory for the snapshot, exits the program if it can't be allocated */
+TableSnapshotType *allocate_snapshot(void) {
+  TableSnapshotType *snapshot = (TableSnapshotType *)malloc(sizeof(TableSnapshotType));
 
-  /* Cast the void parameter to a ServerReadType struct */
-  ServerReadType* passed_in = (ServerReadType*)arg;
-  passed_in->boolean_counter = 1; //set the boolean_counter variable to 1 to indicate that the thread is running
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if (snapshot == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  snapshot->number_of_readers = 0;
+  snapshot->is_retired = C_NOK;
+  return snapshot;
+}
 
-  char *pokemon_send_string = NULL;       //String that will contain all the pokemon of a certain type
-  char line[MAX_MESSAGE_BUFFER_SIZE];     //String that will contain a line from the file
-  int num_lines = 0;                      //Variable that will count the number of lines in the file
-  int saved = 0;                          //Variable that will count the number of pokemon of a certain type that exist inside the file
-  int curr_pokemon_index = passed_in->curr_number_of_pokemon_types - 1; //Int that represents the index of the pokemon type that we want to read from the file
+/* This function applies the changes logged since the pokemon file was last written to a snapshot read from the file */
+/* Parameters: *change_log - input/output (the log of the pokemon file), *loaded - input/output (the snapshot read from the pokemon file, freed if the log changes it) */
+/* Return values: TableSnapshotType pointer to the snapshot holding every logged change, loaded itself if the log holds no change */
+/* Side effects: may allocate a new snapshot and free loaded, may truncate or empty the log */
+TableSnapshotType *recover_snapshot(WriteAheadLogType *change_log, TableSnapshotType *loaded) {
+  TableSnapshotType *recovered = allocate_snapshot();
+  int number_of_changes;
 
-  /* Open the file  in read mode */
-  FILE *fp = fopen(passed_in->file_name, "r");
+  if (wal_recover(change_log, &loaded->table, &recovered->table, &number_of_changes) == C_NOK) {
+    free(recovered);
+    return loaded;
+  }
+  LOG_INFO("Applied %d logged changes to %s", number_of_changes, change_log->data_file_name);
+  free_snapshot(loaded);
+  return recovered;
+}
 
-  /* If the file was not able to be opened, print an error message and exit the function */
-  if(fp == NULL) {
-      printf("SERVER ERROR: file failed to open \n");
-      exit(EXIT_FAILURE);
+/* This function adds a reader to a snapshot so it isn't freed while it is used */
+/* Parameters: *snapshot - input/output (the snapshot being used) */
+/* Return values: pointer to the snapshot */
+/* Side effects: only called by the event loop thread, so the count needs no lock */
+TableSnapshotType *acquire_snapshot(TableSnapshotType *snapshot) {
+  snapshot->number_of_readers++;
+  return snapshot;
+}
+
+/* This function removes a reader from a snapshot, freeing the snapshot if it was replaced and this was its last reader */
+/* Parameters: *snapshot - input/output (the snapshot that is not used anymore, can be NULL) */
+/* Return values: nothing since it's a void function */
+/* Side effects: only called by the event loop thread, may free the snapshot */
+void release_snapshot(TableSnapshotType *snapshot) {
+  if (snapshot == NULL) {
+    return;
   }
+  snapshot->number_of_readers--;
+  if (snapshot->number_of_readers == 0 && snapshot->is_retired == C_OK) {
+    free_snapshot(snapshot);
+  }
+}
 
-  /* Lock the mutex */
-  pthread_mutex_lock(&passed_in->lock);
+/* This function frees a snapshot and its table */
+/* Parameters: *snapshot - input/output (the snapshot being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees dynamically allocated data */
+void free_snapshot(TableSnapshotType *snapshot) {
+  table_free(&snapshot->table);
+  free(snapshot);
+}
 
-  /* Loop through every line of the file from top to bottom and save each line into line variable*/
-  while (fscanf(fp, "%[^\n]\n", line) != EOF) {
+/* This function starts watching the directory of the pokemon file, so writing the file or moving a new file over it reloads it. The directory is watched instead of the file since replacing the file gives it a new inode */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: nothing since it's a void function */
+/* Side effects: creates an inotify instance and adds it to the epoll instance, prints a message if the file can't be watched */
+void watch_pokemon_file(ServerType *server) {
+  char *directory = strdup(server->file_name);
+  char *slash = strrchr(directory, '/');
+  const char *watched_directory = ".";
 
-    /* Make the thread idle waiting if the thread_is_paused condition is met */
-    while(passed_in->thread_is_paused == C_OK) {
-      pthread_cond_wait(&passed_in->cond, &passed_in->lock);
+  server->file_base_name = (strrchr(server->file_name, '/') != NULL) ? strrchr(server->file_name, '/') + 1 : server->file_name;
+  if (slash != NULL) {
+    *slash = '\0';
+    watched_directory = (slash == directory) ? "/" : directory;
+  }
+
+  server->inotify_fd = inotify_init1(IN_NONBLOCK);
+  if (server->inotify_fd >= 0 && inotify_add_watch(server->inotify_fd, watched_directory, IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+    struct epoll_event file_event;
+    memset(&file_event, 0, sizeof(file_event));
+    file_event.events = EPOLLIN | EPOLLET;
+    file_event.data.ptr = &server->inotify_fd; // the inotify event is told apart by its address
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->inotify_fd, &file_event) == 0) {
+      free(directory);
+      return;
     }
-    if (num_lines > 0) { /* Skip the header */
-      /* Create a char pointer to store a copy of the line that is being scanned */
-      char *type_check_string = (char *)malloc(strlen(line) + 1);
+  }
 
-      /* Check if memory is allocated properly, print error message and exit if not */
-      if(type_check_string == NULL) {
-            printf("An error occured while allocating memory. The program will now exit \n");
-            exit(EXIT_FAILURE);
+  LOG_WARN("Can't watch %s for changes, send a reload request to read it again", server->file_name);
+  if (server->inotify_fd >= 0) {
+    close(server->inotify_fd);
+  }
+  server->inotify_fd = -1;
+  free(directory);
+}
+
+/* This function reads the change events of the directory of the pokemon file and reloads the file if it was written or replaced */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: nothing since it's a void function */
+/* Side effects: reads the inotify instance until it is empty, may start a reload */
+void handle_file_events(ServerType *server) {
+  char buffer[FILE_EVENTS_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+  char file_changed = C_NOK;
+  ssize_t length;
+
+  /* The inotify instance is edge-triggered so read every event waiting */
+  while ((length = read(server->inotify_fd, buffer, sizeof(buffer))) > 0) {
+    for (char *position = buffer; position < buffer + length; ) {
+      const struct inotify_event *event = (const struct inotify_event *)position;
+      if (event->len > 0 && strcmp(event->name, server->file_base_name) == 0) {
+        file_changed = C_OK;
       }
+      position += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  if (file_changed == C_OK) {
+    LOG_INFO("%s changed, reloading it", server->file_name);
+    start_reload(server);
+  }
+}
+
+/* This function asks the writer thread to read the pokemon file into a new snapshot, so clients keep being answered during the reload */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: int, C_OK (0) if a reload was requested and C_NOK (-1) if one was already waiting, in which case the file is only read once */
+/* Side effects: locks the writer_lock mutex and wakes the writer thread up */
+int start_reload(ServerType *server) {
+  pthread_mutex_lock(&server->writer_lock);
+  int result = (server->reload_requested == C_OK) ? C_NOK : C_OK;
+  server->reload_requested = C_OK;
+  pthread_cond_signal(&server->writer_wakeup);
+  pthread_mutex_unlock(&server->writer_lock);
+  return result;
+}
+
+/* This function is ran by the writer thread, it makes every change to the table one at a time: reloads of the pokemon file and groups of changes sent by clients.
+   Changes that arrive while a group is being logged wait and form the next group, so a burst of change requests is logged with a few fdatasync calls instead of one per request */
+/* Parameters: *arg - input/output (void* casted parameter containing the ServerType struct) */
+/* Return values: nothing since the function returns NULL */
+/* Side effects: locks the writer_lock mutex, builds new snapshots and hands them to the event loop */
+void *run_table_writer(void *arg) {
+  ServerType *server = (ServerType *)arg;
+
+  pthread_mutex_lock(&server->writer_lock);
+  while (1) {
+    while (server->pending_changes == NULL && server->reload_requested == C_NOK && server->writer_stopping == C_NOK) {
+      pthread_cond_wait(&server->writer_wakeup, &server->writer_lock);
+    }
+
+    /* Stop once every change that was sent is handled */
+    if (server->pending_changes == NULL && server->reload_requested == C_NOK) {
+      break;
+    }
+
+    /* Take every waiting change at once, they are logged together */
+    ServerRequestType *requests = server->pending_changes;
+    char reload = server->reload_requested;
+    server->pending_changes = NULL;
+    server->reload_requested = C_NOK;
+    pthread_mutex_unlock(&server->writer_lock);
 
-      /* Copy the line being read to type_check_string variable and null-terminated the copied string*/
-      strcpy(type_check_string, line);
-      type_check_string[strlen(line)] = '\0';
-      
-      /* Check if the type of the pokemon being read matches the one we want to search for*/
-      if(check_pokemon_type(type_check_string, passed_in->pokemon_types_array[curr_pokemon_index], SEPARATOR) == 0) {
-        
-        /* Null-terminate the line */
-        line[strlen(line)] = '\0';
-        /* Check if any pokemon have been saved or not */
-        if (saved == 0)
-        { /* Allocate memory inside pokemon_send_string for the string, the null-terminating character and the separator, '|' */
-          pokemon_send_string = (char *)malloc(sizeof(char) * (strlen(line) + 2)); 
-          /* Check if memory is allocated properly, print error message and exit if not */
-          if(pokemon_send_string == NULL) { 
+    if (reload == C_OK) {
+      reload_table(server);
+    }
+    if (requests != NULL) {
+      apply_changes(server, requests);
+    }
+
+    pthread_mutex_lock(&server->writer_lock);
+  }
+  pthread_mutex_unlock(&server->writer_lock);
+  return NULL;
+}
+
+/* This function reads the pokemon file again along with the changes logged for it, and hands the new snapshot to the event loop. A file that didn't change since it was read or written is not read again */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: nothing since it's a void function */
+/* Side effects: only called by the writer thread, allocates the new snapshot, may empty the change log if the file was replaced */
+void reload_table(ServerType *server) {
+  FileIdentityType identity;
+
+  /* A compaction moves the file it wrote over the pokemon file, which is already the current table */
+  if (wal_identify(server->file_name, &identity) == C_OK && memcmp(&identity, &server->change_log.data_file, sizeof(FileIdentityType)) == 0) {
+    LOG_INFO("%s didn't change since it was last read or written", server->file_name);
+    return;
+  }
+
+  TableSnapshotType *snapshot = load_snapshot(server->file_name);
+  if (snapshot == NULL) {
+    LOG_ERROR("Could not reload %s, still answering with the previous version", server->file_name);
+    return;
+  }
+  server->change_log.data_file = identity;
+  snapshot = recover_snapshot(&server->change_log, snapshot);
+
+  server->writer_snapshot = snapshot;
+  publish_snapshot(server, snapshot, NULL);
+  LOG_INFO("Reloaded %d pokemon from %s", snapshot->table.number_of_rows, server->file_name);
+}
+
+/* This function applies a group of change requests to the newest snapshot, logs every change that can be applied with a single fdatasync, then hands the new snapshot and the answers to the event loop.
+   Every request is applied completely or not at all, a request that can't be applied is answered with an error and doesn't stop the others */
+/* Parameters: *server - input/output (the state shared by every connection), *requests - input/output (the change requests, newest first) */
+/* Return values: nothing since it's a void function */
+/* Side effects: only called by the writer thread, writes the change log, may compact it into the pokemon file, allocates the answer of every request */
+void apply_changes(ServerType *server, ServerRequestType *requests) {
+  WriteAheadLogType *change_log = &server->change_log;
+  MutationBatchType batch;
+  char *log = NULL;         //Every change of the group, written the way they are logged
+  long log_size = 0;        //Amount of bytes inside log
+  long log_capacity = 0;    //Amount of bytes log can hold before it has to grow
+  int number_of_changes = 0;
+  TableSnapshotType *snapshot = NULL;
+
+  /* The list was built newest first, reverse it so changes are applied in the order they were received */
+  ServerRequestType *oldest = NULL;
+  while (requests != NULL) {
+    ServerRequestType *request = requests;
+    requests = request->next_completed;
+    request->next_completed = oldest;
+    oldest = request;
+  }
+
+  mutation_batch_init(&batch, &server->writer_snapshot->table);
+  for (ServerRequestType *request = oldest; request != NULL; request = request->next_completed) {
+    char error[MAX_QUERY_ERROR_SIZE];
+    MutationType *mutations;
+    int number_of_mutations;
+
+    request->response_type = MESSAGE_ERROR;
+    if (change_log->fd < 0) {
+      snprintf(error, sizeof(error), "%s", CHANGE_LOG_UNAVAILABLE);
+    }
+    else if (mutation_parse(request->query, request->query_length, &mutations, &number_of_mutations, error) == C_OK) {
+      if (mutation_batch_apply(&batch, mutations, number_of_mutations, error) == C_OK) {
+        /* Every change is at most its line plus MUTATION_LINE_EXTRA characters once written to the log */
+        if (log_size + request->query_length + (long)number_of_mutations * MUTATION_LINE_EXTRA > log_capacity) {
+          log_capacity = (log_size + request->query_length + (long)number_of_mutations * MUTATION_LINE_EXTRA) * 2;
+          log = (char *)realloc(log, log_capacity);
+          if (log == NULL) {
             printf("An error occured while allocating memory. The program will now exit \n");
             exit(EXIT_FAILURE);
           }
-          strcpy(pokemon_send_string, line); //Copy the line to the pokemon_send_string variable
         }
-        else {
-          /* Re-allocate memory inside pokemon_send_string for the string, the null-terminating character and the separator, '|' */
-          pokemon_send_string = (char *)realloc(pokemon_send_string, sizeof(char) * (strlen(pokemon_send_string) + strlen(line) + 2));
-          /* Check if memory is allocated properly, print error message and exit if not */
-          if(pokemon_send_string == NULL)
-          {
-            printf("An error occured while allocating memory. The program will now exit \n");
-            exit(EXIT_FAILURE);
-          }
-          strcat(pokemon_send_string, line); //Concatenate the line to the pokemon_send_string variable
+        for (int i = 0; i < number_of_mutations; i++) {
+          log_size += mutation_format(&mutations[i], log + log_size);
         }
-        strcat(pokemon_send_string, "|"); //Concatenate the | character to separate the pokemon in the string
-        saved += 1; //Increment the number of pokemon that have been saved by 1
+        number_of_changes += number_of_mutations;
+        request->response_type = MESSAGE_CHANGE_RESULT;
+        request->response_size = number_of_mutations;
       }
-      /* Free the copied string */
-      free(type_check_string); 
+      free(mutations);
+    }
+    if (request->response_type == MESSAGE_ERROR) {
+      request->response = strdup(error);
+      request->response_size = strlen(error);
+    }
+  }
+
+  /* Log the whole group with one fdatasync before any of it becomes visible, then build the new table out of it */
+  if (number_of_changes > 0) {
+    if (wal_append(change_log, log, log_size, number_of_changes) == C_OK) {
+      snapshot = allocate_snapshot();
+      mutation_batch_build(&batch, &snapshot->table);
+      server->writer_snapshot = snapshot;
+    }
+  }
+  mutation_batch_free(&batch);
+  free(log);
+
+  /* Answer every request that was applied, or tell them the log can't be written */
+  for (ServerRequestType *request = oldest; request != NULL; request = request->next_completed) {
+    if (request->response_type != MESSAGE_CHANGE_RESULT) {
+      continue;
+    }
+    if (snapshot == NULL) {
+      request->response_type = MESSAGE_ERROR;
+      request->response = strdup(CHANGE_LOG_UNAVAILABLE);
+      request->response_size = strlen(CHANGE_LOG_UNAVAILABLE);
+      continue;
+    }
+    request->response = (char *)malloc(CHANGE_RESULT_SIZE);
+    if (request->response == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
     }
-    num_lines++; //Increase the num_lines counter by 1
+    request->response_size = snprintf(request->response, CHANGE_RESULT_SIZE, "Applied %d changes, the table now holds %d pokemon \n", request->response_size, snapshot->table.number_of_rows);
+  }
+
+  publish_snapshot(server, snapshot, oldest);
+
+  /* Write the table into the pokemon file once the log is large enough, so the log starts over */
+  if (snapshot != NULL && change_log->compaction_size > 0 && change_log->size >= change_log->compaction_size) {
+    if (wal_compact(change_log, &snapshot->table) == C_OK) {
+      LOG_INFO("Wrote %d pokemon into %s and emptied %s", snapshot->table.number_of_rows, server->file_name, change_log->log_file_name);
+    }
+  }
+}
+
+/* This function hands a snapshot built by the writer thread and the change requests it answered to the event loop */
+/* Parameters: *server - input/output (the state shared by every connection), *snapshot - input/output (the new snapshot, NULL if the table didn't change), *requests - input/output (the answered requests, oldest first, can be NULL) */
+/* Return values: nothing since it's a void function */
+/* Side effects: locks the completed_lock mutex, writes to the wakeup eventfd, frees a previous snapshot the event loop never swapped in */
+void publish_snapshot(ServerType *server, TableSnapshotType *snapshot, ServerRequestType *requests) {
+  TableSnapshotType *skipped = NULL;
+  uint64_t wakeup = 1;
+
+  /* The requests are pushed oldest first, so the event loop reverses them back into the order they were received */
+  pthread_mutex_lock(&server->completed_lock);
+  if (snapshot != NULL) {
+    skipped = server->published_snapshot;
+    server->published_snapshot = snapshot;
+  }
+  while (requests != NULL) {
+    ServerRequestType *request = requests;
+    requests = request->next_completed;
+    request->next_completed = server->completed_requests;
+    server->completed_requests = request;
+  }
+  pthread_mutex_unlock(&server->completed_lock);
+
+  /* A snapshot replaced before the event loop swapped it in was never given to a request */
+  if (skipped != NULL) {
+    free_snapshot(skipped);
+  }
+
+  if (write(server->wakeup_fd, &wakeup, sizeof(wakeup)) < 0) {
+    LOG_ERROR("Failed to wake the event loop up");
   }
-  fclose(fp); //Close the file
+}
+
+/* This function replaces the current snapshot with one built by the writer thread, the previous snapshot is freed once the requests and messages using it are done */
+/* Parameters: *server - input/output (the state shared by every connection), *snapshot - input/output (the new snapshot) */
+/* Return values: nothing since it's a void function */
+/* Side effects: only called by the event loop thread, may free the previous snapshot */
+void swap_snapshot(ServerType *server, TableSnapshotType *snapshot) {
+  TableSnapshotType *previous = server->snapshot;
+
+  server->snapshot = snapshot;
+  previous->is_retired = C_OK;
+  if (previous->number_of_readers == 0) {
+    free_snapshot(previous);
+  }
+}
+
+/* This function takes a request out of the free list, allocating a new one only when the free list is empty */
+/* Parameters: *server - input/output (the state shared by every connection, which owns the free list) */
+/* Return values: ServerRequestType pointer to a request with every field set to zero */
+/* Side effects: may allocate memory, exits the program if it can't be allocated. Only called by the event loop so the free list needs no mutex, the request holds on to the current snapshot until it is released */
+ServerRequestType *allocate_request(ServerType *server) {
+  ServerRequestType *request = server->free_requests;
+
+  if (request != NULL) {
+    server->free_requests = request->next_completed;
+    memset(request, 0, sizeof(ServerRequestType));
+  }
+  else {
+    request = (ServerRequestType *)calloc(1, sizeof(ServerRequestType));
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if (request == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  /* The request runs on the current snapshot until it is finished, even if a reload replaces it meanwhile */
+  request->snapshot = acquire_snapshot(server->snapshot);
+  return request;
+}
+
+/* This function puts a request whose response was queued back into the free list */
+/* Parameters: *server - input/output (the state shared by every connection, which owns the free list), *request - input/output (the request being reused later) */
+/* Return values: nothing since it's a void function */
+/* Side effects: only called by the event loop so the free list needs no mutex, gives the snapshot of the request back */
+void release_request(ServerType *server, ServerRequestType *request) {
+  release_snapshot(request->snapshot);
+  request->snapshot = NULL;
+  request->next_completed = server->free_requests;
+  server->free_requests = request;
+}
+
+/* This function hands a pokemon type request of a client over to the worker threads */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client that asked for the type), request_id - input (the id the client gave the request), *pokemon_type - input (the type the client asked for, not null-terminated), length - input (the amount of characters inside pokemon_type) */
+/* Return values: nothing since it's a void function */
+/* Side effects: takes a ServerRequestType from the free list which goes back to it once its response is queued */
+void submit_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *pokemon_type, int length) {
+
+  ServerRequestType *request = allocate_request(server);
+  request->server = server;
+  request->connection = connection;
+  request->request_id = request_id;
+  request->received_at = metrics_now();
+  if (length > MAX_MESSAGE_BUFFER_SIZE - 1) {
+    length = MAX_MESSAGE_BUFFER_SIZE - 1;
+  }
+  memcpy(request->pokemon_type, pokemon_type, length);
+  request->pokemon_type[length] = '\0';
+
+  /* Count the request so the connection is not freed while a worker thread still points to it */
+  connection->number_of_pending_requests++;
+
+  worker_pool_submit(&server->pool, server_read_pokemon, request);
+}
+
+/* This function prepares a request whose payload is text, a filter query, an aggregation or a change request */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client that sent the request), request_id - input (the id the client gave the request), *text - input (the text of the request, not null-terminated), length - input (the amount of characters inside text) */
+/* Return values: ServerRequestType pointer to the request holding a copy of the text */
+/* Side effects: takes a ServerRequestType from the free list and allocates a copy of the text, both are released once its response is queued, counts the request as pending for the connection */
+ServerRequestType *allocate_text_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *text, int length) {
+
+  ServerRequestType *request = allocate_request(server);
+  request->server = server;
+  request->connection = connection;
+  request->request_id = request_id;
+  request->received_at = metrics_now();
+  request->query = (char *)malloc(length + 1);
 
-  /* Reallocate space in pokemon_send_string for a null-terminating character */
-  pokemon_send_string = (char *)realloc(pokemon_send_string, sizeof(char) * (strlen(pokemon_send_string) + 1));
   /* Check if memory is allocated properly, print error message and exit if not */
-  if (pokemon_send_string == NULL)
-  {
+  if (request->query == NULL) {
     printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
-  /* Add the null-terminating character to the end of the string */
-  pokemon_send_string[strlen(pokemon_send_string)] = '\0';
+  memcpy(request->query, text, length);
+  request->query[length] = '\0';
+  request->query_length = length;
 
-  char pokemon_send_string_size[MAX_MESSAGE_BUFFER_SIZE];     //String that will contain the amount of bytes of the pokemon_send_string variable
-  char number_of_pokemon_send_string[MAX_MESSAGE_BUFFER_SIZE]; //String that will contain the number of pokemon that have been saved
+  connection->number_of_pending_requests++;
+  return request;
+}
 
-  /* Convert the size of the pokemon_send_string into a string and store inside pokemon_send_string_size */
-  sprintf(pokemon_send_string_size, "%ld", strlen(pokemon_send_string));
-  pokemon_send_string_size[strlen(pokemon_send_string_size)] = '\0'; //Null-terminate the string
+/* This function hands a filter query or an aggregation request of a client over to the worker threads */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client that sent the query), request_id - input (the id the client gave the request), *query - input (the text of the query, not null-terminated), length - input (the amount of characters inside query), function - input (server_filter_pokemon or server_aggregate_pokemon, ran by a worker thread) */
+/* Return values: nothing since it's a void function */
+/* Side effects: takes a ServerRequestType from the free list and allocates a copy of the query, both are released once its response is queued */
+void submit_filter_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *query, int length, WorkFunctionType function) {
+  ServerRequestType *request = allocate_text_request(server, connection, request_id, query, length);
+  worker_pool_submit(&server->pool, function, request);
+}
+
+/* This function hands a change request of a client over to the writer thread, which logs it along with every other change waiting */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client that sent the changes), request_id - input (the id the client gave the request), *changes - input (the text of the changes, not null-terminated), length - input (the amount of characters inside changes) */
+/* Return values: nothing since it's a void function */
+/* Side effects: takes a ServerRequestType from the free list and allocates a copy of the changes, locks the writer_lock mutex and wakes the writer thread up */
+void submit_change_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *changes, int length) {
+  ServerRequestType *request = allocate_text_request(server, connection, request_id, changes, length);
+
+  pthread_mutex_lock(&server->writer_lock);
+  request->next_completed = server->pending_changes;
+  server->pending_changes = request;
+  pthread_cond_signal(&server->writer_wakeup);
+  pthread_mutex_unlock(&server->writer_lock);
+}
+
+/* This function is ran by a worker thread, it looks up the pokemon of a certain type inside the type index of the in-memory table */
+/* Parameters: *arg - input/output (void* casted parameter containing a ServerRequestType struct) */
+/* Return values: nothing since the function is void  */
+/* Side effects: hands the request back to the event loop, never touches the client socket */
+void server_read_pokemon(void *arg) {
 
-  /* Convert the number of pokemon that have been saved into a string and store inside number_of_pokemon_send_string */
-  sprintf(number_of_pokemon_send_string, "%d", saved);
-  number_of_pokemon_send_string[strlen(number_of_pokemon_send_string)] = '\0'; //Null-terminate the string
+  /* Cast the void parameter to a ServerRequestType struct */
+  ServerRequestType *request = (ServerRequestType *)arg;
+  int64_t started_at = metrics_record_since(STAGE_QUEUE, request->received_at);
 
-  /* Make the thread idle waiting if the thread_is_paused condition is met */
-  while(passed_in->thread_is_paused == C_OK) {
-    pthread_cond_wait(&passed_in->cond, &passed_in->lock);
+  /* Look the type up inside the type index, every response was already serialized when the file was loaded */
+  request->entry = table_find_type(&request->snapshot->table, request->pokemon_type);
+  metrics_record_since(STAGE_QUERY, started_at);
+
+  complete_request(request);
+}
+
+/* This function is ran by a worker thread, it parses a filter query, scans the columns of the table for the rows matching it and serializes them */
+/* Parameters: *arg - input/output (void* casted parameter containing a ServerRequestType struct) */
+/* Return values: nothing since the function is void  */
+/* Side effects: allocates the response of the request, hands the request back to the event loop, never touches the client socket */
+void server_filter_pokemon(void *arg) {
+
+  /* Cast the void parameter to a ServerRequestType struct */
+  ServerRequestType *request = (ServerRequestType *)arg;
+  const PokemonTableType *table = &request->snapshot->table;
+  char error[MAX_QUERY_ERROR_SIZE];
+  QueryType query;
+  int key_length;
+  int64_t started_at = metrics_record_since(STAGE_QUEUE, request->received_at);
+
+  /* An identical query over the same table is answered with a copy of the response kept inside the cache */
+  char *key = server_cache_key(request, MESSAGE_FILTER, &key_length);
+  request->response = result_cache_lookup(&request->server->result_cache, key, key_length, &request->response_type, &request->response_size);
+
+  if (request->response == NULL) {
+    /* A query that can't be parsed is answered with an error describing the problem */
+    int parse_result = query_parse(table, request->query, request->query_length, &query, error);
+    started_at = metrics_record_since(STAGE_PARSE, started_at);
+    if (parse_result == C_NOK) {
+      request->response_type = MESSAGE_ERROR;
+      request->response_size = strlen(error);
+      request->response = strdup(error);
+    }
+    else {
+      uint64_t *bitmap = (uint64_t *)malloc(sizeof(uint64_t) * (bitmap_words(table->number_of_rows) + 1));
+      if (bitmap == NULL) {
+        printf("An error occured while allocating memory. The program will now exit \n");
+        exit(EXIT_FAILURE);
+      }
+      int number_of_matches = query_execute(table, &query, bitmap);
+      request->response_type = MESSAGE_RESULT;
+
+      /* Queries with an order or a limit put the matching rows in a list first, the others serialize straight from the bitmap */
+      if (query.sort_column != QUERY_NO_SORT || query.limit != QUERY_NO_LIMIT) {
+        int *rows = (int *)malloc(sizeof(int) * (number_of_matches + 1));
+        if (rows == NULL) {
+          printf("An error occured while allocating memory. The program will now exit \n");
+          exit(EXIT_FAILURE);
+        }
+        int number_of_rows = query_order(table, &query, bitmap, number_of_matches, rows);
+        started_at = metrics_record_since(STAGE_QUERY, started_at);
+        request->response = query_serialize_rows(table, rows, number_of_rows, &request->response_size);
+        free(rows);
+      }
+      else {
+        started_at = metrics_record_since(STAGE_QUERY, started_at);
+        request->response = query_serialize(table, bitmap, number_of_matches, &request->response_size);
+      }
+      metrics_record_since(STAGE_SERIALIZE, started_at);
+      free(bitmap);
+      result_cache_store(&request->server->result_cache, key, key_length, request->response_type, request->response, request->response_size);
+    }
   }
-  /* Send the size of the pokemon_send_string variable to the client and check whether it was sent successfully */
-  if(send(passed_in->client_socket, pokemon_send_string_size, strlen(pokemon_send_string_size), 0) == -1) {
-    printf("SERVER ERROR: failed to send message bytes to client \n");
+  free(key);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if (request->response == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
 
-  sleep(0.25); //Make the thread sleep for 0.25 seconds to stop the messages from being sent too fast and corrupting
+  complete_request(request);
+}
+
+/* This function is ran by a worker thread, it parses an aggregation request and computes the statistics of every group, or copies them from the cache if they were already computed over this table */
+/* Parameters: *arg - input/output (void* casted parameter containing a ServerRequestType struct) */
+/* Return values: nothing since the function is void  */
+/* Side effects: allocates the response of the request, may add it to the result cache, hands the request back to the event loop, never touches the client socket */
+void server_aggregate_pokemon(void *arg) {
+
+  /* Cast the void parameter to a ServerRequestType struct */
+  ServerRequestType *request = (ServerRequestType *)arg;
+  ServerType *server = request->server;
+  const PokemonTableType *table = &request->snapshot->table;
+  char error[MAX_QUERY_ERROR_SIZE];
+  AggregateType aggregate;
+  int key_length;
+  int64_t started_at = metrics_record_since(STAGE_QUEUE, request->received_at);
 
-  /* Send the string containing the pokemon read from the file to the client and check whether it was sent sucessfully */
-  if(send(passed_in->client_socket, pokemon_send_string, strlen(pokemon_send_string), 0) == -1) {
-    printf("SERVER ERROR: failed to send message to client \n");
+  /* An identical request over the same table is answered with a copy of the statistics kept inside the cache */
+  char *key = server_cache_key(request, MESSAGE_AGGREGATE, &key_length);
+  request->response = result_cache_lookup(&server->result_cache, key, key_length, &request->response_type, &request->response_size);
+
+  if (request->response == NULL) {
+    /* A request that can't be parsed is answered with an error describing the problem */
+    int parse_result = aggregate_parse(table, request->query, request->query_length, &aggregate, error);
+    started_at = metrics_record_since(STAGE_PARSE, started_at);
+    if (parse_result == C_NOK) {
+      request->response_type = MESSAGE_ERROR;
+      request->response_size = strlen(error);
+      request->response = strdup(error);
+    }
+    else {
+      request->response_type = MESSAGE_AGGREGATE_RESULT;
+      /* The statistics are computed and written in one pass, so their time is counted as querying */
+      request->response = aggregate_run(table, &aggregate, &request->response_size);
+      metrics_record_since(STAGE_QUERY, started_at);
+      result_cache_store(&server->result_cache, key, key_length, request->response_type, request->response, request->response_size);
+    }
+  }
+  free(key);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if (request->response == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  complete_request(request);
+}
+
+/* This function builds the key a filter query or an aggregation request is cached with, the version of the table and the type of the request followed by the normalized text */
+/* Parameters: *request - input (the request being cached), message_type - input (MESSAGE_FILTER or MESSAGE_AGGREGATE), *key_length - output (the amount of characters inside the key) */
+/* Return values: char pointer to the key (not null-terminated), which must be freed by the caller */
+/* Side effects: allocates memory for the key, exits the program if it can't be allocated */
+char *server_cache_key(const ServerRequestType *request, int message_type, int *key_length) {
+  char *key = (char *)malloc(CACHE_KEY_PREFIX_SIZE + request->query_length);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if (key == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
 
-  /* Send the string containing the number of pokemon saved to the client and check whether it was sent sucessfully */
-  if(send(passed_in->client_socket, number_of_pokemon_send_string, strlen(number_of_pokemon_send_string), 0) == -1) {
-    printf("SERVER ERROR: failed to send message to client \n");
+  /* Responses computed over another table never match since the version is part of the key */
+  *key_length = snprintf(key, CACHE_KEY_PREFIX_SIZE, "%ld:%d:", request->snapshot->table.version, message_type);
+  *key_length += query_normalize(request->query, request->query_length, key + *key_length);
+  return key;
+}
+
+/* This function writes the counters of the server as text, one "name value" line per counter */
+/* Parameters: *server - input/output (the state shared by every connection), *size - output (the amount of characters inside the text) */
+/* Return values: char pointer to the text (not null-terminated), which must be freed by the caller */
+/* Side effects: locks every shard of the result cache one at a time, reads the counters of the change log written by the writer thread, allocates memory for the text */
+char *server_stats(ServerType *server, int *size) {
+  ResultCacheStatsType cache;
+  char *stats = (char *)malloc(MAX_STATS_SIZE);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if (stats == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
     exit(EXIT_FAILURE);
   }
 
-  /* Unlock the mutex */
-  pthread_mutex_unlock(&passed_in->lock);
-  free(pokemon_send_string); //Free the memory allocated to the pokemon_send_string variable
+  result_cache_stats(&server->result_cache, &cache);
+  long lookups = cache.hits + cache.misses;
+  *size = snprintf(stats, MAX_STATS_SIZE,
+                   "connections %d\n"
+                   "table_version %ld\n"
+                   "pokemon %d\n"
+                   "cache_hits %ld\n"
+                   "cache_misses %ld\n"
+                   "cache_hit_rate %.4f\n"
+                   "cache_evictions %ld\n"
+                   "cache_entries %ld\n"
+                   "cache_bytes %ld\n"
+                   "cache_capacity_bytes %ld\n"
+                   "changes %ld\n"
+                   "change_commits %ld\n"
+                   "change_log_bytes %ld\n"
+                   "compactions %ld\n",
+                   server->number_of_connections, server->snapshot->table.version, server->snapshot->table.number_of_rows, cache.hits, cache.misses, (lookups > 0) ? (double)cache.hits / lookups : 0.0,
+                   cache.evictions, cache.entries, cache.bytes, cache.capacity,
+                   __atomic_load_n(&server->change_log.changes, __ATOMIC_RELAXED), __atomic_load_n(&server->change_log.commits, __ATOMIC_RELAXED),
+                   __atomic_load_n(&server->change_log.bytes_written, __ATOMIC_RELAXED), __atomic_load_n(&server->change_log.compactions, __ATOMIC_RELAXED));
+  return stats;
+}
+
+/* This function hands a request finished by a worker thread back to the event loop */
+/* Parameters: *request - input/output (the finished request) */
+/* Return values: nothing since it's a void function */
+/* Side effects: locks the completed_lock mutex, writes to the wakeup eventfd */
+void complete_request(ServerRequestType *request) {
+  ServerType *server = request->server;
+  uint64_t wakeup = 1;
+
+  pthread_mutex_lock(&server->completed_lock);
+  request->next_completed = server->completed_requests;
+  server->completed_requests = request;
+  pthread_mutex_unlock(&server->completed_lock);
+
+  /* Wake the event loop up, the eventfd adds up every write so nothing is lost if it is already awake */
+  if (write(server->wakeup_fd, &wakeup, sizeof(wakeup)) < 0) {
+    LOG_ERROR("Failed to wake the event loop up");
+  }
+}
+
+/* This function queues the responses of every request finished by the worker threads as soon as they are finished, the client matches them to its requests by request id */
+/* Parameters: *server - input/output (the state shared by every connection) */
+/* Return values: nothing since it's a void function */
+/* Side effects: reads the wakeup eventfd, puts finished requests back into the free list, frees connections that were closed while they ran, swaps in the snapshot built by the writer thread */
+void handle_completed_requests(ServerType *server) {
+  uint64_t wakeups;
+
+  /* Reset the eventfd, it is edge-triggered so it only wakes the loop again after a new write */
+  while (read(server->wakeup_fd, &wakeups, sizeof(wakeups)) > 0) {
+  }
+
+  /* Take every finished request at once so the worker threads are blocked as briefly as possible */
+  pthread_mutex_lock(&server->completed_lock);
+  ServerRequestType *completed = server->completed_requests;
+  server->completed_requests = NULL;
+  TableSnapshotType *published_snapshot = server->published_snapshot;
+  server->published_snapshot = NULL;
+  pthread_mutex_unlock(&server->completed_lock);
+
+  /* Swap the snapshot built by the writer thread in before answering the changes it holds, so a client that was told about a change always sees it */
+  if (published_snapshot != NULL) {
+    swap_snapshot(server, published_snapshot);
+  }
+
+  /* The list was built newest first, reverse it so requests that finished first are answered first */
+  ServerRequestType *oldest = NULL;
+  while (completed != NULL) {
+    ServerRequestType *request = completed;
+    completed = request->next_completed;
+    request->next_completed = oldest;
+    oldest = request;
+  }
+
+  /* Queue the response of every finished request and list each client they belong to only once */
+  ConnectionType *ready = NULL;
+  while (oldest != NULL) {
+    ServerRequestType *request = oldest;
+    ConnectionType *connection = request->connection;
+    oldest = request->next_completed;
+
+    queue_response(connection, request);
+    if (connection->is_closed == C_NOK && connection->output_queue_size > 0) {
+      /* The last message queued for the request tells flush_connection when the request was read, once it is fully sent */
+      OutputMessageType *message = &connection->output_queue[connection->output_queue_size - 1];
+      message->received_at = request->received_at;
+      message->queued_at = metrics_now();
+    }
+    connection->number_of_pending_requests--;
+    release_request(server, request);
+
+    if (connection->is_ready == C_NOK) {
+      connection->is_ready = C_OK;
+      connection->next_ready = ready;
+      ready = connection;
+    }
+  }
+
+  while (ready != NULL) {
+    ConnectionType *connection = ready;
+    ready = connection->next_ready;
+    connection->is_ready = C_NOK;
+
+    /* A client that disconnected is freed once its last request is finished */
+    if (connection->is_closed == C_OK) {
+      if (connection->number_of_pending_requests == 0) {
+        release_connection(server, connection);
+      }
+    }
+    else if (flush_connection(connection) == C_NOK || resume_connection(server, connection) == C_NOK) {
+      close_connection(server, connection);
+    }
+  }
+}
+
+/* This function queues the response of a request finished by a worker thread, unless its client disconnected */
+/* Parameters: *connection - input/output (the client that sent the request), *request - input/output (the finished request) */
+/* Return values: nothing since it's a void function */
+/* Side effects: hands the response of a filter query or an aggregation over to the output queue, frees it and the query if the client is gone */
+void queue_response(ConnectionType *connection, ServerRequestType *request) {
+
+  /* A filter query or an aggregation owns its response, the output queue frees it once it is sent */
+  if (request->query != NULL) {
+    free(request->query);
+    if (connection->is_closed == C_NOK && request->response_type == MESSAGE_RESULT) {
+      queue_result(connection, request->request_id, request->response, request->response_size)->owned_data = request->response;
+    }
+    else if (connection->is_closed == C_NOK) {
+      queue_owned_message(connection, request->response_type, request->request_id, request->response, request->response_size);
+    }
+    else {
+      free(request->response);
+    }
+    return;
+  }
+
+  /* Queue the result serialized for the type, or an empty result if no pokemon has the type */
+  if (connection->is_closed == C_NOK) {
+    if (request->entry != NULL) {
+      /* The payload points into the table, keep its snapshot alive until the message is sent */
+      queue_result(connection, request->request_id, request->entry->response, request->entry->response_size)->snapshot = acquire_snapshot(request->snapshot);
+    }
+    else {
+      queue_message(connection, MESSAGE_RESULT, request->request_id, EMPTY_RESULT, RESULT_COUNT_SIZE);
+    }
+  }
+}
+
+/* This function queues a result, split into batches of at most RESULT_BATCH_ROWS pokemon so the client can store the first pokemon of a large result while the rest of it is still being sent and never has to hold the whole payload at once. Every batch points into the result and gets its own pokemon count after its header, nothing is copied */
+/* Parameters: *connection - input/output (the client the result is for), request_id - input (the id of the request the result answers), *data - input (the whole result, the pokemon count followed by every pokemon line ending with '|', it must stay valid until the last batch is sent), size - input (the amount of bytes inside data) */
+/* Return values: OutputMessageType pointer to the last batch, which frees or releases the result once it is sent */
+/* Side effects: may reallocate the output queue of the client */
+OutputMessageType *queue_result(ConnectionType *connection, unsigned int request_id, const char *data, int size) {
+
+  /* A result small enough for one batch is sent as it is */
+  if (size < RESULT_COUNT_SIZE || protocol_read_count((const unsigned char *)data) <= RESULT_BATCH_ROWS) {
+    queue_message(connection, MESSAGE_RESULT, request_id, data, size);
+    return &connection->output_queue[connection->output_queue_size - 1];
+  }
+
+  const char *end = data + size;
+  const char *batch = data + RESULT_COUNT_SIZE;
+  OutputMessageType *message;
+  MessageHeaderType header;
+
+  do {
+    /* Find where the batch ends by moving past RESULT_BATCH_ROWS pokemon lines */
+    const char *batch_end = batch;
+    unsigned int number_of_rows = 0;
+    while (number_of_rows < RESULT_BATCH_ROWS && batch_end < end) {
+      const char *separator = memchr(batch_end, '|', end - batch_end);
+      batch_end = (separator != NULL) ? separator + 1 : end;
+      number_of_rows++;
+    }
+
+    queue_message(connection, MESSAGE_RESULT, request_id, batch, batch_end - batch);
+    message = &connection->output_queue[connection->output_queue_size - 1];
 
-  passed_in->boolean_counter = 0; //Set the boolean_counter to 0 to indicate that the thread is done running
+    /* Write the header again with the count of the batch after it, flagged if more batches follow */
+    header.version = PROTOCOL_VERSION;
+    header.type = MESSAGE_RESULT;
+    header.flags = (batch_end < end) ? RESULT_FLAG_MORE : 0;
+    header.request_id = request_id;
+    header.payload_length = RESULT_COUNT_SIZE + (batch_end - batch);
+    protocol_write_header(message->header, &header);
+    protocol_write_count(message->header + PROTOCOL_HEADER_SIZE, number_of_rows);
+    message->header_size = PROTOCOL_HEADER_SIZE + RESULT_COUNT_SIZE;
+    connection->queued_bytes += RESULT_COUNT_SIZE;
+    batch = batch_end;
+  } while (batch < end);
 
-  pthread_exit(NULL); //Exit the thread
+  return message;
 }
 
-/* This function checks if a pokemon's type matches with a type inputted by the user */
-/* Parameters: *data_line - input (line that information is being parsed from), *ideal_type - input (the pokemon type we want to compare with), *separator - input (the character that separates the infomration in the file) */
-/* Return values: int, C_OK (0) if the two types match and C_NOK (-1) if the two types do not match  */
-/* Side effects: uses void casting to remove warning about unused variables, use strsep which modify the input string*/
-int check_pokemon_type(char* data_line, char* ideal_type, char *separator) {
+/* This function adds a message to the end of the output queue of a client */
+/* Parameters: *connection - input/output (the client the message is for), type - input (the type of the message), request_id - input (the id of the request the message answers), *data - input (the payload of the message, it must stay valid until the message is sent), size - input (the amount of bytes inside the payload) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may reallocate the output queue of the client */
+void queue_message(ConnectionType *connection, int type, unsigned int request_id, const char *data, int size) {
 
-  /* Uses the strsep function twice to get to the information containing the pokemon's type in the data_line string, the variables are not used at all though */
-  char *garbage_number = strsep(&data_line, separator);
-  char *garbage_name = strsep(&data_line, separator);
+  /* Move the unsent messages back to the front of the queue before growing it */
+  if(connection->output_queue_size == connection->output_queue_capacity && connection->output_queue_head > 0) {
+    memmove(connection->output_queue, connection->output_queue + connection->output_queue_head, sizeof(OutputMessageType) * (connection->output_queue_size - connection->output_queue_head));
+    connection->output_queue_size -= connection->output_queue_head;
+    connection->output_queue_head = 0;
+  }
 
-  /* Void cast the functions to get rid of unused variable warning */
-  (void)garbage_name;
-  (void)garbage_number;
+  /* Double the size of the queue if it is still full */
+  if(connection->output_queue_size == connection->output_queue_capacity) {
+    int capacity = (connection->output_queue_capacity > 0) ? connection->output_queue_capacity * 2 : OUTPUT_QUEUE_INITIAL_SIZE;
+    OutputMessageType *queue = (OutputMessageType *)realloc(connection->output_queue, sizeof(OutputMessageType) * capacity);
 
-  /* Get the pokemon type in the string from the file */
-  char *pokemon_type = strsep(&data_line, separator); 
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if(queue == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+    connection->output_queue = queue;
+    connection->output_queue_capacity = capacity;
+  }
+
+  OutputMessageType *message = &connection->output_queue[connection->output_queue_size++];
+  MessageHeaderType header;
+  header.version = PROTOCOL_VERSION;
+  header.type = type;
+  header.flags = 0;
+  header.request_id = request_id;
+  header.payload_length = size;
+  protocol_write_header(message->header, &header);
+  message->header_size = PROTOCOL_HEADER_SIZE;
+  message->data = data;
+  message->size = size;
+  message->sent = 0;
+  connection->queued_bytes += PROTOCOL_HEADER_SIZE + size;
+  message->owned_data = NULL;
+  message->snapshot = NULL;
+  message->received_at = 0;
+  message->queued_at = 0;
+}
 
-  /* Use strcmp to see if the two Pokemon types match, return C_OK (0) if they do match, return C_NOK (-1) if they don't match */
-  if(strcmp(pokemon_type, ideal_type) == 0) {
+/* This function adds a message whose payload was built for it alone to the end of the output queue of a client */
+/* Parameters: *connection - input/output (the client the message is for), type - input (the type of the message), request_id - input (the id of the request the message answers), *data - input (the payload of the message, allocated with malloc), size - input (the amount of bytes inside the payload) */
+/* Return values: nothing since it's a void function */
+/* Side effects: the output queue takes ownership of data and frees it once the message is sent */
+void queue_owned_message(ConnectionType *connection, int type, unsigned int request_id, char *data, int size) {
+  queue_message(connection, type, request_id, data, size);
+  connection->output_queue[connection->output_queue_size - 1].owned_data = data;
+}
+
+/* This function sends as much of the output queue of a client as its socket accepts without blocking */
+/* Parameters: *connection - input/output (the client being sent to) */
+/* Return values: int, C_OK (0) if the connection stays open and C_NOK (-1) if sending failed */
+/* Side effects: writes to the client socket, nothing is sent while the client is paused */
+int flush_connection(ConnectionType *connection) {
+
+  /* Responses stay queued while the client is paused */
+  if(connection->thread_is_paused == C_OK) {
     return C_OK;
   }
-  else {
-    return C_NOK;
+
+  while(connection->output_queue_head < connection->output_queue_size) {
+    struct iovec vectors[MAX_WRITE_VECTORS];
+    int number_of_vectors = 0;
+
+    /* Point at the unsent part of the header and of the payload of as many queued messages as fit, nothing is copied */
+    for(int i = connection->output_queue_head; i < connection->output_queue_size && number_of_vectors + 2 <= MAX_WRITE_VECTORS; i++) {
+      OutputMessageType *message = &connection->output_queue[i];
+      if(message->sent < message->header_size) {
+        vectors[number_of_vectors].iov_base = message->header + message->sent;
+        vectors[number_of_vectors].iov_len = message->header_size - message->sent;
+        number_of_vectors++;
+      }
+      if(message->size > 0) {
+        int payload_sent = (message->sent > message->header_size) ? message->sent - message->header_size : 0;
+        vectors[number_of_vectors].iov_base = (void *)(message->data + payload_sent);
+        vectors[number_of_vectors].iov_len = message->size - payload_sent;
+        number_of_vectors++;
+      }
+    }
+
+    ssize_t bytes_sent = writev(connection->client_socket, vectors, number_of_vectors);
+    if(bytes_sent < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      /* The socket is full, epoll tells us when it has room again */
+      if(errno == EAGAIN || errno == EWOULDBLOCK) {
+        return C_OK;
+      }
+      LOG_ERROR("Failed to send message to client");
+      return C_NOK;
+    }
+
+    /* Move past every message that was fully sent and remember how far the last one got */
+    connection->queued_bytes -= bytes_sent;
+    metrics_count(COUNTER_BYTES_SENT, bytes_sent);
+    while(bytes_sent > 0) {
+      OutputMessageType *message = &connection->output_queue[connection->output_queue_head];
+      int remaining = message->header_size + message->size - message->sent;
+      if(bytes_sent < remaining) {
+        message->sent += bytes_sent;
+        break;
+      }
+      bytes_sent -= remaining;
+      if(message->queued_at != 0) {
+        int64_t now = metrics_record_since(STAGE_SEND, message->queued_at);
+        metrics_record(STAGE_REQUEST, now - message->received_at);
+      }
+      free(message->owned_data);
+      release_snapshot(message->snapshot);
+      connection->output_queue_head++;
+    }
+  }
+
+  /* Every message was sent, start the queue over from the front */
+  connection->output_queue_head = 0;
+  connection->output_queue_size = 0;
+  return C_OK;
+}
+
+/* This function disconnects a client and frees everything the server kept for it */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the client being closed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: closes the client socket once even if it is called again, hands the connection over to be freed after the current events unless worker threads are still running its requests */
+void close_connection(ServerType *server, ConnectionType *connection) {
+
+  /* The socket may already be closed and its number reused by another client */
+  if (connection->is_closed == C_OK) {
+    return;
+  }
+  epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->client_socket, NULL);
+  close(connection->client_socket);
+  server->number_of_connections--;
+  LOG_INFO("Client disconnected.");
+
+  /* Requests still being ran point to the connection, so it is freed once the last of them is finished */
+  connection->is_closed = C_OK;
+  if (connection->number_of_pending_requests == 0) {
+    release_connection(server, connection);
+  }
+}
+
+/* This function hands a closed client with no request left over to the event loop, which frees it once every event of the current epoll_wait is handled */
+/* Parameters: *server - input/output (the state shared by every connection), *connection - input/output (the closed client) */
+/* Return values: nothing since it's a void function */
+/* Side effects: adds the client to freed_connections */
+void release_connection(ServerType *server, ConnectionType *connection) {
+  connection->next_freed = server->freed_connections;
+  server->freed_connections = connection;
+}
+
+/* This function frees the memory the server kept for a client */
+/* Parameters: *connection - input/output (the client being freed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: frees dynamically allocated data */
+void free_connection(ConnectionType *connection) {
+
+  /* Free the payloads of the messages that were never sent */
+  for(int i = connection->output_queue_head; i < connection->output_queue_size; i++) {
+    free(connection->output_queue[i].owned_data);
+    release_snapshot(connection->output_queue[i].snapshot);
   }
+  free(connection->input);
+  free(connection->output_queue);
+  free(connection);
 }
 
 /* This function frees data in a char pointer if it contains any dynamically allocated data */
@@ -17,31 +17,173 @@
 #include <stdio.h>
 #include <pthread.h>
 
+//importing the header files for the protocol, the in-memory pokemon table and the worker threads
+#include "protocol.h"
+#include "pokemon_table.h"
+#include "worker_pool.h"
+#include "query.h"
+#include "aggregate.h"
+#include "result_cache.h"
+#include "mutation.h"
+#include "wal.h"
+#include "table_image.h"
+#include "metrics.h"
+#include "logger.h"
+
 //Variety of constants defined
-#define C_NOK -1                      //Constant to represent an error/not correct value
-#define C_OK 0                        //Constant to represent a correct return value
 #define SEPARATOR ","                 //Constant to represent a separator between values inside a file
-#define SERVER_IP "127.0.0.1"         //Constant to represent the IP address the client will connect to
-#define SERVER_PORT 6000              //Constant to represent the port that the client will connect to
-#define MAX_MESSAGE_BUFFER_SIZE 100   //Constant to represent the largest message that can be sent to the server without forewarning
-
-/* This is a structure that contains all the information that is needed to read pokemon information from the specified file, manipulate the reading thread and to store pokemon as a string. */
-typedef struct ServerRead {
-  char *file_name;                  //Name of the file that contains the pokemon information
-  char boolean_counter;             //Boolean counter to determine whether the thread is running or not
-  char **pokemon_types_array;       //Double pointer containing all the pokemon types that will be and has been read from the file
-  char thread_is_paused;            //Char representing whether the thread is paused or not
+#define MAX_MESSAGE_BUFFER_SIZE 100   //Constant to represent the longest pokemon type a client can ask for
+#define INPUT_BUFFER_INITIAL_SIZE 4096 //Constant to represent the amount of bytes a connection can buffer before its input buffer has to grow
+#define EMPTY_RESULT "\0\0\0\0"      //Constant to represent the payload of a result without any pokemon, a count of zero
+#define UNKNOWN_MESSAGE_ERROR "Unknown message type" //Constant to represent the error sent back for a message the server doesn't know
+#define MAX_EPOLL_EVENTS 256          //Constant to represent the amount of events handled by one call to epoll_wait
+#define OUTPUT_QUEUE_INITIAL_SIZE 8   //Constant to represent the amount of messages a connection can queue before its output queue has to grow
+#define MAX_WRITE_VECTORS 64          //Constant to represent the amount of buffers handed to one call to writev, two per message
+#define CACHE_KEY_PREFIX_SIZE 32      //Constant to represent the longest prefix written in front of a normalized request to make its cache key
+#define MAX_STATS_SIZE 1024           //Constant to represent the longest text answering a stats request
+#define FILE_EVENTS_BUFFER_SIZE 4096  //Constant to represent the amount of bytes of file change events read at once
+#define RELOAD_STARTED "Reloading the pokemon file, new requests use it once it is loaded\n" //Constant to represent the answer to a reload request that started a reload
+#define RELOAD_QUEUED "A reload is already waiting to run, the pokemon file will be read once\n" //Constant to represent the answer to a reload request received while another one is waiting
+#define MAX_QUEUED_BYTES_PER_CONNECTION (16 * 1024 * 1024) //Constant to represent the most bytes of responses one client can leave unsent, because it is paused or reads slowly, before the server stops reading its requests
+#define MAX_THROTTLED_INPUT_SIZE (4 * MAX_REQUEST_PAYLOAD_SIZE) //Constant to represent the most bytes the server buffers from a client whose requests are not read, so its pause and unpause messages can still be found
+#define CHANGE_RESULT_SIZE 128        //Constant to represent the longest text answering a change request
+#define CHANGE_LOG_UNAVAILABLE "The change log can't be written, so pokemon can't be changed" //Constant to represent the error sent back for a change request when the change log can't be opened or written
+
+/* This structure contains one version of the pokemon table. A snapshot never changes once it is published: a reload or a change builds a new snapshot and the event loop swaps the pointer new requests get, while requests already running finish on the snapshot they started with.
+   Only the event loop thread hands snapshots out and gives them back, so counting their readers needs no lock and the worker threads read the table without any lock either */
+typedef struct TableSnapshot {
+  PokemonTableType table;           //Table of this version of the pokemon file
+  int number_of_readers;            //Amount of requests being ran and of queued messages still pointing into the table
+  char is_retired;                  //C_OK once a newer snapshot replaced this one, it is freed as soon as its last reader is done
+} TableSnapshotType;
+
+/* This structure represents one message waiting to be sent to a client. Only the header is written per message, the payload of a type query is never copied and points into the serialized responses of the table, and a batch of a larger result points into the whole result with its own pokemon count written after the header. */
+typedef struct OutputMessage {
+  unsigned char header[PROTOCOL_HEADER_SIZE + RESULT_COUNT_SIZE]; //Header of the message, in network byte order, followed by the pokemon count of a batch
+  int header_size;                  //Amount of bytes inside header, PROTOCOL_HEADER_SIZE or PROTOCOL_HEADER_SIZE + RESULT_COUNT_SIZE for a batch
+  const char *data;                 //Payload of the message, or the rest of it after the pokemon count of a batch
+  int size;                         //Amount of bytes inside data
+  int sent;                         //Amount of bytes of the header and the payload that have already been sent
+  char *owned_data;                 //Payload built for this message only, like the result of a filter query, freed once it is sent. NULL if data points into the table or for every batch of a result but the last one
+  TableSnapshotType *snapshot;      //Snapshot data points into, kept alive until the message is sent. NULL if data doesn't point into a table or for every batch of a result but the last one
+  int64_t received_at;              //Time the request this message answers was read at, 0 if the message is not the last one of a request ran by a worker or the writer thread
+  int64_t queued_at;                //Time the message was queued at, used with received_at to time sending once it is fully sent
+} OutputMessageType;
+
+struct Connection;
+struct Server;
+
+/* This structure represents one request of a client while it is ran by a worker thread and until its response is queued. Finished requests are kept in a free list and reused instead of being freed. */
+typedef struct ServerRequest {
+  struct Server *server;                      //Server the request was received by
+  struct Connection *connection;              //Client that sent the request
+  unsigned int request_id;                    //Id the client gave the request, copied into the response
+  TableSnapshotType *snapshot;                //Snapshot of the table the request runs on, the one that was current when it was received
+  char pokemon_type[MAX_MESSAGE_BUFFER_SIZE]; //Pokemon type the client asked for
+  char *query;                                //Text of the filter query, of the aggregation request or of the change request the client sent, NULL for a type query
+  int query_length;                           //Amount of characters inside query
+  int response_type;                          //Type of the message answering a filter query, an aggregation or a change, MESSAGE_RESULT, MESSAGE_AGGREGATE_RESULT, MESSAGE_CHANGE_RESULT or MESSAGE_ERROR
+  char *response;                             //Payload built by the worker thread for a filter query or an aggregation, or by the writer thread for a change, handed over to the output queue
+  int response_size;                          //Amount of bytes inside response
+  const TypeIndexEntryType *entry;            //Type index entry found by the worker thread, NULL if no pokemon has the type
+  int64_t received_at;                        //Time the request was read at, used to time every stage of it
+  struct ServerRequest *next_completed;       //Next request inside the list of requests finished by the worker threads, inside the list of changes waiting for the writer thread, or inside the free list
+} ServerRequestType;
+
+/* This structure contains everything the server knows about one connected client, replacing the single ServerReadType the server used when it could only serve one client.
+   Every connection has its own credit: a client with too many requests running or too many unsent responses has its next requests left unread until it has credit again, so one paused or slow client never holds the memory or the worker threads the other clients need. Only the event loop thread uses a connection, so none of this needs a lock */
+typedef struct Connection {
   int client_socket;                //Socket that the server uses to communicate with the client
-  int curr_number_of_pokemon_types; //Index of the current pokemon type that is being read from the file
-  int pokemon_types_array_size;     //The amount of pokemon types inside the pokemon_types_array double char pointer
-  pthread_mutex_t lock;             //Mutex that determines whether the reading thread is running or not
-  pthread_cond_t cond;              //Condition variable that determines whether the reading thread is paused or not
-} ServerReadType;
+  char thread_is_paused;            //Char representing whether the client paused its responses or not
+  unsigned char *input;             //Bytes received from the client that do not make up a whole message yet
+  int input_size;                   //Amount of bytes inside input
+  int input_capacity;               //Amount of bytes input can hold before it has to grow
+  OutputMessageType *output_queue;  //Messages waiting to be sent to the client, in order
+  int output_queue_head;            //Index of the first message of output_queue that has not been fully sent
+  int output_queue_size;            //Amount of messages inside output_queue, including the ones already sent
+  int output_queue_capacity;        //Amount of messages output_queue can hold before it has to grow
+  int number_of_pending_requests;   //Amount of requests of the client still being ran by the worker threads
+  long queued_bytes;                //Amount of bytes of the output queue that have not been sent yet
+  char is_throttled;                //Char representing whether the server stopped handling the requests of the client until it has credit again, see connection_has_credit
+  char is_closed;                   //Char representing whether the client disconnected while requests were still being ran
+  char is_ready;                    //Char representing whether the client is inside the list of clients with finished requests
+  struct Connection *next_ready;    //Next client inside the list of clients with finished requests
+  struct Connection *next_freed;    //Next client inside the list of clients freed once the events of the current epoll_wait are handled
+} ConnectionType;
+
+/* This structure contains the state shared by every connection of the server */
+typedef struct Server {
+  int server_socket;                //Socket the server accepts new clients on
+  int epoll_fd;                     //Epoll instance watching the server socket and every client socket
+  int number_of_connections;        //Amount of clients currently connected
+  TableSnapshotType *snapshot;      //Current snapshot of the table, the one new requests run on. Only read and replaced by the event loop thread
+  char *file_name;                  //Name of the pokemon file, read again on every reload and written by every compaction
+  const char *file_base_name;       //Name of the pokemon file without its directory, compared with the names of the file change events
+  int inotify_fd;                   //Inotify instance watching the directory of the pokemon file for changes, -1 if it can't be watched
+  pthread_t writer_thread;          //Thread making every change to the table one at a time, reloads of the pokemon file and changes sent by clients
+  pthread_mutex_t writer_lock;      //Mutex protecting pending_changes, reload_requested and writer_stopping
+  pthread_cond_t writer_wakeup;     //Condition variable the writer thread waits on until it has something to do
+  ServerRequestType *pending_changes; //Change requests waiting for the writer thread, newest first
+  char reload_requested;            //Char representing whether the writer thread has to read the pokemon file again
+  char writer_stopping;             //Char representing whether the writer thread has to stop once it is done
+  TableSnapshotType *writer_snapshot; //Newest snapshot built by the writer thread, the one the next changes are applied to. Only used by the writer thread once it is started
+  WriteAheadLogType change_log;     //Log of the changes made since the pokemon file was last written, only used by the writer thread once it is started
+  TableSnapshotType *published_snapshot; //Snapshot built by the writer thread that the event loop has not swapped in yet, protected by completed_lock
+  WorkerPoolType pool;              //Worker threads running the requests of every client
+  int wakeup_fd;                    //Eventfd the worker threads use to wake the event loop up when a request is finished
+  ServerRequestType *completed_requests; //Requests finished by the worker threads that the event loop has not handled yet
+  pthread_mutex_t completed_lock;   //Mutex protecting completed_requests
+  ServerRequestType *free_requests; //Requests whose response was queued, reused by the event loop so requests are not allocated one by one
+  ConnectionType *freed_connections; //Clients that disconnected with no request left, freed once every event of the current epoll_wait is handled since a later event can still point to them
+  ResultCacheType result_cache;     //Responses of filter queries and aggregations, shared by the worker threads so identical requests are only computed once
+} ServerType;
 
 /* all function prototypes for functions in server.c */
 int file_exists(char *location);
-void *server_read_pokemon(void *arg);
-int check_pokemon_type(char *data_line, char *ideal_type, char *separator);
+int open_server_socket(void);
+void run_event_loop(ServerType *server);
+void accept_connections(ServerType *server);
+int read_connection(ServerType *server, ConnectionType *connection);
+int handle_client_message(ServerType *server, ConnectionType *connection, const MessageHeaderType *header, const char *payload);
+int handle_input(ServerType *server, ConnectionType *connection);
+int connection_has_credit(const ConnectionType *connection);
+void handle_control_messages(ConnectionType *connection, int offset);
+int resume_connection(ServerType *server, ConnectionType *connection);
+TableSnapshotType *allocate_snapshot(void);
+TableSnapshotType *load_snapshot(char *file_name);
+TableSnapshotType *recover_snapshot(WriteAheadLogType *change_log, TableSnapshotType *loaded);
+TableSnapshotType *acquire_snapshot(TableSnapshotType *snapshot);
+void release_snapshot(TableSnapshotType *snapshot);
+void free_snapshot(TableSnapshotType *snapshot);
+void watch_pokemon_file(ServerType *server);
+void handle_file_events(ServerType *server);
+int start_reload(ServerType *server);
+void *run_table_writer(void *arg);
+void reload_table(ServerType *server);
+void apply_changes(ServerType *server, ServerRequestType *requests);
+void publish_snapshot(ServerType *server, TableSnapshotType *snapshot, ServerRequestType *requests);
+void swap_snapshot(ServerType *server, TableSnapshotType *snapshot);
+ServerRequestType *allocate_request(ServerType *server);
+void release_request(ServerType *server, ServerRequestType *request);
+void submit_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *pokemon_type, int length);
+ServerRequestType *allocate_text_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *text, int length);
+void submit_filter_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *query, int length, WorkFunctionType function);
+void submit_change_request(ServerType *server, ConnectionType *connection, unsigned int request_id, const char *changes, int length);
+void server_read_pokemon(void *arg);
+void server_filter_pokemon(void *arg);
+void server_aggregate_pokemon(void *arg);
+char *server_cache_key(const ServerRequestType *request, int message_type, int *key_length);
+char *server_stats(ServerType *server, int *size);
+void complete_request(ServerRequestType *request);
+void handle_completed_requests(ServerType *server);
+void release_connection(ServerType *server, ConnectionType *connection);
+void free_connection(ConnectionType *connection);
+void queue_message(ConnectionType *connection, int type, unsigned int request_id, const char *data, int size);
+void queue_owned_message(ConnectionType *connection, int type, unsigned int request_id, char *data, int size);
+void queue_response(ConnectionType *connection, ServerRequestType *request);
+OutputMessageType *queue_result(ConnectionType *connection, unsigned int request_id, const char *data, int size);
+int flush_connection(ConnectionType *connection);
+void close_connection(ServerType *server, ConnectionType *connection);
 void free_char_pointer(char **char_pointer);
 
 #endif //end of header file
\ No newline at end of file
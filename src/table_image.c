@@ -0,0 +1,526 @@
+/*****************************************************************************/
+/* */
+/* table_image.c */
+/* Purpose: This file writes a pokemon table into a binary image and reads an image back into a table. Every array of the table is stored in the image the way it is laid out in memory, along with the string pool, the text of the pokemon file, the type index with its serialized responses and the sorted orderings, so loading an image copies the file and points the table into it instead of parsing the text again. A checksum of the whole image, header included, is checked before it is used. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server and convert executables. This is already done for you in the MakeFile. Write a loaded table with image_write and load it back with image_load, image_is_file tells an image apart from a pokemon file in text. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "protocol.h"
+#include "table_image.h"
+#include "logger.h"
+
+//Variety of constants defined
+#define CHECKSUM_LANES 4                          //Constant to represent the amount of words the checksum adds up side by side
+#define CHECKSUM_BLOCK_SIZE 32                    //Constant to represent the amount of bytes the checksum adds at once, one word per lane
+#define CHECKSUM_PRIME 0x9E3779B185EBCA87ull      //Constant to represent the odd number the lanes are multiplied by when they are mixed into the checksum
+
+/* This is the type of the kernels adding blocks of an image to its checksum */
+typedef void (*ChecksumBlocksType)(const char *data, long number_of_blocks, uint64_t sums[CHECKSUM_LANES], uint64_t totals[CHECKSUM_LANES]);
+
+/* This function rounds an offset of an image up to the alignment of its sections */
+/* Parameters: offset - input (the offset being rounded) */
+/* Return values: long containing the smallest aligned offset that is not smaller than offset */
+/* Side effects: none */
+static long image_align(long offset) {
+  return (offset + IMAGE_ALIGNMENT - 1) & ~(long)(IMAGE_ALIGNMENT - 1);
+}
+
+/* This function adds blocks of 32 bytes to the checksum of an image one word at a time. Every lane keeps the sum of its words and the sum of those sums, so moving bytes around changes the checksum too */
+/* Parameters: *data - input (the blocks being added), number_of_blocks - input (the amount of 32 byte blocks), sums[] - input/output (the sum of the words of every lane), totals[] - input/output (the sum of the sums of every lane) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void checksum_blocks_scalar(const char *data, long number_of_blocks, uint64_t sums[CHECKSUM_LANES], uint64_t totals[CHECKSUM_LANES]) {
+  for(long block = 0; block < number_of_blocks; block++) {
+    for(int lane = 0; lane < CHECKSUM_LANES; lane++) {
+      uint64_t word;
+      memcpy(&word, data + block * CHECKSUM_BLOCK_SIZE + lane * sizeof(uint64_t), sizeof(word));
+      sums[lane] += word;
+      totals[lane] += sums[lane];
+    }
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* This function adds blocks of 32 bytes to the checksum of an image 16 bytes at a time with SSE2, giving the same checksum as checksum_blocks_scalar */
+/* Parameters: *data - input (the blocks being added), number_of_blocks - input (the amount of 32 byte blocks), sums[] - input/output (the sum of the words of every lane), totals[] - input/output (the sum of the sums of every lane) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+__attribute__((target("sse2")))
+static void checksum_blocks_sse2(const char *data, long number_of_blocks, uint64_t sums[CHECKSUM_LANES], uint64_t totals[CHECKSUM_LANES]) {
+  __m128i low_sums = _mm_loadu_si128((const __m128i *)sums);
+  __m128i high_sums = _mm_loadu_si128((const __m128i *)(sums + 2));
+  __m128i low_totals = _mm_loadu_si128((const __m128i *)totals);
+  __m128i high_totals = _mm_loadu_si128((const __m128i *)(totals + 2));
+
+  for(long block = 0; block < number_of_blocks; block++) {
+    const char *position = data + block * CHECKSUM_BLOCK_SIZE;
+    low_sums = _mm_add_epi64(low_sums, _mm_loadu_si128((const __m128i *)position));
+    high_sums = _mm_add_epi64(high_sums, _mm_loadu_si128((const __m128i *)(position + 16)));
+    low_totals = _mm_add_epi64(low_totals, low_sums);
+    high_totals = _mm_add_epi64(high_totals, high_sums);
+  }
+  _mm_storeu_si128((__m128i *)sums, low_sums);
+  _mm_storeu_si128((__m128i *)(sums + 2), high_sums);
+  _mm_storeu_si128((__m128i *)totals, low_totals);
+  _mm_storeu_si128((__m128i *)(totals + 2), high_totals);
+}
+
+/* This function adds blocks of 32 bytes to the checksum of an image a whole block at a time with AVX2, giving the same checksum as checksum_blocks_scalar */
+/* Parameters: *data - input (the blocks being added), number_of_blocks - input (the amount of 32 byte blocks), sums[] - input/output (the sum of the words of every lane), totals[] - input/output (the sum of the sums of every lane) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+__attribute__((target("avx2")))
+static void checksum_blocks_avx2(const char *data, long number_of_blocks, uint64_t sums[CHECKSUM_LANES], uint64_t totals[CHECKSUM_LANES]) {
+  __m256i lane_sums = _mm256_loadu_si256((const __m256i *)sums);
+  __m256i lane_totals = _mm256_loadu_si256((const __m256i *)totals);
+
+  for(long block = 0; block < number_of_blocks; block++) {
+    lane_sums = _mm256_add_epi64(lane_sums, _mm256_loadu_si256((const __m256i *)(data + block * CHECKSUM_BLOCK_SIZE)));
+    lane_totals = _mm256_add_epi64(lane_totals, lane_sums);
+  }
+  _mm256_storeu_si256((__m256i *)sums, lane_sums);
+  _mm256_storeu_si256((__m256i *)totals, lane_totals);
+}
+#endif
+
+/* This function picks the fastest checksum kernel the processor running the program supports, every kernel gives the same checksum */
+/* Parameters: None */
+/* Return values: ChecksumBlocksType pointing to the AVX2, SSE2 or scalar kernel */
+/* Side effects: none */
+static ChecksumBlocksType choose_checksum_blocks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    return checksum_blocks_avx2;
+  }
+  if(__builtin_cpu_supports("sse2")) {
+    return checksum_blocks_sse2;
+  }
+#endif
+  return checksum_blocks_scalar;
+}
+
+/* This function computes the checksum of the bytes of an image, only adding words so it runs at the speed memory is read */
+/* Parameters: *data - input (the bytes being checked), size - input (the amount of bytes being checked) */
+/* Return values: uint64_t containing the checksum of the bytes */
+/* Side effects: none */
+uint64_t image_checksum(const char *data, long size) {
+  uint64_t sums[CHECKSUM_LANES] = {0};
+  uint64_t totals[CHECKSUM_LANES] = {0};
+  char last_block[CHECKSUM_BLOCK_SIZE] = {0};
+  long number_of_blocks = size / CHECKSUM_BLOCK_SIZE;
+
+  choose_checksum_blocks()(data, number_of_blocks, sums, totals);
+
+  /* The bytes left over after the last whole block are added as a block padded with zeros */
+  memcpy(last_block, data + number_of_blocks * CHECKSUM_BLOCK_SIZE, size - number_of_blocks * CHECKSUM_BLOCK_SIZE);
+  checksum_blocks_scalar(last_block, 1, sums, totals);
+
+  /* Mix the lanes and the size into a single word */
+  uint64_t checksum = (uint64_t)size;
+  for(int lane = 0; lane < CHECKSUM_LANES; lane++) {
+    checksum = (checksum ^ sums[lane]) * CHECKSUM_PRIME;
+    checksum ^= checksum >> 32;
+    checksum = (checksum ^ totals[lane]) * CHECKSUM_PRIME;
+    checksum ^= checksum >> 32;
+  }
+  return checksum;
+}
+
+/* This function computes the checksum of a whole image, its header with the checksum field set to zero followed by every byte after it, so a damaged header is caught like damaged data */
+/* Parameters: *header - input (the header of the image, its checksum field is ignored), *image - input (the image, header->image_size bytes) */
+/* Return values: uint64_t containing the checksum */
+/* Side effects: none */
+static uint64_t image_header_checksum(const ImageHeaderType *header, const char *image) {
+  ImageHeaderType unchecked = *header;
+  unchecked.checksum = 0;
+
+  uint64_t checksum = image_checksum((const char *)&unchecked, sizeof(unchecked));
+  checksum = (checksum ^ image_checksum(image + header->header_size, header->image_size - header->header_size)) * CHECKSUM_PRIME;
+  return checksum ^ (checksum >> 32);
+}
+
+/* This function places every section of the image of a table and fills the sizes the header keeps */
+/* Parameters: *table - input (the table being written), *header - output (the header of the image), sizes[] - output (the amount of bytes of every section) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void image_layout(const PokemonTableType *table, ImageHeaderType *header, long sizes[NUMBER_OF_SECTIONS]) {
+  long rows = table->number_of_rows;
+
+  for(int column = 0; column < NUMBER_OF_COLUMNS; column++) {
+    sizes[column] = rows * sizeof(short);
+  }
+  sizes[SECTION_NAME] = rows * sizeof(StringViewType);
+  sizes[SECTION_FIRST_TYPE] = rows * sizeof(int);
+  sizes[SECTION_SECOND_TYPE] = rows * sizeof(int);
+  sizes[SECTION_LINE] = rows * sizeof(StringViewType);
+  sizes[SECTION_LEGENDARY] = rows * sizeof(char);
+  sizes[SECTION_STRINGS] = table->strings.characters_size;
+  sizes[SECTION_STRING_SLOTS] = table->strings.slots_capacity * sizeof(int);
+  sizes[SECTION_TEXT] = table->file_size;
+  sizes[SECTION_TYPES] = table->number_of_types * sizeof(ImageTypeEntryType);
+
+  /* The row lists and the response of every type are stored one after the other, each aligned */
+  sizes[SECTION_TYPE_DATA] = 0;
+  for(int i = 0; i < table->number_of_types; i++) {
+    const TypeIndexEntryType *entry = &table->types[i];
+    sizes[SECTION_TYPE_DATA] += image_align(entry->number_of_first_type_rows * sizeof(int));
+    sizes[SECTION_TYPE_DATA] += image_align(entry->number_of_second_type_rows * sizeof(int));
+    sizes[SECTION_TYPE_DATA] += image_align(entry->response_size);
+  }
+  sizes[SECTION_SORTED_ROWS] = NUMBER_OF_COLUMNS * rows * sizeof(int);
+
+  memset(header, 0, sizeof(ImageHeaderType));
+  memcpy(header->magic, IMAGE_MAGIC, IMAGE_MAGIC_SIZE);
+  header->format_version = IMAGE_FORMAT_VERSION;
+  header->byte_order = IMAGE_BYTE_ORDER;
+  header->header_size = sizeof(ImageHeaderType);
+  header->view_size = sizeof(StringViewType);
+  header->number_of_rows = table->number_of_rows;
+  header->number_of_types = table->number_of_types;
+  header->strings_size = table->strings.characters_size;
+  header->string_slots_capacity = table->strings.slots_capacity;
+  header->number_of_interned = table->strings.number_of_interned;
+  header->file_hash = table->file_hash;
+  header->file_size = table->file_size;
+  memcpy(header->type_slots, table->type_slots, sizeof(header->type_slots));
+
+  long offset = image_align(sizeof(ImageHeaderType));
+  for(int section = 0; section < NUMBER_OF_SECTIONS; section++) {
+    header->sections[section] = offset;
+    offset = image_align(offset + sizes[section]);
+  }
+  header->image_size = offset;
+}
+
+/* This function copies an array of a table into its section of an image, an empty array may have never been allocated */
+/* Parameters: *destination - output (the section of the image), *source - input (the array of the table, can be NULL if size is 0), size - input (the amount of bytes being copied) */
+/* Return values: nothing since it's a void function */
+/* Side effects: none */
+static void image_copy(char *destination, const void *source, long size) {
+  if(size > 0) {
+    memcpy(destination, source, size);
+  }
+}
+
+/* This function writes a table into a binary image that image_load can read back without parsing it */
+/* Parameters: *table - input (the table being written, loaded from text or from another image), fd - input (the empty file the image is written to, opened for reading and writing) */
+/* Return values: int, C_OK (0) if the image was written and C_NOK (-1) if the file can't be written */
+/* Side effects: sizes the file and writes it through a shared mapping, the caller still has to fsync the file before relying on it */
+int image_write(const PokemonTableType *table, int fd) {
+  ImageHeaderType header;
+  long sizes[NUMBER_OF_SECTIONS];
+
+  image_layout(table, &header, sizes);
+
+  /* Reserve the blocks of the whole image first, writing through the mapping to a disk that is full would kill the process instead of failing */
+  if(posix_fallocate(fd, 0, header.image_size) != 0) {
+    return C_NOK;
+  }
+  char *image = (char *)mmap(NULL, header.image_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(image == MAP_FAILED) {
+    return C_NOK;
+  }
+
+  /* Every array is copied as it is laid out in memory */
+  for(int column = 0; column < NUMBER_OF_COLUMNS; column++) {
+    image_copy(image + header.sections[column], table->columns[column], sizes[column]);
+  }
+  image_copy(image + header.sections[SECTION_NAME], table->name, sizes[SECTION_NAME]);
+  image_copy(image + header.sections[SECTION_FIRST_TYPE], table->first_type, sizes[SECTION_FIRST_TYPE]);
+  image_copy(image + header.sections[SECTION_SECOND_TYPE], table->second_type, sizes[SECTION_SECOND_TYPE]);
+  image_copy(image + header.sections[SECTION_LINE], table->line, sizes[SECTION_LINE]);
+  image_copy(image + header.sections[SECTION_LEGENDARY], table->legendary, sizes[SECTION_LEGENDARY]);
+  image_copy(image + header.sections[SECTION_STRINGS], table->strings.characters, sizes[SECTION_STRINGS]);
+  image_copy(image + header.sections[SECTION_STRING_SLOTS], table->strings.slots, sizes[SECTION_STRING_SLOTS]);
+  image_copy(image + header.sections[SECTION_TEXT], table->file, sizes[SECTION_TEXT]);
+  for(int column = 0; column < NUMBER_OF_COLUMNS; column++) {
+    image_copy(image + header.sections[SECTION_SORTED_ROWS] + column * table->number_of_rows * sizeof(int), table->sorted_rows[column], table->number_of_rows * sizeof(int));
+  }
+
+  /* The pointers of every type entry are replaced by the offsets of the data they point to */
+  ImageTypeEntryType *entries = (ImageTypeEntryType *)(image + header.sections[SECTION_TYPES]);
+  long offset = header.sections[SECTION_TYPE_DATA];
+  for(int i = 0; i < table->number_of_types; i++) {
+    const TypeIndexEntryType *entry = &table->types[i];
+    entries[i].type = entry->type;
+    entries[i].number_of_first_type_rows = entry->number_of_first_type_rows;
+    entries[i].number_of_second_type_rows = entry->number_of_second_type_rows;
+    entries[i].response_size = entry->response_size;
+
+    entries[i].first_type_rows = offset;
+    image_copy(image + offset, entry->first_type_rows, entry->number_of_first_type_rows * sizeof(int));
+    offset += image_align(entry->number_of_first_type_rows * sizeof(int));
+    entries[i].second_type_rows = offset;
+    image_copy(image + offset, entry->second_type_rows, entry->number_of_second_type_rows * sizeof(int));
+    offset += image_align(entry->number_of_second_type_rows * sizeof(int));
+    entries[i].response = offset;
+    image_copy(image + offset, entry->response, entry->response_size);
+    offset += image_align(entry->response_size);
+  }
+
+  /* The header is written last, so it holds the checksum of itself and of everything else */
+  header.checksum = image_header_checksum(&header, image);
+  memcpy(image, &header, sizeof(header));
+
+  int result = (msync(image, header.image_size, MS_SYNC) == 0) ? C_OK : C_NOK;
+  munmap(image, header.image_size);
+  return result;
+}
+
+/* This function tells whether a file starts like a binary image */
+/* Parameters: *file_name - input (the name of the file) */
+/* Return values: int, C_OK (0) if the file starts with the magic of an image and C_NOK (-1) if it doesn't or can't be read */
+/* Side effects: reads the first bytes of the file */
+int image_is_file(const char *file_name) {
+  char magic[IMAGE_MAGIC_SIZE];
+
+  int fd = open(file_name, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    return C_NOK;
+  }
+  ssize_t bytes_read = read(fd, magic, IMAGE_MAGIC_SIZE);
+  close(fd);
+  return (bytes_read == IMAGE_MAGIC_SIZE && memcmp(magic, IMAGE_MAGIC, IMAGE_MAGIC_SIZE) == 0) ? C_OK : C_NOK;
+}
+
+/* This function checks that a range of bytes lies inside an image */
+/* Parameters: *header - input (the header of the image), offset - input (the offset of the first byte), size - input (the amount of bytes) */
+/* Return values: int, C_OK (0) if the range is inside the image and C_NOK (-1) if it isn't */
+/* Side effects: none */
+static int image_check_range(const ImageHeaderType *header, int64_t offset, int64_t size) {
+  return (offset >= (int64_t)header->header_size && size >= 0 && offset <= header->image_size && size <= header->image_size - offset) ? C_OK : C_NOK;
+}
+
+/* This function checks that the header of an image was written by this version of the server on a machine like this one, and that every section it names lies inside the image */
+/* Parameters: *header - input (the header of the image), file_size - input (the amount of bytes inside the file) */
+/* Return values: int, C_OK (0) if the image can be used and C_NOK (-1) if it can't */
+/* Side effects: prints a message telling why the image can't be used */
+static int image_check_header(const ImageHeaderType *header, long file_size) {
+  long sizes[NUMBER_OF_SECTIONS];
+  long rows = header->number_of_rows;
+
+  if(memcmp(header->magic, IMAGE_MAGIC, IMAGE_MAGIC_SIZE) != 0 || header->format_version != IMAGE_FORMAT_VERSION || header->byte_order != IMAGE_BYTE_ORDER ||
+     header->header_size != sizeof(ImageHeaderType) || header->view_size != sizeof(StringViewType)) {
+    LOG_ERROR("The image was written by another version of the server or on another kind of machine, convert the pokemon file again");
+    return C_NOK;
+  }
+  if(header->image_size != file_size || header->number_of_rows < 0 || header->number_of_types < 0 || header->number_of_types * 2 > TYPE_INDEX_SLOTS ||
+     header->strings_size < 0 || header->string_slots_capacity < 0 || header->file_size < 0) {
+    LOG_ERROR("The image is incomplete or damaged");
+    return C_NOK;
+  }
+
+  /* The hash tables are used as they are, so their sizes and slots have to be ones the table could have built: the string pool is masked with its capacity minus one and always keeps an empty slot, every type slot names an entry or none */
+  if((header->string_slots_capacity & (header->string_slots_capacity - 1)) != 0 || header->number_of_interned < 0 || (long)header->number_of_interned * 2 > header->string_slots_capacity) {
+    LOG_ERROR("The image is incomplete or damaged");
+    return C_NOK;
+  }
+  for(int slot = 0; slot < TYPE_INDEX_SLOTS; slot++) {
+    if(header->type_slots[slot] < 0 || header->type_slots[slot] > header->number_of_types) {
+      LOG_ERROR("The image is incomplete or damaged");
+      return C_NOK;
+    }
+  }
+
+  /* Every section has to hold the arrays the header says it holds */
+  for(int column = 0; column < NUMBER_OF_COLUMNS; column++) {
+    sizes[column] = rows * sizeof(short);
+  }
+  sizes[SECTION_NAME] = rows * sizeof(StringViewType);
+  sizes[SECTION_FIRST_TYPE] = rows * sizeof(int);
+  sizes[SECTION_SECOND_TYPE] = rows * sizeof(int);
+  sizes[SECTION_LINE] = rows * sizeof(StringViewType);
+  sizes[SECTION_LEGENDARY] = rows * sizeof(char);
+  sizes[SECTION_STRINGS] = header->strings_size;
+  sizes[SECTION_STRING_SLOTS] = header->string_slots_capacity * sizeof(int);
+  sizes[SECTION_TEXT] = header->file_size;
+  sizes[SECTION_TYPES] = header->number_of_types * sizeof(ImageTypeEntryType);
+  sizes[SECTION_TYPE_DATA] = 0;
+  sizes[SECTION_SORTED_ROWS] = NUMBER_OF_COLUMNS * rows * sizeof(int);
+  for(int section = 0; section < NUMBER_OF_SECTIONS; section++) {
+    if(image_check_range(header, header->sections[section], sizes[section]) == C_NOK || header->sections[section] % IMAGE_ALIGNMENT != 0) {
+      LOG_ERROR("The image is incomplete or damaged");
+      return C_NOK;
+    }
+  }
+  return C_OK;
+}
+
+/* This function checks that every row number of a list names a row of the image */
+/* Parameters: *rows - input (the list of row numbers), number_of_entries - input (the amount of row numbers inside the list), number_of_rows - input (the amount of rows of the image) */
+/* Return values: int, C_OK (0) if every row number is valid and C_NOK (-1) if one isn't */
+/* Side effects: none */
+static int image_check_rows(const int *rows, long number_of_entries, long number_of_rows) {
+  for(long i = 0; i < number_of_entries; i++) {
+    if(rows[i] < 0 || rows[i] >= number_of_rows) {
+      return C_NOK;
+    }
+  }
+  return C_OK;
+}
+
+/* This function checks that every offset stored inside the arrays of an image points inside the part of the image it is read from, since the checksum only catches damage and not an image that was written wrong */
+/* Parameters: *header - input (the header of the image, already checked by image_check_header), *image - input (the image) */
+/* Return values: int, C_OK (0) if every offset is valid and C_NOK (-1) if one isn't */
+/* Side effects: prints a message if an offset is invalid */
+static int image_check_contents(const ImageHeaderType *header, const char *image) {
+  long rows = header->number_of_rows;
+  const char *strings = image + header->sections[SECTION_STRINGS];
+  const int *string_slots = (const int *)(image + header->sections[SECTION_STRING_SLOTS]);
+  const StringViewType *names = (const StringViewType *)(image + header->sections[SECTION_NAME]);
+  const StringViewType *lines = (const StringViewType *)(image + header->sections[SECTION_LINE]);
+  const int *first_types = (const int *)(image + header->sections[SECTION_FIRST_TYPE]);
+  const int *second_types = (const int *)(image + header->sections[SECTION_SECOND_TYPE]);
+  int is_valid = C_OK;
+
+  /* Interned strings are read up to their null character, so the last one has to end inside the pool, and every slot holds 0 or one more than the offset of a string */
+  if(header->strings_size > 0 && strings[header->strings_size - 1] != '\0') {
+    is_valid = C_NOK;
+  }
+  for(int slot = 0; slot < header->string_slots_capacity && is_valid == C_OK; slot++) {
+    if(string_slots[slot] < 0 || string_slots[slot] > header->strings_size) {
+      is_valid = C_NOK;
+    }
+  }
+
+  /* The names and lines point into the text of the file and the types into the string pool */
+  for(long row = 0; row < rows && is_valid == C_OK; row++) {
+    if(names[row].offset < 0 || names[row].length < 0 || names[row].offset > header->file_size - names[row].length ||
+       lines[row].offset < 0 || lines[row].length < 0 || lines[row].offset > header->file_size - lines[row].length ||
+       first_types[row] < 0 || first_types[row] >= header->strings_size || second_types[row] < 0 || second_types[row] >= header->strings_size) {
+      is_valid = C_NOK;
+    }
+  }
+  if(is_valid == C_OK) {
+    is_valid = image_check_rows((const int *)(image + header->sections[SECTION_SORTED_ROWS]), NUMBER_OF_COLUMNS * rows, rows);
+  }
+
+  if(is_valid == C_NOK) {
+    LOG_ERROR("The image is incomplete or damaged");
+  }
+  return is_valid;
+}
+
+/* This function reads a binary image written by image_write into memory and points a table into it, without parsing any of it */
+/* Parameters: *table - output (the table being filled), *file_name - input (the name of the image) */
+/* Return values: int, C_OK (0) if the image was loaded and C_NOK (-1) if it can't be read, changed size while it was read, was written by another version or is damaged */
+/* Side effects: allocates private memory holding the image and the type entries, both are released with table_free */
+int image_load(PokemonTableType *table, const char *file_name) {
+  struct stat file_information;
+
+  memset(table, 0, sizeof(PokemonTableType));
+
+  int fd = open(file_name, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    return C_NOK;
+  }
+  if(fstat(fd, &file_information) < 0 || file_information.st_size < (long)sizeof(ImageHeaderType)) {
+    close(fd);
+    return C_NOK;
+  }
+
+  /* Copy the image into private memory like the text of a pokemon file instead of mapping it, a mapping would change under the table, or fault past its end, if the image is rewritten in place while the table is still answering queries */
+  long size = file_information.st_size;
+  char *image = table_allocate_text(size);
+  if(image == NULL) {
+    close(fd);
+    return C_NOK;
+  }
+  if(table_read_file(fd, image, size) == C_NOK) {
+    munmap(image, size);
+    close(fd);
+    return C_NOK;
+  }
+  close(fd);
+  mprotect(image, size, PROT_READ);
+
+  const ImageHeaderType *header = (const ImageHeaderType *)image;
+  if(image_check_header(header, size) == C_NOK) {
+    munmap(image, size);
+    return C_NOK;
+  }
+  if(image_header_checksum(header, image) != header->checksum) {
+    LOG_ERROR("The checksum of the image doesn't match, the image is damaged");
+    munmap(image, size);
+    return C_NOK;
+  }
+  if(image_check_contents(header, image) == C_NOK) {
+    munmap(image, size);
+    return C_NOK;
+  }
+
+  /* Point every array of the table into the image */
+  table->version = table_next_version();
+  table->number_of_rows = header->number_of_rows;
+  table->rows_capacity = header->number_of_rows;
+  for(int column = 0; column < NUMBER_OF_COLUMNS; column++) {
+    table->columns[column] = (short *)(image + header->sections[column]);
+    table->sorted_rows[column] = (int *)(image + header->sections[SECTION_SORTED_ROWS]) + (long)column * header->number_of_rows;
+  }
+  table->name = (StringViewType *)(image + header->sections[SECTION_NAME]);
+  table->first_type = (int *)(image + header->sections[SECTION_FIRST_TYPE]);
+  table->second_type = (int *)(image + header->sections[SECTION_SECOND_TYPE]);
+  table->line = (StringViewType *)(image + header->sections[SECTION_LINE]);
+  table->legendary = image + header->sections[SECTION_LEGENDARY];
+  table->strings.characters = image + header->sections[SECTION_STRINGS];
+  table->strings.characters_size = header->strings_size;
+  table->strings.characters_capacity = header->strings_size;
+  table->strings.slots = (int *)(image + header->sections[SECTION_STRING_SLOTS]);
+  table->strings.slots_capacity = header->string_slots_capacity;
+  table->strings.number_of_interned = header->number_of_interned;
+  table->file = (header->file_size > 0) ? image + header->sections[SECTION_TEXT] : NULL;
+  table->file_size = header->file_size;
+  table->file_hash = header->file_hash;
+  memcpy(table->type_slots, header->type_slots, sizeof(table->type_slots));
+  table->image = image;
+  table->image_size = size;
+
+  /* The type entries are the only part that holds pointers, so they are the only part rebuilt */
+  const ImageTypeEntryType *entries = (const ImageTypeEntryType *)(image + header->sections[SECTION_TYPES]);
+  table->types = (TypeIndexEntryType *)calloc(header->number_of_types + 1, sizeof(TypeIndexEntryType));
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(table->types == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  table->number_of_types = header->number_of_types;
+  for(int i = 0; i < header->number_of_types; i++) {
+    const ImageTypeEntryType *entry = &entries[i];
+    if(image_check_range(header, entry->first_type_rows, (int64_t)entry->number_of_first_type_rows * sizeof(int)) == C_NOK ||
+       image_check_range(header, entry->second_type_rows, (int64_t)entry->number_of_second_type_rows * sizeof(int)) == C_NOK ||
+       image_check_range(header, entry->response, entry->response_size) == C_NOK || entry->type < 0 || entry->type >= header->strings_size ||
+       image_check_rows((const int *)(image + entry->first_type_rows), entry->number_of_first_type_rows, header->number_of_rows) == C_NOK ||
+       image_check_rows((const int *)(image + entry->second_type_rows), entry->number_of_second_type_rows, header->number_of_rows) == C_NOK) {
+      LOG_ERROR("The image is incomplete or damaged");
+      table_free(table);
+      return C_NOK;
+    }
+    table->types[i].type = entry->type;
+    table->types[i].first_type_rows = (int *)(image + entry->first_type_rows);
+    table->types[i].number_of_first_type_rows = entry->number_of_first_type_rows;
+    table->types[i].second_type_rows = (int *)(image + entry->second_type_rows);
+    table->types[i].number_of_second_type_rows = entry->number_of_second_type_rows;
+    table->types[i].response = image + entry->response;
+    table->types[i].response_size = entry->response_size;
+  }
+  return C_OK;
+}
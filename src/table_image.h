@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/* */
+/* table_image.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the table_image.c file */
+/* How to use: use #include "table_image.h" at the top of any .c files that need to write a pokemon table into a binary image or read one back into memory */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef TABLE_IMAGE_H_
+#define TABLE_IMAGE_H_
+
+//Other libraries that we will need
+#include <stdint.h>
+
+//importing the header file of the table being written
+#include "pokemon_table.h"
+
+//Variety of constants defined
+#define IMAGE_MAGIC "PKMNIMG"             //Constant to represent the first bytes of every image, followed by a null character
+#define IMAGE_MAGIC_SIZE 8                //Constant to represent the amount of bytes of the magic at the start of every image
+#define IMAGE_FORMAT_VERSION 2            //Constant to represent the version of the layout written by image_write, images with another version are not loaded
+#define IMAGE_BYTE_ORDER 0x01020304u      //Constant to represent a word written in the byte order of the machine, so an image written on a machine with another byte order is not loaded
+#define IMAGE_ALIGNMENT 64                //Constant to represent the alignment of every section inside an image
+#define IMAGE_FILE_EXTENSION ".pkb"       //Constant to represent the extension given to images, only used by the converter to name its output
+#define IMAGE_CONVERSION_SUFFIX ".converting" //Constant to represent what is added to the name of the image while the converter is writing it
+
+/* This enum names every section of an image holding an array of the table, the numeric columns come first in the order of PokemonColumnType */
+typedef enum ImageSection {
+  SECTION_NAME = NUMBER_OF_COLUMNS,   //Name view of every row
+  SECTION_FIRST_TYPE,                 //String pool offset of the first type of every row
+  SECTION_SECOND_TYPE,                //String pool offset of the second type of every row
+  SECTION_LINE,                       //Line view of every row
+  SECTION_LEGENDARY,                  //Legendary flag of every row
+  SECTION_STRINGS,                    //Characters of the string pool
+  SECTION_STRING_SLOTS,               //Hash table of the string pool
+  SECTION_TEXT,                       //Text of the pokemon file the views point into
+  SECTION_TYPES,                      //ImageTypeEntryType of every type
+  SECTION_TYPE_DATA,                  //Row lists and responses of every type, pointed to by the type entries
+  SECTION_SORTED_ROWS,                //Rows ordered by every numeric column, one column after the other
+  NUMBER_OF_SECTIONS                  //Amount of sections, must stay last
+} ImageSectionType;
+
+/* This structure contains one type index entry inside an image, the arrays it points to are stored as offsets from the start of the image */
+typedef struct ImageTypeEntry {
+  int32_t type;                       //String pool offset of the interned name of the type
+  int32_t number_of_first_type_rows;  //Amount of rows whose first type is this type
+  int32_t number_of_second_type_rows; //Amount of rows whose second type is this type
+  int32_t response_size;              //Amount of bytes inside the serialized response of the type
+  int64_t first_type_rows;            //Offset of the rows whose first type is this type
+  int64_t second_type_rows;           //Offset of the rows whose second type is this type
+  int64_t response;                   //Offset of the serialized response of the type
+} ImageTypeEntryType;
+
+/* This structure is written at the start of every image. Every array of the table is stored after it as it is laid out in memory, so loading an image only reads the file and points the table into it without parsing anything */
+typedef struct ImageHeader {
+  char magic[IMAGE_MAGIC_SIZE];       //IMAGE_MAGIC
+  uint32_t format_version;            //IMAGE_FORMAT_VERSION
+  uint32_t byte_order;                //IMAGE_BYTE_ORDER
+  uint32_t header_size;               //Size of this structure, which changes along with the layout of the table
+  uint32_t view_size;                 //Size of a StringViewType, which depends on the machine
+  int32_t number_of_rows;             //Amount of pokemon inside the table
+  int32_t number_of_types;            //Amount of type index entries
+  int32_t strings_size;               //Amount of characters inside the string pool
+  int32_t string_slots_capacity;      //Amount of slots inside the hash table of the string pool
+  int32_t number_of_interned;         //Amount of strings inside the hash table of the string pool
+  uint32_t file_hash;                 //Hash of the text of the pokemon file
+  int64_t file_size;                  //Amount of bytes inside the text of the pokemon file
+  int32_t type_slots[TYPE_INDEX_SLOTS]; //Hash table of the type index
+  int64_t sections[NUMBER_OF_SECTIONS]; //Offset of every section from the start of the image
+  int64_t image_size;                 //Amount of bytes inside the image
+  uint64_t checksum;                  //Checksum of the header, with this field set to zero, and of every byte after it
+} ImageHeaderType;
+
+/* all function prototypes for functions in table_image.c */
+int image_is_file(const char *file_name);
+int image_write(const PokemonTableType *table, int fd);
+int image_load(PokemonTableType *table, const char *file_name);
+uint64_t image_checksum(const char *data, long size);
+
+#endif //end of header file
@@ -0,0 +1,334 @@
+/*****************************************************************************/
+/* */
+/* wal.c */
+/* Purpose: This file contains the write-ahead log of the changes made to the pokemon table. Every group of changes is appended to the log and flushed to the disk before it is applied, so a change a client was told about survives the server stopping. When the log grows too large, the whole table is written into the pokemon file and the log starts over. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Open the log with wal_open once the pokemon file is loaded, apply the changes it holds with wal_recover, then append every group of changes with wal_append and write the table back with wal_compact. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//needed for memmem
+#define _GNU_SOURCE
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "wal.h"
+#include "table_image.h"
+
+/* This function reads the identity of a file, which changes whenever the file is written or replaced */
+/* Parameters: *file_name - input (the name of the file), *identity - output (the identity of the file) */
+/* Return values: int, C_OK (0) if the file exists and C_NOK (-1) if it doesn't */
+/* Side effects: none */
+int wal_identify(const char *file_name, FileIdentityType *identity) {
+  struct stat file_information;
+
+  memset(identity, 0, sizeof(FileIdentityType));
+  if(stat(file_name, &file_information) < 0) {
+    return C_NOK;
+  }
+  identity->device = file_information.st_dev;
+  identity->inode = file_information.st_ino;
+  identity->size = file_information.st_size;
+  identity->modified_seconds = file_information.st_mtim.tv_sec;
+  identity->modified_nanoseconds = file_information.st_mtim.tv_nsec;
+  return C_OK;
+}
+
+/* This function writes a whole buffer to a file, writing again after a partial write */
+/* Parameters: fd - input (the file being written), *data - input (the bytes being written), size - input (the amount of bytes being written) */
+/* Return values: int, C_OK (0) if every byte was written and C_NOK (-1) if the file can't be written */
+/* Side effects: writes to the file */
+static int write_all(int fd, const char *data, long size) {
+  while(size > 0) {
+    ssize_t written = write(fd, data, size);
+    if(written < 0 && errno == EINTR) {
+      continue;
+    }
+    if(written <= 0) {
+      return C_NOK;
+    }
+    data += written;
+    size -= written;
+  }
+  return C_OK;
+}
+
+/* This function opens the log of a pokemon file, creating it if it doesn't exist */
+/* Parameters: *wal - output (the log being opened), *data_file_name - input (the name of the pokemon file, it must stay alive while the log is used), compaction_size - input (the size the log can reach before its changes are written into the pokemon file, 0 to never compact) */
+/* Return values: int, C_OK (0) if the log was opened and C_NOK (-1) if it can't be, in which case no change can be made to the table */
+/* Side effects: allocates the name of the log, opens the log file, prints a message if it can't be opened */
+int wal_open(WriteAheadLogType *wal, const char *data_file_name, long compaction_size) {
+  memset(wal, 0, sizeof(WriteAheadLogType));
+  wal->data_file_name = data_file_name;
+  wal->compaction_size = compaction_size;
+  wal->log_file_name = (char *)malloc(strlen(data_file_name) + strlen(WAL_FILE_SUFFIX) + 1);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(wal->log_file_name == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  sprintf(wal->log_file_name, "%s%s", data_file_name, WAL_FILE_SUFFIX);
+
+  wal->fd = open(wal->log_file_name, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if(wal->fd < 0) {
+    LOG_ERROR("Could not open the change log %s, pokemon can't be changed", wal->log_file_name);
+    return C_NOK;
+  }
+  wal->size = lseek(wal->fd, 0, SEEK_END);
+  return C_OK;
+}
+
+/* This function closes the log */
+/* Parameters: *wal - input/output (the log being closed) */
+/* Return values: nothing since it's a void function */
+/* Side effects: closes the log file and frees the name of the log */
+void wal_close(WriteAheadLogType *wal) {
+  if(wal->fd >= 0) {
+    close(wal->fd);
+  }
+  free(wal->log_file_name);
+  wal->log_file_name = NULL;
+  wal->fd = -1;
+}
+
+/* This function empties the log and writes the line naming the pokemon file it applies to, once the pokemon file holds every change */
+/* Parameters: *wal - input/output (the log being emptied), *table - input (the table read from or written to the pokemon file) */
+/* Return values: int, C_OK (0) if the log was emptied and C_NOK (-1) if it can't be written */
+/* Side effects: truncates and writes the log file, waits for it to reach the disk */
+int wal_reset(WriteAheadLogType *wal, const PokemonTableType *table) {
+  char base[WAL_MARKER_SIZE];
+  int length = snprintf(base, sizeof(base), "base %ld %u\n", table->file_size, table->file_hash);
+
+  if(wal->fd < 0) {
+    return C_NOK;
+  }
+  if(ftruncate(wal->fd, 0) < 0 || write_all(wal->fd, base, length) == C_NOK || fdatasync(wal->fd) < 0) {
+    LOG_ERROR("Could not write the change log %s", wal->log_file_name);
+    wal->size = lseek(wal->fd, 0, SEEK_END);
+    return C_NOK;
+  }
+  wal->size = length;
+  return C_OK;
+}
+
+/* This function applies every group of changes inside the log to the table read from the pokemon file, the way it was before the server stopped.
+   The log is only applied if its first line names the pokemon file that was read, a pokemon file that was replaced since the log was written replaces the logged changes too. A group that was only partly written is removed from the log */
+/* Parameters: *wal - input/output (the log being applied), *loaded - input (the table read from the pokemon file), *recovered - output (the table with every logged change applied), *number_of_changes - output (the amount of changes applied) */
+/* Return values: int, C_OK (0) if recovered was built and C_NOK (-1) if the log has no change for this file, in which case loaded is used as is */
+/* Side effects: reads the log file, may truncate or empty it, prints a message if logged changes are dropped */
+int wal_recover(WriteAheadLogType *wal, const PokemonTableType *loaded, PokemonTableType *recovered, int *number_of_changes) {
+  char expected[WAL_MARKER_SIZE];
+  int expected_length = snprintf(expected, sizeof(expected), "base %ld %u\n", loaded->file_size, loaded->file_hash);
+
+  *number_of_changes = 0;
+  if(wal->fd < 0) {
+    return C_NOK;
+  }
+
+  char *log = (char *)malloc(wal->size + 1);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(log == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  long size = 0;
+  while(size < wal->size) {
+    ssize_t result = pread(wal->fd, log + size, wal->size - size, size);
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+    if(result <= 0) {
+      break;
+    }
+    size += result;
+  }
+
+  /* A log written for another version of the pokemon file doesn't apply to this one */
+  if(size < expected_length || memcmp(log, expected, expected_length) != 0) {
+    if(memmem(log, size, "\ncommit ", 8) != NULL) {
+      LOG_WARN("%s changed since the changes inside %s were logged, the logged changes are dropped", wal->data_file_name, wal->log_file_name);
+    }
+    free(log);
+    wal_reset(wal, loaded);
+    return C_NOK;
+  }
+
+  MutationBatchType batch;
+  long group_start = expected_length;   //Offset of the first change of the group being read
+  long valid_end = expected_length;     //Offset one past the last complete group
+  int group_changes = 0;                //Amount of changes of the group being read
+  mutation_batch_init(&batch, loaded);
+
+  /* Apply every group that ends with a commit line matching its changes, and stop at the first one that doesn't */
+  for(long position = expected_length; position < size; ) {
+    const char *line_break = (const char *)memchr(log + position, '\n', size - position);
+    if(line_break == NULL) {
+      break;
+    }
+    long line_length = line_break - (log + position);
+
+    if(line_length < WAL_MARKER_SIZE && strncmp(log + position, "commit ", 7) == 0) {
+      char marker[WAL_MARKER_SIZE];
+      char error[MAX_QUERY_ERROR_SIZE];
+      int logged_changes;
+      unsigned int logged_hash;
+      MutationType *mutations;
+      int parsed_changes;
+
+      memcpy(marker, log + position, line_length);
+      marker[line_length] = '\0';
+      if(sscanf(marker, "commit %d %u", &logged_changes, &logged_hash) != 2 || logged_changes != group_changes ||
+         logged_hash != hash_string(log + group_start, position - group_start)) {
+        break;
+      }
+      if(mutation_parse(log + group_start, position - group_start, &mutations, &parsed_changes, error) == C_NOK) {
+        break;
+      }
+      int result = mutation_batch_apply(&batch, mutations, parsed_changes, error);
+      free(mutations);
+      if(result == C_NOK) {
+        LOG_ERROR("A change inside %s can't be applied: %s", wal->log_file_name, error);
+        break;
+      }
+      valid_end = line_break + 1 - log;
+      group_start = valid_end;
+      group_changes = 0;
+    }
+    else {
+      group_changes++;
+    }
+    position = line_break + 1 - log;
+  }
+
+  /* Remove what follows the last complete group so new groups are not written after a partial one */
+  if(valid_end < wal->size) {
+    LOG_WARN("Removing %ld bytes of changes that were only partly written from %s", wal->size - valid_end, wal->log_file_name);
+    if(ftruncate(wal->fd, valid_end) == 0) {
+      wal->size = valid_end;
+    }
+  }
+
+  int result = C_NOK;
+  if(batch.number_of_changes > 0) {
+    mutation_batch_build(&batch, recovered);
+    *number_of_changes = batch.number_of_changes;
+    result = C_OK;
+  }
+  mutation_batch_free(&batch);
+  free(log);
+  return result;
+}
+
+/* This function appends a group of changes to the log followed by its commit line, and waits for them to reach the disk. Every request of the group is answered only once this returns, so one fdatasync makes all of them durable */
+/* Parameters: *wal - input/output (the log being written), *changes - input (the changes, one per line, written with mutation_format), size - input (the amount of bytes inside changes), number_of_changes - input (the amount of changes) */
+/* Return values: int, C_OK (0) if the group is durable and C_NOK (-1) if it can't be written, in which case the log is left as it was */
+/* Side effects: writes the log file */
+int wal_append(WriteAheadLogType *wal, const char *changes, long size, int number_of_changes) {
+  char commit[WAL_MARKER_SIZE];
+  int commit_length = snprintf(commit, sizeof(commit), "commit %d %u\n", number_of_changes, hash_string(changes, size));
+  struct iovec vectors[2];
+  long total = size + commit_length;
+  long written = 0;
+
+  if(wal->fd < 0) {
+    return C_NOK;
+  }
+
+  /* The changes and their commit line are written together, a partial write is finished by writing the rest */
+  vectors[0].iov_base = (void *)changes;
+  vectors[0].iov_len = size;
+  vectors[1].iov_base = commit;
+  vectors[1].iov_len = commit_length;
+  while(written < total) {
+    ssize_t result = (written == 0) ? writev(wal->fd, vectors, 2) :
+                     (written < size) ? write(wal->fd, changes + written, size - written) : write(wal->fd, commit + (written - size), total - written);
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+    if(result <= 0) {
+      break;
+    }
+    written += result;
+  }
+
+  /* Take a group that didn't fully reach the disk back out, the requests of the group are answered with an error */
+  if(written < total || fdatasync(wal->fd) < 0) {
+    LOG_ERROR("Could not write the change log %s", wal->log_file_name);
+    if(ftruncate(wal->fd, wal->size) < 0) {
+      wal->size = lseek(wal->fd, 0, SEEK_END);
+    }
+    return C_NOK;
+  }
+
+  wal->size += total;
+  __atomic_add_fetch(&wal->commits, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&wal->changes, number_of_changes, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&wal->bytes_written, total, __ATOMIC_RELAXED);
+  return C_OK;
+}
+
+/* This function writes a table into the pokemon file and empties the log, so the log doesn't keep growing and a restart doesn't have to apply every change again.
+   The table is written to another file that is moved over the pokemon file once it reached the disk, so the pokemon file is complete at every moment */
+/* Parameters: *wal - input/output (the log being emptied), *table - input (the table holding every logged change) */
+/* Return values: int, C_OK (0) if the table was written and C_NOK (-1) if it can't be, in which case the log is kept */
+/* Side effects: writes and renames a file next to the pokemon file, in text or as a binary image like the pokemon file it replaces, empties the log file */
+int wal_compact(WriteAheadLogType *wal, const PokemonTableType *table) {
+  char *temporary_name = (char *)malloc(strlen(wal->data_file_name) + strlen(WAL_COMPACTION_SUFFIX) + 1);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(temporary_name == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+  sprintf(temporary_name, "%s%s", wal->data_file_name, WAL_COMPACTION_SUFFIX);
+
+  /* A pokemon file converted into a binary image stays an image, so the next start still maps it instead of parsing it */
+  int is_image = image_is_file(wal->data_file_name);
+  int fd = open(temporary_name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  int written = (fd < 0) ? C_NOK : (is_image == C_OK) ? image_write(table, fd) : write_all(fd, table->file, table->file_size);
+  if(written == C_NOK || fsync(fd) < 0) {
+    LOG_ERROR("Could not write %s, the changes stay inside %s", temporary_name, wal->log_file_name);
+    if(fd >= 0) {
+      close(fd);
+      unlink(temporary_name);
+    }
+    free(temporary_name);
+    return C_NOK;
+  }
+  close(fd);
+
+  if(rename(temporary_name, wal->data_file_name) < 0) {
+    LOG_ERROR("Could not replace %s, the changes stay inside %s", wal->data_file_name, wal->log_file_name);
+    unlink(temporary_name);
+    free(temporary_name);
+    return C_NOK;
+  }
+  free(temporary_name);
+
+  /* The rename only survives a crash once the directory reached the disk. If the server stops before the log is emptied, the log names the previous pokemon file and is dropped when the new one is loaded */
+  char *directory_name = strdup(wal->data_file_name);
+  int directory = (directory_name != NULL) ? open(dirname(directory_name), O_RDONLY | O_CLOEXEC) : -1;
+  if(directory >= 0) {
+    fsync(directory);
+    close(directory);
+  }
+  free(directory_name);
+
+  wal_identify(wal->data_file_name, &wal->data_file);
+  __atomic_add_fetch(&wal->compactions, 1, __ATOMIC_RELAXED);
+  return wal_reset(wal, table);
+}
@@ -0,0 +1,60 @@
+/*****************************************************************************/
+/* */
+/* wal.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the wal.c file */
+/* How to use: use #include "wal.h" at the top of any .c files that need to log the changes made to the pokemon table so they survive a restart */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef WAL_H_
+#define WAL_H_
+
+//importing the header files of the table being logged and of the changes written to the log
+#include "pokemon_table.h"
+#include "mutation.h"
+
+//Variety of constants defined
+#define WAL_FILE_SUFFIX ".wal"                  //Constant to represent what is added to the name of the pokemon file to get the name of its log
+#define WAL_COMPACTION_SUFFIX ".compacting"     //Constant to represent what is added to the name of the pokemon file while it is being rewritten by a compaction
+#define WAL_DEFAULT_COMPACTION_MEGABYTES 4      //Constant to represent the size the log can reach before its changes are written into the pokemon file, when no size is given
+#define WAL_MARKER_SIZE 64                      //Constant to represent the longest base or commit line of the log
+
+/* This structure tells whether a file was changed since it was last looked at, without reading it */
+typedef struct FileIdentity {
+  long device;            //Device holding the file
+  long inode;             //Inode of the file, which changes when another file is moved over it
+  long size;              //Amount of bytes inside the file
+  long modified_seconds;  //Time the file was last written, in seconds
+  long modified_nanoseconds; //Nanoseconds of the time the file was last written
+} FileIdentityType;
+
+/* This structure contains the append-only log of every change made to the pokemon table since the pokemon file was last written.
+   The log starts with a line naming the pokemon file it applies to, "base <size> <hash>", followed by groups of changes written like the changes of a request, one per line.
+   Every group ends with "commit <amount of changes> <hash of the changes>" and is written with a single write followed by a single fdatasync, so many requests are made durable at once and a group that was only partly written when the server stopped is ignored */
+typedef struct WriteAheadLog {
+  int fd;                       //Log file, opened in append mode, -1 if it can't be opened
+  char *log_file_name;          //Name of the log file, the name of the pokemon file followed by WAL_FILE_SUFFIX
+  const char *data_file_name;   //Name of the pokemon file the log applies to
+  long size;                    //Amount of bytes inside the log file
+  long compaction_size;         //Size the log can reach before its changes are written into the pokemon file, 0 to never compact
+  FileIdentityType data_file;   //Identity of the pokemon file when it was last read or written, so a reload of a file that didn't change is skipped
+  long commits;                 //Amount of groups of changes written, each with one fdatasync
+  long changes;                 //Amount of changes written
+  long bytes_written;           //Amount of bytes written to the log
+  long compactions;             //Amount of times the log was written into the pokemon file
+} WriteAheadLogType;
+
+/* all function prototypes for functions in wal.c */
+int wal_identify(const char *file_name, FileIdentityType *identity);
+int wal_open(WriteAheadLogType *wal, const char *data_file_name, long compaction_size);
+void wal_close(WriteAheadLogType *wal);
+int wal_recover(WriteAheadLogType *wal, const PokemonTableType *loaded, PokemonTableType *recovered, int *number_of_changes);
+int wal_reset(WriteAheadLogType *wal, const PokemonTableType *table);
+int wal_append(WriteAheadLogType *wal, const char *changes, long size, int number_of_changes);
+int wal_compact(WriteAheadLogType *wal, const PokemonTableType *table);
+
+#endif //end of header file
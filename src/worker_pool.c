@@ -0,0 +1,151 @@
+/*****************************************************************************/
+/* */
+/* worker_pool.c */
+/* Purpose: This file contains a fixed-size pool of worker threads fed by a work queue, so requests from every client run in parallel on all cores without creating a thread per request. */
+/* How to use: Make sure to compile the file and then link this file when compiling the server executable. This is already done for you in the MakeFile. Start the pool once, submit work to it from any thread and stop it before the program exits. */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//libraries that will be used in the program
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+//importing the header files included with the program to get access to their functions, constants and structs
+#include "server.h"
+#include "worker_pool.h"
+
+/* This function returns the amount of worker threads used when the user does not choose one, which is one per core */
+/* Parameters: None */
+/* Return values: int containing the amount of cores that are online, at least 1 */
+/* Side effects: none */
+int worker_pool_default_size(void) {
+  long number_of_cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return (number_of_cores > 0) ? (int)number_of_cores : 1;
+}
+
+/* This function is ran by every worker thread, it takes the oldest work item off the queue and runs it until the pool is stopped */
+/* Parameters: *arg - input/output (void* casted parameter containing a WorkerPoolType struct) */
+/* Return values: nothing since the function is void  */
+/* Side effects: uses the mutex and cond of the pool to wait for work */
+static void *worker_thread(void *arg) {
+  WorkerPoolType *pool = (WorkerPoolType *)arg;
+
+  while(1) {
+    pthread_mutex_lock(&pool->lock);
+
+    /* Make the thread idle waiting while there is no work and the pool is not stopping */
+    while(pool->queue_size == 0 && pool->is_stopping == C_NOK) {
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+
+    /* Exit once the pool is stopping and all the queued work has been ran */
+    if(pool->queue_size == 0) {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
+    }
+
+    WorkItemType item = pool->queue[pool->queue_head];
+    pool->queue_head = (pool->queue_head + 1) % pool->queue_capacity;
+    pool->queue_size--;
+    pthread_mutex_unlock(&pool->lock);
+
+    /* Run the work without holding the mutex so every worker can run at the same time */
+    item.function(item.argument);
+  }
+}
+
+/* This function creates the work queue and starts the worker threads of a pool */
+/* Parameters: *pool - output (the pool being started), number_of_threads - input (the amount of worker threads to start) */
+/* Return values: nothing since it's a void function */
+/* Side effects: allocates memory and creates threads, exits the program if either fails */
+void worker_pool_start(WorkerPoolType *pool, int number_of_threads) {
+
+  memset(pool, 0, sizeof(WorkerPoolType));
+  pool->is_stopping = C_NOK;
+  pool->number_of_threads = number_of_threads;
+  pool->queue_capacity = WORK_QUEUE_INITIAL_SIZE;
+  pool->queue = (WorkItemType *)malloc(sizeof(WorkItemType) * pool->queue_capacity);
+  pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * number_of_threads);
+
+  /* Check if memory is allocated properly, print error message and exit if not */
+  if(pool->queue == NULL || pool->threads == NULL) {
+    printf("An error occured while allocating memory. The program will now exit \n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Initializing the mutex and cond variables and checking whether they initialized properly */
+  if(pthread_mutex_init(&pool->lock, NULL) != 0) {
+    LOG_ERROR("Mutex failed to initialize");
+    exit(EXIT_FAILURE);
+  }
+  if(pthread_cond_init(&pool->cond, NULL) != 0) {
+    LOG_ERROR("Cond failed to initialize");
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < number_of_threads; i++) {
+    if(pthread_create(&pool->threads[i], NULL, worker_thread, (void *)pool) != 0) {
+      LOG_ERROR("Worker thread failed to start");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+/* This function adds work to the end of the work queue of a pool and wakes up one worker thread to run it */
+/* Parameters: *pool - input/output (the pool running the work), function - input (the function the worker runs), *argument - input (the argument passed to the function) */
+/* Return values: nothing since it's a void function */
+/* Side effects: may grow the work queue, exits the program if memory can't be allocated */
+void worker_pool_submit(WorkerPoolType *pool, WorkFunctionType function, void *argument) {
+  pthread_mutex_lock(&pool->lock);
+
+  /* Double the size of the queue if it is full, unwrapping the circular buffer into the new one */
+  if(pool->queue_size == pool->queue_capacity) {
+    WorkItemType *queue = (WorkItemType *)malloc(sizeof(WorkItemType) * pool->queue_capacity * 2);
+
+    /* Check if memory is allocated properly, print error message and exit if not */
+    if(queue == NULL) {
+      printf("An error occured while allocating memory. The program will now exit \n");
+      exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < pool->queue_size; i++) {
+      queue[i] = pool->queue[(pool->queue_head + i) % pool->queue_capacity];
+    }
+    free(pool->queue);
+    pool->queue = queue;
+    pool->queue_head = 0;
+    pool->queue_capacity *= 2;
+  }
+
+  WorkItemType *item = &pool->queue[(pool->queue_head + pool->queue_size) % pool->queue_capacity];
+  item->function = function;
+  item->argument = argument;
+  pool->queue_size++;
+
+  pthread_cond_signal(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/* This function lets the worker threads finish the queued work, waits for them to exit and frees the pool */
+/* Parameters: *pool - input/output (the pool being stopped) */
+/* Return values: nothing since it's a void function */
+/* Side effects: joins every worker thread, frees the memory of the pool */
+void worker_pool_stop(WorkerPoolType *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->is_stopping = C_OK;
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for(int i = 0; i < pool->number_of_threads; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->cond);
+  free(pool->threads);
+  free(pool->queue);
+}
@@ -0,0 +1,50 @@
+/*****************************************************************************/
+/* */
+/* worker_pool.h */
+/* */
+/* Purpose: This is a header file that contains constants, structures and declaration of all functions used in the worker_pool.c file */
+/* How to use: use #include "worker_pool.h" at the top of any .c files that need to run work on a fixed set of worker threads */
+/* Authors: Nguyen-Hanh Nong */
+/* Revision: Revision 2.0 */
+/* */
+/*****************************************************************************/
+
+//Include guards to protect against double declarations
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+//Other libraries that we will need
+#include <pthread.h>
+
+//Variety of constants defined
+#define WORK_QUEUE_INITIAL_SIZE 64    //Constant to represent the amount of work items the queue can hold before it has to grow
+
+/* This is the type of every function ran by the worker threads */
+typedef void (*WorkFunctionType)(void *argument);
+
+/* This structure represents one piece of work waiting inside the work queue */
+typedef struct WorkItem {
+  WorkFunctionType function;        //Function the worker thread runs
+  void *argument;                   //Argument passed to the function
+} WorkItemType;
+
+/* This structure contains a fixed set of worker threads and the queue of work they take their work from */
+typedef struct WorkerPool {
+  pthread_t *threads;               //Every worker thread of the pool
+  int number_of_threads;            //Amount of worker threads inside threads
+  WorkItemType *queue;              //Circular buffer of work waiting to be ran
+  int queue_head;                   //Index of the oldest work item inside queue
+  int queue_size;                   //Amount of work items inside queue
+  int queue_capacity;               //Amount of work items queue can hold before it has to grow
+  char is_stopping;                 //Char representing whether the worker threads have been told to exit or not
+  pthread_mutex_t lock;             //Mutex protecting the queue
+  pthread_cond_t cond;              //Condition variable the worker threads wait on while the queue is empty
+} WorkerPoolType;
+
+/* all function prototypes for functions in worker_pool.c */
+int worker_pool_default_size(void);
+void worker_pool_start(WorkerPoolType *pool, int number_of_threads);
+void worker_pool_submit(WorkerPoolType *pool, WorkFunctionType function, void *argument);
+void worker_pool_stop(WorkerPoolType *pool);
+
+#endif //end of header file